@@ -0,0 +1,52 @@
+#include "AllocationCounter.h"
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+thread_local uint64_t numAllocations = 0;
+thread_local uint64_t numBytes = 0;
+
+void* allocate(std::size_t size) {
+    numAllocations++;
+    numBytes += size;
+    void* memory = std::malloc(size == 0 ? 1 : size);
+    if (!memory) {
+        throw std::bad_alloc();
+    }
+    return memory;
+}
+
+}
+
+uint64_t allocationCount() {
+    return numAllocations;
+}
+
+uint64_t allocatedBytes() {
+    return numBytes;
+}
+
+void* operator new(std::size_t size) {
+    return allocate(size);
+}
+
+void* operator new[](std::size_t size) {
+    return allocate(size);
+}
+
+void operator delete(void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete[](void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept {
+    std::free(memory);
+}
+
+void operator delete[](void* memory, std::size_t) noexcept {
+    std::free(memory);
+}
@@ -0,0 +1,21 @@
+#ifndef ALLOCATION_COUNTER_H
+#define ALLOCATION_COUNTER_H
+
+#include <cstdint>
+
+/**
+ * Counts the heap allocations made through operator new by the calling thread. Linking
+ * AllocationCounter.cpp into an executable replaces the global operator new and delete.
+ */
+
+/**
+ * @return Number of allocations of the calling thread since it started
+ */
+uint64_t allocationCount();
+
+/**
+ * @return Number of bytes allocated by the calling thread since it started
+ */
+uint64_t allocatedBytes();
+
+#endif // ALLOCATION_COUNTER_H
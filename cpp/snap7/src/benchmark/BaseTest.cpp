@@ -1,8 +1,15 @@
 #include "BaseTest.h"
+#include "BenchmarkUtils.h"
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <memory>
 #include <codecvt>
 #include <regex>
 
+BaseTest::~BaseTest() = default;
+
 TestResults BaseTest::run(int numCycles, int cycleTime, const std::map<std::string, std::string>& tagValues) {
     // Prepare the input and expected output maps
     std::map<std::string, std::string> tags;
@@ -19,23 +26,121 @@ TestResults BaseTest::run(int numCycles, int cycleTime, const std::map<std::stri
     // Execute the read operation
     int connectionTime = 0;
     int disconnectionTime = 0;
-    std::vector<int> readTimes(numCycles, 0);
+    std::vector<int> readTimes;
+    int emittedValues = 0;
+    std::vector<int64_t> readLatencies;
+    std::vector<int64_t> writeLatencies;
+    int verifiedWrites = 0;
+    int skippedCycles = 0;
+    ResourceUsage resources;
+    std::unique_ptr<PerfCounters> counters;
+    PerfSample connectPerf;
+    PerfSample readPerf;
+    PerfSample writePerf;
+    PerfSample disconnectPerf;
+    if (perfCounters) {
+        counters = std::make_unique<PerfCounters>();
+    }
+    std::vector<int64_t> startDelays;
+    std::vector<int64_t> cycleLatencies;
+    int missedDeadlines = 0;
 
     try {
         // Connect to the PLC
         auto startTime = std::chrono::high_resolution_clock::now();
+        if (counters) {
+            counters->start();
+        }
         connect();
+        if (counters) {
+            counters->stop();
+            connectPerf = counters->read();
+        }
         auto endTime = std::chrono::high_resolution_clock::now();
         connectionTime = std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime).count();
 
-        // Perform the read operations
+        // Reading the counters costs a syscall or two itself, which shouldn't be reported
+        ResourceUsage probe = currentResourceUsage();
+        ResourceUsage usageOverhead = currentResourceUsage() - probe;
+        usageOverhead.voluntarySwitches = usageOverhead.involuntarySwitches = 0;
+        usageOverhead.userMicros = usageOverhead.systemMicros = 0;
+
+        // Perform the read and write operations
+        auto period = std::chrono::milliseconds(cycleTime);
+        auto firstStart = std::chrono::steady_clock::now();
         for (int i = 0; i < numCycles; i++) {
-            // Read the values
+            // In fixed-rate mode wait for the deadline of this cycle, unless we are already late
+            auto intendedStart = firstStart + i * period;
+            if (fixedRate) {
+                std::this_thread::sleep_until(intendedStart);
+            }
+
+            // Read the values, or write them in a write cycle
+            bool writeCycle = writeRatio > 0.0 && std::floor((i + 1) * writeRatio) > std::floor(i * writeRatio);
             startTime = std::chrono::high_resolution_clock::now();
-            std::map<std::string, PlcValue> results = read(tags);
+            ResourceUsage usageBefore = currentResourceUsage();
+            auto actualStart = std::chrono::steady_clock::now();
+            if (counters) {
+                counters->start();
+            }
+            std::map<std::string, PlcValue> results;
+            try {
+                if (writeCycle) {
+                    write(tags, expectedResults);
+                } else {
+                    results = changeDetection ? readChanges(tags) : read(tags);
+                }
+            } catch (const ConnectionLost&) {
+                // The driver reconnects in the background, this cycle has no data
+                if (counters) {
+                    counters->stop();
+                }
+                skippedCycles++;
+                if (!fixedRate && i < numCycles - 1) {
+                    std::this_thread::sleep_for(period);
+                }
+                continue;
+            }
+            if (counters) {
+                counters->stop();
+            }
+            auto actualEnd = std::chrono::steady_clock::now();
+            resources += currentResourceUsage() - usageBefore - usageOverhead;
+            if (counters) {
+                (writeCycle ? writePerf : readPerf) += counters->read();
+            }
             endTime = std::chrono::high_resolution_clock::now();
-            int readTime = std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime).count();
-            readTimes[i] = readTime;
+            int64_t latency = std::chrono::duration_cast<std::chrono::microseconds>(actualEnd - actualStart).count();
+            if (writeCycle) {
+                writeLatencies.push_back(latency);
+            } else {
+                readTimes.push_back(std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime).count());
+                readLatencies.push_back(latency);
+                emittedValues += static_cast<int>(results.size());
+            }
+            if (fixedRate) {
+                startDelays.push_back(std::chrono::duration_cast<std::chrono::microseconds>(
+                        actualStart - intendedStart).count());
+                cycleLatencies.push_back(std::chrono::duration_cast<std::chrono::microseconds>(
+                        actualEnd - intendedStart).count());
+                if (actualEnd > intendedStart + period) {
+                    missedDeadlines++;
+                }
+            }
+
+            // Read the written values back, they are checked like any other read (not part of the measured time)
+            if (writeCycle && verifyWrites) {
+                try {
+                    results = read(tags);
+                    if (results.size() != expectedResults.size()) {
+                        throw std::runtime_error("Read after write returned " + std::to_string(results.size()) +
+                                                 " of " + std::to_string(expectedResults.size()) + " values");
+                    }
+                    verifiedWrites++;
+                } catch (const ConnectionLost&) {
+                    // Lost right after the write, the following reads check the values instead
+                }
+            }
 
             // Check the results
             for (const auto& [tagName, value] : results) {
@@ -48,8 +153,8 @@ TestResults BaseTest::run(int numCycles, int cycleTime, const std::map<std::stri
             }
 
             // Wait for the next cycle
-            if (i < numCycles - 1) {
-                std::this_thread::sleep_for(std::chrono::milliseconds(cycleTime));
+            if (!fixedRate && i < numCycles - 1) {
+                std::this_thread::sleep_for(period);
             }
         }
     } catch (const std::exception& e) {
@@ -58,11 +163,209 @@ TestResults BaseTest::run(int numCycles, int cycleTime, const std::map<std::stri
 
     // Disconnect from the PLC
     auto startTime = std::chrono::high_resolution_clock::now();
+    if (counters) {
+        counters->start();
+    }
     disconnect();
+    if (counters) {
+        counters->stop();
+        disconnectPerf = counters->read();
+    }
     auto endTime = std::chrono::high_resolution_clock::now();
     disconnectionTime = std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime).count();
 
-    return TestResults(connectionTime, disconnectionTime, numCycles, readTimes);
+    TestResults testResults(connectionTime, disconnectionTime, static_cast<int>(readTimes.size()), readTimes);
+    testResults.emittedValues = emittedValues;
+    testResults.readLatencies = readLatencies;
+    testResults.writeLatencies = writeLatencies;
+    testResults.verifiedWrites = verifiedWrites;
+    testResults.skippedCycles = skippedCycles;
+    testResults.resources = resources;
+    testResults.fixedRate = fixedRate;
+    testResults.startDelays = startDelays;
+    testResults.cycleLatencies = cycleLatencies;
+    testResults.missedDeadlines = missedDeadlines;
+    if (counters) {
+        testResults.perfCounters = true;
+        for (int event = 0; event < PERF_EVENT_COUNT; event++) {
+            testResults.perfAvailable[event] = counters->available(static_cast<PerfEvent>(event));
+        }
+        testResults.connectPerf = connectPerf;
+        testResults.readPerf = readPerf;
+        testResults.writePerf = writePerf;
+        testResults.disconnectPerf = disconnectPerf;
+    }
+    return testResults;
+}
+
+std::map<std::string, PlcValue> BaseTest::readChanges(const std::map<std::string, std::string>& tags) {
+    std::map<std::string, PlcValue> changes;
+
+    for (auto& [tagName, value] : read(tags)) {
+        auto last = lastValues.find(tagName);
+        if (last != lastValues.end()) {
+            if (value == last->second) {
+                continue;
+            }
+            if (deadband > 0.0 && value.getType() == last->second.getType()) {
+                if (value.getType() == PlcValueType::REAL &&
+                    std::fabs(value.getFloat() - last->second.getFloat()) <= deadband) {
+                    continue;
+                }
+                if (value.getType() == PlcValueType::LREAL &&
+                    std::fabs(value.getDouble() - last->second.getDouble()) <= deadband) {
+                    continue;
+                }
+            }
+        }
+        lastValues[tagName] = value;
+        changes[tagName] = value;
+    }
+
+    return changes;
+}
+
+void BaseTest::setChangeDetection(bool enabled, double deadband) {
+    this->changeDetection = enabled;
+    this->deadband = deadband;
+    lastValues.clear();
+}
+
+void BaseTest::setCaptureFile(const std::string& path) {
+    this->captureFile = path;
+}
+
+void BaseTest::setFixedRate(bool enabled) {
+    this->fixedRate = enabled;
+}
+
+void BaseTest::setPerfCounters(bool enabled) {
+    this->perfCounters = enabled;
+}
+
+void BaseTest::setWriteRatio(double ratio, bool verify) {
+    this->writeRatio = std::min(std::max(ratio, 0.0), 1.0);
+    this->verifyWrites = verify;
+}
+
+namespace {
+
+/**
+ * Integer representation of a numeric value, as it is stored in the PLC.
+ */
+uint64_t integerBits(const PlcValue& value) {
+    switch (value.getType()) {
+        case PlcValueType::BOOL: return value.getBool() ? 1 : 0;
+        case PlcValueType::SINT: return static_cast<uint64_t>(value.getInt8());
+        case PlcValueType::INT: return static_cast<uint64_t>(value.getInt16());
+        case PlcValueType::DINT: return static_cast<uint64_t>(value.getInt32());
+        case PlcValueType::LINT: return static_cast<uint64_t>(value.getInt64());
+        case PlcValueType::USINT: return value.getUint8();
+        case PlcValueType::UINT: return value.getUint16();
+        case PlcValueType::UDINT: return value.getUint32();
+        case PlcValueType::ULINT:
+        case PlcValueType::LWORD: return value.getUint64();
+        case PlcValueType::CHAR: return static_cast<uint8_t>(value.getChar());
+        case PlcValueType::WCHAR: return value.getChar16();
+        default:
+            throw std::runtime_error("Value is not an integer: " + std::to_string(static_cast<int>(value.getType())));
+    }
+}
+
+}
+
+void BaseTest::encodeValue(const PlcValue& value, PlcValueType type, int size, uint8_t* buffer) {
+    memset(buffer, 0, size);
+    switch (type) {
+        case PlcValueType::BOOL:
+            buffer[0] = integerBits(value) ? 0x01 : 0x00;
+            break;
+        case PlcValueType::BYTE:
+        case PlcValueType::SINT:
+        case PlcValueType::USINT:
+        case PlcValueType::CHAR:
+            writeBigEndian(buffer, integerBits(value), 1);
+            break;
+        case PlcValueType::WORD:
+        case PlcValueType::INT:
+        case PlcValueType::UINT:
+        case PlcValueType::WCHAR:
+            writeBigEndian(buffer, integerBits(value), 2);
+            break;
+        case PlcValueType::DWORD:
+        case PlcValueType::DINT:
+        case PlcValueType::UDINT:
+            writeBigEndian(buffer, integerBits(value), 4);
+            break;
+        case PlcValueType::LWORD:
+        case PlcValueType::LINT:
+        case PlcValueType::ULINT:
+            writeBigEndian(buffer, integerBits(value), std::min(size, 8));
+            break;
+        case PlcValueType::REAL: {
+            float number = value.getFloat();
+            uint32_t bits;
+            memcpy(&bits, &number, sizeof(bits));
+            writeBigEndian(buffer, bits, 4);
+            break;
+        }
+        case PlcValueType::LREAL: {
+            double number = value.getDouble();
+            uint64_t bits;
+            memcpy(&bits, &number, sizeof(bits));
+            writeBigEndian(buffer, bits, std::min(size, 8));
+            break;
+        }
+        case PlcValueType::STRING: {
+            // First byte is the max length, second byte is the actual length
+            std::string text = value.getString();
+            size_t length = std::min(text.size(), static_cast<size_t>(size - 2));
+            buffer[0] = static_cast<uint8_t>(size - 2);
+            buffer[1] = static_cast<uint8_t>(length);
+            memcpy(buffer + 2, text.data(), length);
+            break;
+        }
+        case PlcValueType::WSTRING: {
+            // First word is the max length, second word is the actual length
+            std::u16string text = value.getWstring();
+            size_t length = std::min(text.size(), static_cast<size_t>((size - 4) / 2));
+            writeBigEndian(buffer, (size - 4) / 2, 2);
+            writeBigEndian(buffer + 2, length, 2);
+            for (size_t i = 0; i < length; i++) {
+                writeBigEndian(buffer + 4 + i * 2, text[i], 2);
+            }
+            break;
+        }
+        case PlcValueType::TIME:
+            writeBigEndian(buffer, static_cast<uint32_t>(std::llround(value.getDuration().count() * 1000)), 4);
+            break;
+        case PlcValueType::DATE: {
+            // Days since 1990-01-01, like the decoder
+            PlcDate date = value.getDate();
+            int days = 0;
+            for (int year = 1990; year < date.year; year++) {
+                days += ((year % 4 == 0 && year % 100 != 0) || (year % 400 == 0)) ? 366 : 365;
+            }
+            int daysInMonth[] = {0, 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+            if ((date.year % 4 == 0 && date.year % 100 != 0) || (date.year % 400 == 0)) {
+                daysInMonth[2] = 29;
+            }
+            for (int month = 1; month < date.month; month++) {
+                days += daysInMonth[month];
+            }
+            days += date.day - 1;
+            writeBigEndian(buffer, static_cast<uint64_t>(days), 2);
+            break;
+        }
+        case PlcValueType::TIME_OF_DAY: {
+            PlcTimeOfDay time = value.getTimeOfDay();
+            uint32_t milliseconds = ((time.hour * 60 + time.minute) * 60 + time.second) * 1000 + time.millisecond;
+            writeBigEndian(buffer, milliseconds, 4);
+            break;
+        }
+        default:
+            throw std::runtime_error("Unsupported data type: " + std::to_string(static_cast<int>(type)));
+    }
 }
 
 PlcValue BaseTest::getValue(const std::string& value) {
@@ -3,6 +3,8 @@
 
 #include <string>
 #include <map>
+#include <vector>
+#include <ostream>
 #include <thread>
 #include <stdexcept>
 #include <chrono>
@@ -166,12 +168,42 @@ private:
     void copyValue(const PlcValue& other);
 };
 
+/**
+ * Traffic counters of the driver used by a test.
+ */
+struct DriverCounters {
+    uint64_t requests = 0;   // Requests (jobs) executed by the driver
+    uint64_t pdusSent = 0;
+    uint64_t pdusRecvd = 0;
+    uint64_t bytesSent = 0;  // Bytes on the wire, including the ISO-on-TCP headers
+    uint64_t bytesRecvd = 0;
+};
+
+/**
+ * Connection losses of a test whose driver reconnects by itself.
+ */
+struct ReconnectStats {
+    int losses = 0;             // Connection losses detected
+    int attempts = 0;           // Reconnect attempts, successful or not
+    int replans = 0;            // Prepared plans rebuilt because the negotiated PDU size changed
+    std::vector<int64_t> gaps;  // Loss to restored connection, for every reconnect (in microseconds)
+};
+
+/**
+ * Thrown by a test whose connection is down while its driver reconnects. run() skips
+ * the cycle instead of failing.
+ */
+class ConnectionLost : public std::runtime_error {
+public:
+    explicit ConnectionLost(const std::string& what) : std::runtime_error(what) {}
+};
+
 /**
  * Abstract base class for benchmark tests.
  */
 class BaseTest {
 public:
-    //virtual ~BaseTest() = default;
+    virtual ~BaseTest();
 
     /**
      * Run the benchmark test.
@@ -208,7 +240,100 @@ public:
      */
     virtual std::map<std::string, PlcValue> read(const std::map<std::string, std::string>& tags) = 0;
 
+    /**
+     * Write values to the PLC.
+     * 
+     * @param tags Map of tag names to tag addresses
+     * @param values Map of tag names to the values to write
+     */
+    virtual void write(const std::map<std::string, std::string>& tags, const std::map<std::string, PlcValue>& values) = 0;
+
+    /**
+     * Read values from the PLC and only return the ones that changed since the previous call.
+     * The default implementation compares the decoded values, implementations with access
+     * to the raw buffers should override it.
+     * 
+     * @param tags Map of tag names to tag addresses
+     * @return Map of tag names to changed values
+     */
+    virtual std::map<std::string, PlcValue> readChanges(const std::map<std::string, std::string>& tags);
+
+    /**
+     * Make run() use readChanges() instead of read().
+     * 
+     * @param enabled true to only receive changed values
+     * @param deadband Absolute deadband applied to REAL and LREAL values (0 = report every change)
+     */
+    void setChangeDetection(bool enabled, double deadband = 0.0);
+
+    /**
+     * Record the traffic of the next connection into a pcap file, which can be
+     * replayed later with s7_replay.
+     * 
+     * @param path Path of the capture file (empty = no capture)
+     */
+    void setCaptureFile(const std::string& path);
+
+    /**
+     * Schedule the read cycles on a fixed timeline (cycle i is due at start + i * cycleTime)
+     * instead of sleeping cycleTime after each read. Slow reads then delay the following
+     * cycles instead of silently reducing the rate, and the latency is measured from the
+     * intended start, so the queueing delay is not omitted from the results.
+     * 
+     * @param enabled true to use the fixed-rate schedule
+     */
+    void setFixedRate(bool enabled);
+
+    /**
+     * Collect hardware performance counters (cycles, instructions, cache and branch misses,
+     * task clock) separately for connect, the read operations and disconnect.
+     * 
+     * @param enabled true to collect the counters
+     */
+    void setPerfCounters(bool enabled);
+
+    /**
+     * Mix writes into the cycles of run(). A write cycle writes the expected values of all
+     * tags back to the PLC, so the values read in the other cycles don't change.
+     * 
+     * @param ratio Fraction of the cycles that write (0 = only reads, 1 = only writes)
+     * @param verify Read all tags back after every write and compare them
+     */
+    void setWriteRatio(double ratio, bool verify = false);
+
+    /**
+     * Print the statistics collected by the underlying driver (if any).
+     * 
+     * @param out Stream to print to
+     */
+    virtual void printStatistics(std::ostream& /*out*/) {}
+
+    /**
+     * Get the traffic counters of the underlying driver (if any), accumulated since the
+     * last connect().
+     * 
+     * @param counters Receives the counters
+     * @return false if the driver doesn't provide counters
+     */
+    virtual bool getDriverCounters(DriverCounters& /*counters*/) { return false; }
+
+    /**
+     * Get the connection losses of the test, if its driver reconnects by itself.
+     * 
+     * @param stats Receives the losses, reconnects and gaps
+     * @return false if the test doesn't reconnect
+     */
+    virtual bool getReconnectStats(ReconnectStats& /*stats*/) { return false; }
+
 protected:
+    bool changeDetection = false;
+    double deadband = 0.0;
+    std::string captureFile;
+    bool fixedRate = false;
+    bool perfCounters = false;
+    double writeRatio = 0.0;
+    bool verifyWrites = false;
+
     /**
      * Parse a value string into a PlcValue.
      * 
@@ -216,6 +341,20 @@ protected:
      * @return Parsed value
      */
     PlcValue getValue(const std::string& value);
+
+    /**
+     * Encode a value into the big-endian S7 representation of a tag, the inverse of the
+     * decoding done by read().
+     * 
+     * @param value The value
+     * @param type Type of the tag the value is written to
+     * @param size Size of the tag in bytes
+     * @param buffer Buffer receiving size bytes
+     */
+    void encodeValue(const PlcValue& value, PlcValueType type, int size, uint8_t* buffer);
+
+private:
+    std::map<std::string, PlcValue> lastValues; // Last values returned by the default readChanges()
 };
 
 #endif // BASE_TEST_H
@@ -0,0 +1,548 @@
+#include "BenchmarkResults.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#if !defined(_WIN32)
+#include <sys/utsname.h>
+#endif
+
+namespace {
+
+/**
+ * Minimal JSON document model, just enough to read back the files written here.
+ */
+struct JsonValue {
+    enum class Kind { NUL, BOOL, NUMBER, STRING, ARRAY, OBJECT };
+    Kind kind = Kind::NUL;
+    bool boolean = false;
+    double number = 0.0;
+    std::string text;
+    std::vector<JsonValue> items;
+    std::map<std::string, JsonValue> members;
+
+    const JsonValue& operator[](const std::string& name) const {
+        static const JsonValue missing;
+        auto member = members.find(name);
+        return member == members.end() ? missing : member->second;
+    }
+};
+
+class JsonParser {
+public:
+    explicit JsonParser(const std::string& text) : text(text) {}
+
+    JsonValue parse() {
+        JsonValue value = parseValue();
+        skipWhitespace();
+        if (pos != text.size()) {
+            fail("trailing characters");
+        }
+        return value;
+    }
+
+private:
+    const std::string& text;
+    size_t pos = 0;
+
+    [[noreturn]] void fail(const std::string& message) {
+        throw std::runtime_error("Invalid JSON at offset " + std::to_string(pos) + ": " + message);
+    }
+
+    void skipWhitespace() {
+        while (pos < text.size() && std::isspace(static_cast<unsigned char>(text[pos]))) {
+            pos++;
+        }
+    }
+
+    bool consume(const char* token) {
+        size_t length = std::char_traits<char>::length(token);
+        if (text.compare(pos, length, token) == 0) {
+            pos += length;
+            return true;
+        }
+        return false;
+    }
+
+    void expect(char c) {
+        skipWhitespace();
+        if (pos >= text.size() || text[pos] != c) {
+            fail(std::string("expected '") + c + "'");
+        }
+        pos++;
+    }
+
+    std::string parseString() {
+        expect('"');
+        std::string result;
+        while (pos < text.size() && text[pos] != '"') {
+            char c = text[pos++];
+            if (c != '\\') {
+                result += c;
+                continue;
+            }
+            if (pos >= text.size()) {
+                break;
+            }
+            char escape = text[pos++];
+            switch (escape) {
+                case 'b': result += '\b'; break;
+                case 'f': result += '\f'; break;
+                case 'n': result += '\n'; break;
+                case 'r': result += '\r'; break;
+                case 't': result += '\t'; break;
+                case 'u': {
+                    if (pos + 4 > text.size()) {
+                        fail("truncated escape");
+                    }
+                    long code = std::strtol(text.substr(pos, 4).c_str(), nullptr, 16);
+                    pos += 4;
+                    result += code < 0x80 ? static_cast<char>(code) : '?';
+                    break;
+                }
+                default: result += escape; break;
+            }
+        }
+        expect('"');
+        return result;
+    }
+
+    JsonValue parseValue() {
+        skipWhitespace();
+        JsonValue value;
+        if (pos >= text.size()) {
+            fail("unexpected end");
+        }
+        char c = text[pos];
+        if (c == '{') {
+            value.kind = JsonValue::Kind::OBJECT;
+            pos++;
+            skipWhitespace();
+            if (pos < text.size() && text[pos] == '}') {
+                pos++;
+                return value;
+            }
+            do {
+                std::string name = parseString();
+                expect(':');
+                value.members[name] = parseValue();
+                skipWhitespace();
+            } while (pos < text.size() && text[pos] == ',' && ++pos);
+            expect('}');
+        } else if (c == '[') {
+            value.kind = JsonValue::Kind::ARRAY;
+            pos++;
+            skipWhitespace();
+            if (pos < text.size() && text[pos] == ']') {
+                pos++;
+                return value;
+            }
+            do {
+                value.items.push_back(parseValue());
+                skipWhitespace();
+            } while (pos < text.size() && text[pos] == ',' && ++pos);
+            expect(']');
+        } else if (c == '"') {
+            value.kind = JsonValue::Kind::STRING;
+            value.text = parseString();
+        } else if (consume("true")) {
+            value.kind = JsonValue::Kind::BOOL;
+            value.boolean = true;
+        } else if (consume("false")) {
+            value.kind = JsonValue::Kind::BOOL;
+        } else if (consume("null")) {
+            value.kind = JsonValue::Kind::NUL;
+        } else {
+            char* end = nullptr;
+            value.kind = JsonValue::Kind::NUMBER;
+            value.number = std::strtod(text.c_str() + pos, &end);
+            if (end == text.c_str() + pos) {
+                fail("unexpected character");
+            }
+            pos = end - text.c_str();
+        }
+        return value;
+    }
+};
+
+std::string jsonString(const std::string& text) {
+    std::ostringstream out;
+    out << '"';
+    for (char c : text) {
+        switch (c) {
+            case '"': out << "\\\""; break;
+            case '\\': out << "\\\\"; break;
+            case '\n': out << "\\n"; break;
+            case '\r': out << "\\r"; break;
+            case '\t': out << "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    out << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c) << std::dec;
+                } else {
+                    out << c;
+                }
+        }
+    }
+    out << '"';
+    return out.str();
+}
+
+void writeObject(std::ostream& out, const std::vector<std::pair<std::string, std::string>>& members,
+                 const std::string& indent) {
+    out << "{";
+    for (size_t i = 0; i < members.size(); i++) {
+        out << (i == 0 ? "\n" : ",\n") << indent << "  " << jsonString(members[i].first) << ": "
+            << jsonString(members[i].second);
+    }
+    out << "\n" << indent << "}";
+}
+
+void writeSamples(std::ostream& out, const std::vector<int64_t>& samples) {
+    out << "[";
+    for (size_t i = 0; i < samples.size(); i++) {
+        out << (i == 0 ? "" : ", ") << samples[i];
+    }
+    out << "]";
+}
+
+void writePerf(std::ostream& out, const TestResults& results, const PerfSample& sample) {
+    out << "{";
+    bool first = true;
+    for (int event = 0; event < PERF_EVENT_COUNT; event++) {
+        if (results.perfAvailable[event]) {
+            out << (first ? "" : ", ") << jsonString(PerfCounters::name(static_cast<PerfEvent>(event))) << ": "
+                << sample.values[event];
+            first = false;
+        }
+    }
+    out << "}";
+}
+
+std::vector<int64_t> readSamples(const JsonValue& array) {
+    std::vector<int64_t> samples;
+    for (const auto& item : array.items) {
+        samples.push_back(static_cast<int64_t>(item.number));
+    }
+    return samples;
+}
+
+std::vector<std::pair<std::string, std::string>> readObject(const JsonValue& object) {
+    std::vector<std::pair<std::string, std::string>> members;
+    for (const auto& [name, value] : object.members) {
+        members.emplace_back(name, value.text);
+    }
+    return members;
+}
+
+struct Metric {
+    const char* name;
+    bool higherIsBetter;
+    double (*compute)(std::vector<int64_t>& samples); // Samples may be reordered
+};
+
+double metricP50(std::vector<int64_t>& samples) {
+    std::sort(samples.begin(), samples.end());
+    return percentile(samples, 0.5);
+}
+
+double metricP99(std::vector<int64_t>& samples) {
+    std::sort(samples.begin(), samples.end());
+    return percentile(samples, 0.99);
+}
+
+double metricThroughput(std::vector<int64_t>& samples) {
+    double total = 0.0;
+    for (int64_t sample : samples) {
+        total += static_cast<double>(sample);
+    }
+    return total > 0.0 ? samples.size() * 1e6 / total : 0.0;
+}
+
+const Metric metrics[] = {
+    {"p50", false, metricP50},
+    {"p99", false, metricP99},
+    {"reads/s", true, metricThroughput}
+};
+
+const int bootstrapIterations = 2000;
+
+}
+
+double percentile(const std::vector<int64_t>& sorted, double fraction) {
+    if (sorted.empty()) {
+        return 0.0;
+    }
+    size_t index = static_cast<size_t>(std::ceil(fraction * sorted.size()));
+    index = index == 0 ? 0 : std::min(index - 1, sorted.size() - 1);
+    return static_cast<double>(sorted[index]);
+}
+
+const std::vector<int64_t>& latencySamples(const TestResults& results) {
+    return results.fixedRate ? results.cycleLatencies : results.readLatencies;
+}
+
+LatencySummary summarize(const std::vector<int64_t>& samples) {
+    LatencySummary summary;
+    if (samples.empty()) {
+        return summary;
+    }
+    std::vector<int64_t> sorted = samples;
+    std::sort(sorted.begin(), sorted.end());
+    double sum = 0.0;
+    for (int64_t sample : sorted) {
+        sum += static_cast<double>(sample);
+    }
+    summary.count = sorted.size();
+    summary.mean = sum / sorted.size();
+    double squares = 0.0;
+    for (int64_t sample : sorted) {
+        squares += (sample - summary.mean) * (sample - summary.mean);
+    }
+    summary.stddev = sorted.size() > 1 ? std::sqrt(squares / (sorted.size() - 1)) : 0.0;
+    summary.min = static_cast<double>(sorted.front());
+    summary.p50 = percentile(sorted, 0.5);
+    summary.p90 = percentile(sorted, 0.9);
+    summary.p99 = percentile(sorted, 0.99);
+    summary.max = static_cast<double>(sorted.back());
+    summary.readsPerSecond = summary.mean > 0.0 ? 1e6 / summary.mean : 0.0;
+    return summary;
+}
+
+std::vector<std::pair<std::string, std::string>> collectEnvironment() {
+    std::vector<std::pair<std::string, std::string>> environment;
+
+    std::time_t now = std::time(nullptr);
+    char timestamp[32];
+    std::strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+    environment.emplace_back("timestamp", timestamp);
+
+#if defined(_WIN32)
+    const char* host = std::getenv("COMPUTERNAME");
+    environment.emplace_back("host", host ? host : "");
+    environment.emplace_back("os", "Windows");
+#else
+    struct utsname name;
+    if (uname(&name) == 0) {
+        environment.emplace_back("host", name.nodename);
+        environment.emplace_back("os", std::string(name.sysname) + " " + name.release + " " + name.machine);
+    }
+#endif
+    environment.emplace_back("cpus", std::to_string(std::thread::hardware_concurrency()));
+
+#if defined(__clang__)
+    environment.emplace_back("compiler", "clang " __clang_version__);
+#elif defined(__GNUC__)
+    environment.emplace_back("compiler", "gcc " __VERSION__);
+#elif defined(_MSC_VER)
+    environment.emplace_back("compiler", "msvc " + std::to_string(_MSC_VER));
+#endif
+#if defined(NDEBUG)
+    environment.emplace_back("build", "release");
+#else
+    environment.emplace_back("build", "debug");
+#endif
+    return environment;
+}
+
+void writeResultsJson(const std::string& path, const BenchmarkResults& results) {
+    std::ofstream out(path);
+    if (!out.is_open()) {
+        throw std::runtime_error("Failed to create results file: " + path);
+    }
+    out << std::setprecision(10);
+    out << "{\n  \"version\": 1,\n  \"configuration\": ";
+    writeObject(out, results.configuration, "  ");
+    out << ",\n  \"environment\": ";
+    writeObject(out, results.environment, "  ");
+    out << ",\n  \"tests\": [";
+    for (size_t i = 0; i < results.tests.size(); i++) {
+        const BenchmarkResults::Test& test = results.tests[i];
+        const TestResults& testResults = test.results;
+        LatencySummary summary = summarize(latencySamples(testResults));
+        out << (i == 0 ? "\n" : ",\n") << "    {\n"
+            << "      \"name\": " << jsonString(test.name) << ",\n"
+            << "      \"connectionTime\": " << testResults.connectionTime << ",\n"
+            << "      \"disconnectionTime\": " << testResults.disconnectionTime << ",\n"
+            << "      \"numReadCycles\": " << testResults.numReadCycles << ",\n"
+            << "      \"emittedValues\": " << testResults.emittedValues << ",\n"
+            << "      \"verifiedWrites\": " << testResults.verifiedWrites << ",\n"
+            << "      \"fixedRate\": " << (testResults.fixedRate ? "true" : "false") << ",\n"
+            << "      \"missedDeadlines\": " << testResults.missedDeadlines << ",\n"
+            << "      \"summary\": {\"count\": " << summary.count << ", \"mean\": " << summary.mean
+            << ", \"stddev\": " << summary.stddev << ", \"min\": " << summary.min << ", \"p50\": " << summary.p50
+            << ", \"p90\": " << summary.p90 << ", \"p99\": " << summary.p99 << ", \"max\": " << summary.max
+            << ", \"readsPerSecond\": " << summary.readsPerSecond << "},\n"
+            << "      \"resources\": {\"allocations\": " << testResults.resources.allocations
+            << ", \"allocatedBytes\": " << testResults.resources.allocatedBytes
+            << ", \"syscalls\": " << testResults.resources.syscalls
+            << ", \"voluntarySwitches\": " << testResults.resources.voluntarySwitches
+            << ", \"involuntarySwitches\": " << testResults.resources.involuntarySwitches
+            << ", \"userMicros\": " << testResults.resources.userMicros
+            << ", \"systemMicros\": " << testResults.resources.systemMicros << "},\n";
+        if (testResults.perfCounters) {
+            out << "      \"perf\": {\"connect\": ";
+            writePerf(out, testResults, testResults.connectPerf);
+            out << ", \"read\": ";
+            writePerf(out, testResults, testResults.readPerf);
+            out << ", \"write\": ";
+            writePerf(out, testResults, testResults.writePerf);
+            out << ", \"disconnect\": ";
+            writePerf(out, testResults, testResults.disconnectPerf);
+            out << "},\n";
+        }
+        out << "      \"samples\": {\n        \"readLatencies\": ";
+        writeSamples(out, testResults.readLatencies);
+        out << ",\n        \"writeLatencies\": ";
+        writeSamples(out, testResults.writeLatencies);
+        out << ",\n        \"startDelays\": ";
+        writeSamples(out, testResults.startDelays);
+        out << ",\n        \"cycleLatencies\": ";
+        writeSamples(out, testResults.cycleLatencies);
+        out << "\n      }\n    }";
+    }
+    out << "\n  ]\n}\n";
+}
+
+void writeResultsCsv(const std::string& path, const BenchmarkResults& results) {
+    std::ofstream out(path);
+    if (!out.is_open()) {
+        throw std::runtime_error("Failed to create results file: " + path);
+    }
+    out << "test,operation,index,latencyUs,startDelayUs,cycleLatencyUs\n";
+    for (const auto& test : results.tests) {
+        const TestResults& testResults = test.results;
+        // The fixed rate samples only line up with the reads when no cycle wrote
+        bool perCycle = testResults.writeLatencies.empty();
+        for (size_t cycle = 0; cycle < testResults.readLatencies.size(); cycle++) {
+            out << test.name << ",read," << cycle << "," << testResults.readLatencies[cycle] << ",";
+            if (perCycle && cycle < testResults.startDelays.size()) {
+                out << testResults.startDelays[cycle];
+            }
+            out << ",";
+            if (perCycle && cycle < testResults.cycleLatencies.size()) {
+                out << testResults.cycleLatencies[cycle];
+            }
+            out << "\n";
+        }
+        for (size_t write = 0; write < testResults.writeLatencies.size(); write++) {
+            out << test.name << ",write," << write << "," << testResults.writeLatencies[write] << ",,\n";
+        }
+    }
+}
+
+BenchmarkResults loadResultsJson(const std::string& path) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        throw std::runtime_error("Failed to open results file: " + path);
+    }
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    std::string text = buffer.str();
+    JsonValue document = JsonParser(text).parse();
+    if (document["version"].number != 1) {
+        throw std::runtime_error("Unsupported results file: " + path);
+    }
+
+    BenchmarkResults results;
+    results.configuration = readObject(document["configuration"]);
+    results.environment = readObject(document["environment"]);
+    for (const auto& item : document["tests"].items) {
+        const JsonValue& samples = item["samples"];
+        std::vector<int64_t> readLatencies = readSamples(samples["readLatencies"]);
+        std::vector<int> readTimes;
+        for (int64_t latency : readLatencies) {
+            readTimes.push_back(static_cast<int>(latency / 1000));
+        }
+        TestResults testResults(static_cast<int>(item["connectionTime"].number),
+                                static_cast<int>(item["disconnectionTime"].number),
+                                static_cast<int>(item["numReadCycles"].number), readTimes);
+        testResults.emittedValues = static_cast<int>(item["emittedValues"].number);
+        testResults.readLatencies = readLatencies;
+        testResults.writeLatencies = readSamples(samples["writeLatencies"]);
+        testResults.verifiedWrites = static_cast<int>(item["verifiedWrites"].number);
+        testResults.fixedRate = item["fixedRate"].boolean;
+        testResults.startDelays = readSamples(samples["startDelays"]);
+        testResults.cycleLatencies = readSamples(samples["cycleLatencies"]);
+        testResults.missedDeadlines = static_cast<int>(item["missedDeadlines"].number);
+        const JsonValue& resources = item["resources"];
+        testResults.resources.allocations = static_cast<uint64_t>(resources["allocations"].number);
+        testResults.resources.allocatedBytes = static_cast<uint64_t>(resources["allocatedBytes"].number);
+        testResults.resources.syscalls = static_cast<uint64_t>(resources["syscalls"].number);
+        testResults.resources.voluntarySwitches = static_cast<uint64_t>(resources["voluntarySwitches"].number);
+        testResults.resources.involuntarySwitches = static_cast<uint64_t>(resources["involuntarySwitches"].number);
+        testResults.resources.userMicros = static_cast<uint64_t>(resources["userMicros"].number);
+        testResults.resources.systemMicros = static_cast<uint64_t>(resources["systemMicros"].number);
+        results.tests.push_back({item["name"].text, testResults});
+    }
+    return results;
+}
+
+bool compareResults(const BenchmarkResults& baseline, const BenchmarkResults& current, double threshold,
+                    std::ostream& out) {
+    bool passed = true;
+    std::mt19937 random(1);
+
+    for (const auto& test : current.tests) {
+        auto base = std::find_if(baseline.tests.begin(), baseline.tests.end(),
+                                 [&test](const BenchmarkResults::Test& other) { return other.name == test.name; });
+        out << "Comparing: '" << test.name << "'" << std::endl;
+        if (base == baseline.tests.end()) {
+            out << "  --> FAIL: test not found in the baseline" << std::endl;
+            passed = false;
+            continue;
+        }
+        const std::vector<int64_t>& baseSamples = latencySamples(base->results);
+        const std::vector<int64_t>& currentSamples = latencySamples(test.results);
+        if (baseSamples.empty() || currentSamples.empty()) {
+            out << "  --> FAIL: no samples to compare" << std::endl;
+            passed = false;
+            continue;
+        }
+
+        for (const Metric& metric : metrics) {
+            std::vector<int64_t> baseCopy = baseSamples;
+            std::vector<int64_t> currentCopy = currentSamples;
+            double baseValue = metric.compute(baseCopy);
+            double currentValue = metric.compute(currentCopy);
+
+            // Bootstrap the ratio current / baseline by resampling both runs
+            std::vector<double> ratios;
+            std::uniform_int_distribution<size_t> pickBase(0, baseSamples.size() - 1);
+            std::uniform_int_distribution<size_t> pickCurrent(0, currentSamples.size() - 1);
+            for (int iteration = 0; iteration < bootstrapIterations; iteration++) {
+                for (auto& sample : baseCopy) {
+                    sample = baseSamples[pickBase(random)];
+                }
+                for (auto& sample : currentCopy) {
+                    sample = currentSamples[pickCurrent(random)];
+                }
+                double resampledBase = metric.compute(baseCopy);
+                if (resampledBase > 0.0) {
+                    ratios.push_back(metric.compute(currentCopy) / resampledBase);
+                }
+            }
+            std::sort(ratios.begin(), ratios.end());
+            double low = ratios.empty() ? 1.0 : ratios[static_cast<size_t>(0.025 * (ratios.size() - 1))];
+            double high = ratios.empty() ? 1.0 : ratios[static_cast<size_t>(0.975 * (ratios.size() - 1))];
+
+            bool regressed = metric.higherIsBetter ? high < 1.0 - threshold : low > 1.0 + threshold;
+            passed = passed && !regressed;
+            out << "  --> " << (regressed ? "FAIL " : "ok   ") << std::left << std::setw(8) << metric.name
+                << std::right << std::fixed << std::setprecision(2)
+                << (metric.higherIsBetter ? baseValue : baseValue / 1000.0) << " -> "
+                << (metric.higherIsBetter ? currentValue : currentValue / 1000.0)
+                << (metric.higherIsBetter ? "" : " ms") << ", ratio " << std::setprecision(3)
+                << (baseValue > 0.0 ? currentValue / baseValue : 0.0) << " (95% CI " << low << " .. " << high << ")"
+                << std::defaultfloat << std::endl;
+        }
+    }
+    return passed;
+}
@@ -0,0 +1,95 @@
+#ifndef BENCHMARK_RESULTS_H
+#define BENCHMARK_RESULTS_H
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <ostream>
+#include <cstdint>
+#include "TestResults.h"
+
+/**
+ * Summary statistics of the latency samples of a test (in microseconds).
+ */
+struct LatencySummary {
+    size_t count = 0;
+    double mean = 0.0;
+    double stddev = 0.0;
+    double min = 0.0;
+    double p50 = 0.0;
+    double p90 = 0.0;
+    double p99 = 0.0;
+    double max = 0.0;
+    double readsPerSecond = 0.0; // Reads one connection completes per second (1 / mean)
+};
+
+/**
+ * Results of one s7_benchmark run, with everything needed to reproduce and compare it.
+ */
+struct BenchmarkResults {
+    struct Test {
+        std::string name;
+        TestResults results;
+    };
+
+    std::vector<std::pair<std::string, std::string>> configuration;
+    std::vector<std::pair<std::string, std::string>> environment;
+    std::vector<Test> tests;
+};
+
+/**
+ * The latency samples of a test: measured from the intended start in fixed-rate mode,
+ * otherwise the read times.
+ */
+const std::vector<int64_t>& latencySamples(const TestResults& results);
+
+/**
+ * Percentile of sorted samples (nearest rank, in the unit of the samples).
+ *
+ * @param sorted Samples in ascending order
+ * @param fraction Percentile as a fraction (0.99 = p99, 1.0 = max)
+ * @return The sample at the nearest rank, 0 if there are no samples
+ */
+double percentile(const std::vector<int64_t>& sorted, double fraction);
+
+/**
+ * Compute the summary statistics of latency samples.
+ */
+LatencySummary summarize(const std::vector<int64_t>& samples);
+
+/**
+ * Describe the machine and build the benchmark runs on (host, OS, compiler, time).
+ */
+std::vector<std::pair<std::string, std::string>> collectEnvironment();
+
+/**
+ * Write the results as JSON: configuration, environment and for every test the summary and
+ * all per-cycle samples. The file can be used as baseline with compareResults().
+ */
+void writeResultsJson(const std::string& path, const BenchmarkResults& results);
+
+/**
+ * Write the per-cycle samples as CSV (one row per test and cycle).
+ */
+void writeResultsCsv(const std::string& path, const BenchmarkResults& results);
+
+/**
+ * Load results written by writeResultsJson (throws std::runtime_error on errors).
+ */
+BenchmarkResults loadResultsJson(const std::string& path);
+
+/**
+ * Compare the p50, p99 and throughput of every test with a baseline. The ratio of each
+ * metric (current / baseline) is bootstrapped; a metric regresses when its whole 95%
+ * confidence interval is worse than the threshold.
+ *
+ * @param baseline Stored results
+ * @param current Results of this run
+ * @param threshold Tolerated relative change (0.1 = 10%)
+ * @param out Stream the report is printed to
+ * @return false if any metric regressed or a test is missing in the baseline
+ */
+bool compareResults(const BenchmarkResults& baseline, const BenchmarkResults& current, double threshold,
+                    std::ostream& out);
+
+#endif // BENCHMARK_RESULTS_H
@@ -0,0 +1,89 @@
+#ifndef BENCHMARK_UTILS_H
+#define BENCHMARK_UTILS_H
+
+#include <string>
+#include <vector>
+#include <sstream>
+#include <fstream>
+#include <iostream>
+#include <chrono>
+#include <cstdint>
+
+/**
+ * Split a comma separated list, empty items are skipped.
+ */
+inline std::vector<std::string> splitList(const std::string& list) {
+    std::vector<std::string> items;
+    std::stringstream stream(list);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        if (!item.empty()) {
+            items.push_back(item);
+        }
+    }
+    return items;
+}
+
+/**
+ * Parse a comma separated list of integers.
+ */
+inline std::vector<int> parseList(const std::string& list) {
+    std::vector<int> values;
+    for (const std::string& item : splitList(list)) {
+        values.push_back(std::stoi(item));
+    }
+    return values;
+}
+
+/**
+ * Microseconds on the steady clock.
+ */
+inline int64_t nowMicros() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * Nanoseconds on the steady clock.
+ */
+inline int64_t nowNanos() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * Write the low size bytes of an unsigned value in big-endian byte order (the S7 one).
+ */
+inline void writeBigEndian(uint8_t* data, uint64_t value, int size) {
+    for (int i = size - 1; i >= 0; i--) {
+        data[i] = static_cast<uint8_t>(value);
+        value >>= 8;
+    }
+}
+
+/**
+ * Write the samples of a benchmark to a CSV file (the --resultsCsv option).
+ *
+ * @param path File to create
+ * @param header Column names, comma separated
+ * @param rows Samples, one line each
+ * @param writeRow Writes the columns of a row to the stream, without the line end
+ * @return false if the file couldn't be created (the error is printed)
+ */
+template <typename Rows, typename WriteRow>
+bool writeSamplesCsv(const std::string& path, const std::string& header, const Rows& rows, WriteRow writeRow) {
+    std::ofstream out(path);
+    if (!out.is_open()) {
+        std::cerr << "Failed to create results file: " << path << std::endl;
+        return false;
+    }
+    out << header << "\n";
+    for (const auto& row : rows) {
+        writeRow(out, row);
+        out << "\n";
+    }
+    std::cout << "Samples written to " << path << std::endl;
+    return true;
+}
+
+#endif // BENCHMARK_UTILS_H
@@ -0,0 +1,102 @@
+#include "ChangeDetector.h"
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+double decodeReal(const uint8_t* data) {
+    uint32_t temp = (static_cast<uint32_t>(data[0]) << 24) | (static_cast<uint32_t>(data[1]) << 16) |
+                    (static_cast<uint32_t>(data[2]) << 8) | static_cast<uint32_t>(data[3]);
+    float value;
+    memcpy(&value, &temp, sizeof(float));
+    return value;
+}
+
+double decodeLReal(const uint8_t* data) {
+    uint64_t temp = 0;
+    for (int i = 0; i < 8; i++) {
+        temp = (temp << 8) | data[i];
+    }
+    double value;
+    memcpy(&value, &temp, sizeof(double));
+    return value;
+}
+
+}
+
+ChangeDetector::ChangeDetector(double deadband) : deadband(deadband) {
+}
+
+void ChangeDetector::setDeadband(double deadband) {
+    this->deadband = deadband;
+}
+
+void ChangeDetector::reset() {
+    previous.clear();
+}
+
+void ChangeDetector::detect(const ReadPlan& plan, std::vector<ChangedItem>& changed) {
+    changed.clear();
+
+    // A different plan layout means we have nothing to compare against
+    bool layoutChanged = previous.size() != plan.groups.size();
+    for (size_t g = 0; !layoutChanged && g < plan.groups.size(); g++) {
+        layoutChanged = previous[g].size() != plan.groups[g].buffer.size();
+    }
+    if (layoutChanged) {
+        previous.clear();
+        for (const auto& group : plan.groups) {
+            previous.push_back(group.buffer);
+            for (const auto& item : group.items) {
+                changed.push_back({&item, group.buffer.data() + item.offset});
+            }
+        }
+        return;
+    }
+
+    for (size_t g = 0; g < plan.groups.size(); g++) {
+        const ReadPlanGroup& group = plan.groups[g];
+        std::vector<uint8_t>& last = previous[g];
+
+        // Fast path: the whole block is unchanged
+        if (memcmp(last.data(), group.buffer.data(), group.buffer.size()) == 0) {
+            continue;
+        }
+
+        for (const auto& item : group.items) {
+            const uint8_t* oldData = last.data() + item.offset;
+            const uint8_t* newData = group.buffer.data() + item.offset;
+            if (memcmp(oldData, newData, item.size) == 0) {
+                continue;
+            }
+            if (!exceedsDeadband(item, oldData, newData)) {
+                // Keep the last reported bytes, so slow drifts are reported eventually
+                continue;
+            }
+            memcpy(last.data() + item.offset, newData, item.size);
+            changed.push_back({&item, newData});
+        }
+    }
+}
+
+bool ChangeDetector::exceedsDeadband(const ReadPlanItem& item, const uint8_t* oldData, const uint8_t* newData) const {
+    if (deadband <= 0.0) {
+        return true;
+    }
+    double oldValue;
+    double newValue;
+    switch (item.type) {
+        case PlcValueType::REAL:
+            oldValue = decodeReal(oldData);
+            newValue = decodeReal(newData);
+            break;
+        case PlcValueType::LREAL:
+            oldValue = decodeLReal(oldData);
+            newValue = decodeLReal(newData);
+            break;
+        default:
+            return true;
+    }
+    // NaN never compares within the deadband, so transitions from and to NaN are reported
+    return !(std::fabs(newValue - oldValue) <= deadband);
+}
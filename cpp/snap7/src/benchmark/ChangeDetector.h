@@ -0,0 +1,69 @@
+#ifndef CHANGE_DETECTOR_H
+#define CHANGE_DETECTOR_H
+
+#include <vector>
+#include <cstdint>
+#include "ReadPlan.h"
+
+/**
+ * An item reported by the ChangeDetector together with its current raw bytes.
+ */
+struct ChangedItem {
+    const ReadPlanItem* item;
+    const uint8_t* data;
+};
+
+/**
+ * Detects which items of a read plan changed since the previous cycle by comparing
+ * the raw read buffers instead of decoded values.
+ *
+ * Each group buffer is first compared as a whole, so an unchanged block costs a single
+ * memcmp. Only if the block differs, the individual items are compared. REAL and LREAL
+ * items can additionally be filtered by a deadband, in which case they are only reported
+ * once they moved more than the deadband away from the last reported value.
+ */
+class ChangeDetector {
+public:
+    /**
+     * Constructor.
+     *
+     * @param deadband Absolute deadband applied to REAL and LREAL items (0 = report every change)
+     */
+    explicit ChangeDetector(double deadband = 0.0);
+
+    /**
+     * Set the deadband applied to REAL and LREAL items.
+     *
+     * @param deadband Absolute deadband (0 = report every change)
+     */
+    void setDeadband(double deadband);
+
+    /**
+     * Forget all previously seen buffers, so the next call to detect reports every item.
+     */
+    void reset();
+
+    /**
+     * Compare the current buffers of the plan with the ones seen in the previous cycle.
+     *
+     * @param plan Read plan whose group buffers have just been filled
+     * @param changed Output vector receiving the items that changed
+     */
+    void detect(const ReadPlan& plan, std::vector<ChangedItem>& changed);
+
+private:
+    double deadband;
+    std::vector<std::vector<uint8_t>> previous; // Last reported bytes per group
+
+    /**
+     * Check if the change of an item is large enough to be reported.
+     *
+     * @param item The item to check
+     * @param oldData Last reported bytes of the group
+     * @param newData Current bytes of the group
+     * @return true if the change exceeds the deadband
+     */
+    bool exceedsDeadband(const ReadPlanItem& item, const uint8_t* oldData, const uint8_t* newData) const;
+};
+
+#endif // CHANGE_DETECTOR_H
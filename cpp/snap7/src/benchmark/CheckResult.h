@@ -0,0 +1,35 @@
+#ifndef CHECK_RESULT_H
+#define CHECK_RESULT_H
+
+#include "../lib/snap7_libmain.h"
+#include <string>
+#include <stdexcept>
+
+/**
+ * Function returning the text of a snap7 error (Cli_ErrorText, Srv_ErrorText or Par_ErrorText).
+ */
+typedef int (S7API *ErrorTextFunction)(int error, char* text, int textLen);
+
+/**
+ * Throw a runtime_error with the text of a snap7 error, if there was one.
+ *
+ * @param result Result of a snap7 call (0 = success)
+ * @param what What was attempted, prefixed to the error text
+ * @param errorText Function describing the error, client errors by default
+ */
+inline void check(int result, const std::string& what, ErrorTextFunction errorText = Cli_ErrorText) {
+    if (result != 0) {
+        char text[1024];
+        errorText(result, text, sizeof(text));
+        throw std::runtime_error(what + ": " + std::string(text));
+    }
+}
+
+/**
+ * Throw a runtime_error with the text of a snap7 partner error, if there was one.
+ */
+inline void checkPartner(int result, const std::string& what) {
+    check(result, what, Par_ErrorText);
+}
+
+#endif // CHECK_RESULT_H
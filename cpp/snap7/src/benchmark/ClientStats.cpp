@@ -0,0 +1,73 @@
+#include "ClientStats.h"
+#include <memory>
+
+namespace {
+
+const char* const operationNames[s7opCount] = {
+    "None", "ReadArea", "WriteArea", "ReadMultiVars", "WriteMultiVars", "DBGet", "Upload", "Download",
+    "Delete", "ListBlocks", "AgBlockInfo", "ListBlocksOfType", "ReadSzlList", "ReadSZL", "GetDateTime",
+    "SetDateTime", "GetOrderCode", "GetCpuInfo", "GetCpInfo", "GetPlcStatus", "PlcHotStart",
+    "PlcColdStart", "CopyRamToRom", "Compress", "PlcStop", "GetProtection", "SetPassword",
+    "ClearPassword", "DBFill"
+};
+
+/**
+ * Upper bound (in microseconds) of the histogram bucket containing the given percentile.
+ */
+uint64_t percentile(const TS7OpStats& stats, int phase, double fraction) {
+    uint64_t target = static_cast<uint64_t>(stats.Calls * fraction + 0.5);
+    uint64_t count = 0;
+    for (int bucket = 0; bucket < s7StatBuckets; bucket++) {
+        count += stats.Histogram[phase][bucket];
+        if (count >= target) {
+            return bucket == s7StatBuckets - 1 ? stats.MaxTime[phase] : (1ULL << bucket);
+        }
+    }
+    return stats.MaxTime[phase];
+}
+
+}
+
+void printClientStats(std::ostream& out, S7Object client) {
+    // Too large for the stack of some platforms
+    auto stats = std::make_unique<TS7ClientStats>();
+    if (Cli_GetStats(client, stats.get()) != 0) {
+        return;
+    }
+    for (int op = 0; op < s7opCount; op++) {
+        const TS7OpStats& opStats = stats->Op[op];
+        if (opStats.Calls == 0) {
+            continue;
+        }
+        out << "  --> " << operationNames[op] << ": " << opStats.Calls << " calls, "
+            << opStats.Errors << " errors, "
+            << opStats.PDUsSent << "/" << opStats.PDUsRecvd << " PDUs ("
+            << opStats.Fragments << " fragments), "
+            << opStats.BytesSent << "/" << opStats.BytesRecvd << " bytes sent/received" << std::endl;
+        out << "      avg us send/wait/recv/decode: "
+            << opStats.Time[s7phSend] / opStats.Calls << "/"
+            << opStats.Time[s7phWait] / opStats.Calls << "/"
+            << opStats.Time[s7phRecv] / opStats.Calls << "/"
+            << opStats.Time[s7phDecode] / opStats.Calls
+            << ", total avg " << opStats.Time[s7phTotal] / opStats.Calls
+            << " us, p99 < " << percentile(opStats, s7phTotal, 0.99)
+            << " us, max " << opStats.MaxTime[s7phTotal] << " us" << std::endl;
+    }
+}
+
+bool sumClientStats(S7Object client, DriverCounters& counters) {
+    auto stats = std::make_unique<TS7ClientStats>();
+    if (Cli_GetStats(client, stats.get()) != 0) {
+        return false;
+    }
+    counters = DriverCounters();
+    for (int op = 0; op < s7opCount; op++) {
+        const TS7OpStats& opStats = stats->Op[op];
+        counters.requests += opStats.Calls;
+        counters.pdusSent += opStats.PDUsSent;
+        counters.pdusRecvd += opStats.PDUsRecvd;
+        counters.bytesSent += opStats.BytesSent;
+        counters.bytesRecvd += opStats.BytesRecvd;
+    }
+    return true;
+}
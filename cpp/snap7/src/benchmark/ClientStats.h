@@ -0,0 +1,27 @@
+#ifndef CLIENT_STATS_H
+#define CLIENT_STATS_H
+
+#include <ostream>
+#include "BaseTest.h"
+#include "../lib/snap7_libmain.h"
+
+/**
+ * Print the per-operation counters of a snap7 client (Cli_GetStats), one line per
+ * operation that has been used: calls, PDUs, bytes on the wire, the average time of
+ * each phase and the 99th percentile of the total time.
+ *
+ * @param out Stream to print to
+ * @param client The snap7 client
+ */
+void printClientStats(std::ostream& out, S7Object client);
+
+/**
+ * Sum the per-operation counters of a snap7 client (Cli_GetStats).
+ *
+ * @param client The snap7 client
+ * @param counters Receives the sums
+ * @return false if the counters couldn't be read
+ */
+bool sumClientStats(S7Object client, DriverCounters& counters);
+
+#endif // CLIENT_STATS_H
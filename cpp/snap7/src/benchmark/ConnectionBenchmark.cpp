@@ -0,0 +1,247 @@
+#include "BenchmarkResults.h"
+#include "CheckResult.h"
+#include "BenchmarkUtils.h"
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <iomanip>
+#include <stdexcept>
+#include <algorithm>
+#include <cstdlib>
+
+/**
+ * Timings of one connect/disconnect cycle (in microseconds).
+ */
+struct ConnectionSample {
+    int64_t tcp;        // TCP connect
+    int64_t iso;        // ISO connection request/confirm
+    int64_t negotiate;  // PDU length negotiation
+    int64_t connect;    // Cli_ConnectTo as seen by the caller
+    int64_t disconnect; // Cli_Disconnect as seen by the caller
+};
+
+/**
+ * Microseconds elapsed since a point in time.
+ */
+int64_t microsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * Print one line of the phase table (times in milliseconds).
+ */
+void printPhase(const std::string& name, const std::vector<int64_t>& samples) {
+    LatencySummary summary = summarize(samples);
+    std::cout << "  " << std::left << std::setw(12) << name << std::right << std::fixed << std::setprecision(3)
+              << std::setw(10) << summary.mean / 1000.0 << std::setw(10) << summary.p50 / 1000.0
+              << std::setw(10) << summary.p90 / 1000.0 << std::setw(10) << summary.p99 / 1000.0
+              << std::setw(10) << summary.max / 1000.0 << std::defaultfloat << std::endl;
+}
+
+/**
+ * Print the header of the phase table.
+ */
+void printHeader() {
+    std::cout << "  " << std::left << std::setw(12) << "ms" << std::right << std::setw(10) << "mean"
+              << std::setw(10) << "p50" << std::setw(10) << "p90" << std::setw(10) << "p99"
+              << std::setw(10) << "max" << std::endl;
+}
+
+/**
+ * Connect a batch of clients one after another or all at once with Cli_ConnectMany
+ * and print the phases of their connections.
+ *
+ * @return The time to connect the whole batch (in microseconds)
+ */
+int64_t connectBatch(const std::vector<S7Object>& clients, bool bulk) {
+    auto start = std::chrono::steady_clock::now();
+    if (bulk) {
+        std::vector<S7Object> batch(clients);
+        check(Cli_ConnectMany(batch.data(), int(batch.size()), nullptr), "Failed to connect to PLC");
+    } else {
+        for (S7Object client : clients) {
+            check(Cli_Connect(client), "Failed to connect to PLC");
+        }
+    }
+    int64_t elapsed = microsSince(start);
+
+    std::vector<int64_t> tcp, iso, negotiate;
+    for (S7Object client : clients) {
+        int tcpTime, isoTime, negotiateTime;
+        Cli_GetConnectTimes(client, tcpTime, isoTime, negotiateTime);
+        tcp.push_back(tcpTime);
+        iso.push_back(isoTime);
+        negotiate.push_back(negotiateTime);
+        Cli_Disconnect(client);
+    }
+    printHeader();
+    printPhase("tcp", tcp);
+    printPhase("iso", iso);
+    printPhase("negotiate", negotiate);
+    std::cout << "  --> " << clients.size() << " clients connected in " << std::fixed << std::setprecision(3)
+              << elapsed / 1000.0 << " ms" << std::defaultfloat << std::endl;
+    return elapsed;
+}
+
+/**
+ * Main function.
+ */
+int main(int argc, char* argv[]) {
+    std::string host = std::getenv("host") ? std::getenv("host") : "192.168.23.30";
+    int remoteRack = std::getenv("remoteRack") ? std::stoi(std::getenv("remoteRack")) : 0;
+    int remoteSlot = std::getenv("remoteSlot") ? std::stoi(std::getenv("remoteSlot")) : 1;
+    int remotePort = 102;
+    int numConnects = 50;
+    int pause = 0;
+    bool reuse = false;
+    int dbNumber = 4;
+    int readSize = 2;
+    int bulk = 0;
+    std::string resultsCsv;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--host" && i + 1 < argc) {
+            host = argv[++i];
+        } else if (arg == "--remoteRack" && i + 1 < argc) {
+            remoteRack = std::stoi(argv[++i]);
+        } else if (arg == "--remoteSlot" && i + 1 < argc) {
+            remoteSlot = std::stoi(argv[++i]);
+        } else if (arg == "--port" && i + 1 < argc) {
+            remotePort = std::stoi(argv[++i]);
+        } else if (arg == "--numConnects" && i + 1 < argc) {
+            numConnects = std::stoi(argv[++i]);
+        } else if (arg == "--pause" && i + 1 < argc) {
+            pause = std::stoi(argv[++i]);
+        } else if (arg == "--reuse") {
+            reuse = true;
+        } else if (arg == "--db" && i + 1 < argc) {
+            dbNumber = std::stoi(argv[++i]);
+        } else if (arg == "--readSize" && i + 1 < argc) {
+            readSize = std::stoi(argv[++i]);
+        } else if (arg == "--bulk" && i + 1 < argc) {
+            bulk = std::stoi(argv[++i]);
+        } else if (arg == "--resultsCsv" && i + 1 < argc) {
+            resultsCsv = argv[++i];
+        }
+    }
+
+    std::cout << "Scenario: " << numConnects << " connections to " << host << ", " << pause
+              << "ms pause" << std::endl << std::endl;
+
+    S7Object client = Cli_Create();
+    uint16_t port = uint16_t(remotePort);
+    Cli_SetParam(client, p_u16_RemotePort, &port);
+    std::vector<S7Object> batch;
+    std::vector<ConnectionSample> samples;
+    std::vector<uint8_t> buffer(readSize);
+    try {
+        // Connect, negotiate and disconnect over and over
+        std::cout << "Running: 'Connect'" << std::endl;
+        for (int i = 0; i < numConnects; i++) {
+            ConnectionSample sample{};
+            auto start = std::chrono::steady_clock::now();
+            check(Cli_ConnectTo(client, host.c_str(), remoteRack, remoteSlot), "Failed to connect to PLC");
+            sample.connect = microsSince(start);
+            int tcp, iso, negotiate;
+            Cli_GetConnectTimes(client, tcp, iso, negotiate);
+            sample.tcp = tcp;
+            sample.iso = iso;
+            sample.negotiate = negotiate;
+
+            start = std::chrono::steady_clock::now();
+            Cli_Disconnect(client);
+            sample.disconnect = microsSince(start);
+            samples.push_back(sample);
+
+            if (pause > 0) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(pause));
+            }
+        }
+
+        std::vector<int64_t> tcp, iso, negotiate, connect, disconnect;
+        for (const auto& sample : samples) {
+            tcp.push_back(sample.tcp);
+            iso.push_back(sample.iso);
+            negotiate.push_back(sample.negotiate);
+            connect.push_back(sample.connect);
+            disconnect.push_back(sample.disconnect);
+        }
+        printHeader();
+        printPhase("tcp", tcp);
+        printPhase("iso", iso);
+        printPhase("negotiate", negotiate);
+        printPhase("connect", connect);
+        printPhase("disconnect", disconnect);
+
+        // Cost of a read on an open connection vs. one that needs a new connection first
+        if (reuse) {
+            std::cout << "Running: 'Reuse'" << std::endl;
+            std::vector<int64_t> reused, reconnected;
+            check(Cli_ConnectTo(client, host.c_str(), remoteRack, remoteSlot), "Failed to connect to PLC");
+            for (int i = 0; i < numConnects; i++) {
+                auto start = std::chrono::steady_clock::now();
+                check(Cli_DBRead(client, dbNumber, 0, readSize, buffer.data()), "Failed to read from PLC");
+                reused.push_back(microsSince(start));
+            }
+            Cli_Disconnect(client);
+            for (int i = 0; i < numConnects; i++) {
+                auto start = std::chrono::steady_clock::now();
+                check(Cli_ConnectTo(client, host.c_str(), remoteRack, remoteSlot), "Failed to connect to PLC");
+                check(Cli_DBRead(client, dbNumber, 0, readSize, buffer.data()), "Failed to read from PLC");
+                Cli_Disconnect(client);
+                reconnected.push_back(microsSince(start));
+            }
+            printHeader();
+            printPhase("reuse", reused);
+            printPhase("reconnect", reconnected);
+            double ratio = summarize(reconnected).mean / std::max(summarize(reused).mean, 1.0);
+            std::cout << "  --> " << std::fixed << std::setprecision(1) << ratio
+                      << "x the time of a read on an open connection" << std::defaultfloat << std::endl;
+        }
+
+        // Cold start of many connections: one after another vs. all at once
+        if (bulk > 0) {
+            word remoteTsap = word((CONNTYPE_PG << 8) + remoteRack * 0x20 + remoteSlot);
+            for (int i = 0; i < bulk; i++) {
+                S7Object batchClient = Cli_Create();
+                batch.push_back(batchClient);
+                Cli_SetParam(batchClient, p_u16_RemotePort, &port);
+                Cli_SetConnectionParams(batchClient, host.c_str(), 0x0100, remoteTsap);
+            }
+            std::cout << "Running: 'Sequential'" << std::endl;
+            int64_t sequential = connectBatch(batch, false);
+            std::cout << "Running: 'Bulk'" << std::endl;
+            int64_t parallel = connectBatch(batch, true);
+            std::cout << "  --> " << std::fixed << std::setprecision(1)
+                      << double(sequential) / std::max(double(parallel), 1.0)
+                      << "x faster than one after another" << std::defaultfloat << std::endl;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        for (S7Object batchClient : batch) {
+            Cli_Destroy(batchClient);
+        }
+        Cli_Destroy(client);
+        return 1;
+    }
+    for (S7Object batchClient : batch) {
+        Cli_Destroy(batchClient);
+    }
+    Cli_Destroy(client);
+
+    if (!resultsCsv.empty()) {
+        size_t connection = 0;
+        if (!writeSamplesCsv(resultsCsv, "connection,tcpUs,isoUs,negotiateUs,connectUs,disconnectUs", samples,
+                             [&connection](std::ostream& out, const ConnectionSample& sample) {
+                                 out << connection++ << "," << sample.tcp << "," << sample.iso << ","
+                                     << sample.negotiate << "," << sample.connect << "," << sample.disconnect;
+                             })) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,123 @@
+#include "BenchmarkResults.h"
+#include "BenchmarkUtils.h"
+#include "../lib/snap7_libmain.h"
+#include "snap_sync.h"
+#include <iostream>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <iomanip>
+#include <cstdint>
+
+/**
+ * Latencies of one hand-off scenario.
+ */
+struct HandoffResult {
+    std::string name;
+    LatencySummary latency;
+};
+
+/**
+ * Round trips between the caller and a worker thread through two auto reset events,
+ * the way TSnap7Client hands a job to TClientThread (EvtJob) and waits for it (EvtComplete).
+ */
+template <typename Event>
+std::vector<int64_t> pingPong(int cycles) {
+    Event job(false);
+    Event complete(false);
+    std::atomic<bool> stop{false};
+    std::thread worker([&]() {
+        for (;;) {
+            job.WaitForever();
+            if (stop) {
+                break;
+            }
+            complete.Set();
+        }
+    });
+    std::vector<int64_t> latencies;
+    latencies.reserve(cycles);
+    for (int i = 0; i < cycles; i++) {
+        int64_t start = nowNanos();
+        job.Set();
+        complete.WaitFor(5000);
+        latencies.push_back(nowNanos() - start);
+    }
+    stop = true;
+    job.Set();
+    worker.join();
+    return latencies;
+}
+
+/**
+ * Asynchronous jobs of a client that isn't connected: the job fails as soon as the worker
+ * runs it, so the time from Cli_AsDBRead to the end of Cli_WaitAsCompletion is the hand-off
+ * to TClientThread and back.
+ */
+std::vector<int64_t> clientJobs(int cycles) {
+    S7Object client = Cli_Create();
+    std::vector<uint8_t> buffer(16);
+    std::vector<int64_t> latencies;
+    latencies.reserve(cycles);
+    for (int i = 0; i < cycles; i++) {
+        int64_t start = nowNanos();
+        Cli_AsDBRead(client, 1, 0, int(buffer.size()), buffer.data());
+        Cli_WaitAsCompletion(client, 5000);
+        latencies.push_back(nowNanos() - start);
+    }
+    Cli_Destroy(client);
+    return latencies;
+}
+
+/**
+ * Print one row of the results table, in microseconds.
+ */
+void printRow(const HandoffResult& result) {
+    std::cout << "  " << std::left << std::setw(24) << result.name << std::right << std::fixed
+              << std::setprecision(2) << std::setw(10) << result.latency.mean / 1000.0 << std::setw(10)
+              << result.latency.p50 / 1000.0 << std::setw(10) << result.latency.p99 / 1000.0 << std::setw(10)
+              << result.latency.max / 1000.0 << std::defaultfloat << std::endl;
+}
+
+/**
+ * Main function.
+ */
+int main(int argc, char* argv[]) {
+    int cycles = 20000;
+    std::string resultsCsv;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--cycles" && i + 1 < argc) {
+            cycles = std::stoi(argv[++i]);
+        } else if (arg == "--resultsCsv" && i + 1 < argc) {
+            resultsCsv = argv[++i];
+        }
+    }
+
+    std::cout << "Scenario: " << cycles << " round trips per test, " << std::thread::hardware_concurrency()
+              << " CPUs" << std::endl << std::endl;
+
+    std::vector<HandoffResult> results;
+    std::cout << "Running: 'Hand-off'" << std::endl;
+    std::cout << "  " << std::left << std::setw(24) << "us" << std::right << std::setw(10) << "mean"
+              << std::setw(10) << "p50" << std::setw(10) << "p99" << std::setw(10) << "max" << std::endl;
+    results.push_back({"TSnapEvent", summarize(pingPong<TSnapEvent>(cycles))});
+    printRow(results.back());
+    results.push_back({"TSnapLightEvent", summarize(pingPong<TSnapLightEvent>(cycles))});
+    printRow(results.back());
+    results.push_back({"client job", summarize(clientJobs(cycles))});
+    printRow(results.back());
+
+    if (!resultsCsv.empty() &&
+        !writeSamplesCsv(resultsCsv, "test,meanNs,p50Ns,p99Ns,maxNs", results,
+                         [](std::ostream& out, const HandoffResult& result) {
+                             out << result.name << "," << result.latency.mean << "," << result.latency.p50 << ","
+                                 << result.latency.p99 << "," << result.latency.max;
+                         })) {
+        return 1;
+    }
+    return 0;
+}
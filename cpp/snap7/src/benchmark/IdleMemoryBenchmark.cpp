@@ -0,0 +1,199 @@
+#include "CheckResult.h"
+#include "BenchmarkUtils.h"
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <iomanip>
+#include <stdexcept>
+#include <cstdint>
+#include <csignal>
+#if defined(__unix__)
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+/**
+ * Resident memory and threads of the server with a number of idle connections.
+ */
+struct MemorySample {
+    int connections;
+    int64_t residentKb;
+    int threads;
+};
+
+#if defined(__unix__)
+/**
+ * Read the resident set and the threads of a process from /proc/<pid>/status.
+ */
+MemorySample processMemory(pid_t pid, int connections) {
+    MemorySample sample{connections, 0, 0};
+    std::ifstream status("/proc/" + std::to_string(pid) + "/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.compare(0, 6, "VmRSS:") == 0) {
+            sample.residentKb = std::stoll(line.substr(6));
+        } else if (line.compare(0, 8, "Threads:") == 0) {
+            sample.threads = std::stoi(line.substr(8));
+        }
+    }
+    return sample;
+}
+
+/**
+ * Raise the open files limit to the hard limit, every connection needs a descriptor.
+ */
+void raiseFileLimit() {
+    rlimit limit{};
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+}
+
+/**
+ * Body of the server process: serve one DB until killed. Writes one byte to ready once
+ * listening (or closes it without writing if the server didn't start).
+ */
+void serve(const std::string& address, int port, int ready) {
+    std::vector<uint8_t> db(1024);
+    S7Object server = Srv_Create();
+    uint16_t localPort = uint16_t(port);
+    Srv_SetParam(server, p_u16_LocalPort, &localPort);
+    Srv_RegisterArea(server, srvAreaDB, 1, db.data(), int(db.size()));
+    if (Srv_StartTo(server, address.c_str()) == 0) {
+        char started = 1;
+        if (write(ready, &started, 1) == 1) {
+            for (;;) {
+                pause();
+            }
+        }
+    }
+    _exit(1);
+}
+#endif
+
+/**
+ * Resident memory of a server per idle connection: the server runs in a child process
+ * so that only its memory is measured, the clients connect in steps, read the CPU info
+ * and a DB once (as an HMI would, so that the request path has been used) and then
+ * stay idle.
+ */
+int main(int argc, char* argv[]) {
+    std::string address = "127.0.0.1";
+    int port = 1102;
+    std::string steps = "0,250,500,1000";
+    bool read = true;
+    int settle = 500;
+    std::string resultsCsv;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--address" && i + 1 < argc) {
+            address = argv[++i];
+        } else if (arg == "--port" && i + 1 < argc) {
+            port = std::stoi(argv[++i]);
+        } else if (arg == "--connections" && i + 1 < argc) {
+            steps = argv[++i];
+        } else if (arg == "--noRead") {
+            read = false;
+        } else if (arg == "--settle" && i + 1 < argc) {
+            settle = std::stoi(argv[++i]);
+        } else if (arg == "--resultsCsv" && i + 1 < argc) {
+            resultsCsv = argv[++i];
+        }
+    }
+
+#if defined(__unix__)
+    std::vector<int> counts = parseList(steps);
+    std::cout << "Scenario: server on " << address << ":" << port << ", " << steps << " idle connections"
+              << (read ? ", one SZL and one DB read each" : "") << std::endl << std::endl;
+
+    raiseFileLimit();
+    int pipeFds[2];
+    if (pipe(pipeFds) != 0) {
+        std::cerr << "Failed to create a pipe" << std::endl;
+        return 1;
+    }
+    pid_t server = fork();
+    if (server == 0) {
+        close(pipeFds[0]);
+        serve(address, port, pipeFds[1]);
+    }
+    close(pipeFds[1]);
+    char started = 0;
+    if (server < 0 || ::read(pipeFds[0], &started, 1) != 1) {
+        std::cerr << "Failed to start the server on " << address << ":" << port << std::endl;
+        if (server > 0) {
+            waitpid(server, nullptr, 0);
+        }
+        return 1;
+    }
+    close(pipeFds[0]);
+
+    std::vector<S7Object> clients;
+    std::vector<MemorySample> samples;
+    std::vector<uint8_t> buffer(2);
+    uint16_t remotePort = uint16_t(port);
+    int exitCode = 0;
+    try {
+        std::cout << "Running: 'Idle connections'" << std::endl;
+        std::cout << "  " << std::left << std::setw(12) << "connections" << std::right << std::setw(12) << "RSS KB"
+                  << std::setw(10) << "threads" << std::setw(14) << "KB/connection" << std::endl;
+        for (int count : counts) {
+            std::vector<S7Object> batch;
+            while (int(clients.size() + batch.size()) < count) {
+                S7Object client = Cli_Create();
+                batch.push_back(client);
+                Cli_SetParam(client, p_u16_RemotePort, &remotePort);
+                Cli_SetConnectionParams(client, address.c_str(), 0x0100, 0x0101);
+            }
+            clients.insert(clients.end(), batch.begin(), batch.end());
+            if (!batch.empty()) {
+                check(Cli_ConnectMany(batch.data(), int(batch.size()), nullptr), "Failed to connect to the server");
+                if (read) {
+                    for (S7Object client : batch) {
+                        TS7CpuInfo info;
+                        check(Cli_GetCpuInfo(client, &info), "Failed to read the CPU info");
+                        check(Cli_DBRead(client, 1, 0, int(buffer.size()), buffer.data()), "Failed to read from the server");
+                    }
+                }
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(settle));
+
+            MemorySample sample = processMemory(server, int(clients.size()));
+            samples.push_back(sample);
+            std::cout << "  " << std::left << std::setw(12) << sample.connections << std::right << std::setw(12)
+                      << sample.residentKb << std::setw(10) << sample.threads;
+            if (sample.connections > samples.front().connections) {
+                double perConnection = double(sample.residentKb - samples.front().residentKb) /
+                                       (sample.connections - samples.front().connections);
+                std::cout << std::setw(14) << std::fixed << std::setprecision(1) << perConnection << std::defaultfloat;
+            }
+            std::cout << std::endl;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        exitCode = 1;
+    }
+    for (S7Object client : clients) {
+        Cli_Destroy(client);
+    }
+    kill(server, SIGTERM);
+    waitpid(server, nullptr, 0);
+
+    if (exitCode == 0 && !resultsCsv.empty() &&
+        !writeSamplesCsv(resultsCsv, "connections,residentKb,threads", samples,
+                         [](std::ostream& out, const MemorySample& sample) {
+                             out << sample.connections << "," << sample.residentKb << "," << sample.threads;
+                         })) {
+        return 1;
+    }
+    return exitCode;
+#else
+    std::cerr << "The idle memory benchmark needs /proc (Linux)" << std::endl;
+    return 1;
+#endif
+}
@@ -0,0 +1,134 @@
+#include "../lib/snap7_libmain.h"
+#include <iostream>
+#include <string>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <csignal>
+
+std::atomic<bool> stopRequested(false);
+
+/**
+ * Stop the proxy on Ctrl+C.
+ */
+void onSignal(int) {
+    stopRequested = true;
+}
+
+/**
+ * Convert a time in (fractional) milliseconds to microseconds.
+ */
+longword toMicros(const std::string& milliseconds) {
+    return static_cast<longword>(std::stod(milliseconds) * 1000.0);
+}
+
+/**
+ * Main function: forward the connections made to address:port to the target, impairing the
+ * traffic in one or both directions, until interrupted or until the duration elapsed.
+ *
+ * The snap7 client always connects to port 102, so the proxy listens on a different local
+ * address by default (point the benchmark to --host 127.0.0.2).
+ */
+int main(int argc, char* argv[]) {
+    std::string address = "127.0.0.2";
+    int port = 102;
+    std::string target = "127.0.0.1";
+    int targetPort = 102;
+    std::string direction = "both";
+    std::string jitterKind = "uniform";
+    longword seed = 1;
+    int duration = 0;
+    TProxyImpairment impairment = {};
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--address" && i + 1 < argc) {
+            address = argv[++i];
+        } else if (arg == "--port" && i + 1 < argc) {
+            port = std::stoi(argv[++i]);
+        } else if (arg == "--target" && i + 1 < argc) {
+            target = argv[++i];
+        } else if (arg == "--targetPort" && i + 1 < argc) {
+            targetPort = std::stoi(argv[++i]);
+        } else if (arg == "--direction" && i + 1 < argc) {
+            direction = argv[++i];
+        } else if (arg == "--delay" && i + 1 < argc) {
+            impairment.Delay = toMicros(argv[++i]);
+        } else if (arg == "--jitter" && i + 1 < argc) {
+            impairment.Jitter = toMicros(argv[++i]);
+        } else if (arg == "--jitterKind" && i + 1 < argc) {
+            jitterKind = argv[++i];
+        } else if (arg == "--bandwidth" && i + 1 < argc) {
+            impairment.Bandwidth = static_cast<longword>(std::stoul(argv[++i]));
+        } else if (arg == "--segmentSize" && i + 1 < argc) {
+            impairment.SegmentSize = std::stoi(argv[++i]);
+        } else if (arg == "--segmentGap" && i + 1 < argc) {
+            impairment.SegmentGap = toMicros(argv[++i]);
+        } else if (arg == "--stallPermille" && i + 1 < argc) {
+            impairment.StallPermille = std::stoi(argv[++i]);
+        } else if (arg == "--stallTime" && i + 1 < argc) {
+            impairment.StallTime = toMicros(argv[++i]);
+        } else if (arg == "--seed" && i + 1 < argc) {
+            seed = static_cast<longword>(std::stoul(argv[++i]));
+        } else if (arg == "--duration" && i + 1 < argc) {
+            duration = std::stoi(argv[++i]);
+        }
+    }
+    if (jitterKind == "uniform") {
+        impairment.JitterKind = prxJitterUniform;
+    } else if (jitterKind == "normal") {
+        impairment.JitterKind = prxJitterNormal;
+    } else if (jitterKind == "pareto") {
+        impairment.JitterKind = prxJitterPareto;
+    } else {
+        std::cerr << "Unknown jitter kind: " << jitterKind << " (expected uniform, normal or pareto)" << std::endl;
+        return 1;
+    }
+    if (direction != "both" && direction != "toServer" && direction != "toClient") {
+        std::cerr << "Unknown direction: " << direction << " (expected both, toServer or toClient)" << std::endl;
+        return 1;
+    }
+
+    char errorText[1024];
+    S7Object proxy = Prx_Create();
+    int result = Prx_SetSeed(proxy, seed);
+    if (result == 0 && direction != "toClient") {
+        result = Prx_SetImpairment(proxy, prxToServer, &impairment);
+    }
+    if (result == 0 && direction != "toServer") {
+        result = Prx_SetImpairment(proxy, prxToClient, &impairment);
+    }
+    if (result == 0) {
+        result = Prx_StartTo(proxy, address.c_str(), static_cast<word>(port), target.c_str(),
+                             static_cast<word>(targetPort));
+    }
+    if (result != 0) {
+        Srv_ErrorText(result, errorText, sizeof(errorText));
+        std::cerr << "Failed to start proxy: " << errorText << std::endl;
+        Prx_Destroy(proxy);
+        return 1;
+    }
+
+    std::cout << "Forwarding " << address << ":" << port << " to " << target << ":" << targetPort << " ("
+              << direction << "): " << impairment.Delay / 1000.0 << " ms delay, " << impairment.Jitter / 1000.0
+              << " ms " << jitterKind << " jitter, "
+              << (impairment.Bandwidth ? std::to_string(impairment.Bandwidth) + " bytes/s" : "unlimited")
+              << ", stall " << impairment.StallPermille << "/1000 for " << impairment.StallTime / 1000.0 << " ms"
+              << std::endl;
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+    auto startTime = std::chrono::steady_clock::now();
+    while (!stopRequested) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        if (duration > 0 && std::chrono::steady_clock::now() - startTime >= std::chrono::seconds(duration)) {
+            break;
+        }
+    }
+
+    longword chunks, stalls;
+    Prx_Stop(proxy);
+    Prx_GetStats(proxy, chunks, stalls);
+    Prx_Destroy(proxy);
+    std::cout << "  --> " << chunks << " chunks forwarded, " << stalls << " stalled" << std::endl;
+    return 0;
+}
@@ -0,0 +1,234 @@
+#include "BenchmarkResults.h"
+#include "CheckResult.h"
+#include "BenchmarkUtils.h"
+#include <iostream>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <iomanip>
+#include <stdexcept>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+
+/**
+ * Latencies of the asynchronous reads of one thread configuration.
+ */
+struct JitterResult {
+    std::string config;
+    LatencySummary latency;
+    int started;
+    int errors;
+};
+
+/**
+ * Completion of the pending asynchronous read, set by the client worker thread.
+ */
+struct PendingRead {
+    std::atomic<int64_t> completedAt{0};
+    std::atomic<int> result{0};
+};
+
+/**
+ * Called by the client worker thread when an asynchronous job completes.
+ */
+void S7API onCompletion(void* usrPtr, int, int opResult) {
+    PendingRead* pending = static_cast<PendingRead*>(usrPtr);
+    pending->result = opResult;
+    pending->completedAt = nowMicros();
+}
+
+/**
+ * Thread configuration of a named scenario: "default" leaves the system settings,
+ * "pinned" pins the threads to one CPU, "fifo" runs them SCHED_FIFO, "pinned-fifo" both.
+ */
+TSnapThreadConfig threadConfig(const std::string& name, int cpu, int priority) {
+    TSnapThreadConfig config;
+    memset(&config, 0, sizeof(config));
+    if (name == "pinned" || name == "pinned-fifo") {
+        config.AffinityMask = uint64_t(1) << cpu;
+    }
+    if (name == "fifo" || name == "pinned-fifo") {
+        config.Policy = thrPolicyFifo;
+        config.Priority = priority;
+    }
+    if (name != "default" && name != "pinned" && name != "fifo" && name != "pinned-fifo") {
+        throw std::runtime_error("Unknown configuration: " + name + " (expected default, pinned, fifo or pinned-fifo)");
+    }
+    return config;
+}
+
+/**
+ * Poll a DB with asynchronous reads at a fixed period while busy threads compete for the
+ * CPUs, with the client worker and the server workers in the given configuration.
+ * The latency of a read goes from the request to its completion callback, so it only
+ * depends on the snap7 threads (and the network stack), not on the polling thread.
+ */
+JitterResult runConfig(const std::string& name, const std::string& address, int port, int cycles, int period,
+                       int load, int cpu, int priority) {
+    JitterResult result{name, {}, 0, 0};
+    TSnapThreadConfig config = threadConfig(name, cpu, priority);
+    check(Thr_SetConfig(thrClientWorker, &config), "Failed to configure the client threads");
+    check(Thr_SetConfig(thrServerWorker, &config), "Failed to configure the server threads");
+
+    // The threads started from now on (server workers, client worker) get the configuration
+    std::vector<uint8_t> db(64);
+    S7Object server = Srv_Create();
+    uint16_t localPort = uint16_t(port);
+    Srv_SetParam(server, p_u16_LocalPort, &localPort);
+    Srv_RegisterArea(server, srvAreaDB, 1, db.data(), int(db.size()));
+    S7Object client = 0;
+
+    std::atomic<bool> stop{false};
+    std::vector<std::thread> busy;
+    std::vector<int64_t> latencies;
+    PendingRead pending;
+    std::vector<uint8_t> buffer(16);
+    try {
+        check(Srv_StartTo(server, address.c_str()), "Failed to start the server", Srv_ErrorText);
+        client = Cli_Create();
+        Cli_SetParam(client, p_u16_RemotePort, &localPort);
+        check(Cli_ConnectTo(client, address.c_str(), 0, 1), "Failed to connect to the server");
+        Cli_SetAsCallback(client, onCompletion, &pending);
+
+        // Competing work (historian, UI, ...)
+        for (int i = 0; i < load; i++) {
+            busy.emplace_back([&stop]() {
+                volatile uint64_t spin = 0;
+                while (!stop.load(std::memory_order_relaxed)) {
+                    spin = spin + 1;
+                }
+            });
+        }
+
+        auto next = std::chrono::steady_clock::now();
+        for (int i = 0; i < cycles; i++) {
+            next += std::chrono::milliseconds(period);
+            std::this_thread::sleep_until(next);
+            pending.completedAt = 0;
+            int64_t start = nowMicros();
+            check(Cli_AsDBRead(client, 1, 0, int(buffer.size()), buffer.data()), "Failed to start a read");
+            check(Cli_WaitAsCompletion(client, 5000), "Failed to read from the server");
+            // The waiter may be woken before the callback returns
+            while (pending.completedAt == 0) {
+                std::this_thread::yield();
+            }
+            latencies.push_back(pending.completedAt - start);
+        }
+    } catch (...) {
+        stop = true;
+        for (auto& thread : busy) {
+            thread.join();
+        }
+        if (client) {
+            Cli_Destroy(client);
+        }
+        Srv_Destroy(server);
+        throw;
+    }
+    stop = true;
+    for (auto& thread : busy) {
+        thread.join();
+    }
+    Cli_Destroy(client);
+    Srv_Destroy(server);
+
+    int started = 0, errors = 0;
+    Thr_GetStats(thrClientWorker, started, errors);
+    result.started += started;
+    result.errors += errors;
+    Thr_GetStats(thrServerWorker, started, errors);
+    result.started += started;
+    result.errors += errors;
+    result.latency = summarize(latencies);
+    return result;
+}
+
+/**
+ * Main function.
+ */
+int main(int argc, char* argv[]) {
+    std::string address = "127.0.0.1";
+    int port = 1102;
+    int cycles = 500;
+    int period = 10;
+    int load = int(std::thread::hardware_concurrency());
+    // The affinity mask reaches CPU 63
+    int cpu = std::min(load > 0 ? load - 1 : 0, 63);
+    int priority = 50;
+    std::string configs = "default,pinned,fifo,pinned-fifo";
+    std::string resultsCsv;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--address" && i + 1 < argc) {
+            address = argv[++i];
+        } else if (arg == "--port" && i + 1 < argc) {
+            port = std::stoi(argv[++i]);
+        } else if (arg == "--cycles" && i + 1 < argc) {
+            cycles = std::stoi(argv[++i]);
+        } else if (arg == "--period" && i + 1 < argc) {
+            period = std::stoi(argv[++i]);
+        } else if (arg == "--load" && i + 1 < argc) {
+            load = std::stoi(argv[++i]);
+        } else if (arg == "--cpu" && i + 1 < argc) {
+            cpu = std::stoi(argv[++i]);
+        } else if (arg == "--priority" && i + 1 < argc) {
+            priority = std::stoi(argv[++i]);
+        } else if (arg == "--configs" && i + 1 < argc) {
+            configs = argv[++i];
+        } else if (arg == "--resultsCsv" && i + 1 < argc) {
+            resultsCsv = argv[++i];
+        }
+    }
+
+    if (cpu < 0 || cpu > 63) {
+        std::cerr << "The pinned threads need a CPU from 0 to 63, got " << cpu << std::endl;
+        return 1;
+    }
+
+    std::cout << "Scenario: " << cycles << " asynchronous reads every " << period << "ms from " << address << ":"
+              << port << ", " << load << " busy threads, CPU " << cpu << " for the pinned threads" << std::endl
+              << std::endl;
+
+    std::vector<JitterResult> results;
+    try {
+        for (const std::string& name : splitList(configs)) {
+            std::cout << "Running: '" << name << "'" << std::endl;
+            JitterResult result = runConfig(name, address, port, cycles, period, load, cpu, priority);
+            results.push_back(result);
+            std::cout << "  " << std::left << std::setw(12) << "ms" << std::right << std::setw(10) << "mean"
+                      << std::setw(10) << "p50" << std::setw(10) << "p99" << std::setw(10) << "max"
+                      << std::setw(10) << "stddev" << std::endl;
+            std::cout << "  " << std::left << std::setw(12) << "read" << std::right << std::fixed
+                      << std::setprecision(3) << std::setw(10) << result.latency.mean / 1000.0 << std::setw(10)
+                      << result.latency.p50 / 1000.0 << std::setw(10) << result.latency.p99 / 1000.0
+                      << std::setw(10) << result.latency.max / 1000.0 << std::setw(10)
+                      << result.latency.stddev / 1000.0 << std::defaultfloat << std::endl;
+            std::cout << "  --> " << result.started << " snap7 threads configured, " << result.errors
+                      << " couldn't apply the configuration" << std::endl;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    // Leave the defaults to the threads started afterwards
+    TSnapThreadConfig defaults;
+    memset(&defaults, 0, sizeof(defaults));
+    Thr_SetConfig(thrClientWorker, &defaults);
+    Thr_SetConfig(thrServerWorker, &defaults);
+
+    if (!resultsCsv.empty() &&
+        !writeSamplesCsv(resultsCsv, "config,meanUs,p50Us,p99Us,maxUs,stddevUs,threads,errors", results,
+                         [](std::ostream& out, const JitterResult& result) {
+                             out << result.config << "," << result.latency.mean << "," << result.latency.p50 << ","
+                                 << result.latency.p99 << "," << result.latency.max << ","
+                                 << result.latency.stddev << "," << result.started << "," << result.errors;
+                         })) {
+        return 1;
+    }
+    return 0;
+}
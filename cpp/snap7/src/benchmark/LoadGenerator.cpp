@@ -0,0 +1,152 @@
+#include "LoadGenerator.h"
+#include "BenchmarkResults.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <stdexcept>
+#include <thread>
+
+int LoadStepResult::totalReads() const {
+    int reads = 0;
+    for (const auto& client : clients) {
+        reads += client.numReads;
+    }
+    return reads;
+}
+
+double LoadStepResult::readsPerSecond() const {
+    return seconds > 0.0 ? totalReads() / seconds : 0.0;
+}
+
+double LoadStepResult::valuesPerSecond() const {
+    double values = 0.0;
+    for (const auto& client : clients) {
+        values += static_cast<double>(client.numReads) * client.numTags;
+    }
+    return seconds > 0.0 ? values / seconds : 0.0;
+}
+
+LoadGenerator::LoadGenerator(TestFactory factory, const std::map<std::string, std::string>& tagValues,
+                             int numCycles, int cycleTime, bool fixedRate)
+    : factory(std::move(factory)), tagValues(tagValues), numCycles(numCycles), cycleTime(cycleTime),
+      fixedRate(fixedRate) {
+    // The tags are split between the clients, each one needs at least one
+    if (this->tagValues.empty()) {
+        throw std::invalid_argument("The load test needs at least one tag");
+    }
+}
+
+std::map<std::string, std::string> LoadGenerator::tagsOfClient(int client, int numClients) const {
+    int groups = std::min(numClients, static_cast<int>(tagValues.size()));
+    std::map<std::string, std::string> tags;
+    int index = 0;
+    for (const auto& [address, value] : tagValues) {
+        if (index++ % groups == client % groups) {
+            tags[address] = value;
+        }
+    }
+    return tags;
+}
+
+LoadStepResult LoadGenerator::runStep(int numClients) {
+    LoadStepResult step;
+    step.numClients = numClients;
+    step.clients.resize(numClients);
+
+    std::vector<std::thread> threads;
+    auto startTime = std::chrono::steady_clock::now();
+    for (int client = 0; client < numClients; client++) {
+        LoadClientResult& result = step.clients[client];
+        result.client = client;
+        std::map<std::string, std::string> tags = tagsOfClient(client, numClients);
+        result.numTags = static_cast<int>(tags.size());
+        threads.emplace_back([this, &result, tags]() {
+            try {
+                std::unique_ptr<BaseTest> test = factory();
+                test->setFixedRate(fixedRate);
+                TestResults testResults = test->run(numCycles, cycleTime, tags);
+                result.numReads = testResults.numReadCycles;
+                result.latencies = fixedRate ? testResults.cycleLatencies : testResults.readLatencies;
+                result.missedDeadlines = testResults.missedDeadlines;
+            } catch (const std::exception& e) {
+                result.error = e.what();
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    auto endTime = std::chrono::steady_clock::now();
+    step.seconds = std::chrono::duration<double>(endTime - startTime).count();
+    return step;
+}
+
+void LoadGenerator::run(int maxClients, bool ramp, std::ostream& out) {
+    std::vector<int> steps;
+    if (ramp) {
+        for (int numClients = 1; numClients < maxClients; numClients *= 2) {
+            steps.push_back(numClients);
+        }
+    }
+    steps.push_back(maxClients);
+
+    std::vector<LoadStepResult> results;
+    for (int numClients : steps) {
+        out << "Running: '" << numClients << " clients'" << std::endl;
+        results.push_back(runStep(numClients));
+        printStep(results.back(), out);
+    }
+
+    if (results.size() > 1) {
+        // The knee is the smallest number of clients reaching 95% of the peak throughput
+        double peak = 0.0;
+        for (const auto& step : results) {
+            peak = std::max(peak, step.readsPerSecond());
+        }
+        for (const auto& step : results) {
+            if (step.readsPerSecond() >= 0.95 * peak) {
+                out << "Knee: " << step.numClients << " clients (" << static_cast<int64_t>(step.readsPerSecond())
+                    << " reads/s, peak " << static_cast<int64_t>(peak) << " reads/s)" << std::endl;
+                break;
+            }
+        }
+    }
+}
+
+void LoadGenerator::printStep(const LoadStepResult& step, std::ostream& out) const {
+    std::vector<int64_t> all;
+    int missedDeadlines = 0;
+    int failedClients = 0;
+    for (const auto& client : step.clients) {
+        std::vector<int64_t> sorted = client.latencies;
+        std::sort(sorted.begin(), sorted.end());
+        all.insert(all.end(), sorted.begin(), sorted.end());
+        missedDeadlines += client.missedDeadlines;
+
+        out << "    client " << std::setw(2) << client.client << ": " << client.numTags << " tags, ";
+        if (!client.error.empty()) {
+            failedClients++;
+            out << "failed: " << client.error << std::endl;
+            continue;
+        }
+        out << std::fixed << std::setprecision(2)
+            << client.numReads / step.seconds << " reads/s, "
+            << percentile(sorted, 0.5) / 1000.0 << " ms p50, " << percentile(sorted, 0.99) / 1000.0 << " ms p99"
+            << std::defaultfloat << std::endl;
+    }
+    std::sort(all.begin(), all.end());
+
+    out << "  --> " << static_cast<int64_t>(step.readsPerSecond()) << " reads/s, "
+        << static_cast<int64_t>(step.valuesPerSecond()) << " values/s, "
+        << std::fixed << std::setprecision(2)
+        << percentile(all, 0.5) / 1000.0 << " ms p50, " << percentile(all, 0.99) / 1000.0 << " ms p99, "
+        << percentile(all, 1.0) / 1000.0 << " ms max latency" << std::defaultfloat << std::endl;
+    if (fixedRate) {
+        out << "  --> " << missedDeadlines << " of " << all.size() << " cycles missed their "
+            << cycleTime << " ms deadline" << std::endl;
+    }
+    if (failedClients > 0) {
+        out << "  --> " << failedClients << " of " << step.numClients << " clients failed" << std::endl;
+    }
+}
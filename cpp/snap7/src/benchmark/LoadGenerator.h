@@ -0,0 +1,99 @@
+#ifndef LOAD_GENERATOR_H
+#define LOAD_GENERATOR_H
+
+#include <string>
+#include <map>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <ostream>
+#include <cstdint>
+#include "BaseTest.h"
+
+/**
+ * Result of one client of a load step.
+ */
+struct LoadClientResult {
+    int client;
+    int numTags;                    // Number of tags read by the client
+    int numReads = 0;               // Number of completed read cycles
+    std::vector<int64_t> latencies; // Latency of each read (in microseconds, from the intended start in fixed-rate mode)
+    int missedDeadlines = 0;
+    std::string error;              // Empty if the client finished all its cycles
+};
+
+/**
+ * Result of running a number of clients concurrently.
+ */
+struct LoadStepResult {
+    int numClients;
+    double seconds;                 // Wall time from the start of the first to the end of the last client
+    std::vector<LoadClientResult> clients;
+
+    int totalReads() const;
+    double readsPerSecond() const;
+    double valuesPerSecond() const;
+};
+
+/**
+ * Runs N independent benchmark tests on N threads, each with its own connection and its
+ * own subset of the tags, and aggregates their throughput and latency. When ramping, N is
+ * doubled from 1 up to the maximum, which shows at which number of clients the PLC stops
+ * scaling (the knee).
+ */
+class LoadGenerator {
+public:
+    using TestFactory = std::function<std::unique_ptr<BaseTest>()>;
+
+    /**
+     * Constructor.
+     *
+     * @param factory Creates a new, unconnected test for every client
+     * @param tagValues Map of tag addresses to expected values, split between the clients
+     * @param numCycles Number of read cycles performed by each client
+     * @param cycleTime Time between read cycles (in milliseconds)
+     * @param fixedRate Schedule the cycles of each client on a fixed timeline
+     * @throws std::invalid_argument if there are no tags
+     */
+    LoadGenerator(TestFactory factory, const std::map<std::string, std::string>& tagValues,
+                  int numCycles, int cycleTime, bool fixedRate);
+
+    /**
+     * Run one load step with the given number of concurrent clients.
+     *
+     * @param numClients Number of clients
+     * @return The results of all clients
+     */
+    LoadStepResult runStep(int numClients);
+
+    /**
+     * Run load steps with 1, 2, 4, ... clients up to maxClients (which is always included)
+     * and print the results of each step and the knee of the curve.
+     *
+     * @param maxClients Maximum number of clients
+     * @param ramp false to only run the step with maxClients
+     * @param out Stream to print to
+     */
+    void run(int maxClients, bool ramp, std::ostream& out);
+
+    /**
+     * Tags read by one of the clients. Tags are dealt round robin; with more clients than
+     * tags several clients read the same tag.
+     *
+     * @param client Index of the client
+     * @param numClients Number of clients
+     * @return Map of tag addresses to expected values
+     */
+    std::map<std::string, std::string> tagsOfClient(int client, int numClients) const;
+
+private:
+    TestFactory factory;
+    std::map<std::string, std::string> tagValues;
+    int numCycles;
+    int cycleTime;
+    bool fixedRate;
+
+    void printStep(const LoadStepResult& step, std::ostream& out) const;
+};
+
+#endif // LOAD_GENERATOR_H
@@ -0,0 +1,190 @@
+#include "Snap7OptimizedTest.h"
+#include "AllocationCounter.h"
+#include "PerfCounters.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/**
+ * Keep the compiler from optimizing a result away.
+ */
+template <typename T>
+void doNotOptimize(const T& value) {
+#if defined(__GNUC__)
+    asm volatile("" : : "r"(&value) : "memory");
+#else
+    static volatile const void* sink;
+    sink = &value;
+#endif
+}
+
+/**
+ * Gives the micro benchmarks access to the hot paths of the tests.
+ */
+class MicroBenchmarkTarget : public Snap7OptimizedTest {
+public:
+    MicroBenchmarkTarget() : Snap7OptimizedTest("127.0.0.1", 0, 1) {}
+
+    using Snap7OptimizedTest::parseAddress;
+    using Snap7OptimizedTest::convertBufferToPlcValue;
+    using BaseTest::getValue;
+};
+
+/**
+ * A tag of the default tag set: address, expected value and the raw bytes the PLC returns.
+ */
+struct MicroBenchmarkTag {
+    std::string address;
+    std::string value;
+    PlcValueType type;
+    std::vector<uint8_t> buffer;
+};
+
+const std::vector<MicroBenchmarkTag> tags = {
+    {"%DB4:0.0:BOOL", "BOOL;true", PlcValueType::BOOL, {0x01}},
+    {"%DB4:1:BYTE", "USINT;42", PlcValueType::BYTE, {42}},
+    {"%DB4:2:WORD", "UINT;42424", PlcValueType::WORD, {0xA5, 0xB8}},
+    {"%DB4:4:DWORD", "UDINT;4242442424", PlcValueType::DWORD, {0xFC, 0xDE, 0x41, 0xB8}},
+    {"%DB4:16:SINT", "SINT;-42", PlcValueType::SINT, {0xD6}},
+    {"%DB4:17:USINT", "USINT;42", PlcValueType::USINT, {42}},
+    {"%DB4:18:INT", "INT;-2424", PlcValueType::INT, {0xF6, 0x88}},
+    {"%DB4:20:UINT", "UINT;42424", PlcValueType::UINT, {0xA5, 0xB8}},
+    {"%DB4:22:DINT", "DINT;-242442424", PlcValueType::DINT, {0xF1, 0x8C, 0xD4, 0x48}},
+    {"%DB4:26:UDINT", "UDINT;4242442424", PlcValueType::UDINT, {0xFC, 0xDE, 0x41, 0xB8}},
+    {"%DB4:46:REAL", "REAL;3.141593", PlcValueType::REAL, {0x40, 0x49, 0x0F, 0xDC}},
+    {"%DB4:50:LREAL", "LREAL;2.71828182846", PlcValueType::LREAL, {0x40, 0x05, 0xBF, 0x0A, 0x8B, 0x14, 0x5F, 0xCF}},
+    {"%DB4:136:CHAR", "CHAR;H", PlcValueType::CHAR, {'H'}},
+    {"%DB4:138:WCHAR", "WCHAR;w", PlcValueType::WCHAR, {0x00, 'w'}},
+    {"%DB4:140:STRING(10)", "STRING;hurz", PlcValueType::STRING, {10, 4, 'h', 'u', 'r', 'z', 0, 0, 0, 0, 0, 0}},
+    {"%DB4:396:WSTRING(10)", "WSTRING;wolf", PlcValueType::WSTRING,
+        {0, 10, 0, 4, 0, 'w', 0, 'o', 0, 'l', 0, 'f', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0}},
+    {"%DB4:58:TIME", "TIME;PT1.234S", PlcValueType::TIME, {0x00, 0x00, 0x04, 0xD2}},
+    {"%DB4:70:DATE", "DATE;1998-03-28", PlcValueType::DATE, {0x0B, 0xC0}},
+    {"%DB4:72:TIME_OF_DAY", "TIME_OF_DAY;15:36:30.123", PlcValueType::TIME_OF_DAY, {0x03, 0x59, 0x64, 0xAB}}
+};
+
+/**
+ * Result of one micro benchmark.
+ */
+struct MicroBenchmarkResult {
+    double nanosPerOp;
+    double allocationsPerOp;
+    double instructionsPerOp; // Negative if the counters are not available
+};
+
+/**
+ * Run a function often enough to fill the minimum time, several times, and report the
+ * fastest repetition (the one least disturbed by the rest of the system).
+ */
+MicroBenchmarkResult measure(const std::function<void()>& operation, double minSeconds, PerfCounters& counters) {
+    // Find an iteration count that runs for roughly a tenth of the minimum time
+    uint64_t iterations = 1;
+    while (true) {
+        auto startTime = std::chrono::steady_clock::now();
+        for (uint64_t i = 0; i < iterations; i++) {
+            operation();
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+        if (seconds >= minSeconds / 10 || iterations >= (1ULL << 30)) {
+            break;
+        }
+        iterations *= 2;
+    }
+
+    MicroBenchmarkResult best = {0.0, 0.0, -1.0};
+    for (int repetition = 0; repetition < 10; repetition++) {
+        uint64_t allocations = allocationCount();
+        counters.start();
+        auto startTime = std::chrono::steady_clock::now();
+        for (uint64_t i = 0; i < iterations; i++) {
+            operation();
+        }
+        auto endTime = std::chrono::steady_clock::now();
+        counters.stop();
+        double nanos = std::chrono::duration<double, std::nano>(endTime - startTime).count() / iterations;
+        if (repetition == 0 || nanos < best.nanosPerOp) {
+            best.nanosPerOp = nanos;
+            best.allocationsPerOp = static_cast<double>(allocationCount() - allocations) / iterations;
+            best.instructionsPerOp = counters.available() ? static_cast<double>(counters.instructions()) / iterations : -1.0;
+        }
+    }
+    return best;
+}
+
+/**
+ * Main function.
+ */
+int main(int argc, char* argv[]) {
+    std::string filter;
+    double minSeconds = 1.0;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--filter" && i + 1 < argc) {
+            filter = argv[++i];
+        } else if (arg == "--minTime" && i + 1 < argc) {
+            minSeconds = std::stoi(argv[++i]) / 1000.0;
+        }
+    }
+
+    MicroBenchmarkTarget target;
+    PerfCounters counters;
+    std::vector<std::pair<std::string, std::function<void()>>> benchmarks;
+
+    for (const auto& tag : tags) {
+        std::string typeName = tag.address.substr(tag.address.rfind(':') + 1);
+        typeName = typeName.substr(0, typeName.find('('));
+        benchmarks.emplace_back("parseAddress/" + typeName, [&target, &tag]() {
+            int area, dbNumber, start, wordLen, size;
+            PlcValueType type;
+            target.parseAddress(tag.address, area, dbNumber, start, wordLen, size, type);
+            doNotOptimize(start);
+        });
+        benchmarks.emplace_back("convertBufferToPlcValue/" + typeName, [&target, &tag]() {
+            PlcValue value = target.convertBufferToPlcValue(tag.buffer.data(), tag.type);
+            doNotOptimize(value);
+        });
+        benchmarks.emplace_back("getValue/" + typeName, [&target, &tag]() {
+            PlcValue value = target.getValue(tag.value);
+            doNotOptimize(value);
+        });
+
+        PlcValue value = target.getValue(tag.value);
+        benchmarks.emplace_back("PlcValue copy/" + typeName, [value]() {
+            PlcValue copy(value);
+            doNotOptimize(copy);
+        });
+        benchmarks.emplace_back("PlcValue compare/" + typeName, [value, other = value]() {
+            bool equal = value == other;
+            doNotOptimize(equal);
+        });
+    }
+
+    std::cout << std::left << std::setw(40) << "Benchmark" << std::right << std::setw(12) << "ns/op"
+              << std::setw(12) << "allocs/op" << std::setw(14) << "instr/op" << std::endl;
+    for (const auto& [name, operation] : benchmarks) {
+        if (!filter.empty() && name.find(filter) == std::string::npos) {
+            continue;
+        }
+        MicroBenchmarkResult result = measure(operation, minSeconds, counters);
+        std::cout << std::left << std::setw(40) << name << std::right << std::fixed
+                  << std::setw(12) << std::setprecision(1) << result.nanosPerOp
+                  << std::setw(12) << std::setprecision(2) << result.allocationsPerOp << std::setw(14);
+        if (result.instructionsPerOp >= 0.0) {
+            std::cout << std::setprecision(0) << result.instructionsPerOp;
+        } else {
+            std::cout << "n/a";
+        }
+        std::cout << std::defaultfloat << std::endl;
+    }
+    if (!counters.available()) {
+        std::cout << std::endl << "Instruction counts not available (perf_event_open failed)" << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,246 @@
+#include "BenchmarkResults.h"
+#include "CheckResult.h"
+#include "BenchmarkUtils.h"
+#include <iostream>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <iomanip>
+#include <stdexcept>
+#include <cstdint>
+
+/**
+ * Counts and verifies the blocks arriving at the passive partner.
+ */
+struct Receiver {
+    std::atomic<int> numReceived{0};
+    std::atomic<int> numCorrupted{0};
+    int expectedSize = 0;
+};
+
+/**
+ * Timings of one BSend (in microseconds).
+ */
+struct TransferSample {
+    int window;
+    int size;
+    int64_t latency;
+};
+
+/**
+ * Content of byte i of the block with the given id, so the receiver can verify every block.
+ */
+uint8_t patternByte(longword id, int i) {
+    return static_cast<uint8_t>(id * 31 + i * 7);
+}
+
+/**
+ * Verify and count a block that arrived at the passive partner.
+ */
+void verifyBlock(Receiver* receiver, int opResult, longword id, const void* data, int size) {
+    bool valid = opResult == 0 && size == receiver->expectedSize;
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    for (int i = 0; valid && i < size; i++) {
+        valid = bytes[i] == patternByte(id, i);
+    }
+    if (!valid) {
+        receiver->numCorrupted++;
+    }
+    receiver->numReceived++;
+}
+
+/**
+ * Called by the worker of the passive partner for every complete block.
+ */
+void S7API onBlockReceived(void* usrPtr, int opResult, longword id, void* data, int size) {
+    verifyBlock(static_cast<Receiver*>(usrPtr), opResult, id, data, size);
+}
+
+/**
+ * Take the blocks from the receive ring of the passive partner, verify them where the
+ * partner reassembled them and give the buffers back.
+ */
+void consumeRing(S7Object passive, Receiver* receiver, const std::atomic<bool>* stop) {
+    while (!*stop) {
+        longword id;
+        void* data;
+        int size;
+        if (Par_RecvFromRing(passive, id, data, size, 100) == 0) {
+            verifyBlock(receiver, 0, id, data, size);
+            Par_ReleaseRingBuffer(passive, data);
+        }
+    }
+}
+
+/**
+ * Wait until a partner is linked to its peer.
+ */
+void waitLinked(S7Object partner, int timeout) {
+    auto start = std::chrono::steady_clock::now();
+    int status = 0;
+    while (Par_GetStatus(partner, status) == 0 && status != par_linked) {
+        if (std::chrono::steady_clock::now() - start > std::chrono::milliseconds(timeout)) {
+            throw std::runtime_error("Partners didn't link within " + std::to_string(timeout) + "ms");
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+}
+
+/**
+ * Main function: links an active and a passive partner over loopback and measures BSend
+ * throughput and latency for every combination of payload size and send window.
+ *
+ * The partners use port 102 like a PLC, so the passive one listens on its own local address
+ * (127.0.0.3 by default, next to a simulated PLC on 127.0.0.1). The active partner doesn't
+ * bind its local address, the passive one sees its connection coming from 127.0.0.1.
+ *
+ * With --loops the partners are served by event loops (both of them by the same loop with
+ * --loops 1).
+ */
+int main(int argc, char* argv[]) {
+    std::string passiveAddress = "127.0.0.3";
+    std::string activeAddress = "127.0.0.1";
+    std::vector<int> sizes = {256, 1024, 4096, 16384, 65535};
+    std::vector<int> windows = {1, 2, 4, 8};
+    int numTransfers = 100;
+    int pduSize = 480;
+    int workInterval = 1;
+    int ringBuffers = 0;
+    int loops = 0;
+    std::string resultsCsv;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--passiveAddress" && i + 1 < argc) {
+            passiveAddress = argv[++i];
+        } else if (arg == "--activeAddress" && i + 1 < argc) {
+            activeAddress = argv[++i];
+        } else if (arg == "--sizes" && i + 1 < argc) {
+            sizes = parseList(argv[++i]);
+        } else if (arg == "--windows" && i + 1 < argc) {
+            windows = parseList(argv[++i]);
+        } else if (arg == "--numTransfers" && i + 1 < argc) {
+            numTransfers = std::stoi(argv[++i]);
+        } else if (arg == "--pduSize" && i + 1 < argc) {
+            pduSize = std::stoi(argv[++i]);
+        } else if (arg == "--workInterval" && i + 1 < argc) {
+            workInterval = std::stoi(argv[++i]);
+        } else if (arg == "--ring" && i + 1 < argc) {
+            ringBuffers = std::stoi(argv[++i]);
+        } else if (arg == "--loops" && i + 1 < argc) {
+            loops = std::stoi(argv[++i]);
+        } else if (arg == "--resultsCsv" && i + 1 < argc) {
+            resultsCsv = argv[++i];
+        }
+    }
+
+    std::cout << "Scenario: " << numTransfers << " BSends per size from " << activeAddress << " to "
+              << passiveAddress << ", " << pduSize << " bytes PDU, "
+              << (ringBuffers > 0 ? "received into a ring of " + std::to_string(ringBuffers) + " buffers"
+                                  : "received with a callback")
+              << std::endl << std::endl;
+
+    Receiver receiver;
+    S7Object passive = Par_Create(0);
+    S7Object active = Par_Create(1);
+    std::vector<TransferSample> samples;
+    std::vector<uint8_t> ring(static_cast<size_t>(ringBuffers) * 65536);
+    std::atomic<bool> stopConsumer(false);
+    std::thread consumer;
+    try {
+        // The worker polls for pending sends between reads, keep it from idling away the latency
+        for (S7Object partner : {passive, active}) {
+            checkPartner(Par_SetParam(partner, p_i32_PDURequest, &pduSize), "Failed to set the PDU size");
+            checkPartner(Par_SetParam(partner, p_i32_WorkInterval, &workInterval), "Failed to set the work interval");
+        }
+        checkPartner(Par_SetEventLoops(loops), "Failed to set the event loops");
+        // Keep the ICMP keep alive of the active partner out of the measurement
+        longword keepAliveTime = 3600000;
+        checkPartner(Par_SetParam(active, p_u32_KeepAliveTime, &keepAliveTime), "Failed to set the keep alive time");
+        if (ringBuffers > 0) {
+            checkPartner(Par_SetRecvRing(passive, ring.data(), 65536, ringBuffers), "Failed to set the receive ring");
+            consumer = std::thread(consumeRing, passive, &receiver, &stopConsumer);
+        } else {
+            checkPartner(Par_SetRecvCallback(passive, onBlockReceived, &receiver), "Failed to set the receive callback");
+        }
+        checkPartner(Par_StartTo(passive, passiveAddress.c_str(), activeAddress.c_str(), 0x1001, 0x1002),
+              "Failed to start the passive partner");
+        checkPartner(Par_StartTo(active, activeAddress.c_str(), passiveAddress.c_str(), 0x1002, 0x1001),
+              "Failed to start the active partner");
+        waitLinked(active, 5000);
+        waitLinked(passive, 5000);
+
+        std::vector<uint8_t> payload(65536);
+        longword id = 0;
+        for (int window : windows) {
+            checkPartner(Par_SetParam(active, p_i32_BSendWindow, &window), "Failed to set the send window");
+            std::cout << "Running: 'BSend window " << window << "'" << std::endl;
+            std::cout << "  " << std::right << std::setw(8) << "bytes" << std::setw(10) << "MB/s"
+                      << std::setw(10) << "mean" << std::setw(10) << "p50" << std::setw(10) << "p99"
+                      << std::setw(10) << "max" << std::endl;
+            for (int size : sizes) {
+                receiver.expectedSize = size;
+                std::vector<int64_t> latencies;
+                auto startTime = std::chrono::steady_clock::now();
+                for (int transfer = 0; transfer < numTransfers; transfer++) {
+                    id++;
+                    for (int i = 0; i < size; i++) {
+                        payload[i] = patternByte(id, i);
+                    }
+                    int expected = receiver.numReceived + 1;
+                    auto start = std::chrono::steady_clock::now();
+                    checkPartner(Par_BSend(active, id, payload.data(), size), "Failed to send block");
+                    // The last acknowledgement is sent before the block is delivered
+                    while (receiver.numReceived < expected) {
+                        std::this_thread::yield();
+                    }
+                    latencies.push_back(std::chrono::duration_cast<std::chrono::microseconds>(
+                            std::chrono::steady_clock::now() - start).count());
+                }
+                double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+                double megabytesPerSecond = static_cast<double>(size) * numTransfers / seconds / 1e6;
+
+                LatencySummary summary = summarize(latencies);
+                std::cout << "  " << std::setw(8) << size << std::fixed << std::setprecision(2)
+                          << std::setw(10) << megabytesPerSecond << std::setprecision(3)
+                          << std::setw(10) << summary.mean / 1000.0 << std::setw(10) << summary.p50 / 1000.0
+                          << std::setw(10) << summary.p99 / 1000.0 << std::setw(10) << summary.max / 1000.0
+                          << std::defaultfloat << std::endl;
+                for (int64_t latency : latencies) {
+                    samples.push_back({window, size, latency});
+                }
+            }
+        }
+        if (receiver.numCorrupted > 0) {
+            throw std::runtime_error(std::to_string(receiver.numCorrupted) + " blocks arrived corrupted");
+        }
+        std::cout << "  --> " << receiver.numReceived << " blocks received and verified" << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        stopConsumer = true;
+        if (consumer.joinable()) {
+            consumer.join();
+        }
+        Par_Destroy(active);
+        Par_Destroy(passive);
+        return 1;
+    }
+    stopConsumer = true;
+    if (consumer.joinable()) {
+        consumer.join();
+    }
+    Par_Destroy(active);
+    Par_Destroy(passive);
+
+    if (!resultsCsv.empty() &&
+        !writeSamplesCsv(resultsCsv, "window,bytes,latencyUs", samples,
+                         [](std::ostream& out, const TransferSample& sample) {
+                             out << sample.window << "," << sample.size << "," << sample.latency;
+                         })) {
+        return 1;
+    }
+
+    return 0;
+}
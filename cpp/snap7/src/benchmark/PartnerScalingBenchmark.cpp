@@ -0,0 +1,254 @@
+#include "BenchmarkResults.h"
+#include "CheckResult.h"
+#include "BenchmarkUtils.h"
+#include <iostream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <chrono>
+#include <thread>
+#include <iomanip>
+#include <stdexcept>
+#include <cstdint>
+#include <cstring>
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+/**
+ * Delivery latencies seen by one passive partner. Only its worker (thread or event loop)
+ * appends to them while the partners are running.
+ */
+struct Link {
+    S7Object active = 0;
+    S7Object passive = 0;
+    std::vector<int64_t> latencies;
+};
+
+/**
+ * Results of one run (one partner count with one runtime).
+ */
+struct ScalingResult {
+    std::string runtime;
+    int numPartners;
+    double cpuPercent;
+    double switchesPerSecond;
+    int threads;
+    int64_t sent;
+    int64_t busy;
+    LatencySummary latency;
+};
+
+/**
+ * CPU time (user + system) and context switches of the whole process.
+ */
+void processUsage(int64_t& cpuMicros, int64_t& switches) {
+    cpuMicros = 0;
+    switches = 0;
+#if defined(__unix__) || defined(__APPLE__)
+    rusage usage{};
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+        cpuMicros = static_cast<int64_t>(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000 +
+                    usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+        switches = usage.ru_nvcsw + usage.ru_nivcsw;
+    }
+#endif
+}
+
+/**
+ * @return Number of threads of the process (0 if unknown)
+ */
+int processThreads() {
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.compare(0, 8, "Threads:") == 0) {
+            return std::stoi(line.substr(8));
+        }
+    }
+    return 0;
+}
+
+/**
+ * Called by the worker of a passive partner for every complete block, the first bytes
+ * carry the time it was handed to the active partner.
+ */
+void S7API onBlockReceived(void* usrPtr, int opResult, longword, void* data, int size) {
+    Link* link = static_cast<Link*>(usrPtr);
+    if (opResult == 0 && size >= static_cast<int>(sizeof(int64_t))) {
+        int64_t sentAt;
+        memcpy(&sentAt, data, sizeof(sentAt));
+        link->latencies.push_back(nowMicros() - sentAt);
+    }
+}
+
+/**
+ * Wait until all partners are linked to their peers.
+ */
+void waitLinked(const std::vector<std::unique_ptr<Link>>& links, int timeout) {
+    auto start = std::chrono::steady_clock::now();
+    for (const auto& link : links) {
+        for (S7Object partner : {link->active, link->passive}) {
+            int status = 0;
+            while (Par_GetStatus(partner, status) == 0 && status != par_linked) {
+                if (std::chrono::steady_clock::now() - start > std::chrono::milliseconds(timeout)) {
+                    throw std::runtime_error("Partners didn't link within " + std::to_string(timeout) + "ms");
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+        }
+    }
+}
+
+/**
+ * Link numPartners pairs of partners, let every active partner send a block each interval
+ * for the given duration and measure the CPU used by the process and the delivery latency.
+ */
+ScalingResult runScenario(int numPartners, int loops, int interval, int duration, int size) {
+    ScalingResult result{};
+    result.runtime = loops > 0 ? std::to_string(loops) + " event loops" : "threads";
+    result.numPartners = numPartners;
+    checkPartner(Par_SetEventLoops(loops), "Failed to set the event loops");
+
+    // Every passive partner listens on its own address, all connections come from 127.0.0.1
+    std::vector<std::unique_ptr<Link>> links;
+    std::vector<uint8_t> payload(size);
+    try {
+        for (int i = 0; i < numPartners; i++) {
+            links.push_back(std::make_unique<Link>());
+            Link& link = *links.back();
+            std::string address = "127.0.1." + std::to_string(i + 1);
+            link.passive = Par_Create(0);
+            link.active = Par_Create(1);
+            checkPartner(Par_SetRecvCallback(link.passive, onBlockReceived, &link), "Failed to set the receive callback");
+            checkPartner(Par_StartTo(link.passive, address.c_str(), "127.0.0.1", 0x1001, 0x1002),
+                  "Failed to start the passive partner " + address);
+            checkPartner(Par_StartTo(link.active, "127.0.0.1", address.c_str(), 0x1002, 0x1001),
+                  "Failed to start the active partner to " + address);
+        }
+        waitLinked(links, 5000 + numPartners * 100);
+
+        int64_t startCpu, startSwitches, endCpu, endSwitches;
+        processUsage(startCpu, startSwitches);
+        auto startTime = std::chrono::steady_clock::now();
+        auto nextTime = startTime;
+        auto endTime = startTime + std::chrono::seconds(duration);
+        longword id = 0;
+        while (nextTime < endTime) {
+            for (const auto& link : links) {
+                int64_t sentAt = nowMicros();
+                memcpy(payload.data(), &sentAt, sizeof(sentAt));
+                if (Par_AsBSend(link->active, ++id, payload.data(), size) == 0) {
+                    result.sent++;
+                } else {
+                    result.busy++;
+                }
+            }
+            nextTime += std::chrono::milliseconds(interval);
+            std::this_thread::sleep_until(nextTime);
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+        processUsage(endCpu, endSwitches);
+        result.threads = processThreads();
+        result.cpuPercent = static_cast<double>(endCpu - startCpu) / (seconds * 1e6) * 100.0;
+        result.switchesPerSecond = static_cast<double>(endSwitches - startSwitches) / seconds;
+    } catch (...) {
+        for (auto& link : links) {
+            Par_Destroy(link->active);
+            Par_Destroy(link->passive);
+        }
+        throw;
+    }
+
+    // Stopping the partners also stops their callbacks, the latencies can be read afterwards
+    for (auto& link : links) {
+        Par_Stop(link->active);
+        Par_Stop(link->passive);
+    }
+    std::vector<int64_t> latencies;
+    for (auto& link : links) {
+        latencies.insert(latencies.end(), link->latencies.begin(), link->latencies.end());
+        Par_Destroy(link->active);
+        Par_Destroy(link->passive);
+    }
+    result.latency = summarize(latencies);
+    return result;
+}
+
+/**
+ * Main function: compares one thread per partner with partners sharing a few event loops,
+ * for a growing number of partner links.
+ *
+ * The passive partners listen on 127.0.1.1, 127.0.1.2, ... (port 102, so this needs to run
+ * with the rights to bind it). Every passive address also has its listener thread, in both
+ * runtimes.
+ */
+int main(int argc, char* argv[]) {
+    std::vector<int> counts = {1, 10, 50, 100};
+    int loops = 2;
+    int interval = 100;
+    int duration = 5;
+    int size = 64;
+    std::string resultsCsv;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--counts" && i + 1 < argc) {
+            counts = parseList(argv[++i]);
+        } else if (arg == "--loops" && i + 1 < argc) {
+            loops = std::stoi(argv[++i]);
+        } else if (arg == "--interval" && i + 1 < argc) {
+            interval = std::stoi(argv[++i]);
+        } else if (arg == "--duration" && i + 1 < argc) {
+            duration = std::stoi(argv[++i]);
+        } else if (arg == "--size" && i + 1 < argc) {
+            size = std::stoi(argv[++i]);
+        } else if (arg == "--resultsCsv" && i + 1 < argc) {
+            resultsCsv = argv[++i];
+        }
+    }
+    if (size < static_cast<int>(sizeof(int64_t))) {
+        size = sizeof(int64_t);
+    }
+
+    std::cout << "Scenario: one " << size << " bytes BSend per link every " << interval << "ms, "
+              << duration << "s per run" << std::endl << std::endl;
+
+    std::vector<ScalingResult> results;
+    try {
+        for (int runtimeLoops : {0, loops}) {
+            std::cout << "Running: '" << (runtimeLoops > 0 ? std::to_string(runtimeLoops) + " event loops" : "threads")
+                      << "'" << std::endl;
+            std::cout << "  " << std::right << std::setw(8) << "links" << std::setw(8) << "cpu%"
+                      << std::setw(12) << "switches/s" << std::setw(9) << "threads" << std::setw(10) << "p50 ms"
+                      << std::setw(10) << "p99 ms" << std::setw(10) << "max ms" << std::setw(8) << "busy" << std::endl;
+            for (int count : counts) {
+                ScalingResult result = runScenario(count, runtimeLoops, interval, duration, size);
+                std::cout << "  " << std::setw(8) << count << std::fixed << std::setprecision(1)
+                          << std::setw(8) << result.cpuPercent << std::setw(12) << result.switchesPerSecond
+                          << std::setw(9) << result.threads << std::setprecision(3)
+                          << std::setw(10) << result.latency.p50 / 1000.0 << std::setw(10) << result.latency.p99 / 1000.0
+                          << std::setw(10) << result.latency.max / 1000.0 << std::defaultfloat
+                          << std::setw(8) << result.busy << std::endl;
+                results.push_back(result);
+            }
+        }
+        Par_SetEventLoops(0);
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    if (!resultsCsv.empty() &&
+        !writeSamplesCsv(resultsCsv, "runtime,links,cpuPercent,switchesPerSecond,threads,sent,busy,p50Us,p99Us,maxUs",
+                         results, [](std::ostream& out, const ScalingResult& result) {
+                             out << result.runtime << "," << result.numPartners << "," << result.cpuPercent << ","
+                                 << result.switchesPerSecond << "," << result.threads << "," << result.sent << ","
+                                 << result.busy << "," << result.latency.p50 << "," << result.latency.p99 << ","
+                                 << result.latency.max;
+                         })) {
+        return 1;
+    }
+
+    return 0;
+}
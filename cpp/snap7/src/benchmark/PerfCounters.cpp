@@ -0,0 +1,131 @@
+#include "PerfCounters.h"
+
+#if defined(__linux__)
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace {
+
+const struct {
+    uint32_t type;
+    uint64_t config;
+} events[PERF_EVENT_COUNT] = {
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+    {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK}
+};
+
+int openCounter(uint32_t type, uint64_t config) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = 1;
+    attr.exclude_kernel = type == PERF_TYPE_HARDWARE ? 1 : 0;
+    attr.exclude_hv = 1;
+    return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+}
+
+uint64_t readCounter(int fd) {
+    uint64_t value = 0;
+    if (fd < 0 || ::read(fd, &value, sizeof(value)) != sizeof(value)) {
+        return 0;
+    }
+    return value;
+}
+
+}
+
+PerfCounters::PerfCounters() {
+    for (int event = 0; event < PERF_EVENT_COUNT; event++) {
+        fds[event] = openCounter(events[event].type, events[event].config);
+    }
+}
+
+PerfCounters::~PerfCounters() {
+    for (int fd : fds) {
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+}
+
+void PerfCounters::start() {
+    for (int fd : fds) {
+        if (fd >= 0) {
+            ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+}
+
+void PerfCounters::stop() {
+    for (int fd : fds) {
+        if (fd >= 0) {
+            ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        }
+    }
+}
+
+PerfSample PerfCounters::read() const {
+    PerfSample sample;
+    for (int event = 0; event < PERF_EVENT_COUNT; event++) {
+        sample.values[event] = readCounter(fds[event]);
+    }
+    return sample;
+}
+
+#else
+
+PerfCounters::PerfCounters() {
+    for (int& fd : fds) {
+        fd = -1;
+    }
+}
+
+PerfCounters::~PerfCounters() {
+}
+
+void PerfCounters::start() {
+}
+
+void PerfCounters::stop() {
+}
+
+PerfSample PerfCounters::read() const {
+    return PerfSample();
+}
+
+#endif
+
+PerfSample& PerfSample::operator+=(const PerfSample& other) {
+    for (int event = 0; event < PERF_EVENT_COUNT; event++) {
+        values[event] += other.values[event];
+    }
+    return *this;
+}
+
+bool PerfCounters::available() const {
+    return available(PERF_INSTRUCTIONS);
+}
+
+bool PerfCounters::available(PerfEvent event) const {
+    return fds[event] >= 0;
+}
+
+uint64_t PerfCounters::instructions() const {
+    return read().values[PERF_INSTRUCTIONS];
+}
+
+const char* PerfCounters::name(PerfEvent event) {
+    static const char* const names[PERF_EVENT_COUNT] = {
+        "cycles", "instructions", "cache-misses", "branch-misses", "task-clock"
+    };
+    return names[event];
+}
@@ -0,0 +1,81 @@
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <cstdint>
+
+/**
+ * Counters read by PerfCounters.
+ */
+enum PerfEvent {
+    PERF_CYCLES,
+    PERF_INSTRUCTIONS,
+    PERF_CACHE_MISSES,
+    PERF_BRANCH_MISSES,
+    PERF_TASK_CLOCK,    // Time on the CPU (in nanoseconds)
+    PERF_EVENT_COUNT
+};
+
+/**
+ * Values of all counters, zero for counters that are not available.
+ */
+struct PerfSample {
+    uint64_t values[PERF_EVENT_COUNT] = {};
+
+    PerfSample& operator+=(const PerfSample& other);
+};
+
+/**
+ * Performance counters of the calling thread (user space only, except the task clock),
+ * read with perf_event_open on Linux. Every counter is opened on its own, so a VM without
+ * a PMU still gets the task clock. On other platforms, or when the kernel doesn't allow it
+ * (perf_event_paranoid, containers), nothing is available and all counts are zero.
+ */
+class PerfCounters {
+public:
+    PerfCounters();
+    ~PerfCounters();
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    /**
+     * @return true if at least the instruction counter could be opened
+     */
+    bool available() const;
+
+    /**
+     * @param event The counter
+     * @return true if the counter could be opened
+     */
+    bool available(PerfEvent event) const;
+
+    /**
+     * Reset and start counting.
+     */
+    void start();
+
+    /**
+     * Stop counting.
+     */
+    void stop();
+
+    /**
+     * @return Counts between start() and stop()
+     */
+    PerfSample read() const;
+
+    /**
+     * @return Instructions retired between start() and stop()
+     */
+    uint64_t instructions() const;
+
+    /**
+     * @return Name of a counter
+     */
+    static const char* name(PerfEvent event);
+
+private:
+    int fds[PERF_EVENT_COUNT];
+};
+
+#endif // PERF_COUNTERS_H
@@ -0,0 +1,40 @@
+#ifndef READ_PLAN_H
+#define READ_PLAN_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "BaseTest.h"
+
+/**
+ * A single tag inside a read group.
+ */
+struct ReadPlanItem {
+    std::string tagName;  // Name of the tag the value belongs to
+    int start;            // Start address (bit address for BOOL, byte address otherwise)
+    int wordLen;          // S7 word length used to request the item
+    int size;             // Size of the item in bytes
+    int amount;           // Number of elements requested for the item
+    PlcValueType type;    // Type the raw bytes are decoded into
+    size_t offset;        // Offset of the item's bytes inside the group buffer
+};
+
+/**
+ * A group of tags that are fetched with one request (Cli_ReadArea for a single item,
+ * Cli_ReadMultiVars otherwise). All items of a group share one contiguous buffer.
+ */
+struct ReadPlanGroup {
+    int area;                       // S7 area code shared by all items
+    int dbNumber;                   // DB number shared by all items
+    std::vector<ReadPlanItem> items;
+    std::vector<uint8_t> buffer;    // Raw bytes of all items, laid out back to back
+};
+
+/**
+ * The grouped read requests needed to fetch a set of tags.
+ */
+struct ReadPlan {
+    std::vector<ReadPlanGroup> groups;
+};
+
+#endif // READ_PLAN_H
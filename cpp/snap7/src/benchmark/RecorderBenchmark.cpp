@@ -0,0 +1,184 @@
+#include "TimeSeriesRecorder.h"
+#include "BenchmarkUtils.h"
+#include <iostream>
+#include <string>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <cstdint>
+
+/**
+ * Build a plan with a realistic type mix, grouped in requests of up to 20 items.
+ *
+ * @param numTags Number of tags in the plan
+ * @return The read plan
+ */
+ReadPlan buildPlan(int numTags) {
+    const PlcValueType types[] = {PlcValueType::BOOL, PlcValueType::INT, PlcValueType::DINT,
+                                  PlcValueType::REAL, PlcValueType::LREAL, PlcValueType::STRING};
+    const int sizes[] = {1, 2, 4, 4, 8, 12};
+
+    ReadPlan plan;
+    for (int i = 0; i < numTags; i++) {
+        if (i % 20 == 0) {
+            plan.groups.emplace_back();
+            plan.groups.back().area = 0x84;
+            plan.groups.back().dbNumber = 1;
+        }
+        ReadPlanGroup& group = plan.groups.back();
+        int kind = i % 6;
+        size_t offset = group.buffer.size();
+        group.items.push_back({"tag-" + std::to_string(i + 1), i * 16, 0, sizes[kind], 1, types[kind], offset});
+        group.buffer.resize(offset + sizes[kind]);
+    }
+    return plan;
+}
+
+/**
+ * Fill the buffers of a plan with the values of one cycle.
+ */
+void fillPlan(ReadPlan& plan, int cycle, std::mt19937& random, std::vector<double>& walks) {
+    std::normal_distribution<float> step(0.0f, 0.05f);
+    size_t walk = 0;
+    for (auto& group : plan.groups) {
+        for (auto& item : group.items) {
+            uint8_t* data = group.buffer.data() + item.offset;
+            switch (item.type) {
+                case PlcValueType::BOOL:
+                    data[0] = (cycle / 500) % 2;
+                    break;
+                case PlcValueType::INT:
+                    writeBigEndian(data, static_cast<uint16_t>(cycle), 2);
+                    break;
+                case PlcValueType::DINT:
+                    writeBigEndian(data, static_cast<uint32_t>(-242442424), 4);
+                    break;
+                case PlcValueType::REAL: {
+                    walks[walk] += step(random);
+                    float value = static_cast<float>(walks[walk++]);
+                    uint32_t bits;
+                    memcpy(&bits, &value, sizeof(bits));
+                    writeBigEndian(data, bits, 4);
+                    break;
+                }
+                case PlcValueType::LREAL: {
+                    double value = 50.0 + 10.0 * std::sin(cycle / 1000.0);
+                    uint64_t bits;
+                    memcpy(&bits, &value, sizeof(bits));
+                    writeBigEndian(data, bits, 8);
+                    break;
+                }
+                default:
+                    data[0] = 10;
+                    data[1] = 4;
+                    memcpy(data + 2, "hurz", 4);
+                    break;
+            }
+        }
+    }
+}
+
+/**
+ * Main function.
+ */
+int main(int argc, char* argv[]) {
+    int numTags = 100;
+    int numCycles = 10000;
+    int chunkSize = 1024;
+    int cycleTime = 100;
+    std::string file = "recorder-benchmark.s7ts";
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--numTags" && i + 1 < argc) {
+            numTags = std::stoi(argv[++i]);
+        } else if (arg == "--numCycles" && i + 1 < argc) {
+            numCycles = std::stoi(argv[++i]);
+        } else if (arg == "--chunkSize" && i + 1 < argc) {
+            chunkSize = std::stoi(argv[++i]);
+        } else if (arg == "--cycleTime" && i + 1 < argc) {
+            cycleTime = std::stoi(argv[++i]);
+        } else if (arg == "--file" && i + 1 < argc) {
+            file = argv[++i];
+        }
+    }
+
+    std::cout << "Scenario: " << numTags << " tags, " << numCycles << " cycles, " << cycleTime << "ms intervals, "
+              << chunkSize << " samples per chunk" << std::endl << std::endl;
+
+    ReadPlan plan = buildPlan(numTags);
+    std::mt19937 random(42);
+    std::uniform_int_distribution<int> jitter(-500, 500);
+    std::vector<double> walks(numTags, 20.0);
+
+    // Generate all cycles up front, so only the recorder is measured
+    std::vector<int64_t> timestamps(numCycles);
+    std::vector<std::vector<uint8_t>> cycles(numCycles);
+    int64_t rawBytes = 0;
+    int64_t timestamp = 1700000000000000LL;
+    for (int cycle = 0; cycle < numCycles; cycle++) {
+        timestamp += cycleTime * 1000 + jitter(random);
+        timestamps[cycle] = timestamp;
+        fillPlan(plan, cycle, random, walks);
+        for (const auto& group : plan.groups) {
+            cycles[cycle].insert(cycles[cycle].end(), group.buffer.begin(), group.buffer.end());
+            for (const auto& item : group.items) {
+                rawBytes += item.size + sizeof(int64_t);
+            }
+        }
+    }
+
+    std::cout << "Running: 'Recorder'" << std::endl;
+    TimeSeriesRecorder recorder(file, chunkSize);
+    auto startTime = std::chrono::high_resolution_clock::now();
+    for (int cycle = 0; cycle < numCycles; cycle++) {
+        size_t pos = 0;
+        for (auto& group : plan.groups) {
+            memcpy(group.buffer.data(), cycles[cycle].data() + pos, group.buffer.size());
+            pos += group.buffer.size();
+        }
+        recorder.append(timestamps[cycle], plan);
+    }
+    recorder.close();
+    auto endTime = std::chrono::high_resolution_clock::now();
+    double ingestSeconds = std::chrono::duration<double>(endTime - startTime).count();
+    double numSamples = static_cast<double>(recorder.getNumSamples());
+
+    std::cout << "  --> " << static_cast<int64_t>(numSamples / ingestSeconds) << " samples/s ingest, "
+              << static_cast<double>(recorder.getFileSize()) / numSamples << " bytes/sample ("
+              << static_cast<double>(rawBytes) / numSamples << " uncompressed)" << std::endl;
+
+    // Read everything back and verify it against the generated cycles
+    std::cout << "Running: 'Reader'" << std::endl;
+    TimeSeriesReader reader(file);
+    std::vector<int64_t> readTimestamps;
+    std::vector<uint8_t> readData;
+    startTime = std::chrono::high_resolution_clock::now();
+    size_t pos = 0;
+    for (const auto& group : plan.groups) {
+        for (const auto& item : group.items) {
+            reader.read(item.tagName, INT64_MIN, INT64_MAX, readTimestamps, readData);
+            if (readTimestamps != timestamps) {
+                std::cerr << "Timestamp mismatch for " << item.tagName << std::endl;
+                return 1;
+            }
+            for (int cycle = 0; cycle < numCycles; cycle++) {
+                if (memcmp(readData.data() + static_cast<size_t>(cycle) * item.size,
+                           cycles[cycle].data() + pos + item.offset, item.size) != 0) {
+                    std::cerr << "Value mismatch for " << item.tagName << " in cycle " << cycle << std::endl;
+                    return 1;
+                }
+            }
+        }
+        pos += group.buffer.size();
+    }
+    endTime = std::chrono::high_resolution_clock::now();
+    double readSeconds = std::chrono::duration<double>(endTime - startTime).count();
+
+    std::cout << "  --> " << static_cast<int64_t>(numSamples / readSeconds) << " samples/s read, "
+              << reader.getChunks().size() << " chunks verified" << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,83 @@
+#include "../lib/snap7_libmain.h"
+#include <iostream>
+#include <string>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <csignal>
+
+std::atomic<bool> stopRequested(false);
+
+/**
+ * Stop the replay on Ctrl+C.
+ */
+void onSignal(int) {
+    stopRequested = true;
+}
+
+/**
+ * Main function: serve a capture made with s7_benchmark --captureFile (or tcpdump on port 102)
+ * until interrupted or until the duration elapsed.
+ */
+int main(int argc, char* argv[]) {
+    std::string file;
+    std::string address = "0.0.0.0";
+    int port = 102;
+    int timeScale = 100;
+    int duration = 0;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--file" && i + 1 < argc) {
+            file = argv[++i];
+        } else if (arg == "--address" && i + 1 < argc) {
+            address = argv[++i];
+        } else if (arg == "--port" && i + 1 < argc) {
+            port = std::stoi(argv[++i]);
+        } else if (arg == "--timeScale" && i + 1 < argc) {
+            timeScale = std::stoi(argv[++i]);
+        } else if (arg == "--duration" && i + 1 < argc) {
+            duration = std::stoi(argv[++i]);
+        }
+    }
+    if (file.empty()) {
+        std::cerr << "Usage: s7_replay --file <capture.pcap> [--address <ip>] [--port <port>] "
+                  << "[--timeScale <percent>] [--duration <seconds>]" << std::endl;
+        return 1;
+    }
+
+    char errorText[1024];
+    S7Object replay = Rpl_Create();
+    int result = Rpl_LoadCapture(replay, file.c_str());
+    if (result == 0) {
+        result = Rpl_SetTimeScale(replay, timeScale);
+    }
+    if (result == 0) {
+        result = Rpl_StartTo(replay, address.c_str(), static_cast<word>(port));
+    }
+    if (result != 0) {
+        Srv_ErrorText(result, errorText, sizeof(errorText));
+        std::cerr << "Failed to start replay: " << errorText << std::endl;
+        Rpl_Destroy(replay);
+        return 1;
+    }
+
+    std::cout << "Replaying '" << file << "' on " << address << ":" << port << " at " << timeScale
+              << "% of the recorded response times" << std::endl;
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+    auto startTime = std::chrono::steady_clock::now();
+    while (!stopRequested) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        if (duration > 0 && std::chrono::steady_clock::now() - startTime >= std::chrono::seconds(duration)) {
+            break;
+        }
+    }
+
+    longword exchanges, mismatches;
+    Rpl_Stop(replay);
+    Rpl_GetStats(replay, exchanges, mismatches);
+    Rpl_Destroy(replay);
+    std::cout << "  --> " << exchanges << " requests answered, " << mismatches << " mismatches" << std::endl;
+    return 0;
+}
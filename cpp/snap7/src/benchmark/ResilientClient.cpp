@@ -0,0 +1,85 @@
+#include "ResilientClient.h"
+
+#include <algorithm>
+
+ResilientClient::ResilientClient(S7Object client, const std::string& host, int rack, int slot, int pduSize)
+    : client(client), host(host), rack(rack), slot(slot), negotiatedPdu(pduSize) {
+    reconnector = std::thread(&ResilientClient::reconnectLoop, this);
+}
+
+ResilientClient::~ResilientClient() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wakeup.notify_all();
+    reconnector.join();
+}
+
+void ResilientClient::setBackoff(int initialMs, int maxMs) {
+    std::lock_guard<std::mutex> lock(mutex);
+    initialBackoff = std::max(initialMs, 1);
+    maxBackoff = std::max(maxMs, initialBackoff);
+}
+
+bool ResilientClient::available() const {
+    return connected.load(std::memory_order_acquire);
+}
+
+bool ResilientClient::connectionLost(int result) {
+    // Only errors with a TCP or ISO part mean the stream is broken, errors reported by
+    // the PLC (address out of range, item not available, ...) leave it usable
+    if ((result & 0x000FFFFF) == 0) {
+        return false;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        connected.store(false, std::memory_order_release);
+        lostAt = std::chrono::steady_clock::now();
+        reconnectStats.losses++;
+    }
+    wakeup.notify_all();
+    return true;
+}
+
+int ResilientClient::pduSize() const {
+    return negotiatedPdu.load(std::memory_order_relaxed);
+}
+
+ReconnectStats ResilientClient::stats() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return reconnectStats;
+}
+
+void ResilientClient::reconnectLoop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        wakeup.wait(lock, [this]() { return stopping || !connected.load(std::memory_order_relaxed); });
+        if (stopping) {
+            return;
+        }
+
+        // The caller doesn't touch the client until connected is set again
+        int backoff = initialBackoff;
+        while (!stopping) {
+            lock.unlock();
+            Cli_Disconnect(client);
+            int result = Cli_ConnectTo(client, host.c_str(), rack, slot);
+            int requested = 0, negotiated = 0;
+            if (result == 0) {
+                result = Cli_GetPduLength(client, requested, negotiated);
+            }
+            lock.lock();
+            reconnectStats.attempts++;
+            if (result == 0) {
+                negotiatedPdu.store(negotiated, std::memory_order_relaxed);
+                reconnectStats.gaps.push_back(std::chrono::duration_cast<std::chrono::microseconds>(
+                        std::chrono::steady_clock::now() - lostAt).count());
+                connected.store(true, std::memory_order_release);
+                break;
+            }
+            wakeup.wait_for(lock, std::chrono::milliseconds(backoff), [this]() { return stopping; });
+            backoff = std::min(backoff * 2, maxBackoff);
+        }
+    }
+}
@@ -0,0 +1,92 @@
+#ifndef RESILIENT_CLIENT_H
+#define RESILIENT_CLIENT_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "BaseTest.h"
+#include "../lib/snap7_libmain.h"
+
+/**
+ * Keeps a connected snap7 client connected. A failed operation that broke the connection
+ * hands the client over to a background thread, which reconnects it with an exponential
+ * backoff, so the cycles of the caller don't block on connect timeouts. The caller must
+ * not use the client while available() returns false.
+ */
+class ResilientClient {
+public:
+    /**
+     * Constructor, the client must be connected already.
+     *
+     * @param client The snap7 client (not owned)
+     * @param host Host name or IP address of the PLC
+     * @param rack Rack number of the PLC
+     * @param slot Slot number of the PLC
+     * @param pduSize PDU size negotiated by the first connect
+     */
+    ResilientClient(S7Object client, const std::string& host, int rack, int slot, int pduSize);
+
+    /**
+     * Destructor, stops a pending reconnect.
+     */
+    ~ResilientClient();
+
+    /**
+     * Set the wait before the first reconnect attempt, doubled after every failed attempt.
+     *
+     * @param initialMs Wait before the first attempt (in milliseconds)
+     * @param maxMs Longest wait between two attempts (in milliseconds)
+     */
+    void setBackoff(int initialMs, int maxMs);
+
+    /**
+     * Whether the client is connected and can be used, doesn't block.
+     */
+    bool available() const;
+
+    /**
+     * Pass the result of an operation on the client. An error that broke the connection
+     * starts the reconnect.
+     *
+     * @param result Result of the snap7 function
+     * @return true if the connection was lost
+     */
+    bool connectionLost(int result);
+
+    /**
+     * PDU size negotiated by the last connect, only valid while available() returns true.
+     */
+    int pduSize() const;
+
+    /**
+     * Connection losses, reconnect attempts and gaps so far.
+     */
+    ReconnectStats stats();
+
+private:
+    S7Object client;
+    std::string host;
+    int rack;
+    int slot;
+    int initialBackoff = 100;
+    int maxBackoff = 5000;
+    std::atomic<bool> connected{true};
+    std::atomic<int> negotiatedPdu;
+    std::chrono::steady_clock::time_point lostAt;
+    bool stopping = false;
+    std::mutex mutex;
+    std::condition_variable wakeup;
+    ReconnectStats reconnectStats;
+    std::thread reconnector;
+
+    /**
+     * Body of the reconnect thread.
+     */
+    void reconnectLoop();
+};
+
+#endif // RESILIENT_CLIENT_H
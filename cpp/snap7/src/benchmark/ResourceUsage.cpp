@@ -0,0 +1,133 @@
+#include "ResourceUsage.h"
+#include "AllocationCounter.h"
+#include <cstdio>
+#include <cstring>
+#if defined(__linux__)
+#include <dlfcn.h>
+#include <poll.h>
+#include <sys/resource.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#endif
+
+namespace {
+
+thread_local uint64_t numSocketCalls = 0;
+
+#if defined(__linux__)
+/**
+ * Read syscr and syscw from /proc/thread-self/io (falls back to the whole process on
+ * kernels before 3.17).
+ */
+bool readSyscalls(uint64_t& syscalls) {
+    FILE* file = std::fopen("/proc/thread-self/io", "r");
+    if (!file) {
+        file = std::fopen("/proc/self/io", "r");
+    }
+    if (!file) {
+        return false;
+    }
+    char line[128];
+    unsigned long long value;
+    syscalls = 0;
+    while (std::fgets(line, sizeof(line), file)) {
+        if (std::sscanf(line, "syscr: %llu", &value) == 1 || std::sscanf(line, "syscw: %llu", &value) == 1) {
+            syscalls += value;
+        }
+    }
+    std::fclose(file);
+    return true;
+}
+#endif
+
+}
+
+#if defined(__linux__)
+/**
+ * Socket calls don't show up in syscr/syscw, so the libc wrappers used by snap7 are
+ * interposed here: they count the call and forward it to the next definition (libc).
+ */
+#define COUNTED_CALL(name, ...)                                                              \
+    static auto next = reinterpret_cast<decltype(&name)>(dlsym(RTLD_NEXT, #name));       \
+    numSocketCalls++;                                                                    \
+    return next(__VA_ARGS__)
+
+extern "C" {
+
+ssize_t send(int fd, const void* data, size_t size, int flags) {
+    COUNTED_CALL(send, fd, data, size, flags);
+}
+
+ssize_t recv(int fd, void* data, size_t size, int flags) {
+    COUNTED_CALL(recv, fd, data, size, flags);
+}
+
+ssize_t sendto(int fd, const void* data, size_t size, int flags, const struct sockaddr* address, socklen_t length) {
+    COUNTED_CALL(sendto, fd, data, size, flags, address, length);
+}
+
+ssize_t recvfrom(int fd, void* data, size_t size, int flags, struct sockaddr* address, socklen_t* length) {
+    COUNTED_CALL(recvfrom, fd, data, size, flags, address, length);
+}
+
+int select(int numFds, fd_set* readFds, fd_set* writeFds, fd_set* exceptFds, struct timeval* timeout) {
+    COUNTED_CALL(select, numFds, readFds, writeFds, exceptFds, timeout);
+}
+
+int poll(struct pollfd* fds, nfds_t numFds, int timeout) {
+    COUNTED_CALL(poll, fds, numFds, timeout);
+}
+
+}
+#endif
+
+ResourceUsage& ResourceUsage::operator+=(const ResourceUsage& other) {
+    allocations += other.allocations;
+    allocatedBytes += other.allocatedBytes;
+    syscalls += other.syscalls;
+    voluntarySwitches += other.voluntarySwitches;
+    involuntarySwitches += other.involuntarySwitches;
+    userMicros += other.userMicros;
+    systemMicros += other.systemMicros;
+    return *this;
+}
+
+ResourceUsage ResourceUsage::operator-(const ResourceUsage& other) const {
+    ResourceUsage difference;
+    difference.allocations = allocations - other.allocations;
+    difference.allocatedBytes = allocatedBytes - other.allocatedBytes;
+    difference.syscalls = syscalls - other.syscalls;
+    difference.voluntarySwitches = voluntarySwitches - other.voluntarySwitches;
+    difference.involuntarySwitches = involuntarySwitches - other.involuntarySwitches;
+    difference.userMicros = userMicros - other.userMicros;
+    difference.systemMicros = systemMicros - other.systemMicros;
+    return difference;
+}
+
+ResourceUsage currentResourceUsage() {
+    ResourceUsage usage;
+    usage.allocations = allocationCount();
+    usage.allocatedBytes = allocatedBytes();
+#if defined(__linux__)
+    struct rusage rusage;
+    if (getrusage(RUSAGE_THREAD, &rusage) == 0) {
+        usage.voluntarySwitches = rusage.ru_nvcsw;
+        usage.involuntarySwitches = rusage.ru_nivcsw;
+        usage.userMicros = rusage.ru_utime.tv_sec * 1000000ULL + rusage.ru_utime.tv_usec;
+        usage.systemMicros = rusage.ru_stime.tv_sec * 1000000ULL + rusage.ru_stime.tv_usec;
+    }
+    readSyscalls(usage.syscalls);
+    usage.syscalls += numSocketCalls;
+#endif
+    return usage;
+}
+
+bool syscallCountsAvailable() {
+#if defined(__linux__)
+    uint64_t syscalls;
+    return readSyscalls(syscalls);
+#else
+    return false;
+#endif
+}
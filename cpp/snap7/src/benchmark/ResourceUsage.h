@@ -0,0 +1,36 @@
+#ifndef RESOURCE_USAGE_H
+#define RESOURCE_USAGE_H
+
+#include <cstdint>
+
+/**
+ * Resources used by the calling thread. Allocations come from the AllocationCounter (which
+ * must be linked into the executable), the rest from getrusage and /proc/thread-self/io on
+ * Linux, plus the socket calls counted by wrappers around send, recv, select and poll
+ * (which is why ResourceUsage.cpp must be linked into the executable as well). Counters
+ * that are not available on a platform stay zero.
+ */
+struct ResourceUsage {
+    uint64_t allocations = 0;
+    uint64_t allocatedBytes = 0;
+    uint64_t syscalls = 0;            // Read/write class system calls (syscr + syscw) and socket calls
+    uint64_t voluntarySwitches = 0;   // Context switches while waiting (e.g. for the PLC)
+    uint64_t involuntarySwitches = 0; // Context switches because the time slice was used up
+    uint64_t userMicros = 0;          // CPU time in user space
+    uint64_t systemMicros = 0;        // CPU time in the kernel
+
+    ResourceUsage& operator+=(const ResourceUsage& other);
+    ResourceUsage operator-(const ResourceUsage& other) const;
+};
+
+/**
+ * Read the counters of the calling thread. Doesn't allocate.
+ */
+ResourceUsage currentResourceUsage();
+
+/**
+ * @return true if the syscall counters can be read on this system
+ */
+bool syscallCountsAvailable();
+
+#endif // RESOURCE_USAGE_H
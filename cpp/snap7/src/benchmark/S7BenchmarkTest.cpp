@@ -1,32 +1,161 @@
 #include "Snap7Test.h"
 #include "Snap7OptimizedTest.h"
+#include "LoadGenerator.h"
+#include "BenchmarkResults.h"
 #include <iostream>
 #include <fstream>
 #include <sstream>
 #include <string>
 #include <map>
+#include <memory>
+#include <algorithm>
+#include <iomanip>
+#include <cmath>
+
+/**
+ * Print the performance counters of one phase of a test.
+ * 
+ * @param results The results of the test
+ * @param phase Name of the phase
+ * @param sample Counters of the phase
+ * @param divisor Number of operations the counters are divided by
+ */
+void printPerf(const TestResults& results, const std::string& phase, const PerfSample& sample, double divisor) {
+    std::cout << "  --> perf " << phase << ":" << std::fixed << std::setprecision(0);
+    for (int event = 0; event < PERF_EVENT_COUNT; event++) {
+        std::cout << (event == 0 ? " " : ", ");
+        if (!results.perfAvailable[event]) {
+            std::cout << "n/a " << PerfCounters::name(static_cast<PerfEvent>(event));
+        } else if (event == PERF_TASK_CLOCK) {
+            std::cout << std::setprecision(1) << sample.values[event] / divisor / 1000.0 << " us "
+                      << PerfCounters::name(static_cast<PerfEvent>(event)) << std::setprecision(0);
+        } else {
+            std::cout << sample.values[event] / divisor << " " << PerfCounters::name(static_cast<PerfEvent>(event));
+        }
+    }
+    if (results.perfAvailable[PERF_CYCLES] && results.perfAvailable[PERF_INSTRUCTIONS] &&
+        sample.values[PERF_CYCLES] > 0) {
+        std::cout << std::setprecision(2) << " (IPC "
+                  << static_cast<double>(sample.values[PERF_INSTRUCTIONS]) / sample.values[PERF_CYCLES] << ")";
+    }
+    std::cout << std::defaultfloat << std::endl;
+}
+
+/**
+ * How the benchmark tests are run.
+ */
+struct RunOptions {
+    int numCycles = 50;             // Number of read cycles to perform
+    int cycleTime = 300;            // Time between read cycles (in milliseconds)
+    bool changeDetection = false;   // Only decode and return values that changed since the previous cycle
+    double deadband = 0.0;          // Absolute deadband for REAL and LREAL values when using change detection
+    std::string capturePrefix;      // Prefix of the pcap file the traffic of a test is captured to (empty = no capture)
+    bool clientStats = false;       // Print the statistics of the driver after a test
+    bool fixedRate = false;         // Schedule the cycles on a fixed timeline, report the latency from the intended start
+    bool perfCounters = false;      // Collect performance counters for connect, read and disconnect
+    double writeRatio = 0.0;        // Fraction of the cycles that write the expected values instead of reading
+    bool verifyWrites = false;      // Read the values back after every write
+};
 
 /**
  * Run a benchmark test.
  * 
  * @param test The test to run
- * @param numCycles Number of read cycles to perform
- * @param cycleTime Time between read cycles (in milliseconds)
  * @param tagValues Map of tag addresses to expected values
+ * @param options How to run the test
+ * @return The results of the test
  */
-void runTest(BaseTest& test, int numCycles, int cycleTime, const std::map<std::string, std::string>& tagValues) {
+TestResults runTest(BaseTest& test, const std::map<std::string, std::string>& tagValues, const RunOptions& options) {
     std::cout << "Running: '" << test.getName() << "'" << std::endl;
-    TestResults testResults = test.run(numCycles, cycleTime, tagValues);
+    test.setChangeDetection(options.changeDetection, options.deadband);
+    test.setFixedRate(options.fixedRate);
+    test.setPerfCounters(options.perfCounters);
+    test.setWriteRatio(options.writeRatio, options.verifyWrites);
+    std::string captureFile = options.capturePrefix.empty() ? "" : options.capturePrefix + "-" + test.getName() + ".pcap";
+    test.setCaptureFile(captureFile);
+    TestResults testResults = test.run(options.numCycles, options.cycleTime, tagValues);
     
     int totalReadTime = 0;
     for (int readTime : testResults.readTimes) {
         totalReadTime += readTime;
     }
-    int averageReadTime = totalReadTime / testResults.numReadCycles;
+    int averageReadTime = testResults.numReadCycles > 0 ? totalReadTime / testResults.numReadCycles : 0;
     
     std::cout << "  --> " << testResults.connectionTime << " ms connect, "
               << testResults.disconnectionTime << " ms disconnect, "
-              << averageReadTime << " ms avg read time" << std::endl;
+              << averageReadTime << " ms avg read time";
+    if (options.changeDetection) {
+        std::cout << ", " << testResults.emittedValues << " values emitted";
+    }
+    std::cout << std::endl;
+    if (!testResults.writeLatencies.empty()) {
+        LatencySummary writes = summarize(testResults.writeLatencies);
+        std::cout << std::fixed << std::setprecision(2)
+                  << "  --> " << writes.count << " writes, " << writes.mean / 1000.0 << " ms avg, "
+                  << writes.p50 / 1000.0 << " ms p50, " << writes.p99 / 1000.0 << " ms p99 write time"
+                  << std::defaultfloat;
+        if (options.verifyWrites) {
+            std::cout << ", " << testResults.verifiedWrites << " verified by reading back";
+        }
+        std::cout << std::endl;
+    }
+    const ResourceUsage& resources = testResults.resources;
+    double cycles = std::max<size_t>(testResults.readLatencies.size() + testResults.writeLatencies.size(), 1);
+    std::cout << std::fixed << std::setprecision(1)
+              << "  --> " << resources.allocations / cycles << " allocations ("
+              << resources.allocatedBytes / cycles << " bytes), "
+              << resources.syscalls / cycles << " syscalls, "
+              << (resources.voluntarySwitches + resources.involuntarySwitches) / cycles << " context switches, "
+              << (resources.userMicros + resources.systemMicros) / cycles << " us CPU per cycle"
+              << std::defaultfloat << std::endl;
+    if (testResults.perfCounters) {
+        printPerf(testResults, "connect", testResults.connectPerf, 1);
+        printPerf(testResults, "read/cycle", testResults.readPerf,
+                  std::max<size_t>(testResults.readLatencies.size(), 1));
+        if (!testResults.writeLatencies.empty()) {
+            printPerf(testResults, "write/cycle", testResults.writePerf, testResults.writeLatencies.size());
+        }
+        printPerf(testResults, "disconnect", testResults.disconnectPerf, 1);
+        if (testResults.perfAvailable[PERF_TASK_CLOCK]) {
+            // Whatever isn't spent on the CPU is spent waiting for the PLC
+            double readMicros = 0.0;
+            for (int64_t latency : testResults.readLatencies) {
+                readMicros += static_cast<double>(latency);
+            }
+            double onCpu = readMicros > 0.0 ? testResults.readPerf.values[PERF_TASK_CLOCK] / 10.0 / readMicros : 0.0;
+            std::cout << "  --> " << std::fixed << std::setprecision(1) << onCpu
+                      << "% of the read time on the CPU" << std::defaultfloat << std::endl;
+        }
+    }
+    if (testResults.fixedRate && !testResults.cycleLatencies.empty()) {
+        std::vector<int64_t> latencies = testResults.cycleLatencies;
+        std::sort(latencies.begin(), latencies.end());
+        int64_t maxStartDelay = *std::max_element(testResults.startDelays.begin(), testResults.startDelays.end());
+        std::cout << std::fixed << std::setprecision(2)
+                  << "  --> " << percentile(latencies, 0.5) / 1000.0 << " ms p50, "
+                  << percentile(latencies, 0.99) / 1000.0 << " ms p99, "
+                  << percentile(latencies, 1.0) / 1000.0 << " ms max latency from intended start, "
+                  << maxStartDelay / 1000.0 << " ms max start delay" << std::endl
+                  << std::defaultfloat
+                  << "  --> " << testResults.missedDeadlines << " of " << testResults.numReadCycles
+                  << " cycles missed their " << options.cycleTime << " ms deadline" << std::endl;
+    }
+    ReconnectStats reconnects;
+    if (test.getReconnectStats(reconnects)) {
+        LatencySummary gaps = summarize(reconnects.gaps);
+        std::cout << std::fixed << std::setprecision(1)
+                  << "  --> " << reconnects.losses << " connections lost, " << reconnects.attempts
+                  << " reconnect attempts, " << gaps.mean / 1000.0 << " ms avg, " << gaps.max / 1000.0
+                  << " ms max gap, " << testResults.skippedCycles << " cycles skipped, "
+                  << reconnects.replans << " plans rebuilt" << std::defaultfloat << std::endl;
+    }
+    if (!captureFile.empty()) {
+        std::cout << "  --> traffic captured to " << captureFile << std::endl;
+    }
+    if (options.clientStats) {
+        test.printStatistics(std::cout);
+    }
+    return testResults;
 }
 
 /**
@@ -34,11 +163,31 @@ void runTest(BaseTest& test, int numCycles, int cycleTime, const std::map<std::s
  */
 int main(int argc, char* argv[]) {
     // Get configuration from environment variables or command line arguments
+    RunOptions options;
     std::string host = std::getenv("host") ? std::getenv("host") : "192.168.23.30";
     int remoteRack = std::getenv("remoteRack") ? std::stoi(std::getenv("remoteRack")) : 0;
     int remoteSlot = std::getenv("remoteSlot") ? std::stoi(std::getenv("remoteSlot")) : 1;
-    int numCycles = std::getenv("numCycles") ? std::stoi(std::getenv("numCycles")) : 50;
-    int cycleTime = std::getenv("cycleTime") ? std::stoi(std::getenv("cycleTime")) : 300;
+    options.numCycles = std::getenv("numCycles") ? std::stoi(std::getenv("numCycles")) : 50;
+    options.cycleTime = std::getenv("cycleTime") ? std::stoi(std::getenv("cycleTime")) : 300;
+    options.changeDetection = std::getenv("changeDetection") ? std::string(std::getenv("changeDetection")) == "true" : false;
+    options.deadband = std::getenv("deadband") ? std::stod(std::getenv("deadband")) : 0.0;
+    std::string recordFile = std::getenv("recordFile") ? std::getenv("recordFile") : "";
+    options.capturePrefix = std::getenv("captureFile") ? std::getenv("captureFile") : "";
+    options.clientStats = std::getenv("clientStats") ? std::string(std::getenv("clientStats")) == "true" : false;
+    std::string traceFile = std::getenv("traceFile") ? std::getenv("traceFile") : "";
+    options.fixedRate = std::getenv("fixedRate") ? std::string(std::getenv("fixedRate")) == "true" : false;
+    int loadClients = std::getenv("loadClients") ? std::stoi(std::getenv("loadClients")) : 0;
+    bool loadRamp = std::getenv("loadRamp") ? std::string(std::getenv("loadRamp")) == "true" : false;
+    std::string loadTest = std::getenv("loadTest") ? std::getenv("loadTest") : "optimized";
+    options.perfCounters = std::getenv("perfCounters") ? std::string(std::getenv("perfCounters")) == "true" : false;
+    std::string resultsJson = std::getenv("resultsJson") ? std::getenv("resultsJson") : "";
+    std::string resultsCsv = std::getenv("resultsCsv") ? std::getenv("resultsCsv") : "";
+    std::string baseline = std::getenv("baseline") ? std::getenv("baseline") : "";
+    double threshold = std::getenv("threshold") ? std::stod(std::getenv("threshold")) : 0.1;
+    options.writeRatio = std::getenv("writeRatio") ? std::stod(std::getenv("writeRatio")) : 0.0;
+    options.verifyWrites = std::getenv("verifyWrites") ? std::string(std::getenv("verifyWrites")) == "true" : false;
+    bool autoReconnect = std::getenv("autoReconnect") ? std::string(std::getenv("autoReconnect")) == "true" : false;
+    int pduRequest = std::getenv("pduRequest") ? std::stoi(std::getenv("pduRequest")) : 0;
     std::string defaultTags = "%DB4:0.0:BOOL|BOOL;true\n"
             "%DB4:1:BYTE|USINT;42\n"
             "%DB4:2:WORD|UINT;42424\n"
@@ -71,9 +220,47 @@ int main(int argc, char* argv[]) {
         } else if (arg == "--remoteSlot" && i + 1 < argc) {
             remoteSlot = std::stoi(argv[++i]);
         } else if (arg == "--numCycles" && i + 1 < argc) {
-            numCycles = std::stoi(argv[++i]);
+            options.numCycles = std::stoi(argv[++i]);
         } else if (arg == "--cycleTime" && i + 1 < argc) {
-            cycleTime = std::stoi(argv[++i]);
+            options.cycleTime = std::stoi(argv[++i]);
+        } else if (arg == "--changeDetection") {
+            options.changeDetection = true;
+        } else if (arg == "--deadband" && i + 1 < argc) {
+            options.deadband = std::stod(argv[++i]);
+        } else if (arg == "--recordFile" && i + 1 < argc) {
+            recordFile = argv[++i];
+        } else if (arg == "--captureFile" && i + 1 < argc) {
+            options.capturePrefix = argv[++i];
+        } else if (arg == "--clientStats") {
+            options.clientStats = true;
+        } else if (arg == "--traceFile" && i + 1 < argc) {
+            traceFile = argv[++i];
+        } else if (arg == "--fixedRate") {
+            options.fixedRate = true;
+        } else if (arg == "--loadClients" && i + 1 < argc) {
+            loadClients = std::stoi(argv[++i]);
+        } else if (arg == "--loadRamp") {
+            loadRamp = true;
+        } else if (arg == "--loadTest" && i + 1 < argc) {
+            loadTest = argv[++i];
+        } else if (arg == "--perfCounters") {
+            options.perfCounters = true;
+        } else if (arg == "--resultsJson" && i + 1 < argc) {
+            resultsJson = argv[++i];
+        } else if (arg == "--resultsCsv" && i + 1 < argc) {
+            resultsCsv = argv[++i];
+        } else if (arg == "--baseline" && i + 1 < argc) {
+            baseline = argv[++i];
+        } else if (arg == "--threshold" && i + 1 < argc) {
+            threshold = std::stod(argv[++i]);
+        } else if (arg == "--writeRatio" && i + 1 < argc) {
+            options.writeRatio = std::stod(argv[++i]);
+        } else if (arg == "--verifyWrites") {
+            options.verifyWrites = true;
+        } else if (arg == "--autoReconnect") {
+            autoReconnect = true;
+        } else if (arg == "--pduRequest" && i + 1 < argc) {
+            pduRequest = std::stoi(argv[++i]);
         }
     }
     
@@ -118,14 +305,97 @@ int main(int argc, char* argv[]) {
         tagValues[address] = value;
     }
     
-    std::cout << "Scenario: " << tagValues.size() << " tags, " << numCycles << " cycles, " << cycleTime << "ms intervals" << std::endl << std::endl;
+    std::cout << "Scenario: " << tagValues.size() << " tags, " << options.numCycles << " cycles, " << options.cycleTime << "ms intervals" << std::endl << std::endl;
     
+    // Run the load test (N concurrent clients) instead of the sequential tests
+    if (loadClients > 0) {
+        LoadGenerator::TestFactory factory;
+        if (loadTest == "snap7") {
+            factory = [&]() { return std::make_unique<Snap7Test>(host, remoteRack, remoteSlot); };
+        } else if (loadTest == "optimized") {
+            factory = [&]() {
+                auto test = std::make_unique<Snap7OptimizedTest>(host, remoteRack, remoteSlot);
+                test->setAutoReconnect(autoReconnect);
+                test->setPduRequest(pduRequest);
+                return test;
+            };
+        } else {
+            std::cerr << "Unknown load test: " << loadTest << " (expected snap7 or optimized)" << std::endl;
+            return 1;
+        }
+        if (tagValues.empty()) {
+            std::cerr << "The load test needs at least one tag" << std::endl;
+            return 1;
+        }
+        LoadGenerator loadGenerator(factory, tagValues, options.numCycles, options.cycleTime, options.fixedRate);
+        loadGenerator.run(loadClients, loadRamp, std::cout);
+        return 0;
+    }
+
     // Run the test
+    BenchmarkResults results;
+    results.configuration = {
+        {"host", host}, {"remoteRack", std::to_string(remoteRack)}, {"remoteSlot", std::to_string(remoteSlot)},
+        {"numCycles", std::to_string(options.numCycles)}, {"cycleTime", std::to_string(options.cycleTime)},
+        {"numTags", std::to_string(tagValues.size())}, {"changeDetection", options.changeDetection ? "true" : "false"},
+        {"deadband", std::to_string(options.deadband)}, {"fixedRate", options.fixedRate ? "true" : "false"},
+        {"perfCounters", options.perfCounters ? "true" : "false"}, {"writeRatio", std::to_string(options.writeRatio)},
+        {"verifyWrites", options.verifyWrites ? "true" : "false"}, {"autoReconnect", autoReconnect ? "true" : "false"},
+        {"pduRequest", std::to_string(pduRequest)},
+        {"tags", tagStringList}
+    };
+    results.environment = collectEnvironment();
+
     Snap7Test snap7Test(host, remoteRack, remoteSlot);
-    runTest(snap7Test, numCycles, cycleTime, tagValues);
+    results.tests.push_back({snap7Test.getName(),
+        runTest(snap7Test, tagValues, options)});
 
     Snap7OptimizedTest snap7OptimizedTest(host, remoteRack, remoteSlot);
-    runTest(snap7OptimizedTest, numCycles, cycleTime, tagValues);
+    snap7OptimizedTest.setAutoReconnect(autoReconnect);
+    snap7OptimizedTest.setPduRequest(pduRequest);
+    std::unique_ptr<TimeSeriesRecorder> recorder;
+    if (!recordFile.empty()) {
+        recorder = std::make_unique<TimeSeriesRecorder>(recordFile);
+        snap7OptimizedTest.setRecorder(recorder.get());
+    }
+    results.tests.push_back({snap7OptimizedTest.getName(),
+        runTest(snap7OptimizedTest, tagValues, options)});
     
+    if (recorder) {
+        recorder->close();
+        std::cout << "Recorded " << recorder->getNumSamples() << " samples to " << recordFile
+                  << " (" << recorder->getFileSize() << " bytes)" << std::endl;
+    }
+
+    if (!traceFile.empty()) {
+        int result = Trc_Dump(traceFile.c_str());
+        if (result == 0) {
+            std::cout << "Trace written to " << traceFile << std::endl;
+        } else {
+            char text[1024];
+            Cli_ErrorText(result, text, sizeof(text));
+            std::cerr << "Failed to write trace: " << text << std::endl;
+        }
+    }
+
+    if (!resultsJson.empty()) {
+        writeResultsJson(resultsJson, results);
+        std::cout << "Results written to " << resultsJson << std::endl;
+    }
+    if (!resultsCsv.empty()) {
+        writeResultsCsv(resultsCsv, results);
+        std::cout << "Samples written to " << resultsCsv << std::endl;
+    }
+
+    // Fail the run if it got slower than the baseline
+    if (!baseline.empty()) {
+        std::cout << std::endl;
+        if (!compareResults(loadResultsJson(baseline), results, threshold, std::cout)) {
+            std::cout << "Regression against " << baseline << " (threshold " << threshold * 100 << "%)" << std::endl;
+            return 2;
+        }
+        std::cout << "No regression against " << baseline << std::endl;
+    }
+
     return 0;
 }
\ No newline at end of file
@@ -1,9 +1,10 @@
 #include "Snap7OptimizedTest.h"
 #include <regex>
 #include <cstring>
+#include <algorithm>
 
 Snap7OptimizedTest::Snap7OptimizedTest(const std::string& host, int rack, int slot)
-    : host(host), rack(rack), slot(slot), client(0), connected(false), pduSize(0) {
+    : host(host), rack(rack), slot(slot), client(0), connected(false), pduSize(0), recorder(nullptr) {
 }
 
 Snap7OptimizedTest::~Snap7OptimizedTest() {
@@ -29,7 +30,26 @@ void Snap7OptimizedTest::connect() {
         throw std::runtime_error("Failed to create Snap7 client");
     }
 
-    int result = Cli_ConnectTo(client, host.c_str(), rack, slot);
+    int result;
+    if (!captureFile.empty()) {
+        result = Cli_StartCapture(client, captureFile.c_str());
+        if (result != 0) {
+            char errorText[1024];
+            Cli_ErrorText(result, errorText, sizeof(errorText));
+            throw std::runtime_error("Failed to start capture: " + std::string(errorText));
+        }
+    }
+
+    if (pduRequest > 0) {
+        result = Cli_SetParam(client, p_i32_PDURequest, &pduRequest);
+        if (result != 0) {
+            char errorText[1024];
+            Cli_ErrorText(result, errorText, sizeof(errorText));
+            throw std::runtime_error("Failed to set the PDU size: " + std::string(errorText));
+        }
+    }
+
+    result = Cli_ConnectTo(client, host.c_str(), rack, slot);
     if (result != 0) {
         char errorText[1024];
         Cli_ErrorText(result, errorText, sizeof(errorText));
@@ -46,6 +66,12 @@ void Snap7OptimizedTest::connect() {
     }
     pduSize = negotiatedPduSize;
 
+    if (autoReconnect) {
+        reconnectStats = ReconnectStats();
+        replans = 0;
+        resilient = std::make_unique<ResilientClient>(client, host, rack, slot, pduSize);
+        resilient->setBackoff(initialBackoff, maxBackoff);
+    }
     connected = true;
 }
 
@@ -54,13 +80,138 @@ void Snap7OptimizedTest::disconnect() {
         return;
     }
 
+    // Stop a pending reconnect before disconnecting
+    if (resilient) {
+        reconnectStats = resilient->stats();
+        resilient.reset();
+    }
     Cli_Disconnect(client);
     connected = false;
 }
 
+void Snap7OptimizedTest::setAutoReconnect(bool enabled, int initialBackoff, int maxBackoff) {
+    this->autoReconnect = enabled;
+    this->initialBackoff = initialBackoff;
+    this->maxBackoff = maxBackoff;
+}
+
+void Snap7OptimizedTest::setPduRequest(int size) {
+    this->pduRequest = size;
+}
+
+bool Snap7OptimizedTest::getReconnectStats(ReconnectStats& stats) {
+    if (!autoReconnect) {
+        return false;
+    }
+    stats = resilient ? resilient->stats() : reconnectStats;
+    stats.replans = replans;
+    return true;
+}
+
+void Snap7OptimizedTest::ensureConnected() {
+    if (!resilient) {
+        return;
+    }
+    if (!resilient->available()) {
+        throw ConnectionLost("Reconnecting to " + host);
+    }
+
+    // The prepared plan only needs to be rebuilt if the PLC came back with another PDU size
+    int negotiated = resilient->pduSize();
+    if (negotiated != pduSize) {
+        pduSize = negotiated;
+        if (!changePlanTags.empty()) {
+            changePlanTags.clear();
+            replans++;
+        }
+    }
+}
+
+void Snap7OptimizedTest::throwError(int result, const std::string& message) {
+    char errorText[1024];
+    Cli_ErrorText(result, errorText, sizeof(errorText));
+    if (resilient && resilient->connectionLost(result)) {
+        throw ConnectionLost(message + ": " + std::string(errorText));
+    }
+    throw std::runtime_error(message + ": " + std::string(errorText));
+}
+
+void Snap7OptimizedTest::printStatistics(std::ostream& out) {
+    if (client) {
+        printClientStats(out, client);
+    }
+}
+
+bool Snap7OptimizedTest::getDriverCounters(DriverCounters& counters) {
+    return client && sumClientStats(client, counters);
+}
+
 std::map<std::string, PlcValue> Snap7OptimizedTest::read(const std::map<std::string, std::string>& tags) {
     std::map<std::string, PlcValue> results;
 
+    ensureConnected();
+
+    ReadPlan plan = buildReadPlan(tags);
+    executeReadPlan(plan);
+
+    // Convert the data to the appropriate type and store in results
+    for (const auto& group : plan.groups) {
+        for (const auto& item : group.items) {
+            results[item.tagName] = convertBufferToPlcValue(group.buffer.data() + item.offset, item.type);
+        }
+    }
+
+    return results;
+}
+
+void Snap7OptimizedTest::write(const std::map<std::string, std::string>& tags, const std::map<std::string, PlcValue>& values) {
+    ensureConnected();
+    ReadPlan plan = buildReadPlan(tags, true);
+
+    // Encode the values into the group buffers
+    for (auto& group : plan.groups) {
+        for (const auto& item : group.items) {
+            auto value = values.find(item.tagName);
+            if (value == values.end()) {
+                throw std::runtime_error("No value to write for tag " + item.tagName);
+            }
+            encodeValue(value->second, item.type, item.size, group.buffer.data() + item.offset);
+        }
+    }
+
+    executeWritePlan(plan);
+}
+
+std::map<std::string, PlcValue> Snap7OptimizedTest::readChanges(const std::map<std::string, std::string>& tags) {
+    std::map<std::string, PlcValue> results;
+
+    ensureConnected();
+
+    // The plan is kept between cycles, as the change detection compares against the previous buffers
+    if (changePlanTags != tags) {
+        changePlan = buildReadPlan(tags);
+        changePlanTags = tags;
+        changeDetector.reset();
+    }
+    changeDetector.setDeadband(deadband);
+    executeReadPlan(changePlan);
+
+    // Only decode the items whose bytes changed
+    changeDetector.detect(changePlan, changedItems);
+    for (const auto& [item, data] : changedItems) {
+        results[item->tagName] = convertBufferToPlcValue(data, item->type);
+    }
+
+    return results;
+}
+
+void Snap7OptimizedTest::setRecorder(TimeSeriesRecorder* recorder) {
+    this->recorder = recorder;
+}
+
+ReadPlan Snap7OptimizedTest::buildReadPlan(const std::map<std::string, std::string>& tags, bool forWrite) {
+    ReadPlan plan;
+
     // Parse all addresses first
     std::vector<std::tuple<std::string, int, int, int, int, int, PlcValueType>> parsedTags;
     for (const auto& [tagName, address] : tags) {
@@ -99,6 +250,10 @@ std::map<std::string, PlcValue> Snap7OptimizedTest::read(const std::map<std::str
 
             // Calculate the size this item would add to the PDU
             int itemSize = calculatePduItemSize(area, wordLen, size);
+            if (forWrite) {
+                // Written data is sent with a 4 byte header and padded to an even length
+                itemSize += 5;
+            }
 
             // Check if adding this item would exceed PDU size or max items limit
             if ((currentGroup.size() >= maxItemsPerRequest) || 
@@ -119,78 +274,116 @@ std::map<std::string, PlcValue> Snap7OptimizedTest::read(const std::map<std::str
             optimalGroups.push_back(currentGroup);
         }
 
-        // Process each optimal group
+        // Lay out the items of each group back to back in one buffer
         for (const auto& group : optimalGroups) {
-            // If there's only one item in the group, use the original method
-            if (group.size() == 1) {
-                auto [tagName, start, wordLen, size, _, type] = group[0];
+            ReadPlanGroup planGroup;
+            planGroup.area = area;
+            planGroup.dbNumber = dbNumber;
+            size_t offset = 0;
+            for (const auto& [tagName, start, wordLen, size, _, type] : group) {
+                int amount = (type == PlcValueType::STRING || type == PlcValueType::WSTRING) ? size : 1;
+                planGroup.items.push_back({tagName, start, wordLen, size, amount, type, offset});
+                offset += size;
+            }
+            planGroup.buffer.resize(offset);
+            plan.groups.push_back(std::move(planGroup));
+        }
+    }
 
-                // Allocate buffer for the data
-                std::vector<uint8_t> buffer(size);
+    return plan;
+}
 
-                // Read the data
-                int numElements = 1;
-                if (type == PlcValueType::STRING || type == PlcValueType::WSTRING) {
-                    numElements = size;
-                }
+void Snap7OptimizedTest::executeReadPlan(ReadPlan& plan) {
+    for (auto& group : plan.groups) {
+        // If there's only one item in the group, use the original method
+        if (group.items.size() == 1) {
+            const ReadPlanItem& item = group.items[0];
 
-                int result = Cli_ReadArea(client, area, dbNumber, start, numElements, wordLen, buffer.data());
-                if (result != 0) {
-                    char errorText[1024];
-                    Cli_ErrorText(result, errorText, sizeof(errorText));
-                    throw std::runtime_error("Failed to read from PLC: " + std::string(errorText));
-                }
+            int result = Cli_ReadArea(client, group.area, group.dbNumber, item.start, item.amount, item.wordLen, group.buffer.data());
+            if (result != 0) {
+                throwError(result, "Failed to read from PLC");
+            }
+            continue;
+        }
 
-                // Convert the data to the appropriate type and store in results
-                results[tagName] = convertBufferToPlcValue(buffer.data(), type);
-            } else {
-                // Use multi-item read for groups with more than one item
-                std::vector<TS7DataItem> dataItems(group.size());
-                std::vector<std::vector<uint8_t>> buffers(group.size());
-
-                // Prepare data items and buffers
-                for (size_t i = 0; i < group.size(); i++) {
-                    auto [tagName, start, wordLen, size, _, type] = group[i];
-
-                    // Allocate buffer for this item
-                    buffers[i].resize(size);
-
-                    // Set up data item
-                    dataItems[i].Area = area;
-                    dataItems[i].WordLen = wordLen;
-                    dataItems[i].DBNumber = dbNumber;
-                    dataItems[i].Start = start;
-                    dataItems[i].Amount = (type == PlcValueType::STRING || type == PlcValueType::WSTRING) ? size : 1;
-                    dataItems[i].pdata = buffers[i].data();
-                }
+        // Use multi-item read for groups with more than one item
+        std::vector<TS7DataItem> dataItems(group.items.size());
+
+        // Prepare data items pointing into the group buffer
+        for (size_t i = 0; i < group.items.size(); i++) {
+            const ReadPlanItem& item = group.items[i];
+            dataItems[i].Area = group.area;
+            dataItems[i].WordLen = item.wordLen;
+            dataItems[i].DBNumber = group.dbNumber;
+            dataItems[i].Start = item.start;
+            dataItems[i].Amount = item.amount;
+            dataItems[i].pdata = group.buffer.data() + item.offset;
+        }
 
-                // Perform multi-item read
-                int result = Cli_ReadMultiVars(client, dataItems.data(), static_cast<int>(dataItems.size()));
-                if (result != 0) {
-                    char errorText[1024];
-                    Cli_ErrorText(result, errorText, sizeof(errorText));
-                    throw std::runtime_error("Failed to read multiple items from PLC: " + std::string(errorText));
-                }
+        // Perform multi-item read
+        int result = Cli_ReadMultiVars(client, dataItems.data(), static_cast<int>(dataItems.size()));
+        if (result != 0) {
+            throwError(result, "Failed to read multiple items from PLC");
+        }
 
-                // Process results
-                for (size_t i = 0; i < group.size(); i++) {
-                    auto [tagName, start, wordLen, size, _, type] = group[i];
+        // Check if any specific item had an error
+        for (size_t i = 0; i < group.items.size(); i++) {
+            if (dataItems[i].Result != 0) {
+                char errorText[1024];
+                Cli_ErrorText(dataItems[i].Result, errorText, sizeof(errorText));
+                throw std::runtime_error("Failed to read item " + group.items[i].tagName + " from PLC: " + std::string(errorText));
+            }
+        }
+    }
 
-                    // Check if this specific item had an error
-                    if (dataItems[i].Result != 0) {
-                        char errorText[1024];
-                        Cli_ErrorText(dataItems[i].Result, errorText, sizeof(errorText));
-                        throw std::runtime_error("Failed to read item " + tagName + " from PLC: " + std::string(errorText));
-                    }
+    if (recorder) {
+        auto now = std::chrono::system_clock::now().time_since_epoch();
+        recorder->append(std::chrono::duration_cast<std::chrono::microseconds>(now).count(), plan);
+    }
+}
 
-                    // Convert the data to the appropriate type and store in results
-                    results[tagName] = convertBufferToPlcValue(buffers[i].data(), type);
-                }
+void Snap7OptimizedTest::executeWritePlan(ReadPlan& plan) {
+    for (auto& group : plan.groups) {
+        // If there's only one item in the group, use the original method
+        if (group.items.size() == 1) {
+            const ReadPlanItem& item = group.items[0];
+
+            int result = Cli_WriteArea(client, group.area, group.dbNumber, item.start, item.amount, item.wordLen, group.buffer.data());
+            if (result != 0) {
+                throwError(result, "Failed to write to PLC");
             }
+            continue;
         }
-    }
 
-    return results;
+        // Use multi-item write for groups with more than one item
+        std::vector<TS7DataItem> dataItems(group.items.size());
+
+        // Prepare data items pointing into the group buffer
+        for (size_t i = 0; i < group.items.size(); i++) {
+            const ReadPlanItem& item = group.items[i];
+            dataItems[i].Area = group.area;
+            dataItems[i].WordLen = item.wordLen;
+            dataItems[i].DBNumber = group.dbNumber;
+            dataItems[i].Start = item.start;
+            dataItems[i].Amount = item.amount;
+            dataItems[i].pdata = group.buffer.data() + item.offset;
+        }
+
+        // Perform multi-item write
+        int result = Cli_WriteMultiVars(client, dataItems.data(), static_cast<int>(dataItems.size()));
+        if (result != 0) {
+            throwError(result, "Failed to write multiple items to PLC");
+        }
+
+        // Check if any specific item had an error
+        for (size_t i = 0; i < group.items.size(); i++) {
+            if (dataItems[i].Result != 0) {
+                char errorText[1024];
+                Cli_ErrorText(dataItems[i].Result, errorText, sizeof(errorText));
+                throw std::runtime_error("Failed to write item " + group.items[i].tagName + " to PLC: " + std::string(errorText));
+            }
+        }
+    }
 }
 
 int Snap7OptimizedTest::calculatePduItemSize(int area, int wordLen, int size) {
@@ -238,8 +431,8 @@ int Snap7OptimizedTest::calculatePduItemSize(int area, int wordLen, int size) {
     return headerSize + dataSize;
 }
 
-PlcValue Snap7OptimizedTest::convertBufferToPlcValue(void* buffer, PlcValueType type) {
-    uint8_t* data = static_cast<uint8_t*>(buffer);
+PlcValue Snap7OptimizedTest::convertBufferToPlcValue(const void* buffer, PlcValueType type) {
+    const uint8_t* data = static_cast<const uint8_t*>(buffer);
 
     // Convert the data to the appropriate type
     switch (type) {
@@ -313,7 +506,7 @@ PlcValue Snap7OptimizedTest::convertBufferToPlcValue(void* buffer, PlcValueType
             {
                 // First byte is the max length, second byte is the actual length
                 int length = data[1];
-                std::string value(reinterpret_cast<char*>(data + 2), length);
+                std::string value(reinterpret_cast<const char*>(data + 2), length);
                 return PlcValue(value);
             }
         case PlcValueType::WSTRING:
@@ -2,6 +2,12 @@
 #define SNAP7_OPTIMIZED_TEST_H
 
 #include "BaseTest.h"
+#include "ChangeDetector.h"
+#include "ReadPlan.h"
+#include "TimeSeriesRecorder.h"
+#include "ClientStats.h"
+#include "ResilientClient.h"
+#include <memory>
 #include "../lib/snap7_libmain.h"
 
 /**
@@ -48,6 +54,67 @@ public:
      */
     std::map<std::string, PlcValue> read(const std::map<std::string, std::string>& tags) override;
 
+    /**
+     * Write values to the PLC, grouped like the reads into as few requests as possible.
+     * 
+     * @param tags Map of tag names to tag addresses
+     * @param values Map of tag names to the values to write
+     */
+    void write(const std::map<std::string, std::string>& tags, const std::map<std::string, PlcValue>& values) override;
+
+    /**
+     * Print the per-operation counters of the snap7 client.
+     * 
+     * @param out Stream to print to
+     */
+    void printStatistics(std::ostream& out) override;
+
+    /**
+     * Sum of the Cli_GetStats counters of the client.
+     */
+    bool getDriverCounters(DriverCounters& counters) override;
+
+    /**
+     * Read values from the PLC and only return the ones whose raw bytes changed
+     * since the previous call.
+     * 
+     * @param tags Map of tag names to tag addresses
+     * @return Map of tag names to changed values
+     */
+    std::map<std::string, PlcValue> readChanges(const std::map<std::string, std::string>& tags) override;
+
+    /**
+     * Record the raw values of every executed read plan.
+     * 
+     * @param recorder Recorder receiving the samples (nullptr to stop recording)
+     */
+    void setRecorder(TimeSeriesRecorder* recorder);
+
+    /**
+     * Reconnect in the background when the connection is lost, instead of failing. The
+     * cycles are skipped meanwhile (ConnectionLost), and the change detection plan is
+     * only rebuilt if the PLC comes back with a different PDU size. Applies to the next
+     * connect().
+     * 
+     * @param enabled true to reconnect
+     * @param initialBackoff Wait before the first reconnect attempt, doubled after every failure (in milliseconds)
+     * @param maxBackoff Longest wait between two attempts (in milliseconds)
+     */
+    void setAutoReconnect(bool enabled, int initialBackoff = 100, int maxBackoff = 5000);
+
+    /**
+     * PDU size requested from the PLC. Larger PDUs (960 on a S7-1500) pack more tags into
+     * every read; the PLC may still grant less. Applies to the next connect().
+     * 
+     * @param size PDU size in bytes (240..4096, 0 for the library default)
+     */
+    void setPduRequest(int size);
+
+    /**
+     * Connection losses, reconnects and gaps, if auto reconnect is enabled.
+     */
+    bool getReconnectStats(ReconnectStats& stats) override;
+
 private:
     std::string host;
     int rack;
@@ -55,6 +122,59 @@ private:
     S7Object client;
     bool connected;
     int pduSize; // Maximum PDU size negotiated with the PLC
+    ReadPlan changePlan; // Plan kept between cycles for change detection
+    std::map<std::string, std::string> changePlanTags; // Tags the change plan was built for
+    ChangeDetector changeDetector;
+    std::vector<ChangedItem> changedItems;
+    TimeSeriesRecorder* recorder;
+    int pduRequest = 0;
+    bool autoReconnect = false;
+    int initialBackoff = 100;
+    int maxBackoff = 5000;
+    std::unique_ptr<ResilientClient> resilient; // Only while connected with auto reconnect
+    ReconnectStats reconnectStats; // Stats of the last connection, kept after disconnect()
+    int replans = 0;
+
+    /**
+     * With auto reconnect, throw ConnectionLost while reconnecting and pick up the PDU
+     * size of the new connection.
+     */
+    void ensureConnected();
+
+    /**
+     * Throw the error of a failed request, ConnectionLost if it broke the connection
+     * and auto reconnect is enabled.
+     * 
+     * @param result Result of the snap7 function
+     * @param message Description of the failed request
+     */
+    void throwError(int result, const std::string& message);
+
+    /**
+     * Group the tags into as few requests as the negotiated PDU size allows.
+     * 
+     * @param tags Map of tag names to tag addresses
+     * @param forWrite Whether the plan is used for writing (the data travels in the request then)
+     * @return The read plan for the tags
+     */
+    ReadPlan buildReadPlan(const std::map<std::string, std::string>& tags, bool forWrite = false);
+
+    /**
+     * Execute all requests of a read plan, filling the group buffers.
+     * 
+     * @param plan The read plan to execute
+     */
+    void executeReadPlan(ReadPlan& plan);
+
+    /**
+     * Execute all requests of a write plan, sending the group buffers.
+     * 
+     * @param plan The write plan to execute
+     */
+    void executeWritePlan(ReadPlan& plan);
+
+protected:
+    // Protected so the micro benchmarks can measure them without a connection
 
     /**
      * Parse an S7 address string.
@@ -75,8 +195,9 @@ private:
      * @param type The type of the data
      * @return PlcValue object containing the converted data
      */
-    PlcValue convertBufferToPlcValue(void* buffer, PlcValueType type);
+    PlcValue convertBufferToPlcValue(const void* buffer, PlcValueType type);
 
+private:
     /**
      * Calculate the size of an item in the PDU.
      * 
@@ -29,7 +29,17 @@ void Snap7Test::connect() {
         throw std::runtime_error("Failed to create Snap7 client");
     }
 
-    int result = Cli_ConnectTo(client, host.c_str(), rack, slot);
+    int result;
+    if (!captureFile.empty()) {
+        result = Cli_StartCapture(client, captureFile.c_str());
+        if (result != 0) {
+            char errorText[1024];
+            Cli_ErrorText(result, errorText, sizeof(errorText));
+            throw std::runtime_error("Failed to start capture: " + std::string(errorText));
+        }
+    }
+
+    result = Cli_ConnectTo(client, host.c_str(), rack, slot);
     if (result != 0) {
         char errorText[1024];
         Cli_ErrorText(result, errorText, sizeof(errorText));
@@ -48,6 +58,46 @@ void Snap7Test::disconnect() {
     connected = false;
 }
 
+void Snap7Test::printStatistics(std::ostream& out) {
+    if (client) {
+        printClientStats(out, client);
+    }
+}
+
+bool Snap7Test::getDriverCounters(DriverCounters& counters) {
+    return client && sumClientStats(client, counters);
+}
+
+void Snap7Test::write(const std::map<std::string, std::string>& tags, const std::map<std::string, PlcValue>& values) {
+    for (const auto& [tagName, address] : tags) {
+        auto value = values.find(tagName);
+        if (value == values.end()) {
+            throw std::runtime_error("No value to write for tag " + tagName);
+        }
+        int area, dbNumber, start, wordLen, size;
+        PlcValueType type;
+        parseAddress(address, area, dbNumber, start, wordLen, size, type);
+
+        // Encode the value the same way it is read
+        std::vector<uint8_t> buffer(size);
+        encodeValue(value->second, type, size, buffer.data());
+
+        // Write the data
+        int numElements = 1;
+        if (type == PlcValueType::STRING) {
+            numElements = size;
+        } else if (type == PlcValueType::WSTRING) {
+            numElements = size;
+        }
+        int result = Cli_WriteArea(client, area, dbNumber, start, numElements, wordLen, buffer.data());
+        if (result != 0) {
+            char errorText[1024];
+            Cli_ErrorText(result, errorText, sizeof(errorText));
+            throw std::runtime_error("Failed to write to PLC: " + std::string(errorText));
+        }
+    }
+}
+
 std::map<std::string, PlcValue> Snap7Test::read(const std::map<std::string, std::string>& tags) {
     std::map<std::string, PlcValue> results;
 
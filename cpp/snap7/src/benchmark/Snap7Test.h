@@ -2,6 +2,7 @@
 #define SNAP7_TEST_H
 
 #include "BaseTest.h"
+#include "ClientStats.h"
 #include "../lib/snap7_libmain.h"
 
 /**
@@ -48,6 +49,26 @@ public:
      */
     std::map<std::string, PlcValue> read(const std::map<std::string, std::string>& tags) override;
 
+    /**
+     * Write values to the PLC, one request per tag.
+     * 
+     * @param tags Map of tag names to tag addresses
+     * @param values Map of tag names to the values to write
+     */
+    void write(const std::map<std::string, std::string>& tags, const std::map<std::string, PlcValue>& values) override;
+
+    /**
+     * Print the per-operation counters of the snap7 client.
+     * 
+     * @param out Stream to print to
+     */
+    void printStatistics(std::ostream& out) override;
+
+    /**
+     * Sum of the Cli_GetStats counters of the client.
+     */
+    bool getDriverCounters(DriverCounters& counters) override;
+
 private:
     std::string host;
     int rack;
@@ -0,0 +1,149 @@
+#include "TagSetGenerator.h"
+#include "Snap7Test.h"
+#include "Snap7OptimizedTest.h"
+#include "BenchmarkResults.h"
+#include "BenchmarkUtils.h"
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <iomanip>
+#include <cmath>
+
+/**
+ * Serves the DBs of a generated tag set with an in-process snap7 server.
+ */
+class SimulatedPlc {
+public:
+    SimulatedPlc(const std::string& address, TagSet& tagSet) : server(Srv_Create()) {
+        for (auto& [dbNumber, contents] : tagSet.dataBlocks) {
+            Srv_RegisterArea(server, srvAreaDB, static_cast<word>(dbNumber), contents.data(),
+                             static_cast<int>(contents.size()));
+        }
+        int result = Srv_StartTo(server, address.c_str());
+        if (result != 0) {
+            char errorText[1024];
+            Srv_ErrorText(result, errorText, sizeof(errorText));
+            Srv_Destroy(server);
+            throw std::runtime_error("Failed to start the simulated PLC: " + std::string(errorText));
+        }
+    }
+
+    ~SimulatedPlc() {
+        Srv_Stop(server);
+        Srv_Destroy(server);
+    }
+
+    SimulatedPlc(const SimulatedPlc&) = delete;
+    SimulatedPlc& operator=(const SimulatedPlc&) = delete;
+
+private:
+    S7Object server;
+};
+
+/**
+ * Run one configuration and print PDUs, bytes and latency per cycle.
+ */
+void runConfiguration(BaseTest& test, const std::string& label, int numCycles, int cycleTime,
+                      const std::map<std::string, std::string>& tagValues) {
+    std::cout << "Running: '" << label << ", " << test.getName() << "'" << std::endl;
+    TestResults testResults = test.run(numCycles, cycleTime, tagValues);
+
+    std::vector<int64_t> latencies = testResults.readLatencies;
+    std::sort(latencies.begin(), latencies.end());
+    std::cout << std::fixed << std::setprecision(2);
+    DriverCounters counters;
+    if (test.getDriverCounters(counters)) {
+        double cycles = testResults.numReadCycles;
+        std::cout << "  --> " << counters.requests / cycles << " requests/cycle, "
+                  << counters.pdusSent / cycles << "/" << counters.pdusRecvd / cycles << " PDUs/cycle, "
+                  << counters.bytesSent / cycles << "/" << counters.bytesRecvd / cycles
+                  << " bytes/cycle sent/received" << std::endl;
+    }
+    std::cout << "  --> " << percentile(latencies, 0.5) / 1000.0 << " ms p50, " << percentile(latencies, 0.99) / 1000.0
+              << " ms p99, " << percentile(latencies, 1.0) / 1000.0 << " ms max read time" << std::endl
+              << std::defaultfloat;
+}
+
+/**
+ * Main function: generate tag sets of increasing size, serve them with a simulated PLC and
+ * run the tests against them.
+ */
+int main(int argc, char* argv[]) {
+    std::string address = "127.0.0.1";
+    std::vector<std::string> sizes = {"10", "100", "1000", "10000"};
+    std::vector<std::string> densities = {"0.5"};
+    std::string test = "optimized";
+    std::string tagsFile;
+    int numCycles = 20;
+    int cycleTime = 0;
+    TagSetOptions options;
+    options.numDbs = 4; // 10000 tags don't fit into a single DB
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--address" && i + 1 < argc) {
+            address = argv[++i];
+        } else if (arg == "--sizes" && i + 1 < argc) {
+            sizes = splitList(argv[++i]);
+        } else if (arg == "--densities" && i + 1 < argc) {
+            densities = splitList(argv[++i]);
+        } else if (arg == "--types" && i + 1 < argc) {
+            options.types = splitList(argv[++i]);
+        } else if (arg == "--dbs" && i + 1 < argc) {
+            options.numDbs = std::stoi(argv[++i]);
+        } else if (arg == "--gaps" && i + 1 < argc) {
+            options.gaps = parseGapDistribution(argv[++i]);
+        } else if (arg == "--stringLength" && i + 1 < argc) {
+            options.stringLength = std::stoi(argv[++i]);
+        } else if (arg == "--seed" && i + 1 < argc) {
+            options.seed = static_cast<unsigned int>(std::stoul(argv[++i]));
+        } else if (arg == "--test" && i + 1 < argc) {
+            test = argv[++i];
+        } else if (arg == "--numCycles" && i + 1 < argc) {
+            numCycles = std::stoi(argv[++i]);
+        } else if (arg == "--cycleTime" && i + 1 < argc) {
+            cycleTime = std::stoi(argv[++i]);
+        } else if (arg == "--tagsFile" && i + 1 < argc) {
+            tagsFile = argv[++i];
+        }
+    }
+    if (test != "snap7" && test != "optimized" && test != "both") {
+        std::cerr << "Unknown test: " << test << " (expected snap7, optimized or both)" << std::endl;
+        return 1;
+    }
+
+    std::cout << "Sweep: " << numCycles << " cycles per configuration, " << options.numDbs << " DBs, "
+              << options.types.size() << " types, simulated PLC on " << address << std::endl << std::endl;
+
+    try {
+        for (const auto& density : densities) {
+            for (const auto& size : sizes) {
+                options.numTags = std::stoi(size);
+                options.density = std::stod(density);
+                TagSet tagSet = generateTagSet(options);
+                std::string label = size + " tags, density " + density;
+                if (!tagsFile.empty()) {
+                    writeTagsFile(tagsFile + "-" + size + "-" + density + ".txt", tagSet);
+                }
+
+                SimulatedPlc plc(address, tagSet);
+                if (test != "optimized") {
+                    Snap7Test snap7Test(address, 0, 1);
+                    runConfiguration(snap7Test, label, numCycles, cycleTime, tagSet.tagValues);
+                }
+                if (test != "snap7") {
+                    Snap7OptimizedTest snap7OptimizedTest(address, 0, 1);
+                    runConfiguration(snap7OptimizedTest, label, numCycles, cycleTime, tagSet.tagValues);
+                }
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,196 @@
+#include "TagSetGenerator.h"
+#include "BenchmarkUtils.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+
+const size_t maxDbSize = 65534;
+
+/**
+ * Size of a tag in bytes.
+ */
+int sizeOf(const std::string& type, int stringLength) {
+    if (type == "BOOL" || type == "SINT" || type == "USINT" || type == "CHAR") {
+        return 1;
+    }
+    if (type == "INT" || type == "UINT" || type == "WCHAR") {
+        return 2;
+    }
+    if (type == "DINT" || type == "UDINT" || type == "REAL" || type == "TIME") {
+        return 4;
+    }
+    if (type == "STRING") {
+        return stringLength + 2;
+    }
+    if (type == "WSTRING") {
+        return stringLength * 2 + 4;
+    }
+    throw std::runtime_error("Unsupported type for generated tags: " + type);
+}
+
+std::string randomText(std::mt19937& random, int maxLength) {
+    std::uniform_int_distribution<int> length(1, maxLength);
+    std::uniform_int_distribution<int> letter('a', 'z');
+    std::string text(length(random), ' ');
+    for (auto& c : text) {
+        c = static_cast<char>(letter(random));
+    }
+    return text;
+}
+
+/**
+ * Write a random value of the given type to the DB and return the address and expected value.
+ */
+std::pair<std::string, std::string> generateTag(std::mt19937& random, const std::string& type, int dbNumber,
+                                                size_t offset, int stringLength, uint8_t* data) {
+    std::ostringstream address;
+    std::ostringstream value;
+    address << "%DB" << dbNumber << ":" << offset;
+    value << type << ";";
+
+    if (type == "BOOL") {
+        int bit = std::uniform_int_distribution<int>(0, 7)(random);
+        bool state = std::uniform_int_distribution<int>(0, 1)(random) != 0;
+        data[0] = static_cast<uint8_t>(std::uniform_int_distribution<int>(0, 255)(random));
+        data[0] = state ? (data[0] | (1 << bit)) : (data[0] & ~(1 << bit));
+        address << "." << bit;
+        value << (state ? "true" : "false");
+    } else if (type == "SINT" || type == "INT" || type == "DINT") {
+        int size = sizeOf(type, stringLength);
+        int64_t limit = (1LL << (size * 8 - 1)) - 1;
+        int64_t number = std::uniform_int_distribution<int64_t>(-limit - 1, limit)(random);
+        writeBigEndian(data, static_cast<uint64_t>(number), size);
+        value << number;
+    } else if (type == "USINT" || type == "UINT" || type == "UDINT") {
+        int size = sizeOf(type, stringLength);
+        uint64_t number = std::uniform_int_distribution<uint64_t>(0, (1ULL << (size * 8)) - 1)(random);
+        writeBigEndian(data, number, size);
+        value << number;
+    } else if (type == "REAL") {
+        // Quarters are exact in binary, so the text round trips
+        float number = std::uniform_int_distribution<int>(-40000, 40000)(random) / 4.0f;
+        uint32_t bits;
+        memcpy(&bits, &number, sizeof(bits));
+        writeBigEndian(data, bits, 4);
+        value << std::setprecision(9) << number;
+    } else if (type == "CHAR") {
+        char c = static_cast<char>(std::uniform_int_distribution<int>('A', 'Z')(random));
+        data[0] = static_cast<uint8_t>(c);
+        value << c;
+    } else if (type == "WCHAR") {
+        char c = static_cast<char>(std::uniform_int_distribution<int>('a', 'z')(random));
+        writeBigEndian(data, static_cast<uint8_t>(c), 2);
+        value << c;
+    } else if (type == "STRING") {
+        std::string text = randomText(random, stringLength);
+        data[0] = static_cast<uint8_t>(stringLength);
+        data[1] = static_cast<uint8_t>(text.size());
+        memcpy(data + 2, text.data(), text.size());
+        value << text;
+    } else if (type == "WSTRING") {
+        std::string text = randomText(random, stringLength);
+        writeBigEndian(data, static_cast<uint64_t>(stringLength), 2);
+        writeBigEndian(data + 2, text.size(), 2);
+        for (size_t i = 0; i < text.size(); i++) {
+            writeBigEndian(data + 4 + i * 2, static_cast<uint8_t>(text[i]), 2);
+        }
+        value << text;
+    } else if (type == "TIME") {
+        uint32_t milliseconds = std::uniform_int_distribution<uint32_t>(0, 86400000)(random);
+        writeBigEndian(data, milliseconds, 4);
+        value << "PT" << milliseconds / 1000 << "." << std::setw(3) << std::setfill('0') << milliseconds % 1000 << "S";
+    }
+
+    address << ":" << type;
+    if (type == "STRING" || type == "WSTRING") {
+        address << "(" << stringLength << ")";
+    }
+    return {address.str(), value.str()};
+}
+
+}
+
+TagSet generateTagSet(const TagSetOptions& options) {
+    if (options.numTags < 0 || options.numDbs < 1 || options.types.empty() ||
+        options.density <= 0.0 || options.density > 1.0 || options.stringLength < 1 || options.stringLength > 254) {
+        throw std::runtime_error("Invalid tag set options");
+    }
+
+    std::mt19937 random(options.seed);
+    std::uniform_int_distribution<size_t> pickType(0, options.types.size() - 1);
+    std::vector<size_t> ends(options.numDbs, 0);
+    TagSet tagSet;
+
+    for (int i = 0; i < options.numTags; i++) {
+        const std::string& type = options.types[pickType(random)];
+        int size = sizeOf(type, options.stringLength);
+        int db = i % options.numDbs;
+        int dbNumber = options.firstDb + db;
+
+        // Gap in front of the tag, averaging to the requested density
+        double meanGap = size * (1.0 - options.density) / options.density;
+        size_t gap = 0;
+        if (meanGap > 0.0) {
+            switch (options.gaps) {
+                case GapDistribution::FIXED:
+                    gap = static_cast<size_t>(std::lround(meanGap));
+                    break;
+                case GapDistribution::UNIFORM:
+                    gap = std::uniform_int_distribution<size_t>(0, static_cast<size_t>(std::lround(2 * meanGap)))(random);
+                    break;
+                case GapDistribution::EXPONENTIAL:
+                    gap = static_cast<size_t>(std::lround(std::exponential_distribution<double>(1.0 / meanGap)(random)));
+                    break;
+            }
+        }
+
+        // Everything larger than a byte starts at an even address, like in a real DB
+        size_t offset = ends[db] + gap;
+        if (size > 1) {
+            offset = (offset + 1) & ~static_cast<size_t>(1);
+        }
+        if (offset + size > maxDbSize) {
+            throw std::runtime_error("Generated tags don't fit into " + std::to_string(options.numDbs) +
+                                     " DBs, use more DBs or a higher density");
+        }
+        ends[db] = offset + size;
+
+        std::vector<uint8_t>& contents = tagSet.dataBlocks[dbNumber];
+        if (contents.size() < ends[db]) {
+            contents.resize(ends[db]);
+        }
+        auto tag = generateTag(random, type, dbNumber, offset, options.stringLength, contents.data() + offset);
+        tagSet.tagValues[tag.first] = tag.second;
+    }
+    return tagSet;
+}
+
+void writeTagsFile(const std::string& path, const TagSet& tagSet) {
+    std::ofstream file(path);
+    if (!file.is_open()) {
+        throw std::runtime_error("Failed to create tags file: " + path);
+    }
+    for (const auto& [address, value] : tagSet.tagValues) {
+        file << address << "|" << value << "\n";
+    }
+}
+
+GapDistribution parseGapDistribution(const std::string& name) {
+    if (name == "fixed") {
+        return GapDistribution::FIXED;
+    }
+    if (name == "uniform") {
+        return GapDistribution::UNIFORM;
+    }
+    if (name == "exponential") {
+        return GapDistribution::EXPONENTIAL;
+    }
+    throw std::runtime_error("Unknown gap distribution: " + name);
+}
@@ -0,0 +1,62 @@
+#ifndef TAG_SET_GENERATOR_H
+#define TAG_SET_GENERATOR_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <cstdint>
+
+/**
+ * Distribution of the unused bytes between two tags.
+ */
+enum class GapDistribution {
+    FIXED,       // Every gap has the mean size
+    UNIFORM,     // Uniform between 0 and twice the mean
+    EXPONENTIAL  // Mostly small gaps with a few large holes
+};
+
+/**
+ * Parameters of a synthetic tag set.
+ */
+struct TagSetOptions {
+    int numTags = 100;
+    std::vector<std::string> types = {"BOOL", "INT", "DINT", "UDINT", "REAL", "STRING"}; // Picked with equal probability
+    int numDbs = 1;              // Tags are spread round robin over DB firstDb .. firstDb + numDbs - 1
+    int firstDb = 1;
+    double density = 0.5;        // Fraction of the DB bytes used by tags (1.0 = back to back)
+    GapDistribution gaps = GapDistribution::UNIFORM;
+    int stringLength = 10;       // Maximum length of STRING and WSTRING tags
+    unsigned int seed = 42;
+};
+
+/**
+ * A generated tag set, with the contents of the DBs holding the expected values.
+ */
+struct TagSet {
+    std::map<std::string, std::string> tagValues;    // Tag address -> expected value ("type;value")
+    std::map<int, std::vector<uint8_t>> dataBlocks;  // DB number -> contents
+};
+
+/**
+ * Generate a tag set. Supported types are BOOL, SINT, USINT, INT, UINT, DINT, UDINT, REAL,
+ * CHAR, WCHAR, STRING, WSTRING and TIME.
+ *
+ * @param options Parameters of the tag set
+ * @return The tag set (throws std::runtime_error if the tags don't fit into the DBs)
+ */
+TagSet generateTagSet(const TagSetOptions& options);
+
+/**
+ * Write the tags of a tag set in the format of the tagsFile of s7_benchmark.
+ *
+ * @param path Path of the file
+ * @param tagSet The tag set
+ */
+void writeTagsFile(const std::string& path, const TagSet& tagSet);
+
+/**
+ * Parse the name of a gap distribution ("fixed", "uniform" or "exponential").
+ */
+GapDistribution parseGapDistribution(const std::string& name);
+
+#endif // TAG_SET_GENERATOR_H
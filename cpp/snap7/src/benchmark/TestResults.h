@@ -2,6 +2,9 @@
 #define TEST_RESULTS_H
 
 #include <vector>
+#include <cstdint>
+#include "ResourceUsage.h"
+#include "PerfCounters.h"
 
 /**
  * Struct to hold the results of a benchmark test.
@@ -9,8 +12,28 @@
 struct TestResults {
     int connectionTime;       // Time taken to establish a connection to the PLC (in milliseconds)
     int disconnectionTime;    // Time taken to disconnect from the PLC (in milliseconds)
-    int numReadCycles;        // Number of read cycles performed
+    int numReadCycles;        // Number of read cycles performed (write cycles are not included)
     std::vector<int> readTimes; // Array of times taken for each read operation (in milliseconds)
+    int emittedValues = 0;    // Number of values returned by all read cycles (less than tags * cycles with change detection)
+    std::vector<int64_t> readLatencies; // Time taken for each read operation (in microseconds)
+    std::vector<int64_t> writeLatencies; // Time taken for each write operation (in microseconds)
+    int verifiedWrites = 0;   // Writes whose values were read back and compared
+    int skippedCycles = 0;    // Cycles skipped while the connection was down (see ConnectionLost)
+    ResourceUsage resources;  // Resources used by all read and write operations together
+
+    // Only filled in fixed-rate mode
+    bool fixedRate = false;
+    std::vector<int64_t> startDelays;     // Actual minus intended start of each cycle (in microseconds)
+    std::vector<int64_t> cycleLatencies;  // Intended start to end of each read (in microseconds)
+    int missedDeadlines = 0;              // Cycles not finished before the intended start of the next one
+
+    // Only filled if performance counters were requested
+    bool perfCounters = false;
+    bool perfAvailable[PERF_EVENT_COUNT] = {}; // Counters the kernel allowed to open
+    PerfSample connectPerf;
+    PerfSample readPerf;                       // All read cycles together
+    PerfSample writePerf;                      // All write cycles together
+    PerfSample disconnectPerf;
 
     TestResults(int connectionTime, int disconnectionTime, int numReadCycles, const std::vector<int>& readTimes)
         : connectionTime(connectionTime), disconnectionTime(disconnectionTime), numReadCycles(numReadCycles), readTimes(readTimes) {}
@@ -0,0 +1,316 @@
+#include "TimeSeriesCodec.h"
+#include <stdexcept>
+
+namespace {
+
+int countLeadingZeros(uint64_t value) {
+#if defined(__GNUC__)
+    return value == 0 ? 64 : __builtin_clzll(value);
+#else
+    int count = 0;
+    for (uint64_t mask = 1ULL << 63; mask != 0 && (value & mask) == 0; mask >>= 1) {
+        count++;
+    }
+    return count;
+#endif
+}
+
+int countTrailingZeros(uint64_t value) {
+#if defined(__GNUC__)
+    return value == 0 ? 64 : __builtin_ctzll(value);
+#else
+    int count = 0;
+    for (uint64_t mask = 1; mask != 0 && (value & mask) == 0; mask <<= 1) {
+        count++;
+    }
+    return count;
+#endif
+}
+
+uint64_t widthMask(int width) {
+    return width >= 64 ? ~0ULL : (1ULL << width) - 1;
+}
+
+uint64_t zigZag(int64_t value) {
+    return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+int64_t unZigZag(uint64_t value) {
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+int64_t signExtend(uint64_t value, int width) {
+    if (width < 64 && (value & (1ULL << (width - 1)))) {
+        value |= ~widthMask(width);
+    }
+    return static_cast<int64_t>(value);
+}
+
+}
+
+ColumnEncoding encodingFor(PlcValueType type, int size) {
+    switch (type) {
+        case PlcValueType::BOOL:
+            return ColumnEncoding::RUN_LENGTH;
+        case PlcValueType::REAL:
+        case PlcValueType::LREAL:
+            return ColumnEncoding::XOR;
+        case PlcValueType::STRING:
+        case PlcValueType::WSTRING:
+        case PlcValueType::RAW_BYTE_ARRAY:
+            return ColumnEncoding::RAW;
+        default:
+            return size <= 8 ? ColumnEncoding::DELTA : ColumnEncoding::RAW;
+    }
+}
+
+void BitWriter::writeBit(bool bit) {
+    writeBits(bit ? 1 : 0, 1);
+}
+
+void BitWriter::writeBits(uint64_t value, int bits) {
+    while (bits > 0) {
+        int used = static_cast<int>(bitCount % 8);
+        if (used == 0) {
+            bytes.push_back(0);
+        }
+        int free = 8 - used;
+        int n = bits < free ? bits : free;
+        uint8_t chunk = static_cast<uint8_t>((value >> (bits - n)) & ((1u << n) - 1));
+        bytes.back() |= static_cast<uint8_t>(chunk << (free - n));
+        bits -= n;
+        bitCount += n;
+    }
+}
+
+void BitWriter::writeVarint(uint64_t value) {
+    while (value >= 0x80) {
+        writeBits((value & 0x7F) | 0x80, 8);
+        value >>= 7;
+    }
+    writeBits(value, 8);
+}
+
+void BitWriter::writeBytes(const uint8_t* data, size_t size) {
+    for (size_t i = 0; i < size; i++) {
+        writeBits(data[i], 8);
+    }
+}
+
+void BitWriter::clear() {
+    bytes.clear();
+    bitCount = 0;
+}
+
+BitReader::BitReader(const uint8_t* data, size_t size) : data(data), size(size) {
+}
+
+bool BitReader::readBit() {
+    return readBits(1) != 0;
+}
+
+uint64_t BitReader::readBits(int bits) {
+    uint64_t value = 0;
+    while (bits > 0) {
+        size_t bytePos = bitPos / 8;
+        if (bytePos >= size) {
+            throw std::runtime_error("Unexpected end of encoded column");
+        }
+        int used = static_cast<int>(bitPos % 8);
+        int free = 8 - used;
+        int n = bits < free ? bits : free;
+        uint64_t chunk = (data[bytePos] >> (free - n)) & ((1u << n) - 1);
+        value = (value << n) | chunk;
+        bits -= n;
+        bitPos += n;
+    }
+    return value;
+}
+
+uint64_t BitReader::readVarint() {
+    uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        uint64_t byte = readBits(8);
+        value |= (byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            return value;
+        }
+    }
+    throw std::runtime_error("Invalid varint in encoded column");
+}
+
+void BitReader::readBytes(uint8_t* data, size_t size) {
+    for (size_t i = 0; i < size; i++) {
+        data[i] = static_cast<uint8_t>(readBits(8));
+    }
+}
+
+void encodeTimestamps(const std::vector<int64_t>& timestamps, BitWriter& out) {
+    if (timestamps.empty()) {
+        return;
+    }
+    out.writeBits(static_cast<uint64_t>(timestamps[0]), 64);
+    if (timestamps.size() == 1) {
+        return;
+    }
+    int64_t previousDelta = timestamps[1] - timestamps[0];
+    out.writeVarint(zigZag(previousDelta));
+
+    // Polling is periodic, so most deltas of deltas are zero or small jitter
+    for (size_t i = 2; i < timestamps.size(); i++) {
+        int64_t delta = timestamps[i] - timestamps[i - 1];
+        int64_t deltaOfDelta = delta - previousDelta;
+        previousDelta = delta;
+
+        if (deltaOfDelta == 0) {
+            out.writeBits(0x0, 1);
+        } else if (deltaOfDelta >= -63 && deltaOfDelta <= 64) {
+            out.writeBits(0x2, 2);
+            out.writeBits(static_cast<uint64_t>(deltaOfDelta + 63), 7);
+        } else if (deltaOfDelta >= -2047 && deltaOfDelta <= 2048) {
+            out.writeBits(0x6, 3);
+            out.writeBits(static_cast<uint64_t>(deltaOfDelta + 2047), 12);
+        } else if (deltaOfDelta >= -524287 && deltaOfDelta <= 524288) {
+            out.writeBits(0xE, 4);
+            out.writeBits(static_cast<uint64_t>(deltaOfDelta + 524287), 20);
+        } else {
+            out.writeBits(0xF, 4);
+            out.writeBits(static_cast<uint64_t>(deltaOfDelta), 64);
+        }
+    }
+}
+
+void decodeTimestamps(BitReader& in, size_t count, std::vector<int64_t>& timestamps) {
+    timestamps.clear();
+    if (count == 0) {
+        return;
+    }
+    timestamps.push_back(static_cast<int64_t>(in.readBits(64)));
+    if (count == 1) {
+        return;
+    }
+    int64_t delta = unZigZag(in.readVarint());
+    timestamps.push_back(timestamps[0] + delta);
+
+    for (size_t i = 2; i < count; i++) {
+        int64_t deltaOfDelta;
+        if (!in.readBit()) {
+            deltaOfDelta = 0;
+        } else if (!in.readBit()) {
+            deltaOfDelta = static_cast<int64_t>(in.readBits(7)) - 63;
+        } else if (!in.readBit()) {
+            deltaOfDelta = static_cast<int64_t>(in.readBits(12)) - 2047;
+        } else if (!in.readBit()) {
+            deltaOfDelta = static_cast<int64_t>(in.readBits(20)) - 524287;
+        } else {
+            deltaOfDelta = static_cast<int64_t>(in.readBits(64));
+        }
+        delta += deltaOfDelta;
+        timestamps.push_back(timestamps[i - 1] + delta);
+    }
+}
+
+void encodeValues(ColumnEncoding encoding, int width, const std::vector<uint64_t>& values, BitWriter& out) {
+    if (values.empty()) {
+        return;
+    }
+    switch (encoding) {
+        case ColumnEncoding::RUN_LENGTH: {
+            size_t runStart = 0;
+            for (size_t i = 1; i <= values.size(); i++) {
+                if (i == values.size() || values[i] != values[runStart]) {
+                    out.writeBits(values[runStart], width);
+                    out.writeVarint(i - runStart);
+                    runStart = i;
+                }
+            }
+            break;
+        }
+        case ColumnEncoding::XOR: {
+            out.writeBits(values[0], width);
+            int previousLeading = -1;
+            int previousTrailing = 0;
+            for (size_t i = 1; i < values.size(); i++) {
+                uint64_t x = values[i] ^ values[i - 1];
+                if (x == 0) {
+                    out.writeBit(false);
+                    continue;
+                }
+                out.writeBit(true);
+                int leading = countLeadingZeros(x) - (64 - width);
+                int trailing = countTrailingZeros(x);
+                if (previousLeading >= 0 && leading >= previousLeading && trailing >= previousTrailing) {
+                    // The meaningful bits fit into the previous window
+                    out.writeBit(false);
+                    out.writeBits(x >> previousTrailing, width - previousLeading - previousTrailing);
+                } else {
+                    int meaningful = width - leading - trailing;
+                    out.writeBit(true);
+                    out.writeBits(static_cast<uint64_t>(leading), 6);
+                    out.writeBits(static_cast<uint64_t>(meaningful - 1), 6);
+                    out.writeBits(x >> trailing, meaningful);
+                    previousLeading = leading;
+                    previousTrailing = trailing;
+                }
+            }
+            break;
+        }
+        case ColumnEncoding::DELTA: {
+            out.writeBits(values[0], width);
+            for (size_t i = 1; i < values.size(); i++) {
+                uint64_t delta = (values[i] - values[i - 1]) & widthMask(width);
+                out.writeVarint(zigZag(signExtend(delta, width)));
+            }
+            break;
+        }
+        case ColumnEncoding::RAW:
+            throw std::runtime_error("RAW columns are not value encoded");
+    }
+}
+
+void decodeValues(ColumnEncoding encoding, int width, BitReader& in, size_t count, std::vector<uint64_t>& values) {
+    values.clear();
+    if (count == 0) {
+        return;
+    }
+    switch (encoding) {
+        case ColumnEncoding::RUN_LENGTH:
+            while (values.size() < count) {
+                uint64_t value = in.readBits(width);
+                uint64_t run = in.readVarint();
+                if (run == 0 || run > count - values.size()) {
+                    throw std::runtime_error("Invalid run length in encoded column");
+                }
+                values.insert(values.end(), run, value);
+            }
+            break;
+        case ColumnEncoding::XOR: {
+            values.push_back(in.readBits(width));
+            int leading = 0;
+            int trailing = 0;
+            for (size_t i = 1; i < count; i++) {
+                if (!in.readBit()) {
+                    values.push_back(values[i - 1]);
+                    continue;
+                }
+                if (in.readBit()) {
+                    leading = static_cast<int>(in.readBits(6));
+                    int meaningful = static_cast<int>(in.readBits(6)) + 1;
+                    trailing = width - leading - meaningful;
+                }
+                uint64_t x = in.readBits(width - leading - trailing) << trailing;
+                values.push_back(values[i - 1] ^ x);
+            }
+            break;
+        }
+        case ColumnEncoding::DELTA:
+            values.push_back(in.readBits(width));
+            for (size_t i = 1; i < count; i++) {
+                int64_t delta = unZigZag(in.readVarint());
+                values.push_back((values[i - 1] + static_cast<uint64_t>(delta)) & widthMask(width));
+            }
+            break;
+        case ColumnEncoding::RAW:
+            throw std::runtime_error("RAW columns are not value encoded");
+    }
+}
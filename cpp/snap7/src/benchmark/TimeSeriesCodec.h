@@ -0,0 +1,75 @@
+#ifndef TIME_SERIES_CODEC_H
+#define TIME_SERIES_CODEC_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include "BaseTest.h"
+
+/**
+ * Encoding used for the value column of a tag.
+ */
+enum class ColumnEncoding : uint8_t {
+    RUN_LENGTH = 0, // Runs of identical values (BOOL)
+    XOR = 1,        // Gorilla style XOR against the previous value (REAL, LREAL)
+    DELTA = 2,      // Zig-zag encoded deltas (integers and other scalar types)
+    RAW = 3         // Bytes stored as they were read (STRING, WSTRING)
+};
+
+/**
+ * Select the encoding for a tag.
+ *
+ * @param type Type of the tag
+ * @param size Size of the tag in bytes
+ * @return The encoding of the value column
+ */
+ColumnEncoding encodingFor(PlcValueType type, int size);
+
+/**
+ * Appends single bits or groups of bits to a byte vector (MSB first).
+ */
+class BitWriter {
+public:
+    void writeBit(bool bit);
+    void writeBits(uint64_t value, int bits);
+    void writeVarint(uint64_t value);
+    void writeBytes(const uint8_t* data, size_t size);
+    const std::vector<uint8_t>& getBytes() const { return bytes; }
+    void clear();
+
+private:
+    std::vector<uint8_t> bytes;
+    size_t bitCount = 0;
+};
+
+/**
+ * Reads bits written by a BitWriter.
+ */
+class BitReader {
+public:
+    BitReader(const uint8_t* data, size_t size);
+    bool readBit();
+    uint64_t readBits(int bits);
+    uint64_t readVarint();
+    void readBytes(uint8_t* data, size_t size);
+
+private:
+    const uint8_t* data;
+    size_t size;
+    size_t bitPos = 0;
+};
+
+/**
+ * Delta-of-delta encoding of timestamps (in microseconds).
+ */
+void encodeTimestamps(const std::vector<int64_t>& timestamps, BitWriter& out);
+void decodeTimestamps(BitReader& in, size_t count, std::vector<int64_t>& timestamps);
+
+/**
+ * Encoding of a scalar value column. Values are the big-endian bytes of the tag interpreted
+ * as an unsigned integer of width bits. RAW columns are written with BitWriter::writeBytes.
+ */
+void encodeValues(ColumnEncoding encoding, int width, const std::vector<uint64_t>& values, BitWriter& out);
+void decodeValues(ColumnEncoding encoding, int width, BitReader& in, size_t count, std::vector<uint64_t>& values);
+
+#endif // TIME_SERIES_CODEC_H
@@ -0,0 +1,420 @@
+#include "TimeSeriesRecorder.h"
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <algorithm>
+
+#ifdef _WIN32
+#include <iterator>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+namespace {
+
+const uint64_t InitialCapacity = 1024 * 1024;
+
+/**
+ * Bounds checked cursor over the index of a segment file.
+ */
+class IndexCursor {
+public:
+    IndexCursor(const uint8_t* data, uint64_t size, uint64_t pos) : data(data), size(size), pos(pos) {}
+
+    template<typename T>
+    T get() {
+        T value;
+        need(sizeof(T));
+        memcpy(&value, data + pos, sizeof(T));
+        pos += sizeof(T);
+        return value;
+    }
+
+    std::string getString(size_t length) {
+        need(length);
+        std::string value(reinterpret_cast<const char*>(data + pos), length);
+        pos += length;
+        return value;
+    }
+
+private:
+    const uint8_t* data;
+    uint64_t size;
+    uint64_t pos;
+
+    void need(uint64_t length) {
+        if (pos + length > size) {
+            throw std::runtime_error("Truncated segment index");
+        }
+    }
+};
+
+}
+
+TimeSeriesRecorder::TimeSeriesRecorder(const std::string& path, size_t samplesPerChunk)
+    : samplesPerChunk(samplesPerChunk > 0 ? samplesPerChunk : 1), numSamples(0),
+      path(path), fd(-1), mapping(nullptr), capacity(0), fileSize(0) {
+#ifndef _WIN32
+    fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        throw std::runtime_error("Failed to create segment file: " + path);
+    }
+#else
+    fd = 0;
+#endif
+    reserve(InitialCapacity);
+    write(TimeSeriesSegmentMagic, 8);
+}
+
+TimeSeriesRecorder::~TimeSeriesRecorder() {
+    try {
+        close();
+    } catch (const std::exception&) {
+        // Nothing sensible left to do in a destructor
+    }
+}
+
+void TimeSeriesRecorder::append(int64_t timestamp, const ReadPlan& plan) {
+    mapPlan(plan);
+
+    size_t itemIndex = 0;
+    for (const auto& group : plan.groups) {
+        for (const auto& item : group.items) {
+            uint32_t columnId = planColumns[itemIndex++];
+            Column& column = columns[columnId];
+            const uint8_t* data = group.buffer.data() + item.offset;
+
+            column.timestamps.push_back(timestamp);
+            if (column.tag.encoding == ColumnEncoding::RAW) {
+                column.raw.insert(column.raw.end(), data, data + item.size);
+            } else {
+                uint64_t value = 0;
+                for (int i = 0; i < item.size; i++) {
+                    value = (value << 8) | data[i];
+                }
+                column.values.push_back(value);
+            }
+            numSamples++;
+
+            if (column.timestamps.size() >= samplesPerChunk) {
+                sealChunk(columnId);
+            }
+        }
+    }
+}
+
+void TimeSeriesRecorder::flush() {
+    for (uint32_t columnId = 0; columnId < columns.size(); columnId++) {
+        sealChunk(columnId);
+    }
+}
+
+void TimeSeriesRecorder::close() {
+    if (fd < 0) {
+        return;
+    }
+    flush();
+
+    // Write the index
+    uint64_t indexOffset = fileSize;
+    uint32_t numTags = static_cast<uint32_t>(columns.size());
+    write(&numTags, sizeof(numTags));
+    for (const auto& column : columns) {
+        uint16_t nameLength = static_cast<uint16_t>(column.tag.tagName.size());
+        uint8_t type = static_cast<uint8_t>(column.tag.type);
+        uint8_t encoding = static_cast<uint8_t>(column.tag.encoding);
+        uint32_t size = static_cast<uint32_t>(column.tag.size);
+        write(&nameLength, sizeof(nameLength));
+        write(column.tag.tagName.data(), nameLength);
+        write(&type, sizeof(type));
+        write(&encoding, sizeof(encoding));
+        write(&size, sizeof(size));
+    }
+    uint32_t numChunks = static_cast<uint32_t>(chunks.size());
+    write(&numChunks, sizeof(numChunks));
+    for (const auto& chunk : chunks) {
+        write(&chunk.tagId, sizeof(chunk.tagId));
+        write(&chunk.numSamples, sizeof(chunk.numSamples));
+        write(&chunk.firstTimestamp, sizeof(chunk.firstTimestamp));
+        write(&chunk.lastTimestamp, sizeof(chunk.lastTimestamp));
+        write(&chunk.offset, sizeof(chunk.offset));
+        write(&chunk.length, sizeof(chunk.length));
+    }
+    write(&indexOffset, sizeof(indexOffset));
+    write(TimeSeriesIndexMagic, 8);
+
+#ifndef _WIN32
+    msync(mapping, fileSize, MS_SYNC);
+    munmap(mapping, capacity);
+    int truncated = ftruncate(fd, static_cast<off_t>(fileSize));
+    ::close(fd);
+    if (truncated != 0) {
+        throw std::runtime_error("Failed to truncate segment file: " + path);
+    }
+#else
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char*>(contents.data()), static_cast<std::streamsize>(fileSize));
+    contents.clear();
+#endif
+    mapping = nullptr;
+    capacity = 0;
+    fd = -1;
+}
+
+uint64_t TimeSeriesRecorder::getNumSamples() const {
+    return numSamples;
+}
+
+uint64_t TimeSeriesRecorder::getFileSize() const {
+    return fileSize;
+}
+
+void TimeSeriesRecorder::mapPlan(const ReadPlan& plan) {
+    // Usually the same plan is appended every cycle, so only verify the mapping
+    size_t itemIndex = 0;
+    bool matches = true;
+    for (const auto& group : plan.groups) {
+        for (const auto& item : group.items) {
+            if (itemIndex >= planColumns.size() || columns[planColumns[itemIndex]].tag.tagName != item.tagName) {
+                matches = false;
+                break;
+            }
+            itemIndex++;
+        }
+    }
+    if (matches && itemIndex == planColumns.size()) {
+        return;
+    }
+
+    planColumns.clear();
+    for (const auto& group : plan.groups) {
+        for (const auto& item : group.items) {
+            auto existing = columnIds.find(item.tagName);
+            if (existing != columnIds.end()) {
+                const TimeSeriesTag& tag = columns[existing->second].tag;
+                if (tag.type != item.type || tag.size != item.size) {
+                    throw std::runtime_error("Tag " + item.tagName + " changed its type while recording");
+                }
+                planColumns.push_back(existing->second);
+                continue;
+            }
+            uint32_t columnId = static_cast<uint32_t>(columns.size());
+            Column column;
+            column.tag = {item.tagName, item.type, encodingFor(item.type, item.size), item.size};
+            columns.push_back(std::move(column));
+            columnIds[item.tagName] = columnId;
+            planColumns.push_back(columnId);
+        }
+    }
+}
+
+void TimeSeriesRecorder::sealChunk(uint32_t columnId) {
+    Column& column = columns[columnId];
+    if (column.timestamps.empty()) {
+        return;
+    }
+
+    TimeSeriesChunk chunk;
+    chunk.tagId = columnId;
+    chunk.numSamples = static_cast<uint32_t>(column.timestamps.size());
+    chunk.firstTimestamp = column.timestamps.front();
+    chunk.lastTimestamp = column.timestamps.back();
+    chunk.offset = fileSize;
+
+    writer.clear();
+    encodeTimestamps(column.timestamps, writer);
+    uint32_t timestampBytes = static_cast<uint32_t>(writer.getBytes().size());
+    write(&timestampBytes, sizeof(timestampBytes));
+    write(writer.getBytes().data(), timestampBytes);
+
+    writer.clear();
+    if (column.tag.encoding == ColumnEncoding::RAW) {
+        writer.writeBytes(column.raw.data(), column.raw.size());
+    } else {
+        encodeValues(column.tag.encoding, column.tag.size * 8, column.values, writer);
+    }
+    write(writer.getBytes().data(), writer.getBytes().size());
+
+    chunk.length = static_cast<uint32_t>(fileSize - chunk.offset);
+    chunks.push_back(chunk);
+
+    column.timestamps.clear();
+    column.values.clear();
+    column.raw.clear();
+}
+
+void TimeSeriesRecorder::write(const void* data, size_t size) {
+    reserve(fileSize + size);
+    memcpy(mapping + fileSize, data, size);
+    fileSize += size;
+}
+
+void TimeSeriesRecorder::reserve(uint64_t size) {
+    if (size <= capacity) {
+        return;
+    }
+    uint64_t newCapacity = std::max(std::max(capacity * 2, size), InitialCapacity);
+#ifndef _WIN32
+    if (mapping) {
+        munmap(mapping, capacity);
+        mapping = nullptr;
+    }
+    if (ftruncate(fd, static_cast<off_t>(newCapacity)) != 0) {
+        throw std::runtime_error("Failed to grow segment file: " + path);
+    }
+    void* address = mmap(nullptr, newCapacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (address == MAP_FAILED) {
+        throw std::runtime_error("Failed to map segment file: " + path);
+    }
+    mapping = static_cast<uint8_t*>(address);
+#else
+    contents.resize(newCapacity);
+    mapping = contents.data();
+#endif
+    capacity = newCapacity;
+}
+
+TimeSeriesReader::TimeSeriesReader(const std::string& path) : mapping(nullptr), fileSize(0) {
+#ifndef _WIN32
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Failed to open segment file: " + path);
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size < 32) {
+        ::close(fd);
+        throw std::runtime_error("Invalid segment file: " + path);
+    }
+    fileSize = static_cast<uint64_t>(info.st_size);
+    void* address = mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (address == MAP_FAILED) {
+        throw std::runtime_error("Failed to map segment file: " + path);
+    }
+    mapping = static_cast<const uint8_t*>(address);
+#else
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        throw std::runtime_error("Failed to open segment file: " + path);
+    }
+    contents.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    mapping = contents.data();
+    fileSize = contents.size();
+#endif
+
+    try {
+        if (fileSize < 32 || memcmp(mapping, TimeSeriesSegmentMagic, 8) != 0 ||
+            memcmp(mapping + fileSize - 8, TimeSeriesIndexMagic, 8) != 0) {
+            throw std::runtime_error("Invalid segment file: " + path);
+        }
+        uint64_t indexOffset;
+        memcpy(&indexOffset, mapping + fileSize - 16, sizeof(indexOffset));
+
+        IndexCursor cursor(mapping, fileSize - 16, indexOffset);
+        uint32_t numTags = cursor.get<uint32_t>();
+        for (uint32_t i = 0; i < numTags; i++) {
+            TimeSeriesTag tag;
+            uint16_t nameLength = cursor.get<uint16_t>();
+            tag.tagName = cursor.getString(nameLength);
+            tag.type = static_cast<PlcValueType>(cursor.get<uint8_t>());
+            tag.encoding = static_cast<ColumnEncoding>(cursor.get<uint8_t>());
+            tag.size = static_cast<int>(cursor.get<uint32_t>());
+            tags.push_back(tag);
+        }
+        uint32_t numChunks = cursor.get<uint32_t>();
+        for (uint32_t i = 0; i < numChunks; i++) {
+            TimeSeriesChunk chunk;
+            chunk.tagId = cursor.get<uint32_t>();
+            chunk.numSamples = cursor.get<uint32_t>();
+            chunk.firstTimestamp = cursor.get<int64_t>();
+            chunk.lastTimestamp = cursor.get<int64_t>();
+            chunk.offset = cursor.get<uint64_t>();
+            chunk.length = cursor.get<uint32_t>();
+            if (chunk.tagId >= tags.size() || chunk.offset + chunk.length > indexOffset) {
+                throw std::runtime_error("Invalid chunk in segment file: " + path);
+            }
+            chunks.push_back(chunk);
+        }
+    } catch (...) {
+#ifndef _WIN32
+        munmap(const_cast<uint8_t*>(mapping), fileSize);
+#endif
+        throw;
+    }
+}
+
+TimeSeriesReader::~TimeSeriesReader() {
+#ifndef _WIN32
+    if (mapping) {
+        munmap(const_cast<uint8_t*>(mapping), fileSize);
+    }
+#endif
+}
+
+const std::vector<TimeSeriesTag>& TimeSeriesReader::getTags() const {
+    return tags;
+}
+
+const std::vector<TimeSeriesChunk>& TimeSeriesReader::getChunks() const {
+    return chunks;
+}
+
+void TimeSeriesReader::read(const std::string& tagName, int64_t from, int64_t to,
+                            std::vector<int64_t>& timestamps, std::vector<uint8_t>& data) const {
+    timestamps.clear();
+    data.clear();
+
+    auto tag = std::find_if(tags.begin(), tags.end(), [&](const TimeSeriesTag& t) { return t.tagName == tagName; });
+    if (tag == tags.end()) {
+        throw std::runtime_error("Unknown tag: " + tagName);
+    }
+    uint32_t tagId = static_cast<uint32_t>(tag - tags.begin());
+
+    std::vector<int64_t> chunkTimestamps;
+    std::vector<uint64_t> chunkValues;
+    std::vector<uint8_t> chunkRaw;
+    for (const auto& chunk : chunks) {
+        if (chunk.tagId != tagId || chunk.lastTimestamp < from || chunk.firstTimestamp > to) {
+            continue;
+        }
+        const uint8_t* chunkData = mapping + chunk.offset;
+        uint32_t timestampBytes;
+        if (chunk.length < sizeof(timestampBytes)) {
+            throw std::runtime_error("Truncated chunk for tag " + tagName);
+        }
+        memcpy(&timestampBytes, chunkData, sizeof(timestampBytes));
+        if (sizeof(timestampBytes) + timestampBytes > chunk.length) {
+            throw std::runtime_error("Truncated chunk for tag " + tagName);
+        }
+
+        BitReader timestampReader(chunkData + sizeof(timestampBytes), timestampBytes);
+        decodeTimestamps(timestampReader, chunk.numSamples, chunkTimestamps);
+
+        BitReader valueReader(chunkData + sizeof(timestampBytes) + timestampBytes,
+                              chunk.length - sizeof(timestampBytes) - timestampBytes);
+        if (tag->encoding == ColumnEncoding::RAW) {
+            chunkRaw.resize(static_cast<size_t>(chunk.numSamples) * tag->size);
+            valueReader.readBytes(chunkRaw.data(), chunkRaw.size());
+        } else {
+            decodeValues(tag->encoding, tag->size * 8, valueReader, chunk.numSamples, chunkValues);
+        }
+
+        for (size_t i = 0; i < chunkTimestamps.size(); i++) {
+            if (chunkTimestamps[i] < from || chunkTimestamps[i] > to) {
+                continue;
+            }
+            timestamps.push_back(chunkTimestamps[i]);
+            if (tag->encoding == ColumnEncoding::RAW) {
+                const uint8_t* sample = chunkRaw.data() + i * tag->size;
+                data.insert(data.end(), sample, sample + tag->size);
+            } else {
+                for (int b = tag->size - 1; b >= 0; b--) {
+                    data.push_back(static_cast<uint8_t>(chunkValues[i] >> (b * 8)));
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,176 @@
+#ifndef TIME_SERIES_RECORDER_H
+#define TIME_SERIES_RECORDER_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <cstdint>
+#include "ReadPlan.h"
+#include "TimeSeriesCodec.h"
+
+/**
+ * Layout of a segment file (all integers in host byte order):
+ *
+ *   header:  "S7TSSEG1"
+ *   chunks:  uint32 timestamp bytes, encoded timestamps, encoded values
+ *   index:   uint32 tag count, per tag { uint16 name length, name, uint8 type, uint8 encoding, uint32 size }
+ *            uint32 chunk count, per chunk { uint32 tag, uint32 samples, int64 first, int64 last,
+ *                                             uint64 offset, uint32 length }
+ *   footer:  uint64 index offset, "S7TSIDX1"
+ */
+const char* const TimeSeriesSegmentMagic = "S7TSSEG1";
+const char* const TimeSeriesIndexMagic = "S7TSIDX1";
+
+/**
+ * Index entry of a tag stored in a segment file.
+ */
+struct TimeSeriesTag {
+    std::string tagName;
+    PlcValueType type;
+    ColumnEncoding encoding;
+    int size; // Size of one sample in bytes
+};
+
+/**
+ * Index entry of a chunk stored in a segment file.
+ */
+struct TimeSeriesChunk {
+    uint32_t tagId;
+    uint32_t numSamples;
+    int64_t firstTimestamp;
+    int64_t lastTimestamp;
+    uint64_t offset;
+    uint32_t length;
+};
+
+/**
+ * Records the raw values of every read cycle into per-tag columnar chunks, which are
+ * compressed and appended to a memory-mapped segment file once they are full.
+ */
+class TimeSeriesRecorder {
+public:
+    /**
+     * Constructor.
+     *
+     * @param path Path of the segment file to create (an existing file is overwritten)
+     * @param samplesPerChunk Number of samples collected per tag before a chunk is written
+     */
+    explicit TimeSeriesRecorder(const std::string& path, size_t samplesPerChunk = 1024);
+
+    /**
+     * Destructor, closes the segment file if this hasn't been done yet.
+     */
+    ~TimeSeriesRecorder();
+
+    TimeSeriesRecorder(const TimeSeriesRecorder&) = delete;
+    TimeSeriesRecorder& operator=(const TimeSeriesRecorder&) = delete;
+
+    /**
+     * Append one sample for every item of a read plan whose buffers have just been filled.
+     *
+     * @param timestamp Timestamp of the read cycle (microseconds since epoch)
+     * @param plan The executed read plan
+     */
+    void append(int64_t timestamp, const ReadPlan& plan);
+
+    /**
+     * Write all partially filled chunks to the segment file.
+     */
+    void flush();
+
+    /**
+     * Flush, write the index and close the segment file.
+     */
+    void close();
+
+    /**
+     * @return Number of samples appended so far
+     */
+    uint64_t getNumSamples() const;
+
+    /**
+     * @return Size of the segment file in bytes (only final after close())
+     */
+    uint64_t getFileSize() const;
+
+private:
+    struct Column {
+        TimeSeriesTag tag;
+        std::vector<int64_t> timestamps;
+        std::vector<uint64_t> values;   // Scalar columns
+        std::vector<uint8_t> raw;       // RAW columns
+    };
+
+    size_t samplesPerChunk;
+    std::vector<Column> columns;
+    std::map<std::string, uint32_t> columnIds;
+    std::vector<uint32_t> planColumns;  // Column of each item of the last appended plan
+    std::vector<TimeSeriesChunk> chunks;
+    BitWriter writer;
+    uint64_t numSamples;
+
+    // Memory-mapped output file
+    std::string path;
+    int fd;
+    uint8_t* mapping;
+    uint64_t capacity;
+    uint64_t fileSize;
+    std::vector<uint8_t> contents; // Used instead of the mapping on platforms without mmap
+
+    void mapPlan(const ReadPlan& plan);
+    void sealChunk(uint32_t columnId);
+    void write(const void* data, size_t size);
+    void reserve(uint64_t size);
+};
+
+/**
+ * Reads a segment file written by the TimeSeriesRecorder.
+ */
+class TimeSeriesReader {
+public:
+    /**
+     * Open and memory-map a segment file.
+     *
+     * @param path Path of the segment file
+     */
+    explicit TimeSeriesReader(const std::string& path);
+
+    /**
+     * Destructor.
+     */
+    ~TimeSeriesReader();
+
+    TimeSeriesReader(const TimeSeriesReader&) = delete;
+    TimeSeriesReader& operator=(const TimeSeriesReader&) = delete;
+
+    /**
+     * @return All tags stored in the segment
+     */
+    const std::vector<TimeSeriesTag>& getTags() const;
+
+    /**
+     * @return All chunks stored in the segment
+     */
+    const std::vector<TimeSeriesChunk>& getChunks() const;
+
+    /**
+     * Read the samples of a tag within a time range. Only chunks overlapping the range are decoded.
+     *
+     * @param tagName Name of the tag
+     * @param from First timestamp to return (inclusive)
+     * @param to Last timestamp to return (inclusive)
+     * @param timestamps Output vector receiving the timestamps
+     * @param data Output vector receiving the raw big-endian bytes of the samples (size bytes per sample)
+     */
+    void read(const std::string& tagName, int64_t from, int64_t to,
+              std::vector<int64_t>& timestamps, std::vector<uint8_t>& data) const;
+
+private:
+    std::vector<TimeSeriesTag> tags;
+    std::vector<TimeSeriesChunk> chunks;
+    const uint8_t* mapping;
+    uint64_t fileSize;
+    std::vector<uint8_t> contents; // Used instead of the mapping on platforms without mmap
+};
+
+#endif // TIME_SERIES_RECORDER_H
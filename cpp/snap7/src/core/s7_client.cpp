@@ -102,6 +102,7 @@ void TSnap7Client::DoCompletion()
 {
     if ((CliCompletion!=NULL) && !Destroying)
     {
+      SNAP_TRACE_SCOPE("Completion", Job.Op);
       try{
           CliCompletion(FUsrPtr, Job.Op, Job.Result);
       }catch (...)
@@ -157,7 +158,7 @@ int TSnap7Client::AsReadArea(int Area, int DBNumber, int Start, int Amount, int
           Job.Amount   = Amount;
           Job.WordLen  = WordLen;
           Job.pData    = pUsrData;
-          JobStart     = SysGetTick();
+          JobStart     = SysGetTickNs();
           StartAsyncJob();
           return 0;
      }
@@ -188,7 +189,7 @@ int TSnap7Client::AsWriteArea(int Area, int DBNumber, int Start, int Amount, int
         // Doublebuffering
         memcpy(&opData, pUsrData, TotalSize);
         Job.pData =&opData;
-        JobStart  =SysGetTick();
+        JobStart  =SysGetTickNs();
         StartAsyncJob();
         return 0;
     }
@@ -205,7 +206,7 @@ int TSnap7Client::AsListBlocksOfType(int BlockType, PS7BlocksOfType pUsrData, in
         Job.Area     =BlockType;
         Job.pData    =pUsrData;
         Job.pAmount  =&ItemsCount;
-        JobStart     =SysGetTick();
+        JobStart     =SysGetTickNs();
         StartAsyncJob();
         return 0;
     }
@@ -225,7 +226,7 @@ int TSnap7Client::AsReadSZL(int ID, int Index, PS7SZL pUsrData, int & Size)
         Job.pAmount  =&Size;
         Job.Amount   =Size;
         Job.IParam   =1; // Data has to be copied into user buffer
-        JobStart     =SysGetTick();
+        JobStart     =SysGetTickNs();
         StartAsyncJob();
         return 0;
     }
@@ -242,7 +243,7 @@ int TSnap7Client::AsReadSZLList(PS7SZLList pUsrData, int &ItemsCount)
         Job.pData    =pUsrData;
         Job.pAmount  =&ItemsCount;
         Job.Amount   =ItemsCount;
-        JobStart     =SysGetTick();
+        JobStart     =SysGetTickNs();
         StartAsyncJob();
         return 0;
     }
@@ -262,7 +263,7 @@ int TSnap7Client::AsUpload(int BlockType, int BlockNum, void * pUsrData, int & S
         Job.Amount   =Size;
         Job.Number   =BlockNum;
         Job.IParam   =0; // not full upload, only data
-        JobStart     =SysGetTick();
+        JobStart     =SysGetTickNs();
         StartAsyncJob();
         return 0;
     }
@@ -282,7 +283,7 @@ int TSnap7Client::AsFullUpload(int BlockType, int BlockNum, void * pUsrData, int
         Job.Amount   =Size;
         Job.Number   =BlockNum;
         Job.IParam   =1; // full upload
-        JobStart     =SysGetTick();
+        JobStart     =SysGetTickNs();
         StartAsyncJob();
         return 0;
     }
@@ -305,7 +306,7 @@ int TSnap7Client::AsDownload(int BlockNum, void * pUsrData, int Size)
         memcpy(&opData, pUsrData, Size);
         Job.Number   =BlockNum;
         Job.Amount   =Size;
-        JobStart     =SysGetTick();
+        JobStart     =SysGetTickNs();
         StartAsyncJob();
         return 0;
     }
@@ -322,7 +323,7 @@ int TSnap7Client::AsCopyRamToRom(int Timeout)
         if (Timeout>0)
         {
           Job.IParam   =Timeout;
-          JobStart     =SysGetTick();
+          JobStart     =SysGetTickNs();
           StartAsyncJob();
           return 0;
         }
@@ -342,7 +343,7 @@ int TSnap7Client::AsCompress(int Timeout)
         if (Timeout>0)
         {
             Job.IParam   =Timeout;
-            JobStart     =SysGetTick();
+            JobStart     =SysGetTickNs();
             StartAsyncJob();
             return 0;
         }
@@ -425,7 +426,7 @@ int TSnap7Client::AsDBGet(int DBNumber, void * pUsrData, int &Size)
         Job.pData    =pUsrData;
         Job.pAmount  =&Size;
         Job.Amount   =Size;
-        JobStart     =SysGetTick();
+        JobStart     =SysGetTickNs();
         StartAsyncJob();
         return 0;
     }
@@ -441,7 +442,7 @@ int TSnap7Client::AsDBFill(int DBNumber, int FillChar)
         Job.Op       =s7opDBFill;
         Job.Number   =DBNumber;
         Job.IParam   =FillChar;
-        JobStart     =SysGetTick();
+        JobStart     =SysGetTickNs();
         StartAsyncJob();
         return 0;
     }
@@ -454,8 +455,8 @@ void TSnap7Client::StartAsyncJob()
     ClrError();
 	if (!ThreadCreated)
 	{
-		EvtJob =  new TSnapEvent(false);
-		EvtComplete = new TSnapEvent(false);
+		EvtJob =  new TSnapLightEvent(false);
+		EvtComplete = new TSnapLightEvent(false);
 	    OpenThread();
 		ThreadCreated=true;
 	}
@@ -26,7 +26,7 @@
 #ifndef s7_client_h
 #define s7_client_h
 //---------------------------------------------------------------------------
-#include "snap_threads.h"
+#include "snap_sync.h"
 #include "s7_micro_client.h"
 //---------------------------------------------------------------------------
 
@@ -43,6 +43,7 @@ public:
      TClientThread(TSnap7Client *Client)
      {
            FClient = Client;
+           Role = thrClientWorker;
      }
 	void Execute();
 };
@@ -56,8 +57,8 @@ private:
     void OpenThread();
     void StartAsyncJob();
 protected:
-    PSnapEvent EvtJob;
-    PSnapEvent EvtComplete;
+    PSnapLightEvent EvtJob;
+    PSnapLightEvent EvtComplete;
     pfn_CliCompletion CliCompletion;
     void *FUsrPtr;
     void DoCompletion();
@@ -0,0 +1,199 @@
+/*=============================================================================|
+|  PROJECT SNAP7                                                         1.3.0 |
+|==============================================================================|
+|  Copyright (C) 2013, 2015 Davide Nardella                                    |
+|  All rights reserved.                                                        |
+|==============================================================================|
+|  SNAP7 is free software: you can redistribute it and/or modify               |
+|  it under the terms of the Lesser GNU General Public License as published by |
+|  the Free Software Foundation, either version 3 of the License, or           |
+|  (at your option) any later version.                                         |
+|                                                                              |
+|  It means that you can distribute your commercial software linked with       |
+|  SNAP7 without the requirement to distribute the source code of your         |
+|  application and without the requirement that your application be itself     |
+|  distributed under LGPL.                                                     |
+|                                                                              |
+|  SNAP7 is distributed in the hope that it will be useful,                    |
+|  but WITHOUT ANY WARRANTY; without even the implied warranty of              |
+|  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the               |
+|  Lesser GNU General Public License for more details.                         |
+|                                                                              |
+|  You should have received a copy of the GNU General Public License and a     |
+|  copy of Lesser GNU General Public License along with Snap7.                 |
+|  If not, see  http://www.gnu.org/licenses/                                   |
+|=============================================================================*/
+#include "s7_connector.h"
+#ifdef NON_BLOCKING_CONNECT
+#include <poll.h>
+#endif
+//---------------------------------------------------------------------------
+#ifdef NON_BLOCKING_CONNECT
+
+// Phases of a connection, each one waits for the socket to be ready
+const int cpTcp       = 0; // TCP connect, waits for writable
+const int cpIso       = 1; // Connection request sent, waits for the CC
+const int cpNegotiate = 2; // Negotiation sent, waits for the answer
+const int cpDone      = 3;
+
+typedef struct {
+    int Phase;
+    int Result;
+    uint64_t Start;    // Start of the phase
+    uint64_t Deadline; // 0 = none
+} TConnectSlot;
+
+//---------------------------------------------------------------------------
+static uint64_t PhaseDeadline(uint64_t Now, int Timeout)
+{
+    return Timeout>0 ? Now+uint64_t(Timeout)*1000 : 0;
+}
+//---------------------------------------------------------------------------
+// Performs the step of the current phase of a client whose socket is ready
+static void ConnectStep(PSnap7MicroClient Client, TConnectSlot &Slot)
+{
+    uint64_t Now;
+
+    switch (Slot.Phase)
+    {
+        case cpTcp:
+            Slot.Result=Client->PeerConnectRequest();
+            Now=SysGetTickUs();
+            Client->TcpConnectTime=longword(Now-Slot.Start);
+            Slot.Phase=cpIso;
+            Slot.Deadline=PhaseDeadline(Now, Client->RecvTimeout);
+            break;
+        case cpIso:
+            Slot.Result=Client->PeerConnectConfirm();
+            Now=SysGetTickUs();
+            Client->IsoConnectTime=longword(Now-Slot.Start);
+            Slot.Phase=cpNegotiate;
+            Slot.Deadline=PhaseDeadline(Now, Client->RecvTimeout);
+            break;
+        case cpNegotiate:
+            Slot.Result=Client->PeerNegotiateConfirm();
+            Now=SysGetTickUs();
+            Client->NegotiateTime=longword(Now-Slot.Start);
+            Slot.Phase=cpDone;
+            break;
+        default:
+            return;
+    }
+    Slot.Start=Now;
+    if (Slot.Result!=0)
+        Slot.Phase=cpDone;
+}
+//---------------------------------------------------------------------------
+int ConnectClients(PSnap7MicroClient *Clients, int Count, int *Results)
+{
+    TConnectSlot *Slots;
+    struct pollfd *Fds;
+    int *Index;
+    int c, n, Waiting, Timeout, Result;
+    uint64_t Now, Next;
+
+    Slots=new TConnectSlot[Count];
+    Fds=new struct pollfd[Count];
+    Index=new int[Count];
+
+    // Starts all the TCP connects
+    Now=SysGetTickUs();
+    for (c = 0; c < Count; c++)
+    {
+        Slots[c].Phase=cpTcp;
+        Slots[c].Start=Now;
+        Slots[c].Deadline=PhaseDeadline(Now, Clients[c]->PingTimeout);
+        Slots[c].Result=Clients[c]->PeerConnectStart();
+        if (Slots[c].Result!=0)
+        {
+            Clients[c]->SckDisconnect();
+            Slots[c].Phase=cpDone;
+        }
+    }
+
+    do
+    {
+        // Collects the sockets still connecting and the nearest deadline
+        Waiting=0;
+        Next=0;
+        for (c = 0; c < Count; c++)
+        {
+            if (Slots[c].Phase==cpDone)
+                continue;
+            Fds[Waiting].fd=Clients[c]->GetSocket();
+            Fds[Waiting].events=Slots[c].Phase==cpTcp ? POLLOUT : POLLIN;
+            Fds[Waiting].revents=0;
+            Index[Waiting++]=c;
+            if ((Slots[c].Deadline!=0) && ((Next==0) || (Slots[c].Deadline<Next)))
+                Next=Slots[c].Deadline;
+        }
+        if (Waiting==0)
+            break;
+
+        Now=SysGetTickUs();
+        if (Next==0)
+            Timeout=-1;
+        else
+            Timeout=Next>Now ? int((Next-Now+999)/1000) : 0;
+
+        n=poll(Fds, Waiting, Timeout);
+        if ((n<0) && (errno!=EINTR))
+        {
+            // Should never happen, gives up all the pending connections
+            for (c = 0; c < Waiting; c++)
+            {
+                Slots[Index[c]].Result=Clients[Index[c]]->PeerConnectTimeout();
+                Slots[Index[c]].Phase=cpDone;
+            }
+            break;
+        }
+
+        for (c = 0; (n>0) && (c < Waiting); c++)
+            if (Fds[c].revents!=0)
+                ConnectStep(Clients[Index[c]], Slots[Index[c]]);
+
+        // Gives up the phases expired
+        Now=SysGetTickUs();
+        for (c = 0; c < Waiting; c++)
+        {
+            TConnectSlot &Slot = Slots[Index[c]];
+            if ((Slot.Phase!=cpDone) && (Fds[c].revents==0) && (Slot.Deadline!=0) && (Now>=Slot.Deadline))
+            {
+                Slot.Result=Clients[Index[c]]->PeerConnectTimeout();
+                Slot.Phase=cpDone;
+            }
+        }
+    } while (true);
+
+    Result=0;
+    for (c = 0; c < Count; c++)
+    {
+        if (Results!=NULL)
+            Results[c]=Slots[c].Result;
+        if (Result==0)
+            Result=Slots[c].Result;
+    }
+
+    delete[] Index;
+    delete[] Fds;
+    delete[] Slots;
+    return Result;
+}
+#else
+//---------------------------------------------------------------------------
+int ConnectClients(PSnap7MicroClient *Clients, int Count, int *Results)
+{
+    int c, Result, First;
+
+    First=0;
+    for (c = 0; c < Count; c++)
+    {
+        Result=Clients[c]->Connect();
+        if (Results!=NULL)
+            Results[c]=Result;
+        if (First==0)
+            First=Result;
+    }
+    return First;
+}
+#endif
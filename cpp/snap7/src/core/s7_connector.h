@@ -0,0 +1,49 @@
+/*=============================================================================|
+|  PROJECT SNAP7                                                         1.3.0 |
+|==============================================================================|
+|  Copyright (C) 2013, 2015 Davide Nardella                                    |
+|  All rights reserved.                                                        |
+|==============================================================================|
+|  SNAP7 is free software: you can redistribute it and/or modify               |
+|  it under the terms of the Lesser GNU General Public License as published by |
+|  the Free Software Foundation, either version 3 of the License, or           |
+|  (at your option) any later version.                                         |
+|                                                                              |
+|  It means that you can distribute your commercial software linked with       |
+|  SNAP7 without the requirement to distribute the source code of your         |
+|  application and without the requirement that your application be itself     |
+|  distributed under LGPL.                                                     |
+|                                                                              |
+|  SNAP7 is distributed in the hope that it will be useful,                    |
+|  but WITHOUT ANY WARRANTY; without even the implied warranty of              |
+|  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the               |
+|  Lesser GNU General Public License for more details.                         |
+|                                                                              |
+|  You should have received a copy of the GNU General Public License and a     |
+|  copy of Lesser GNU General Public License along with Snap7.                 |
+|  If not, see  http://www.gnu.org/licenses/                                   |
+|=============================================================================*/
+#ifndef s7_connector_h
+#define s7_connector_h
+//---------------------------------------------------------------------------
+#include "s7_micro_client.h"
+//---------------------------------------------------------------------------
+// BULK CONNECT
+//
+// Connects many clients at once from the calling thread. All the TCP connects
+// are started non blocking, then each client goes on with the ISO CR/CC and
+// the PDU negotiation as soon as its own answer arrives, so the whole batch
+// takes about as long as the slowest PLC instead of the sum of them.
+//
+// The clients must have their connection params already set. Every phase has
+// the timeout that Connect() would apply : PingTimeout for the TCP connect,
+// RecvTimeout for the CC and for the negotiation. Results (if not NULL)
+// receives the Connect() result of each client and the phase times are the
+// ones of Connect() (TcpConnectTime, IsoConnectTime and NegotiateTime).
+// Returns 0 if all the clients are connected, otherwise the first error.
+//
+// Where connects are blocking (Windows) the clients are connected in sequence.
+//---------------------------------------------------------------------------
+int ConnectClients(PSnap7MicroClient *Clients, int Count, int *Results);
+
+#endif // s7_connector_h
@@ -37,10 +37,30 @@ TIsoTcpSocket::TIsoTcpSocket()
 	IsoPDUSize =1024;
     IsoMaxFragments=MaxIsoFragments;
     LastIsoError=0;
+    FHeaderTime=0;
+    TcpConnectTime=0;
+    PDU=NULL;
+    IsoPayloadSize=0;
+    SetIsoPayloadSize(IsoPayload_Size);
+    ClrIsoCounters();
 }
 //---------------------------------------------------------------------------
 TIsoTcpSocket::~TIsoTcpSocket()
 {
+    delete[] pbyte(PDU);
+}
+//---------------------------------------------------------------------------
+int TIsoTcpSocket::SetIsoPayloadSize(int Size)
+{
+    if ((Size<IsoPayload_Min) || (Size>IsoPayload_Size))
+        return errIsoInvalidDataSize;
+    if (Size!=IsoPayloadSize)
+    {
+        delete[] pbyte(PDU);
+        PDU=PIsoDataPDU(new byte[Size+DataHeaderSize]);
+        IsoPayloadSize=Size;
+    }
+    return 0;
 }
 //---------------------------------------------------------------------------
 int TIsoTcpSocket::CheckPDU(void *pPDU, u_char PduTypeExpected)
@@ -53,7 +73,7 @@ int TIsoTcpSocket::CheckPDU(void *pPDU, u_char PduTypeExpected)
 		Info = PIsoHeaderInfo(pPDU);
 		Size = PDUSize(pPDU);
 		// Performs check
-		if (( Size<7 ) || ( Size>IsoPayload_Size ) ||  // Checks RFC 1006 header length
+		if (( Size<7 ) || ( Size>IsoPayloadSize+int(DataHeaderSize) ) ||  // Checks RFC 1006 header length
 			( Info->HLength<sizeof( TCOTP_DT )-1 ) ||  // Checks ISO 8073 header length
 			( Info->PDUType!=PduTypeExpected))         // Checks PDU Type
 		  return SetIsoError(errIsoInvalidPDU);
@@ -159,17 +179,17 @@ void TIsoTcpSocket::IsoParsePDU(TIsoControlPDU pdu)
 //---------------------------------------------------------------------------
 int TIsoTcpSocket::IsoConfirmConnection(u_char PDUType)
 {
-    PIsoControlPDU CPDU = PIsoControlPDU(&PDU);
+    PIsoControlPDU CPDU = PIsoControlPDU(PDU);
 	u_short TempRef;
 
 	ClrIsoError();
-	PDU.COTP.PDUType=PDUType;
+	PDU->COTP.PDUType=PDUType;
 	// Exchange SrcRef<->DstRef, not strictly needed by COTP 8073 but S7PLC as client needs it.
 	TempRef=CPDU->COTP.DstRef;
 	CPDU->COTP.DstRef=CPDU->COTP.SrcRef;
 	CPDU->COTP.SrcRef=0x0100;//TempRef;
 
-	return SendPacket(&PDU,PDUSize(&PDU));
+	return SendPacket(PDU,PDUSize(PDU));
 }
 //---------------------------------------------------------------------------
 void TIsoTcpSocket::FragmentSkipped(int Size)
@@ -177,104 +197,165 @@ void TIsoTcpSocket::FragmentSkipped(int Size)
 // override for log purpose
 }
 //---------------------------------------------------------------------------
-int TIsoTcpSocket::isoConnect()
+int TIsoTcpSocket::BuildConnectionRequest()
 {
-	pbyte TmpControlPDU;
-    PIsoControlPDU ControlPDU;
-	u_int Length;
-	int Result;
-
 	// Build the default connection telegram
 	BuildControlPDU();
-    ControlPDU =&FControlPDU;
-
 	// Checks the format
-	Result =CheckPDU(ControlPDU, pdu_type_CR);
-	if (Result!=0)
-		return Result;
+	return CheckPDU(&FControlPDU, pdu_type_CR);
+}
+//---------------------------------------------------------------------------
+int TIsoTcpSocket::SendConnectionRequest()
+{
+	// Send connection telegram
+	SendPacket(&FControlPDU, PDUSize(&FControlPDU));
+	if (LastTcpError==0)
+		return 0;
+	else
+		return SetIsoError(errIsoSendPacket);
+}
+//---------------------------------------------------------------------------
+int TIsoTcpSocket::RecvConnectionConfirm()
+{
+	pbyte TmpControlPDU;
+	u_int Length;
+	int Result;
 
-	Result =SckConnect();
-	if (Result==noError)
+	TmpControlPDU = pbyte(&FControlPDU);
+	// Receives TPKT header (4 bytes)
+	RecvPacket(TmpControlPDU, sizeof(TTPKT));
+	if (LastTcpError==0)
 	{
-		// Calcs the length
-		Length =PDUSize(ControlPDU);
-		// Send connection telegram
-		SendPacket(ControlPDU, Length);
-		if (LastTcpError==0)
+		// Calc the packet length
+		Length =PDUSize(TmpControlPDU);
+		// Check if it fits in the buffer and if it's greater then TTPKT size
+		if ((Length<=sizeof(TIsoControlPDU)) && (Length>sizeof(TTPKT)))
 		{
-			TmpControlPDU = pbyte(ControlPDU);
-			// Receives TPKT header (4 bytes)
-			RecvPacket(TmpControlPDU, sizeof(TTPKT));
+			// Points to COTP
+			TmpControlPDU+=sizeof(TTPKT);
+			Length -= sizeof(TTPKT);
+			// Receives remainin bytes 4 bytes after
+			RecvPacket(TmpControlPDU, Length);
 			if (LastTcpError==0)
 			{
-				// Calc the packet length
-				Length =PDUSize(TmpControlPDU);
-				// Check if it fits in the buffer and if it's greater then TTPKT size
-				if ((Length<=sizeof(TIsoControlPDU)) && (Length>sizeof(TTPKT)))
-				{
-					// Points to COTP
-					TmpControlPDU+=sizeof(TTPKT);
-					Length -= sizeof(TTPKT);
-					// Receives remainin bytes 4 bytes after
-					RecvPacket(TmpControlPDU, Length);
-					if (LastTcpError==0)
-					{
-						// Finally checks the Connection Confirm telegram
-						Result =CheckPDU(ControlPDU, pdu_type_CC);
-						if (Result!=0)
-							LastIsoError=Result;
-					}
-					else
-						Result =SetIsoError(errIsoRecvPacket);
-				}
-				else
-					Result =SetIsoError(errIsoInvalidPDU);
+				// Finally checks the Connection Confirm telegram
+				Result =CheckPDU(&FControlPDU, pdu_type_CC);
+				if (Result!=0)
+					LastIsoError=Result;
 			}
 			else
 				Result =SetIsoError(errIsoRecvPacket);
-			// Flush buffer
-			if (Result!=0)
-				Purge();
 		}
 		else
-			Result =SetIsoError(errIsoSendPacket);
+			Result =SetIsoError(errIsoInvalidPDU);
+	}
+	else
+		Result =SetIsoError(errIsoRecvPacket);
+	// Flush buffer
+	if (Result!=0)
+		Purge();
+	return Result;
+}
+//---------------------------------------------------------------------------
+int TIsoTcpSocket::isoConnect()
+{
+	int Result;
+	uint64_t Start;
 
+	TcpConnectTime=0;
+	Result =BuildConnectionRequest();
+	if (Result!=0)
+		return Result;
+
+	Start  =SysGetTickUs();
+	Result =SckConnect();
+	TcpConnectTime=longword(SysGetTickUs()-Start);
+	if (Result==noError)
+	{
+		Result =SendConnectionRequest();
+		if (Result==0)
+			Result =RecvConnectionConfirm();
 		if (Result!=0)
 			SckDisconnect();
 	}
 	return Result;
 }
 //---------------------------------------------------------------------------
+#ifdef NON_BLOCKING_CONNECT
+int TIsoTcpSocket::isoConnectStart()
+{
+	int Result;
+
+	TcpConnectTime=0;
+	Result =BuildConnectionRequest();
+	if (Result==0)
+		Result =SckConnectStart();
+	return Result;
+}
+//---------------------------------------------------------------------------
+int TIsoTcpSocket::isoConnectRequest()
+{
+	int Result;
+
+	Result =SckConnectDone();
+	if (Result==noError)
+		Result =SendConnectionRequest();
+	if (Result!=0)
+		SckDisconnect();
+	return Result;
+}
+//---------------------------------------------------------------------------
+int TIsoTcpSocket::isoConnectConfirm()
+{
+	int Result;
+
+	Result =RecvConnectionConfirm();
+	if (Result!=0)
+		SckDisconnect();
+	return Result;
+}
+#endif
+//---------------------------------------------------------------------------
 int TIsoTcpSocket::isoSendBuffer(void *Data, int Size)
 {
 	int Result;
 	u_int IsoSize;
+	uint64_t Start;
 
     ClrIsoError();
 	// Total Size = Size + Header Size
 	IsoSize =Size+DataHeaderSize;
 	// Checks the length
-	if ((IsoSize>0) && (IsoSize<=IsoFrameSize))
+	if ((IsoSize>0) && (IsoSize<=IsoPayloadSize+DataHeaderSize))
 	{
 		// Builds the header
 		Result =0;
 		// TPKT
-		PDU.TPKT.Version  = isoTcpVersion;
-		PDU.TPKT.Reserved = 0;
-		PDU.TPKT.HI_Lenght= (u_short(IsoSize)>> 8) & 0xFF;
-		PDU.TPKT.LO_Lenght= u_short(IsoSize) & 0xFF;
+		PDU->TPKT.Version  = isoTcpVersion;
+		PDU->TPKT.Reserved = 0;
+		PDU->TPKT.HI_Lenght= (u_short(IsoSize)>> 8) & 0xFF;
+		PDU->TPKT.LO_Lenght= u_short(IsoSize) & 0xFF;
 		// COPT
-		PDU.COTP.HLength   =sizeof(TCOTP_DT)-1;
-		PDU.COTP.PDUType   =pdu_type_DT;
-		PDU.COTP.EoT_Num   =pdu_EoT;
+		PDU->COTP.HLength   =sizeof(TCOTP_DT)-1;
+		PDU->COTP.PDUType   =pdu_type_DT;
+		PDU->COTP.EoT_Num   =pdu_EoT;
 		// Fill payload
-		if (Data!=0) // Data=null ==> use internal buffer PDU.Payload
-            memcpy(&PDU.Payload, Data, Size);
+		if (Data!=0) // Data=null ==> use internal buffer PDU->Payload
+            memcpy(&PDU->Payload, Data, Size);
         // Send over TCP/IP
-        SendPacket(&PDU, IsoSize);
+        SNAP_TRACE_BEGIN("Send", IsoSize);
+        Start=SysGetTickUs();
+        SendPacket(PDU, IsoSize);
+        IsoCounters.SendTime+=longword(SysGetTickUs()-Start);
+        SNAP_TRACE_END("Send");
 
         if (LastTcpError!=0)
             Result =SetIsoError(errIsoSendPacket);
+        else
+        {
+            IsoCounters.PDUsSent++;
+            IsoCounters.BytesSent+=IsoSize;
+        }
 	}
 	else
 		Result =SetIsoError(errIsoInvalidDataSize );
@@ -287,12 +368,12 @@ int TIsoTcpSocket::isoRecvBuffer(void *Data, int & Size)
 
     ClrIsoError();
 	Size =0;
-	Result =isoRecvPDU(&PDU);
+	Result =isoRecvPDU(PDU);
 	if (Result==0)
 	{
-		Size =PDUSize( &PDU )-DataHeaderSize;
+		Size =PDUSize( PDU )-DataHeaderSize;
 		if (Data!=0)  // Data=NULL ==> a child will consume directly PDY.Payload
-            memcpy(Data, &PDU.Payload, Size);
+            memcpy(Data, &PDU->Payload, Size);
 	}
 	return Result;
 }
@@ -353,14 +434,24 @@ int TIsoTcpSocket::isoDisconnect(bool OnlyTCP)
 int TIsoTcpSocket::isoSendPDU(PIsoDataPDU Data)
 {
 	int Result;
+	uint64_t Start;
 
     ClrIsoError();
 	Result=CheckPDU(Data,pdu_type_DT);
 	if (Result==0)
 	{
+		SNAP_TRACE_BEGIN("Send", PDUSize(Data));
+		Start=SysGetTickUs();
 		SendPacket(Data,PDUSize(Data));
+		IsoCounters.SendTime+=longword(SysGetTickUs()-Start);
+		SNAP_TRACE_END("Send");
 		if (LastTcpError!=0)
 			Result=SetIsoError(errIsoSendPacket);
+		else
+		{
+			IsoCounters.PDUsSent++;
+			IsoCounters.BytesSent+=PDUSize(Data);
+		}
 	}
     return Result;
 }
@@ -374,10 +465,12 @@ int TIsoTcpSocket::isoRecvFragment(void *From, int Max, int &Size, bool &EoT)
     byte PDUType;
     ClrIsoError();
 	// header is received always from beginning
-	RecvPacket(&PDU, DataHeaderSize); // TPKT + COPT_DT
+	RecvPacket(PDU, DataHeaderSize); // TPKT + COPT_DT
 	if (LastTcpError==0)
 	{
-        PDUType=PDU.COTP.PDUType;
+        FHeaderTime=SysGetTickUs();
+        SNAP_TRACE_INSTANT("Header", PDUSize(PDU));
+        PDUType=PDU->COTP.PDUType;
         switch (PDUType)
         {
 			case pdu_type_CR:
@@ -385,14 +478,14 @@ int TIsoTcpSocket::isoRecvFragment(void *From, int Max, int &Size, bool &EoT)
 				EoT=true;
 				break;
 			case pdu_type_DT:
-                EoT = (PDU.COTP.EoT_Num & 0x80) == 0x80;  // EoT flag
+                EoT = (PDU->COTP.EoT_Num & 0x80) == 0x80;  // EoT flag
 				break;
 			default:
 				return SetIsoError(errIsoInvalidPDU);
         }
 
-		DataLength = PDUSize(&PDU) - DataHeaderSize;
-		if (CheckPDU(&PDU, PDUType)!=0)
+		DataLength = PDUSize(PDU) - DataHeaderSize;
+		if (CheckPDU(PDU, PDUType)!=0)
 			return LastIsoError;
 		// Checks for data presence
 		if (DataLength>0)  // payload present
@@ -448,17 +541,25 @@ int TIsoTcpSocket::isoRecvPDU(PIsoDataPDU Data)
 	int NumParts;
 	bool Complete;
 
+	uint64_t Start, FirstHeader;
+
 	NumParts =1;
 	Offset =0;
 	Complete =false;
+	FirstHeader =0;
     ClrIsoError();
-	pData = pbyte(&PDU.Payload);
+	pData = pbyte(&PDU->Payload);
+	SNAP_TRACE_BEGIN("Recv", 0);
+	Start=SysGetTickUs();
 	do {
 		pData=pData+Offset;
-		max =IsoPayload_Size-Offset; // Maximum packet allowed
+		max =IsoPayloadSize-Offset; // Maximum packet allowed
 		if (max>0)
 		{
 			Result =isoRecvFragment(pData, max, Received, Complete);
+			if (FirstHeader==0)
+				FirstHeader=FHeaderTime;
+			SNAP_TRACE_INSTANT("Fragment", Received);
 			if((Result==0) &&  !Complete)
 			{
 				++NumParts;
@@ -477,15 +578,21 @@ int TIsoTcpSocket::isoRecvPDU(PIsoDataPDU Data)
 		// Add to offset the header size
 		Size =Offset+Received+DataHeaderSize;
 		// Adjust header
-		PDU.TPKT.HI_Lenght =(u_short(Size)>>8) & 0xFF;
-		PDU.TPKT.LO_Lenght =u_short(Size) & 0xFF;
+		PDU->TPKT.HI_Lenght =(u_short(Size)>>8) & 0xFF;
+		PDU->TPKT.LO_Lenght =u_short(Size) & 0xFF;
 		// Copies data if target is not the local PDU
-		if (Data!=&PDU)
-            memcpy(Data, &PDU, Size);
+		if (Data!=PDU)
+            memcpy(Data, PDU, Size);
+		IsoCounters.PDUsRecvd++;
+		IsoCounters.FragmentsRecvd+=NumParts;
+		IsoCounters.BytesRecvd+=Offset+Received+NumParts*DataHeaderSize;
+		IsoCounters.WaitTime+=longword(FirstHeader-Start);
+		IsoCounters.RecvTime+=longword(SysGetTickUs()-FirstHeader);
 	}
 	else
         if (LastTcpError!=WSAECONNRESET)
             Purge();
+	SNAP_TRACE_END("Recv");
 	return Result;
 }
 //---------------------------------------------------------------------------
@@ -536,6 +643,8 @@ void TIsoTcpSocket::IsoPeek(void *pPDU, TPDUKind &PduKind)
             PduKind=pkUnrecognizedType;
     };
 }
-
-
-
+//---------------------------------------------------------------------------
+void TIsoTcpSocket::ClrIsoCounters()
+{
+	memset(&IsoCounters, 0, sizeof(IsoCounters));
+}
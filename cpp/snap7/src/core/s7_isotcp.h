@@ -27,6 +27,7 @@
 #define s7_isotcp_h
 //---------------------------------------------------------------------------
 #include "snap_msgsock.h"
+#include "snap_trace.h"
 //---------------------------------------------------------------------------
 #pragma pack(1)
 
@@ -35,7 +36,8 @@
 #define isoInvalidHandle        0
 #define MaxTSAPLength    	16     // Max Lenght for Src and Dst TSAP
 #define MaxIsoFragments         64     // Max fragments
-#define IsoPayload_Size    	4096   // Iso telegram Buffer size
+#define IsoPayload_Size    	4096   // Iso telegram Buffer size (the largest one, see SetIsoPayloadSize)
+#define IsoPayload_Min    	240    // Smallest Iso telegram Buffer (smallest PDU of a S7 CPU)
 
 #define noError    			0
 
@@ -208,6 +210,19 @@ typedef enum {
 
 #pragma pack()
 
+// Counters of the data exchanges, accumulated until ClrIsoCounters()
+// Times are in microseconds.
+typedef struct {
+	longword PDUsSent;
+	longword PDUsRecvd;
+	longword FragmentsRecvd;
+	longword BytesSent;   // Headers included
+	longword BytesRecvd;  // Headers included
+	longword SendTime;    // Time spent sending
+	longword WaitTime;    // From the start of a receive to the first header received
+	longword RecvTime;    // From the first header to the complete PDU
+} TIsoCounters;
+
 void ErrIsoText(int Error, char *Msg, int len);
 
 class TIsoTcpSocket : public TMsgSocket
@@ -218,10 +233,17 @@ private:
         int IsoMaxFragments; // max fragments allowed for an ISO telegram
 	// Checks the PDU format
 	int CheckPDU(void *pPDU, u_char PduTypeExpected);
+	// Time at which the header of the last fragment was received
+	uint64_t FHeaderTime;
 	// Receives the next fragment
 	int isoRecvFragment(void *From, int Max, int &Size, bool &EoT);
+	// Steps of isoConnect() after the TCP connect
+	int BuildConnectionRequest();
+	int SendConnectionRequest();
+	int RecvConnectionConfirm();
 protected:
-	TIsoDataPDU PDU;
+	// Only IsoPayloadSize bytes of the payload are allocated
+	PIsoDataPDU PDU;
 	int SetIsoError(int Error);
 	// Builds the control PDU starting from address properties
 	virtual int BuildControlPDU();
@@ -234,19 +256,35 @@ protected:
 	int IsoConfirmConnection(u_char PDUType);
     void ClrIsoError();
 	virtual void FragmentSkipped(int Size);
+	// Reallocates PDU for a payload of Size bytes (IsoPayload_Min..IsoPayload_Size),
+	// only between two telegrams since the content is lost.
+	// Override to update the pointers into the payload.
+	virtual int SetIsoPayloadSize(int Size);
 public:
 	word SrcTSap;  // Source TSAP
 	word DstTSap;  // Destination TSAP
 	word SrcRef;   // Source Reference
 	word DstRef;   // Destination Reference
 	int IsoPDUSize;
+	int IsoPayloadSize; // Payload allocated in PDU (IsoPayload_Size unless resized)
 	int LastIsoError;
+	TIsoCounters IsoCounters;
+	longword TcpConnectTime; // Duration of the TCP connect of the last isoConnect() (us)
 	//--------------------------------------------------------------------------
 	TIsoTcpSocket();
 	~TIsoTcpSocket();
 	// HIGH Level functions (work on payload hiding the underlying protocol)
 	// Connects with a peer, the connection PDU is automatically built starting from address scheme (see below)
 	int isoConnect();
+#ifdef NON_BLOCKING_CONNECT
+	// isoConnect() in three steps, to connect many peers at once :
+	// isoConnectStart() starts the TCP connect, isoConnectRequest() completes it
+	// and sends the CR once the socket is writable, isoConnectConfirm() receives
+	// the CC once the socket is readable. A failed step disconnects.
+	int isoConnectStart();
+	int isoConnectRequest();
+	int isoConnectConfirm();
+#endif
 	// Disconnects from a peer, if OnlyTCP = true, only a TCP disconnect is performed,
 	// otherwise a disconnect PDU is built and send.
 	int isoDisconnect(bool OnlyTCP);
@@ -266,6 +304,7 @@ public:
 	int isoExchangePDU(PIsoDataPDU Data);
 	// Peeks an header info to know which kind of telegram is incoming
 	void IsoPeek(void *pPDU, TPDUKind &PduKind);
+	void ClrIsoCounters();
 };
 
 #endif // s7_isotcp_h
@@ -41,6 +41,7 @@ TSnap7MicroClient::TSnap7MicroClient()
 	DstTSap =0x0000; // It's filled by connection functions
     ConnectionType = CONNTYPE_PG; // Default connection type
 	memset(&Job,0,sizeof(TSnap7Job));
+	ClearStats();
 }
 //---------------------------------------------------------------------------
 TSnap7MicroClient::~TSnap7MicroClient()
@@ -78,9 +79,9 @@ int TSnap7MicroClient::opReadArea()
         return errCliInvalidTransportSize;
      // Request Params size
      RPSize    =sizeof(TReqFunReadItem)+2; // 1 item + FunRead + ItemsCount
-     // Setup pointers (note : PDUH_out and PDU.Payload are the same pointer)
+     // Setup pointers (note : PDUH_out and PDU->Payload are the same pointer)
      ReqParams =PReqFunReadParams(pbyte(PDUH_out)+sizeof(TS7ReqHeader));
-     Answer    =PS7ResHeader23(&PDU.Payload);
+     Answer    =PS7ResHeader23(&PDU->Payload);
      ResParams =PResFunReadParams(pbyte(Answer)+ResHeaderSize23);
      ResData   =PResFunReadItem(pbyte(ResParams)+sizeof(TResFunReadParams));
      // Each packet cannot exceed the PDU length (in bytes) negotiated, and moreover
@@ -98,6 +99,7 @@ int TSnap7MicroClient::opReadArea()
 
           Target=pbyte(Job.pData)+Offset;
           //----------------------------------------------- Read next slice-----
+          SNAP_TRACE_BEGIN("Build", NumElements);
           PDUH_out->P = 0x32;                    // Always 0x32
           PDUH_out->PDUType = PduType_request;   // 0x01
           PDUH_out->AB_EX = 0x0000;              // Always 0x0000
@@ -130,6 +132,7 @@ int TSnap7MicroClient::opReadArea()
           ReqParams->Items[0].Address[0] = Address & 0x000000FF;
 
           IsoSize = sizeof(TS7ReqHeader)+RPSize;
+          SNAP_TRACE_END("Build");
           Result = isoExchangeBuffer(0,IsoSize);
           // Get Data
           if (Result==0)  // 1St level Iso
@@ -194,11 +197,11 @@ int TSnap7MicroClient::opWriteArea()
              4;                       // ReturnCode+TransportSize+DataLength
      RPSize =sizeof(TReqFunWriteItem)+2;
 
-     // Setup pointers (note : PDUH_out and PDU.Payload are the same pointer)
+     // Setup pointers (note : PDUH_out and PDU->Payload are the same pointer)
      ReqParams=PReqFunWriteParams(pbyte(PDUH_out)+sizeof(TS7ReqHeader));
      ReqData  =PReqFunWriteDataItem(pbyte(ReqParams)+sizeof(TReqFunWriteItem)+2); // 2 = FunWrite+ItemsCount
      Target   =pbyte(ReqData)+4; // 4 = ReturnCode+TransportSize+DataLength
-     Answer   =PS7ResHeader23(&PDU.Payload);
+     Answer   =PS7ResHeader23(&PDU->Payload);
      ResParams=PResFunWrite(pbyte(Answer)+ResHeaderSize23);
 
      // Each packet cannot exceed the PDU length (in bytes) negotiated, and moreover
@@ -213,6 +216,7 @@ int TSnap7MicroClient::opWriteArea()
                NumElements=MaxElements;
            Source=pbyte(Job.pData)+Offset;
 
+           SNAP_TRACE_BEGIN("Build", NumElements);
            Size=NumElements * WordSize;
            PDUH_out->P=0x32;                    // Always 0x32
            PDUH_out->PDUType=PduType_request;   // 0x01
@@ -277,6 +281,7 @@ int TSnap7MicroClient::opWriteArea()
 
            memcpy(Target, Source, Size);
            IsoSize=RHSize + Size;
+           SNAP_TRACE_END("Build");
            Result=isoExchangeBuffer(0,IsoSize);
 
            if (Result==0) // 1St check : Iso result
@@ -340,9 +345,16 @@ int TSnap7MicroClient::opReadMultiVars()
     };
 
     // Let's build the PDU
+    SNAP_TRACE_BEGIN("Build", ItemsCount);
     RPSize    = word(2 + ItemsCount * sizeof(TReqFunReadItem));
+    // The PDU buffer only holds the PDU negotiated : check before filling it
+    if (int(RPSize+sizeof(TS7ReqHeader))>PDULength)
+    {
+        SNAP_TRACE_END("Build");
+        return errCliSizeOverPDU;
+    }
     ReqParams = PReqFunReadParams(pbyte(PDUH_out)+sizeof(TS7ReqHeader));
-    Answer    = PS7ResHeader23(&PDU.Payload);
+    Answer    = PS7ResHeader23(&PDU->Payload);
     ResParams = PResFunReadParams(pbyte(Answer)+ResHeaderSize23);
     // Fill Header
     PDUH_out->P=0x32;                    // Always 0x32
@@ -386,6 +398,7 @@ int TSnap7MicroClient::opReadMultiVars()
     };
 
     IsoSize=RPSize+sizeof(TS7ReqHeader);
+    SNAP_TRACE_END("Build");
 	if (IsoSize>PDULength) 
 		return errCliSizeOverPDU;
 	Result=isoExchangeBuffer(0,IsoSize);
@@ -414,6 +427,9 @@ int TSnap7MicroClient::opReadMultiVars()
           // Adjust Size in accord of TransportSize
           if ((ResData[c]->TransportSize != TS_ResOctet) && (ResData[c]->TransportSize != TS_ResReal) && (ResData[c]->TransportSize != TS_ResBit))
             Slice=Slice >> 3;
+          // The data must lie inside the answer received
+          if (pbyte(ResData[c]->Data)+Slice > pbyte(Answer)+IsoSize)
+            return errCliInvalidPlcAnswer;
 
 		  memcpy(Item->pdata, ResData[c]->Data, Slice);
           Item->Result=0;
@@ -465,9 +481,16 @@ int TSnap7MicroClient::opWriteMultiVars()
     };
 
     // Let's build the PDU : setup pointers
+    SNAP_TRACE_BEGIN("Build", ItemsCount);
     RPSize    = word(2 + ItemsCount * sizeof(TReqFunWriteItem));
+    // The PDU buffer only holds the PDU negotiated : check before filling it
+    if (int(RPSize+sizeof(TS7ReqHeader))>PDULength)
+    {
+        SNAP_TRACE_END("Build");
+        return errCliSizeOverPDU;
+    }
     ReqParams = PReqFunWriteParams(pbyte(PDUH_out)+sizeof(TS7ReqHeader));
-    Answer    = PS7ResHeader23(&PDU.Payload);
+    Answer    = PS7ResHeader23(&PDU->Payload);
     ResParams = PResFunWrite(pbyte(Answer)+ResHeaderSize23);
     P=pbyte(ReqParams)+RPSize;
 
@@ -513,6 +536,13 @@ int TSnap7MicroClient::opWriteMultiVars()
         ReqParams->Items[c].Address[0]=Address & 0x000000FF;
 
         // Items Data
+        WordSize=DataSizeByte(Item->WordLen);
+        Size=Item->Amount * WordSize;
+        if (int(RPSize+sizeof(TS7ReqHeader)+Offset+4+Size)>PDULength)
+        {
+            SNAP_TRACE_END("Build");
+            return errCliSizeOverPDU;
+        }
         ReqData[c]=PReqFunWriteDataItem(pbyte(P)+Offset);
         ReqData[c]->ReturnCode=0x00;
 
@@ -537,9 +567,6 @@ int TSnap7MicroClient::opWriteMultiVars()
 			   break;
         };
 
-        WordSize=DataSizeByte(Item->WordLen);
-        Size=Item->Amount * WordSize;
-
 		if ((ReqData[c]->TransportSize!=TS_ResOctet) && (ReqData[c]->TransportSize!=TS_ResReal) && (ReqData[c]->TransportSize!=TS_ResBit))
            ReqData[c]->DataLength=SwapWord(Size*8);
         else
@@ -557,6 +584,7 @@ int TSnap7MicroClient::opWriteMultiVars()
     PDUH_out->DataLen=SwapWord(word(Offset));
 
     IsoSize=RPSize+sizeof(TS7ReqHeader)+int(Offset);
+    SNAP_TRACE_END("Build");
 	if (IsoSize>PDULength) 
 		return errCliSizeOverPDU;
     Result=isoExchangeBuffer(0,IsoSize);
@@ -594,10 +622,10 @@ int TSnap7MicroClient::opListBlocks()
     PS7BlocksList       List;
     int IsoSize, Result;
 
-    // Setup pointers (note : PDUH_out and PDU.Payload are the same pointer)
+    // Setup pointers (note : PDUH_out and PDU->Payload are the same pointer)
     ReqParams=PReqFunGetBlockInfo(pbyte(PDUH_out)+sizeof(TS7ReqHeader));
     ReqData  =PReqDataFunBlocks(pbyte(ReqParams)+sizeof(TReqFunGetBlockInfo));
-    Answer   =PS7ResHeader17(&PDU.Payload);
+    Answer   =PS7ResHeader17(&PDU->Payload);
     ResParams=PResFunGetBlockInfo(pbyte(Answer)+ResHeaderSize17);
     ResData  =PDataFunListAll(pbyte(ResParams)+sizeof(TResFunGetBlockInfo));
     List     =PS7BlocksList(Job.pData);
@@ -687,9 +715,9 @@ int TSnap7MicroClient::opListBlocksOfType()
 
     BlockType=Job.Area;
     List=(word*)(&opData);
-    // Setup pointers (note : PDUH_out and PDU.Payload are the same pointer)
+    // Setup pointers (note : PDUH_out and PDU->Payload are the same pointer)
     ReqParams=PReqFunGetBlockInfo(pbyte(PDUH_out)+sizeof(TS7ReqHeader));
-    Answer   =PS7ResHeader17(&PDU.Payload);
+    Answer   =PS7ResHeader17(&PDU->Payload);
     ResParams=PResFunGetBlockInfo(pbyte(Answer)+ResHeaderSize17);
     ResData  =PDataFunGetBot(pbyte(ResParams)+sizeof(TResFunGetBlockInfo));
     // Get Data
@@ -843,10 +871,10 @@ int TSnap7MicroClient::opAgBlockInfo()
     BlockNum =Job.Number;
     BlockInfo=PS7BlockInfo(Job.pData);
     memset(BlockInfo,0,sizeof(TS7BlockInfo));
-    // Setup pointers (note : PDUH_out and PDU.Payload are the same pointer)
+    // Setup pointers (note : PDUH_out and PDU->Payload are the same pointer)
     ReqParams=PReqFunGetBlockInfo(pbyte(PDUH_out)+sizeof(TS7ReqHeader));
     ReqData  =PReqDataBlockInfo(pbyte(ReqParams)+sizeof(TReqFunGetBlockInfo));
-    Answer   =PS7ResHeader17(&PDU.Payload);
+    Answer   =PS7ResHeader17(&PDU->Payload);
     ResParams=PResFunGetBlockInfo(pbyte(Answer)+ResHeaderSize17);
     ResData  =PResDataBlockInfo(pbyte(ResParams)+sizeof(TResFunGetBlockInfo));
     // Fill Header
@@ -1009,14 +1037,14 @@ int TSnap7MicroClient::opUpload()
     BlockNum =Job.Number;
     Full     =Job.IParam==1;
     // Setup Answer (is the same for all Upload pdus)
-    Answer=  PS7ResHeader23(&PDU.Payload);
+    Answer=  PS7ResHeader23(&PDU->Payload);
     // Init sequence
     Done  =false;
     Offset=0;
     //<-------------------------------------------------------------StartUpload
     PReqFunStartUploadParams ReqParams;
     PResFunStartUploadParams ResParams;
-    // Setup pointers (note : PDUH_out and PDU.Payload are the same pointer)
+    // Setup pointers (note : PDUH_out and PDU->Payload are the same pointer)
     ReqParams=PReqFunStartUploadParams(pbyte(PDUH_out)+sizeof(TS7ReqHeader));
     ResParams=PResFunStartUploadParams(pbyte(Answer)+ResHeaderSize23);
     // Init Header
@@ -1072,7 +1100,7 @@ int TSnap7MicroClient::opUpload()
         pbyte Target;
         int Size;
 
-        // Setup pointers (note : PDUH_out and PDU.Payload are the same pointer)
+        // Setup pointers (note : PDUH_out and PDU->Payload are the same pointer)
         ReqParams=PReqFunUploadParams(pbyte(PDUH_out)+sizeof(TS7ReqHeader));
         // First upload pdu consists of params, block info header, data.
         ResParams=PResFunUploadParams(pbyte(Answer)+ResHeaderSize23);
@@ -1130,7 +1158,7 @@ int TSnap7MicroClient::opUpload()
             pbyte Target;
             int Size;
 
-            // Setup pointers (note : PDUH_out and PDU.Payload are the same pointer)
+            // Setup pointers (note : PDUH_out and PDU->Payload are the same pointer)
             ReqParams=PReqFunUploadParams(pbyte(PDUH_out)+sizeof(TS7ReqHeader));
             // Next upload pdu consists of params, small info header, data.
             ResParams=PResFunUploadParams(pbyte(Answer)+ResHeaderSize23);
@@ -1177,7 +1205,7 @@ int TSnap7MicroClient::opUpload()
             PReqFunEndUploadParams ReqParams;
             PResFunEndUploadParams ResParams;
 
-            // Setup pointers (note : PDUH_out and PDU.Payload are the same pointer)
+            // Setup pointers (note : PDUH_out and PDU->Payload are the same pointer)
             ReqParams=PReqFunEndUploadParams(pbyte(PDUH_out)+sizeof(TS7ReqHeader));
             ResParams=PResFunEndUploadParams(pbyte(Answer)+ResHeaderSize23);
             // Init Header
@@ -1278,9 +1306,9 @@ int TSnap7MicroClient::opDownload()
             PResStartDownloadParams ResParams;
             PS7ResHeader23          Answer;
 
-            // Setup pointers (note : PDUH_out and PDU.Payload are the same pointer)
+            // Setup pointers (note : PDUH_out and PDU->Payload are the same pointer)
             ReqParams=PReqStartDownloadParams(pbyte(PDUH_out)+sizeof(TS7ReqHeader));
-            Answer   =PS7ResHeader23(&PDU.Payload);
+            Answer   =PS7ResHeader23(&PDU->Payload);
             ResParams=PResStartDownloadParams(pbyte(Answer)+ResHeaderSize23);
             // Init Header
             PDUH_out->P=0x32;                     // Always 0x32
@@ -1371,7 +1399,7 @@ int TSnap7MicroClient::opDownload()
                 pbyte Target;
 
                 ReqParams=PReqDownloadParams(pbyte(PDUH_out)+sizeof(TS7ReqHeader));
-                Answer   =PS7ResHeader23(&PDU.Payload);
+                Answer   =PS7ResHeader23(&PDU->Payload);
                 ResParams=PResDownloadParams(pbyte(Answer)+ResHeaderSize23);
                 ResData  =PResDownloadDataHeader(pbyte(ResParams)+sizeof(TResDownloadParams));
                 Target   =pbyte(ResData)+sizeof(TResDownloadDataHeader);
@@ -1433,7 +1461,7 @@ int TSnap7MicroClient::opDownload()
                 word Sequence;
 
                 ReqParams=PReqDownloadParams(pbyte(PDUH_out)+sizeof(TS7ReqHeader));
-                Answer   =PS7ResHeader23(&PDU.Payload);
+                Answer   =PS7ResHeader23(&PDU->Payload);
                 ResParams=PResEndDownloadParams(pbyte(Answer)+ResHeaderSize23);
 
                 Result=isoRecvBuffer(0,Size);
@@ -1467,9 +1495,9 @@ int TSnap7MicroClient::opDownload()
                 PS7ResHeader23 Answer;
                 pbyte ResParams;
 
-                // Setup pointers (note : PDUH_out and PDU.Payload are the same pointer)
+                // Setup pointers (note : PDUH_out and PDU->Payload are the same pointer)
                 ReqParams=PReqControlBlockParams(pbyte(PDUH_out)+sizeof(TS7ReqHeader));
-                Answer=PS7ResHeader23(&PDU.Payload);
+                Answer=PS7ResHeader23(&PDU->Payload);
                 ResParams=pbyte(Answer)+ResHeaderSize23;
                 // Init Header
                 PDUH_out->P=0x32;                     // Always 0x32
@@ -1534,9 +1562,9 @@ int TSnap7MicroClient::opDelete()
 
     BlockType=Job.Area;
     BlockNum =Job.Number;
-    // Setup pointers (note : PDUH_out and PDU.Payload are the same pointer)
+    // Setup pointers (note : PDUH_out and PDU->Payload are the same pointer)
     ReqParams=PReqControlBlockParams(pbyte(PDUH_out)+sizeof(TS7ReqHeader));
-    Answer   =PS7ResHeader23(&PDU.Payload);
+    Answer   =PS7ResHeader23(&PDU->Payload);
     ResParams=pbyte(Answer)+ResHeaderSize23;
     // Init Header
     PDUH_out->P=0x32;                     // Always 0x32
@@ -1616,13 +1644,13 @@ int TSnap7MicroClient::opReadSZL()
     ID=Job.ID;
     Index=Job.Index;
     opSize=0;
-    // Setup pointers (note : PDUH_out and PDU.Payload are the same pointer)
+    // Setup pointers (note : PDUH_out and PDU->Payload are the same pointer)
     ReqParamsFirst=PReqFunReadSZLFirst(pbyte(PDUH_out)+sizeof(TS7ReqHeader));
     ReqParamsNext =PReqFunReadSZLNext(pbyte(PDUH_out)+sizeof(TS7ReqHeader));
     ReqDataFirst  =PS7ReqSZLData(pbyte(ReqParamsFirst)+sizeof(TReqFunReadSZLFirst));
     ReqDataNext   =PS7ReqSZLData(pbyte(ReqParamsNext)+sizeof(TReqFunReadSZLNext));
 
-    Answer        =PS7Answer17(&PDU.Payload);
+    Answer        =PS7Answer17(&PDU->Payload);
     ResParams     =PS7ResParams7(pbyte(Answer)+ResHeaderSize17);
     ResDataFirst  =PS7ResSZLDataFirst(pbyte(ResParams)+sizeof(TS7Params7));
     ResDataNext   =PS7ResSZLDataNext(pbyte(ResParams)+sizeof(TS7Params7));
@@ -1837,10 +1865,10 @@ int TSnap7MicroClient::opGetDateTime()
     int IsoSize, Result;
     word AYear;
 
-    // Setup pointers (note : PDUH_out and PDU.Payload are the same pointer)
+    // Setup pointers (note : PDUH_out and PDU->Payload are the same pointer)
     ReqParams=PReqFunDateTime(pbyte(PDUH_out)+sizeof(TS7ReqHeader));
     ReqData  =PReqDataGetDateTime(pbyte(ReqParams)+sizeof(TReqFunDateTime));
-    Answer   =PS7ResHeader17(&PDU.Payload);
+    Answer   =PS7ResHeader17(&PDU->Payload);
     ResParams=PS7ResParams7(pbyte(Answer)+ResHeaderSize17);
     ResData  =PResDataGetTime(pbyte(ResParams)+sizeof(TS7Params7));
     DateTime =PTimeStruct(Job.pData);
@@ -1904,10 +1932,10 @@ int TSnap7MicroClient::opSetDateTime()
     word AYear;
     int IsoSize, Result;
 
-    // Setup pointers (note : PDUH_out and PDU.Payload are the same pointer)
+    // Setup pointers (note : PDUH_out and PDU->Payload are the same pointer)
     ReqParams=PReqFunDateTime(pbyte(PDUH_out)+sizeof(TS7ReqHeader));
     ReqData  =PReqDataSetTime(pbyte(ReqParams)+sizeof(TReqFunDateTime));
-    Answer   =PS7ResHeader17(&PDU.Payload);
+    Answer   =PS7ResHeader17(&PDU->Payload);
     ResParams=PS7ResParams7(pbyte(Answer)+ResHeaderSize17);
     DateTime =PTimeStruct(Job.pData);
     // Fill Header
@@ -2064,9 +2092,9 @@ int TSnap7MicroClient::opPlcStop()
 
     char p_program[] = {'P','_','P','R','O','G','R','A','M'};
 
-    // Setup pointers (note : PDUH_out and PDU.Payload are the same pointer)
+    // Setup pointers (note : PDUH_out and PDU->Payload are the same pointer)
     ReqParams=PReqFunPlcStop(pbyte(PDUH_out)+sizeof(TS7ReqHeader));
-    Answer   =PS7ResHeader23(&PDU.Payload);
+    Answer   =PS7ResHeader23(&PDU->Payload);
     ResParams=PResFunCtrl(pbyte(Answer)+ResHeaderSize23);
     // Fill Header
     PDUH_out->P=0x32;                    // Always 0x32
@@ -2109,9 +2137,9 @@ int TSnap7MicroClient::opPlcHotStart()
 
     char p_program[] = {'P','_','P','R','O','G','R','A','M'};
 
-    // Setup pointers (note : PDUH_out and PDU.Payload are the same pointer)
+    // Setup pointers (note : PDUH_out and PDU->Payload are the same pointer)
     ReqParams=PReqFunPlcHotStart(pbyte(PDUH_out)+sizeof(TS7ReqHeader));
-    Answer   =PS7ResHeader23(&PDU.Payload);
+    Answer   =PS7ResHeader23(&PDU->Payload);
     ResParams=PResFunCtrl(pbyte(Answer)+ResHeaderSize23);
     // Fill Header
     PDUH_out->P=0x32;                    // Always 0x32
@@ -2166,9 +2194,9 @@ int TSnap7MicroClient::opPlcColdStart()
     int IsoSize, Result;
     char p_program[] = {'P','_','P','R','O','G','R','A','M'};
 
-    // Setup pointers (note : PDUH_out and PDU.Payload are the same pointer)
+    // Setup pointers (note : PDUH_out and PDU->Payload are the same pointer)
     ReqParams=PReqFunPlcColdStart(pbyte(PDUH_out)+sizeof(TS7ReqHeader));
-    Answer   =PS7ResHeader23(&PDU.Payload);
+    Answer   =PS7ResHeader23(&PDU->Payload);
     ResParams=PResFunCtrl(pbyte(Answer)+ResHeaderSize23);
     // Fill Header
     PDUH_out->P=0x32;                     // Always 0x32
@@ -2224,9 +2252,9 @@ int TSnap7MicroClient::opCopyRamToRom()
     int IsoSize, CurTimeout, Result;
     char _modu[] = {'_','M','O','D','U'};
 
-    // Setup pointers (note : PDUH_out and PDU.Payload are the same pointer)
+    // Setup pointers (note : PDUH_out and PDU->Payload are the same pointer)
     ReqParams=PReqFunCopyRamToRom(pbyte(PDUH_out)+sizeof(TS7ReqHeader));
-    Answer   =PS7ResHeader23(&PDU.Payload);
+    Answer   =PS7ResHeader23(&PDU->Payload);
     ResParams=PResFunCtrl(pbyte(Answer)+ResHeaderSize23);
     // Fill Header
     PDUH_out->P=0x32;                    // Always 0x32
@@ -2274,9 +2302,9 @@ int TSnap7MicroClient::opCompress()
     int IsoSize, CurTimeout, Result;
     char _garb[] = {'_','G','A','R','B'};
 
-    // Setup pointers (note : PDUH_out and PDU.Payload are the same pointer)
+    // Setup pointers (note : PDUH_out and PDU->Payload are the same pointer)
     ReqParams=PReqFunCompress(pbyte(PDUH_out)+sizeof(TS7ReqHeader));
-    Answer   =PS7ResHeader23(&PDU.Payload);
+    Answer   =PS7ResHeader23(&PDU->Payload);
     ResParams=PResFunCtrl(pbyte(Answer)+ResHeaderSize23);
     // Fill Header
     PDUH_out->P=0x32;                    // Always 0x32
@@ -2355,10 +2383,10 @@ int TSnap7MicroClient::opSetPassword()
     PS7ResHeader23 Answer;
     int c, IsoSize, Result;
 
-    // Setup pointers (note : PDUH_out and PDU.Payload are the same pointer)
+    // Setup pointers (note : PDUH_out and PDU->Payload are the same pointer)
     ReqParams=PReqFunSecurity(pbyte(PDUH_out)+sizeof(TS7ReqHeader));
     ReqData  =PReqDataSecurity(pbyte(ReqParams)+sizeof(TReqFunSecurity));
-    Answer   =PS7ResHeader23(&PDU.Payload);
+    Answer   =PS7ResHeader23(&PDU->Payload);
     ResParams=PResParamsSecurity(pbyte(Answer)+ResHeaderSize17);
     // Fill Header
     PDUH_out->P=0x32;                    // Always 0x32
@@ -2408,10 +2436,10 @@ int TSnap7MicroClient::opClearPassword()
     PS7ResHeader23 Answer;
     int IsoSize, Result;
 
-    // Setup pointers (note : PDUH_out and PDU.Payload are the same pointer)
+    // Setup pointers (note : PDUH_out and PDU->Payload are the same pointer)
     ReqParams=PReqFunSecurity(pbyte(PDUH_out)+sizeof(TS7ReqHeader));
     ReqData  =PReqDataSecurity(pbyte(ReqParams)+sizeof(TReqFunSecurity));
-    Answer   =PS7ResHeader23(&PDU.Payload);
+    Answer   =PS7ResHeader23(&PDU->Payload);
     ResParams=PResParamsSecurity(pbyte(Answer)+ResHeaderSize17);
     // Fill Header
     PDUH_out->P=0x32;                     // Always 0x32
@@ -2537,8 +2565,12 @@ int TSnap7MicroClient::SubBlockToBlock(int SBB)
 //---------------------------------------------------------------------------
 int TSnap7MicroClient::PerformOperation()
 {
+    uint64_t Start;
     ClrError();
+    ClrIsoCounters();
+    Start=SysGetTickUs();
     int Operation=Job.Op;
+    SNAP_TRACE_BEGIN("Job", Operation);
     switch(Operation)
     {
         case s7opNone:
@@ -2629,16 +2661,80 @@ int TSnap7MicroClient::PerformOperation()
              Job.Result=opClearPassword();
              break;
     }
-   Job.Time =SysGetTick()-JobStart;
+   UpdateStats(Operation, Job.Result, SysGetTickUs()-Start);
+   SNAP_TRACE_END("Job");
+   SetJobTime();
    Job.Pending=false;
    return SetError(Job.Result);
 }
 //---------------------------------------------------------------------------
+void TSnap7MicroClient::SetJobTime()
+{
+    uint64_t Elapsed=SysGetTickNs()-JobStart;
+    Job.Time  =longword(Elapsed/1000000);
+    Job.TimeUs=longword(Elapsed/1000);
+}
+//---------------------------------------------------------------------------
+static int StatBucket(longword Time)
+{
+    int Bucket = 0;
+    while (Time!=0 && Bucket<s7StatBuckets-1)
+    {
+        Time>>=1;
+        Bucket++;
+    }
+    return Bucket;
+}
+//---------------------------------------------------------------------------
+void TSnap7MicroClient::UpdateStats(int Operation, int Result, uint64_t Elapsed)
+{
+    PS7OpStats Stats;
+    longword Phase[s7StatPhases];
+    longword IsoTime;
+
+    if (Operation<0 || Operation>=s7opCount)
+        return;
+    Stats=&FStats.Op[Operation];
+    Stats->Calls++;
+    if (Result!=0)
+        Stats->Errors++;
+    Stats->PDUsSent+=IsoCounters.PDUsSent;
+    Stats->PDUsRecvd+=IsoCounters.PDUsRecvd;
+    Stats->Fragments+=IsoCounters.FragmentsRecvd;
+    Stats->BytesSent+=IsoCounters.BytesSent;
+    Stats->BytesRecvd+=IsoCounters.BytesRecvd;
+
+    Phase[s7phTotal]=longword(Elapsed);
+    Phase[s7phSend]=IsoCounters.SendTime;
+    Phase[s7phWait]=IsoCounters.WaitTime;
+    Phase[s7phRecv]=IsoCounters.RecvTime;
+    IsoTime=IsoCounters.SendTime+IsoCounters.WaitTime+IsoCounters.RecvTime;
+    Phase[s7phDecode]=Phase[s7phTotal]>IsoTime ? Phase[s7phTotal]-IsoTime : 0;
+
+    for (int c = 0; c < s7StatPhases; c++)
+    {
+        Stats->Time[c]+=Phase[c];
+        if (Phase[c]>Stats->MaxTime[c])
+            Stats->MaxTime[c]=Phase[c];
+        Stats->Histogram[c][StatBucket(Phase[c])]++;
+    }
+}
+//---------------------------------------------------------------------------
+void TSnap7MicroClient::GetStats(PS7ClientStats pUsrData)
+{
+    memcpy(pUsrData, &FStats, sizeof(TS7ClientStats));
+}
+//---------------------------------------------------------------------------
+void TSnap7MicroClient::ClearStats()
+{
+    memset(&FStats, 0, sizeof(TS7ClientStats));
+}
+//---------------------------------------------------------------------------
 int TSnap7MicroClient::Disconnect()
 {
-     JobStart=SysGetTick();
+     JobStart=SysGetTickNs();
      PeerDisconnect();
-     Job.Time=SysGetTick()-JobStart;
+     SetJobTime();
 	 Job.Pending=false;
      return 0;
 }
@@ -2657,9 +2753,9 @@ int TSnap7MicroClient::Reset(bool DoReconnect)
 int TSnap7MicroClient::Connect()
 {
 	 int Result;
-	 JobStart=SysGetTick();
+	 JobStart=SysGetTickNs();
 	 Result  =PeerConnect();
-	 Job.Time=SysGetTick()-JobStart;
+	 SetJobTime();
 	 return Result;
 }
 //---------------------------------------------------------------------------
@@ -2750,6 +2846,8 @@ int TSnap7MicroClient::SetParam(int ParamNumber, void *pValue)
 		SrcTSap=*Puint16_t(pValue);
 		break;
 	case p_i32_PDURequest:
+		if ((*Pint32_t(pValue)<IsoPayload_Min) || (*Pint32_t(pValue)>IsoPayload_Size))
+			return errCliInvalidParams;
 		PDURequest=*Pint32_t(pValue);
 		break;
 	default: return errCliInvalidParamNumber;
@@ -2770,7 +2868,7 @@ int TSnap7MicroClient::ReadArea(int Area, int DBNumber, int Start, int Amount, i
          Job.Amount   = Amount;
          Job.WordLen  = WordLen;
          Job.pData    = pUsrData;
-         JobStart     = SysGetTick();
+         JobStart     = SysGetTickNs();
          return PerformOperation();
      }
      else
@@ -2789,7 +2887,7 @@ int TSnap7MicroClient::WriteArea(int Area, int DBNumber, int Start, int Amount,
           Job.Amount   = Amount;
           Job.WordLen  = WordLen;
           Job.pData    = pUsrData;
-          JobStart     = SysGetTick();
+          JobStart     = SysGetTickNs();
           return PerformOperation();
      }
      else
@@ -2804,7 +2902,7 @@ int TSnap7MicroClient::ReadMultiVars(PS7DataItem Item, int ItemsCount)
         Job.Op       =s7opReadMultiVars;
         Job.Amount   =ItemsCount;
         Job.pData    =Item;
-        JobStart     =SysGetTick();
+        JobStart     =SysGetTickNs();
         return PerformOperation();
     }
     else
@@ -2819,7 +2917,7 @@ int TSnap7MicroClient::WriteMultiVars(PS7DataItem Item, int ItemsCount)
         Job.Op       =s7opWriteMultiVars;
         Job.Amount   =ItemsCount;
         Job.pData    =Item;
-        JobStart     =SysGetTick();
+        JobStart     =SysGetTickNs();
         return PerformOperation();
     }
     else
@@ -2893,7 +2991,7 @@ int TSnap7MicroClient::ListBlocks(PS7BlocksList pUsrData)
         Job.Pending  =true;
         Job.Op       =s7opListBlocks;
         Job.pData    =pUsrData;
-        JobStart     =SysGetTick();
+        JobStart     =SysGetTickNs();
         return PerformOperation();
     }
     else
@@ -2909,7 +3007,7 @@ int TSnap7MicroClient::GetAgBlockInfo(int BlockType, int BlockNum, PS7BlockInfo
         Job.Area     =BlockType;
         Job.Number   =BlockNum;
         Job.pData    =pUsrData;
-        JobStart     =SysGetTick();
+        JobStart     =SysGetTickNs();
         return PerformOperation();
     }
     else
@@ -2959,7 +3057,7 @@ int TSnap7MicroClient::ListBlocksOfType(int BlockType, TS7BlocksOfType *pUsrData
 	Job.pData    =pUsrData;
 	Job.pAmount  =&ItemsCount;
 	Job.Amount   =ItemsCount;
-	JobStart     =SysGetTick();
+	JobStart     =SysGetTickNs();
 	return PerformOperation();
     }
     else
@@ -2980,7 +3078,7 @@ int TSnap7MicroClient::Upload(int BlockType, int BlockNum,  void * pUsrData, int
         Job.Amount   =Size;
         Job.Number   =BlockNum;
         Job.IParam   =0; // not full upload, only data
-        JobStart     =SysGetTick();
+        JobStart     =SysGetTickNs();
         return PerformOperation();
     }
     else
@@ -3001,7 +3099,7 @@ int TSnap7MicroClient::FullUpload(int BlockType, int BlockNum, void * pUsrData,
         Job.Amount   =Size;
         Job.Number   =BlockNum;
         Job.IParam   =1; // header + data + footer
-        JobStart     =SysGetTick();
+        JobStart     =SysGetTickNs();
         return PerformOperation();
     }
     else
@@ -3017,7 +3115,7 @@ int TSnap7MicroClient::Download(int BlockNum,  void * pUsrData,  int Size)
         memcpy(&opData, pUsrData, Size);
         Job.Number   =BlockNum;
         Job.Amount   =Size;
-        JobStart     =SysGetTick();
+        JobStart     =SysGetTickNs();
         return PerformOperation();
     }
     else
@@ -3032,7 +3130,7 @@ int TSnap7MicroClient::Delete(int BlockType, int BlockNum)
         Job.Op       =s7opDelete;
         Job.Area     =BlockType;
         Job.Number   =BlockNum;
-        JobStart     =SysGetTick();
+        JobStart     =SysGetTickNs();
         return PerformOperation();
     }
     else
@@ -3051,7 +3149,7 @@ int TSnap7MicroClient::DBGet(int DBNumber, void * pUsrData, int & Size)
         Job.pData    =pUsrData;
         Job.pAmount  =&Size;
         Job.Amount   =Size;
-        JobStart     =SysGetTick();
+        JobStart     =SysGetTickNs();
         return PerformOperation();
     }
     else
@@ -3066,7 +3164,7 @@ int TSnap7MicroClient::DBFill(int DBNumber,  int FillChar)
         Job.Op       =s7opDBFill;
         Job.Number   =DBNumber;
         Job.IParam   =FillChar;
-        JobStart     =SysGetTick();
+        JobStart     =SysGetTickNs();
         return PerformOperation();
     }
     else
@@ -3080,7 +3178,7 @@ int TSnap7MicroClient::GetPlcDateTime(tm &DateTime)
         Job.Pending  =true;
         Job.Op       =s7opGetDateTime;
         Job.pData    =&DateTime;
-        JobStart     =SysGetTick();
+        JobStart     =SysGetTickNs();
         return PerformOperation();
     }
     else
@@ -3094,7 +3192,7 @@ int TSnap7MicroClient::SetPlcDateTime(tm * DateTime)
         Job.Pending  =true;
         Job.Op       =s7opSetDateTime;
         Job.pData    =DateTime;
-        JobStart     =SysGetTick();
+        JobStart     =SysGetTickNs();
         return PerformOperation();
     }
     else
@@ -3116,7 +3214,7 @@ int TSnap7MicroClient::GetOrderCode(PS7OrderCode pUsrData)
         Job.Pending  =true;
         Job.Op       =s7opGetOrderCode;
         Job.pData    =pUsrData;
-        JobStart     =SysGetTick();
+        JobStart     =SysGetTickNs();
         return PerformOperation();
     }
     else
@@ -3130,7 +3228,7 @@ int TSnap7MicroClient::GetCpuInfo(PS7CpuInfo pUsrData)
         Job.Pending  =true;
         Job.Op       =s7opGetCpuInfo;
         Job.pData    =pUsrData;
-        JobStart     =SysGetTick();
+        JobStart     =SysGetTickNs();
         return PerformOperation();
     }
     else
@@ -3144,7 +3242,7 @@ int TSnap7MicroClient::GetCpInfo(PS7CpInfo pUsrData)
         Job.Pending  =true;
         Job.Op       =s7opGetCpInfo;
         Job.pData    =pUsrData;
-        JobStart     =SysGetTick();
+        JobStart     =SysGetTickNs();
         return PerformOperation();
     }
     else
@@ -3163,7 +3261,7 @@ int TSnap7MicroClient::ReadSZL(int ID, int Index, PS7SZL pUsrData, int &Size)
         Job.pAmount  =&Size;
         Job.Amount   =Size;
         Job.IParam   =1; // Data has to be copied into user buffer
-        JobStart     =SysGetTick();
+        JobStart     =SysGetTickNs();
         return PerformOperation();
     }
     else
@@ -3179,7 +3277,7 @@ int TSnap7MicroClient::ReadSZLList(PS7SZLList pUsrData, int &ItemsCount)
         Job.pData    =pUsrData;
         Job.pAmount  =&ItemsCount;
         Job.Amount   =ItemsCount;
-        JobStart     =SysGetTick();
+        JobStart     =SysGetTickNs();
         return PerformOperation();
     }
     else
@@ -3192,7 +3290,7 @@ int TSnap7MicroClient::PlcHotStart()
     {
         Job.Pending  =true;
         Job.Op       =s7opPlcHotStart;
-        JobStart     =SysGetTick();
+        JobStart     =SysGetTickNs();
         return PerformOperation();
     }
     else
@@ -3205,7 +3303,7 @@ int TSnap7MicroClient::PlcColdStart()
     {
         Job.Pending  =true;
         Job.Op       =s7opPlcColdStart;
-        JobStart     =SysGetTick();
+        JobStart     =SysGetTickNs();
         return PerformOperation();
     }
     else
@@ -3218,7 +3316,7 @@ int TSnap7MicroClient::PlcStop()
     {
         Job.Pending  =true;
         Job.Op       =s7opPlcStop;
-        JobStart     =SysGetTick();
+        JobStart     =SysGetTickNs();
         return PerformOperation();
     }
     else
@@ -3234,7 +3332,7 @@ int TSnap7MicroClient::CopyRamToRom(int Timeout)
                Job.Pending =true;
                Job.Op      =s7opCopyRamToRom;
                Job.IParam  =Timeout;
-               JobStart    =SysGetTick();
+               JobStart    =SysGetTickNs();
                return PerformOperation();
           }
           else
@@ -3253,7 +3351,7 @@ int TSnap7MicroClient::Compress(int Timeout)
                Job.Pending =true;
                Job.Op      =s7opCompress;
                Job.IParam  =Timeout;
-               JobStart    =SysGetTick();
+               JobStart    =SysGetTickNs();
                return PerformOperation();
           }
           else
@@ -3270,7 +3368,7 @@ int TSnap7MicroClient::GetPlcStatus(int & Status)
         Job.Pending  =true;
         Job.Op       =s7opGetPlcStatus;
         Job.pData    =&Status;
-        JobStart     =SysGetTick();
+        JobStart     =SysGetTickNs();
         return PerformOperation();
     }
     else
@@ -3284,7 +3382,7 @@ int TSnap7MicroClient::GetProtection(PS7Protection pUsrData)
         Job.Pending  =true;
         Job.Op       =s7opGetProtection;
         Job.pData    =pUsrData;
-        JobStart     =SysGetTick();
+        JobStart     =SysGetTickNs();
         return PerformOperation();
     }
     else
@@ -3305,7 +3403,7 @@ int TSnap7MicroClient::SetSessionPassword(char *Password)
         // copies
         strncpy((char*)&opData,Password,L);
         Job.Op       =s7opSetPassword;
-        JobStart     =SysGetTick();
+        JobStart     =SysGetTickNs();
         return PerformOperation();
     }
     else
@@ -3318,7 +3416,7 @@ int TSnap7MicroClient::ClearSessionPassword()
     {
         Job.Pending  =true;
         Job.Op       =s7opClearPassword;
-        JobStart     =SysGetTick();
+        JobStart     =SysGetTickNs();
         return PerformOperation();
     }
     else
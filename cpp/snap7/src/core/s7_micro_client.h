@@ -69,6 +69,7 @@ const longword errCliFunctionRefused        = 0x02300000;
 const longword errCliDestroying             = 0x02400000;
 const longword errCliInvalidParamNumber     = 0x02500000;
 const longword errCliCannotChangeParam      = 0x02600000;
+const longword errCliCannotOpenCapture      = 0x02700000;
 
 const time_t DeltaSecs = 441763200; // Seconds between 1970/1/1 (C time base) and 1984/1/1 (Siemens base)
 
@@ -199,6 +200,41 @@ typedef struct {
 #define s7opClearPassword     27
 #define s7opDBFill            28
 
+#define s7opCount             29
+
+// Operation statistics (Cli_GetStats)
+// Every operation is split into phases, times are in microseconds :
+//   Send   : sending the request telegrams
+//   Wait   : from the start of a receive to the first header of the answer
+//   Recv   : from the first header to the complete answer (fragments included)
+//   Decode : the rest, i.e. building the requests and decoding the answers
+// Latency histograms are log2 bucketed : bucket n counts the times t with
+// 2^(n-1) <= t < 2^n us (bucket 0 : t = 0), the last one everything longer.
+const int s7phTotal        = 0;
+const int s7phSend         = 1;
+const int s7phWait         = 2;
+const int s7phRecv         = 3;
+const int s7phDecode       = 4;
+const int s7StatPhases     = 5;
+const int s7StatBuckets    = 24;
+
+typedef struct {
+   longword Calls;
+   longword Errors;
+   longword PDUsSent;
+   longword PDUsRecvd;
+   longword Fragments;   // Fragments received
+   uint64_t BytesSent;
+   uint64_t BytesRecvd;
+   uint64_t Time[s7StatPhases];    // Total time per phase
+   longword MaxTime[s7StatPhases]; // Slowest call per phase
+   longword Histogram[s7StatPhases][s7StatBuckets];
+} TS7OpStats, *PS7OpStats;
+
+typedef struct {
+   TS7OpStats Op[s7opCount]; // Indexed by s7opXXXX
+} TS7ClientStats, *PS7ClientStats;
+
 // Param Number (to use with setparam)
 
 // Low level : change them to experiment new connections, their defaults normally work well
@@ -228,7 +264,8 @@ struct TSnap7Job
     int Op;        // Operation Code
     int Result;    // Operation result
     bool Pending;  // A Job is pending
-    longword Time; // Job Execution time
+    longword Time; // Job Execution time (ms)
+    longword TimeUs; // Job Execution time (us)
     // Read/Write
     int Area;      // Also used for Block type and Block of type
     int Number;    // Used for DB Number, Block number
@@ -283,9 +320,12 @@ private:
     longword DWordAt(void * P);
     int CheckBlock(int BlockType, int BlockNum,  void *pBlock,  int Size);
     int SubBlockToBlock(int SBB);
+    TS7ClientStats FStats;
+    void UpdateStats(int Operation, int Result, uint64_t Elapsed);
 protected:
     word ConnectionType;
-    longword JobStart;
+    uint64_t JobStart; // SysGetTickNs() at the start of the job
+    void SetJobTime();
     TSnap7Job Job;
     int DataSizeByte(int WordLength);
     int opSize; // last operation size
@@ -353,9 +393,13 @@ public:
     int GetProtection(PS7Protection pUsrData);
     int SetSessionPassword(char *Password);
     int ClearSessionPassword();
+    // Statistics (consistent only while no job is pending)
+    void GetStats(PS7ClientStats pUsrData);
+    void ClearStats();
     // Properties
     bool Busy(){ return Job.Pending; };
     int Time(){ return int(Job.Time);}
+    int TimeUs(){ return int(Job.TimeUs);}
 };
 
 typedef TSnap7MicroClient *PSnap7MicroClient;
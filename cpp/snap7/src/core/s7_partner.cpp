@@ -27,6 +27,7 @@
 //------------------------------------------------------------------------------
 
 static PServersManager ServersManager = NULL;
+static PPartnerLoops PartnerLoops = NULL;
 
 //------------------------------------------------------------------------------
 int ServersManager_GetServer(longword BindAddress, PConnectionServer &Server)
@@ -51,6 +52,24 @@ void ServersManager_RemovePartner(PConnectionServer Server, PSnap7Partner Partne
     }
 }
 //------------------------------------------------------------------------------
+int PartnerLoops_SetCount(int Count)
+{
+    if (PartnerLoops == NULL)
+    {
+        if (Count == 0)
+            return 0;
+        PartnerLoops = new TPartnerLoops();
+    }
+    return PartnerLoops->SetCount(Count);
+}
+//------------------------------------------------------------------------------
+int PartnerLoops_Attach(PSnap7Partner Partner)
+{
+    if (PartnerLoops == NULL)
+        return errParInvalidParams;
+    return PartnerLoops->Attach(Partner);
+}
+//------------------------------------------------------------------------------
 // CONNECTION SERVERS MANAGER
 //------------------------------------------------------------------------------
 TServersManager::TServersManager()
@@ -349,7 +368,11 @@ void TConnectionServer::Incoming(socket_t Sock)
     // if partner exists must not be already connected : a partner can be connected
     // with only one peer at time
     if ((Partner!=NULL) && (!Partner->Stopping) && (!Partner->Connected))
+    {
         Partner->SetSocket(Sock);
+        if (Partner->FLoop!=NULL)
+            Partner->FLoop->Wake();
+    }
     else
         Msg_CloseSocket(Sock); // we are not interested
 }
@@ -386,23 +409,575 @@ void TPartnerThread::Execute()
     };
 }
 //------------------------------------------------------------------------------
+// PARTNER EVENT LOOP
+//------------------------------------------------------------------------------
+// True if the tick Time has been reached (wraps as SysGetTick does)
+static bool TickDue(longword Now, longword Time)
+{
+    return int32_t(Now-Time)>=0;
+}
+
+// Phases of the connection of an active partner, each one waits for the socket
+const int lpIdle      = 0; // not connecting
+const int lpTcp       = 1; // TCP connect, waits for writable
+const int lpIso       = 2; // Connection request sent, waits for the CC
+const int lpNegotiate = 3; // Negotiation sent, waits for the answer
+//------------------------------------------------------------------------------
+TPartnerLoop::TPartnerLoop()
+{
+    int c;
+    cs = new TSnapCriticalSection;
+    Poller = new TSnapPoller;
+    Role = thrPartner;
+    memset(Partners,0,sizeof(Partners));
+    for (c = 0; c < MaxPartners*2; c++)
+    {
+        Polled[c]=INVALID_SOCKET;
+        PolledOut[c]=false;
+    }
+    PartnersCount=0;
+    FreeOnTerminate=false;
+}
+//------------------------------------------------------------------------------
+TPartnerLoop::~TPartnerLoop()
+{
+    delete Poller;
+    delete cs;
+}
+//------------------------------------------------------------------------------
+void TPartnerLoop::Lock()
+{
+    cs->Enter();
+}
+//------------------------------------------------------------------------------
+void TPartnerLoop::Unlock()
+{
+    cs->Leave();
+}
+//------------------------------------------------------------------------------
+bool TPartnerLoop::Valid()
+{
+    return Poller->Valid();
+}
+//------------------------------------------------------------------------------
+void TPartnerLoop::Wake()
+{
+    Poller->Wake();
+}
+//------------------------------------------------------------------------------
+int TPartnerLoop::Attach(PSnap7Partner Partner)
+{
+    int c;
+    longword Now;
+
+    Lock();
+    for (c = 0; c < MaxPartners; c++)
+    {
+        if (Partners[c]==NULL)
+        {
+            Now=SysGetTick();
+            Partner->FLoop=this;
+            Partner->FLoopSlot=c;
+            Partner->FKaElapsed=Now;
+            // An active partner that could not link in Start() retries after the recovery time
+            if (Partner->Active && !Partner->Linked)
+                Partner->FLoopHold=Now+Partner->RecoveryTime;
+            else
+                Partner->FLoopHold=Now;
+            Partners[c]=Partner;
+            PartnersCount++;
+            break;
+        }
+    }
+    Unlock();
+    if (c==MaxPartners)
+        return errParNoRoom;
+    Wake();
+    return 0;
+}
+//------------------------------------------------------------------------------
+void TPartnerLoop::Detach(PSnap7Partner Partner)
+{
+    // Waits for the loop to finish the service of the partner, if any
+    Lock();
+    Unwatch(Partner->FLoopSlot);
+    if (Partner->FProbing)
+        ProbeStop(Partner);
+    // A connection or a block send left halfway are given up
+    if (Partner->FLoopPhase!=lpIdle)
+    {
+        Partner->PeerDisconnect();
+        Partner->FLoopPhase=lpIdle;
+    }
+    if (Partner->FSendStatus.Busy)
+    {
+        Partner->SetError(errParSendingBlock);
+        Partner->SendEnd();
+        Partner->SendComplete();
+    }
+    Partners[Partner->FLoopSlot]=NULL;
+    PartnersCount--;
+    Partner->FLoop=NULL;
+    Unlock();
+}
+//------------------------------------------------------------------------------
+void TPartnerLoop::Unwatch(int Tag)
+{
+    if (Polled[Tag]!=INVALID_SOCKET)
+    {
+        Poller->Remove(Polled[Tag]);
+        Polled[Tag]=INVALID_SOCKET;
+        PolledOut[Tag]=false;
+    }
+}
+//------------------------------------------------------------------------------
+void TPartnerLoop::Reconcile(longword Now)
+{
+    socket_t Wanted[MaxPartners*2];
+    bool WantedOut[MaxPartners*2];
+    PSnap7Partner Partner;
+    int c;
+
+    // A partner is watched while connecting, or while connected unless it's recovering
+    // from an error, its probe while a keep alive is in progress
+    for (c = 0; c < MaxPartners; c++)
+    {
+        Partner=Partners[c];
+        Wanted[c]=INVALID_SOCKET;
+        WantedOut[c]=false;
+        Wanted[c+MaxPartners]=INVALID_SOCKET;
+        WantedOut[c+MaxPartners]=false;
+        if (Partner==NULL)
+            continue;
+        if (Partner->FLoopPhase!=lpIdle)
+        {
+            Wanted[c]=Partner->FSocket;
+            WantedOut[c]=Partner->FLoopPhase==lpTcp;
+        }
+        else
+            if (Partner->Connected && TickDue(Now, Partner->FLoopHold) &&
+               (Partner->FRecvPending || Partner->FSendStatus.Busy || !Partner->RingFull()))
+                Wanted[c]=Partner->FSocket;
+        if (Partner->FProbing)
+        {
+            Wanted[c+MaxPartners]=Partner->FProbe->GetSocket();
+            WantedOut[c+MaxPartners]=true;
+        }
+    }
+    // All the stale sockets are removed before adding the new ones, since the
+    // socket of a partner may have been reused by another one
+    for (c = 0; c < MaxPartners*2; c++)
+        if ((Polled[c]!=Wanted[c]) || (PolledOut[c]!=WantedOut[c]))
+            Unwatch(c);
+    for (c = 0; c < MaxPartners*2; c++)
+    {
+        if ((Wanted[c]!=INVALID_SOCKET) && (Polled[c]!=Wanted[c]))
+        {
+            if (WantedOut[c] ? Poller->AddWritable(Wanted[c], c) : Poller->Add(Wanted[c], c))
+            {
+                Polled[c]=Wanted[c];
+                PolledOut[c]=WantedOut[c];
+            }
+        }
+    }
+}
+//------------------------------------------------------------------------------
+int TPartnerLoop::NextTimeout(longword Now)
+{
+    PSnap7Partner Partner;
+    longword Timers[4];
+    int c, t, Delta, PhaseTimeout;
+    int Result=LoopMaxWait;
+
+    for (c = 0; c < MaxPartners; c++)
+    {
+        Partner=Partners[c];
+        if ((Partner==NULL) || Partner->Destroying || Partner->Stopping)
+            continue;
+        t=0;
+        if (!TickDue(Now, Partner->FLoopHold))
+            Timers[t++]=Partner->FLoopHold;
+        else
+        {
+            if (Partner->FLoopPhase!=lpIdle)
+            {
+                PhaseTimeout=Partner->FLoopPhase==lpTcp ? Partner->PingTimeout : Partner->RecvTimeout;
+                if (PhaseTimeout>0)
+                    Timers[t++]=Partner->FPhaseStart+PhaseTimeout+1;
+            }
+            else
+                if (!Partner->Connected)
+                {
+                    if (Partner->Active)
+                        return 0; // connection attempt due
+                }
+                else
+                {
+                    if (Partner->FSendStatus.Busy)
+                        Timers[t++]=Partner->FSendStatus.Elapsed+Partner->RecvTimeout+1;
+                    else
+                        if (Partner->FSendPending && !Partner->FRecvPending)
+                            return 0;
+                    if (Partner->FRecvPending)
+                        Timers[t++]=Partner->FRecvStatus.Elapsed+Partner->BRecvTimeout+1;
+                    if (Partner->Active)
+                        Timers[t++]=Partner->FKaElapsed+Partner->KeepAliveTime+1;
+                }
+            if (Partner->FProbing)
+                Timers[t++]=Partner->FProbeStart+Partner->PingTimeout+1;
+        }
+        while (t>0)
+        {
+            Delta=int32_t(Timers[--t]-Now);
+            if (Delta<0)
+                Delta=0;
+            if (Delta<Result)
+                Result=Delta;
+        }
+    }
+    return Result;
+}
+//------------------------------------------------------------------------------
+// PeerConnect() one phase at a time, as s7_connector does : each step is taken
+// when the socket is ready and every phase has the timeout that PeerConnect()
+// would apply (PingTimeout for the TCP connect, RecvTimeout for the answers).
+void TPartnerLoop::ConnectStep(PSnap7Partner Partner, bool Ready, longword Now)
+{
+#ifdef NON_BLOCKING_CONNECT
+    int Result, PhaseTimeout;
+
+    if (Partner->FLoopPhase==lpIdle)
+    {
+        Result=Partner->PeerConnectStart();
+        if (Result==0)
+            Partner->FLoopPhase=lpTcp;
+        else
+            Partner->SckDisconnect();
+    }
+    else
+        if (Ready)
+        {
+            switch (Partner->FLoopPhase)
+            {
+                case lpTcp:
+                    Result=Partner->PeerConnectRequest();
+                    Partner->FLoopPhase=lpIso;
+                    break;
+                case lpIso:
+                    Result=Partner->PeerConnectConfirm();
+                    Partner->FLoopPhase=lpNegotiate;
+                    break;
+                default:
+                    Result=Partner->PeerNegotiateConfirm();
+                    Partner->FLoopPhase=lpIdle;
+                    Partner->Linked=Result==0;
+                    if (Partner->Linked)
+                        Partner->FKaElapsed=Now;
+                    break;
+            }
+        }
+        else
+        {
+            PhaseTimeout=Partner->FLoopPhase==lpTcp ? Partner->PingTimeout : Partner->RecvTimeout;
+            if ((PhaseTimeout<=0) || !TickDue(Now, Partner->FPhaseStart+PhaseTimeout+1))
+                return;
+            Result=Partner->PeerConnectTimeout();
+        }
+    Partner->FPhaseStart=Now;
+    if (Result!=0)
+    {
+        Partner->FLoopPhase=lpIdle;
+        Partner->FLoopHold=Now+Partner->RecoveryTime;
+    }
+#else
+    if (Partner->ConnectToPeer())
+        Partner->FKaElapsed=SysGetTick();
+    else
+        Partner->FLoopHold=SysGetTick()+Partner->RecoveryTime;
+#endif
+}
+//------------------------------------------------------------------------------
+// BlockSend() one step at a time : sends the slices that the window allows, then
+// each ack is read as soon as it arrives. Returns false if the connection was dropped.
+bool TPartnerLoop::SendStep(PSnap7Partner Partner, bool Ready, longword Now)
+{
+    bool Result;
+
+    if (!Partner->FSendStatus.Busy)
+    {
+        Partner->SendBegin();
+        Partner->FSendStatus.Busy=true;
+    }
+    else
+        if (Ready && (Partner->FSendStatus.InFlight>0))
+            Partner->SendAck();
+        else
+            if (Partner->SendAckDue() && TickDue(Now, Partner->FSendStatus.Elapsed+Partner->RecvTimeout+1))
+            {
+                // No answer in time, as isoRecvBuffer() would give up
+                Partner->SetError(errParSendingBlock);
+                Partner->FSendStatus.Broken=true;
+            }
+    while (!Partner->SendDone() && !Partner->SendAckDue())
+        Partner->SendSlice();
+    if (!Partner->SendDone())
+        return true;
+    // A refused block leaves the connection in sync, only a transport error drops it
+    Result=Partner->SendEnd() || (Partner->LastError==errParSendRefused);
+    Partner->SendComplete();
+    if (!Result)
+        Partner->Disconnect();
+    return Result;
+}
+//------------------------------------------------------------------------------
+// Keep alive without waiting : a TCP connect to the peer, that is reachable if it
+// accepts or refuses the connection. The probe is closed as soon as it's answered.
+void TPartnerLoop::ProbeStart(PSnap7Partner Partner, longword Now)
+{
+#ifdef NON_BLOCKING_CONNECT
+    if (Partner->PingTimeout==0) // as Ping()
+        return;
+    if (Partner->FProbe==NULL)
+        Partner->FProbe=new TMsgSocket();
+    strcpy(Partner->FProbe->RemoteAddress, Partner->RemoteAddress);
+    Partner->FProbe->RemotePort=Partner->RemotePort;
+    Partner->FProbe->LastTcpError=0;
+    Partner->FProbeStart=Now;
+    Partner->FProbing=true;
+    if (Partner->FProbe->SckConnectStart()!=0)
+        ProbeStep(Partner, true, Now);
+#else
+    if (!Partner->Ping(Partner->RemoteAddress))
+        Partner->Disconnect();
+#endif
+}
+//------------------------------------------------------------------------------
+void TPartnerLoop::ProbeStep(PSnap7Partner Partner, bool Ready, longword Now)
+{
+#ifdef NON_BLOCKING_CONNECT
+    int Error;
+
+    if (Ready)
+    {
+        Error=Partner->FProbe->LastTcpError;
+        if (Error==0)
+            Error=Partner->FProbe->SckConnectDone();
+    }
+    else
+        if (TickDue(Now, Partner->FProbeStart+Partner->PingTimeout+1))
+            Error=WSAEHOSTUNREACH;
+        else
+            return;
+    ProbeStop(Partner);
+    if ((Error!=0) && (Error!=WSAECONNREFUSED))
+        Partner->Disconnect();
+#endif
+}
+//------------------------------------------------------------------------------
+void TPartnerLoop::ProbeStop(PSnap7Partner Partner)
+{
+    Unwatch(Partner->FLoopSlot+MaxPartners);
+    Partner->FProbe->SckDisconnect();
+    Partner->FProbing=false;
+}
+//------------------------------------------------------------------------------
+void TPartnerLoop::Service(PSnap7Partner Partner, bool Ready, bool ProbeReady, longword Now)
+{
+    bool Acked;
+
+    if (Partner->Destroying || Partner->Stopping || !TickDue(Now, Partner->FLoopHold))
+        return;
+    // Check connection
+    if (!Partner->Connected || (Partner->FLoopPhase!=lpIdle))
+    {
+        if (Partner->Active)
+            ConnectStep(Partner, Ready, Now);
+        return;
+    }
+    // Block send, the readiness of the socket is the ack of a slice
+    if (Partner->FSendStatus.Busy || (Partner->FSendPending && !Partner->FRecvPending))
+    {
+        Acked=Partner->FSendStatus.Busy && Ready;
+        if (!SendStep(Partner, Acked, Now))
+        {
+            Partner->FLoopHold=Now+Partner->RecoveryTime;
+            return;
+        }
+        if (Acked)
+            Ready=false;
+    }
+    // Receive, only when there is something to do
+    if (!Partner->FSendStatus.Busy && (Ready ||
+       (Partner->FRecvPending && TickDue(Now, Partner->FRecvStatus.Elapsed+Partner->BRecvTimeout+1))))
+    {
+        if (!Partner->Work(0))
+        {
+            Partner->FLoopHold=SysGetTick()+Partner->RecoveryTime;
+            return;
+        }
+    }
+    // Keep Alive
+    if (Partner->FProbing)
+        ProbeStep(Partner, ProbeReady, Now);
+    else
+        if (Partner->Active && Partner->Connected && TickDue(Now, Partner->FKaElapsed+Partner->KeepAliveTime+1))
+        {
+            Partner->FKaElapsed=Now;
+            ProbeStart(Partner, Now);
+        }
+}
+//------------------------------------------------------------------------------
+void TPartnerLoop::Execute()
+{
+    bool Ready[MaxPartners*2];
+    int Tags[64];
+    int c, Count, Timeout;
+    longword Now;
+
+    while (!Terminated)
+    {
+        Lock();
+        Now=SysGetTick();
+        Reconcile(Now);
+        Timeout=NextTimeout(Now);
+        Unlock();
+
+        Count=Poller->Wait(Timeout, Tags, 64);
+        if (Terminated)
+            break;
+
+        Lock();
+        memset(Ready,0,sizeof(Ready));
+        for (c = 0; c < Count; c++)
+            Ready[Tags[c]]=true;
+        Now=SysGetTick();
+        for (c = 0; c < MaxPartners; c++)
+        {
+            if (Partners[c]!=NULL)
+                Service(Partners[c], Ready[c] && (Polled[c]!=INVALID_SOCKET),
+                    Ready[c+MaxPartners] && (Polled[c+MaxPartners]!=INVALID_SOCKET), Now);
+        }
+        Unlock();
+    }
+}
+//------------------------------------------------------------------------------
+// EVENT LOOPS MANAGER
+//------------------------------------------------------------------------------
+TPartnerLoops::TPartnerLoops()
+{
+    cs = new TSnapCriticalSection;
+    memset(Loops,0,sizeof(Loops));
+    LoopsCount=0;
+}
+//------------------------------------------------------------------------------
+TPartnerLoops::~TPartnerLoops()
+{
+    Clear();
+    delete cs;
+}
+//------------------------------------------------------------------------------
+void TPartnerLoops::Clear()
+{
+    int c;
+    for (c = 0; c < LoopsCount; c++)
+    {
+        Loops[c]->Terminate();
+        Loops[c]->Wake();
+        if (Loops[c]->WaitFor(LoopMaxWait*2)!=WAIT_OBJECT_0)
+            Loops[c]->Kill();
+        delete Loops[c];
+        Loops[c]=NULL;
+    }
+    LoopsCount=0;
+}
+//------------------------------------------------------------------------------
+int TPartnerLoops::SetCount(int Count)
+{
+    int c, Result;
+
+    if ((Count<0) || (Count>MaxPartnerLoops))
+        return errParInvalidParams;
+    Result=0;
+    cs->Enter();
+    for (c = 0; c < LoopsCount; c++)
+        if (Loops[c]->PartnersCount>0)
+            Result=errParCannotChangeParam;
+    if (Result==0)
+    {
+        Clear();
+        for (c = 0; c < Count; c++)
+        {
+            Loops[c]=new TPartnerLoop();
+            if (!Loops[c]->Valid())
+            {
+                delete Loops[c];
+                Loops[c]=NULL;
+                Clear();
+                Result=errParInvalidParams;
+                break;
+            }
+            Loops[c]->Start();
+            LoopsCount++;
+        }
+    }
+    cs->Leave();
+    return Result;
+}
+//------------------------------------------------------------------------------
+int TPartnerLoops::Attach(PSnap7Partner Partner)
+{
+    int c, Best, Result;
+
+    cs->Enter();
+    Best=-1;
+    for (c = 0; c < LoopsCount; c++)
+        if ((Best<0) || (Loops[c]->PartnersCount<Loops[Best]->PartnersCount))
+            Best=c;
+    if (Best>=0)
+        Result=Loops[Best]->Attach(Partner);
+    else
+        Result=errParInvalidParams;
+    cs->Leave();
+    return Result;
+}
+//------------------------------------------------------------------------------
 // S7 PARTNER
 //------------------------------------------------------------------------------
 TSnap7Partner::TSnap7Partner(bool CreateActive)
 {
     // We skip RFC/ISO header, our PDU is the ISO payload
-    PDUH_in=PS7ReqHeader(&PDU.Payload);
+    PDUH_in=PS7ReqHeader(&PDU->Payload);
     FWorkerThread=0;
+    FLoop=NULL;
+    FLoopSlot=0;
+    FLoopHold=0;
+    FKaElapsed=0;
+    FLoopPhase=lpIdle;
+    FPhaseStart=0;
+    FProbe=NULL;
+    FProbing=false;
+    FProbeStart=0;
     OnBRecv = 0;
     OnBSend = 0;
     Active=CreateActive;
     SendEvt = new TSnapEvent(true);
     RecvEvt = new TSnapEvent(true);
+    RingCS = new TSnapCriticalSection;
+    RingFreeEvt = new TSnapEvent(true);
+    RingReadyEvt = new TSnapEvent(true);
+    FRing = NULL;
+    FRingBufSize = 0;
+    FRingCount = 0;
+    FRingFree = 0;
+    FRingSeq = 0;
+    FRecvSlot = -1;
+    memset(FRingSlots,0,sizeof(FRingSlots));
     FSendPending = false;
     FRecvPending = false;
     memset(&FRecvStatus,0,sizeof(TRecvStatus));
+    memset(&FSendStatus,0,sizeof(TSendStatus));
     memset(&FRecvLast,0,sizeof(TRecvLast));
-    FSendElapsed  = 0;
+    FSendStart    = 0;
 	Destroying    = false;
     // public
     Linked        =false;
@@ -410,12 +985,15 @@ TSnap7Partner::TSnap7Partner(bool CreateActive)
     BindError     =false;
     BRecvTimeout  =3000;
     BSendTimeout  =3000;
+    BSendWindow   =1;
     RecoveryTime  =500;
     KeepAliveTime =5000;
     NextByte      =0;
     PeerAddress   =0;
     SendTime      =0;
     RecvTime      =0;
+    SendTimeUs    =0;
+    RecvTimeUs    =0;
     BytesSent     =0;
     BytesRecv     =0;
     SendErrors    =0;
@@ -429,6 +1007,11 @@ TSnap7Partner::~TSnap7Partner()
     OnBSend = 0;
     delete SendEvt;
     delete RecvEvt;
+    delete RingFreeEvt;
+    delete RingReadyEvt;
+    delete RingCS;
+    if (FProbe!=NULL)
+        delete FProbe;
 }
 //------------------------------------------------------------------------------
 byte TSnap7Partner::GetNextByte()
@@ -458,8 +1041,8 @@ int TSnap7Partner::Start()
           Linked=PeerConnect()==0;
           Result=0; // we need to create the worker thread even tough it's not linked
       };
-     // if ok create the worker thread
-     if (Result==0)
+     // if ok join an event loop (if any) or create the worker thread
+     if ((Result==0) && (PartnerLoops_Attach(this)!=0))
      {
          FWorkerThread = new TPartnerThread(this, RecoveryTime);
          FWorkerThread->Start();
@@ -501,6 +1084,13 @@ int TSnap7Partner::Stop()
 //------------------------------------------------------------------------------
 void TSnap7Partner::Disconnect()
 {
+    // The loop must forget the socket before it's closed (and maybe reused)
+    if (FLoop!=NULL)
+    {
+        FLoop->Unwatch(FLoopSlot);
+        if (FProbing)
+            FLoop->ProbeStop(this);
+    }
     PeerDisconnect();
     Linked=false;
 }
@@ -545,6 +1135,9 @@ int TSnap7Partner::GetParam(int ParamNumber, void * pValue)
 		case p_i32_BRecvTimeout:    
 			*Pint32_t(pValue)=BRecvTimeout;
 			break;
+		case p_i32_BSendWindow:
+			*Pint32_t(pValue)=BSendWindow;
+			break;
 		case p_u32_RecoveryTime:    
 			*Puint32_t(pValue)=RecoveryTime;
 			break;
@@ -588,6 +1181,8 @@ int TSnap7Partner::SetParam(int ParamNumber, void * pValue)
 			SrcTSap=*Puint16_t(pValue);
 			break;
 		case p_i32_PDURequest:
+			if ((*Pint32_t(pValue)<IsoPayload_Min) || (*Pint32_t(pValue)>IsoPayload_Size))
+				return errParInvalidParams;
 			PDURequest=*Pint32_t(pValue);
 			break;
 		case p_i32_BSendTimeout:
@@ -596,6 +1191,11 @@ int TSnap7Partner::SetParam(int ParamNumber, void * pValue)
 		case p_i32_BRecvTimeout:    
 			BRecvTimeout=*Pint32_t(pValue);
 			break;
+		case p_i32_BSendWindow:
+			if (*Pint32_t(pValue)<1)
+				return errParInvalidParams;
+			BSendWindow=*Pint32_t(pValue);
+			break;
 		case p_u32_RecoveryTime:    
 			RecoveryTime=*Puint32_t(pValue);
 			break;
@@ -609,6 +1209,12 @@ int TSnap7Partner::SetParam(int ParamNumber, void * pValue)
 //------------------------------------------------------------------------------
 void TSnap7Partner::ClearRecv()
 {
+    // An incomplete block gives its ring buffer back
+    if (FRecvSlot>=0)
+    {
+        RingRelease(FRecvSlot, rsFilling);
+        FRecvSlot=-1;
+    }
     memset(&FRecvStatus,0,sizeof(TRecvStatus));
     FRecvPending=false;
 }
@@ -627,6 +1233,13 @@ bool TSnap7Partner::ConnectToPeer()
     return Result;
 }
 //------------------------------------------------------------------------------
+int TSnap7Partner::SetIsoPayloadSize(int Size)
+{
+    int Result = TSnap7Peer::SetIsoPayloadSize(Size);
+    PDUH_in=PS7ReqHeader(&PDU->Payload);
+    return Result;
+}
+//------------------------------------------------------------------------------
 bool TSnap7Partner::PerformFunctionNegotiate()
 {
     PReqFunNegotiateParams ReqParams;
@@ -657,7 +1270,7 @@ bool TSnap7Partner::PerformFunctionNegotiate()
     ResParams->FunNegotiate=pduNegotiate;
     ResParams->Unknown=0x0;
     // Checks PDU request length
-    if (SwapWord(ResParams->PDULength)>IsoPayload_Size)
+    if (SwapWord(ReqParams->PDULength)>IsoPayload_Size)
         ResParams->PDULength=SwapWord(IsoPayload_Size);
     else
         ResParams->PDULength=ReqParams->PDULength;
@@ -678,6 +1291,8 @@ bool TSnap7Partner::PerformFunctionNegotiate()
 void TSnap7Partner::CloseWorker()
 {
      int Timeout;
+     if (FLoop)
+          FLoop->Detach(this);
      if (FWorkerThread)
      {
           FWorkerThread->Terminate();
@@ -697,132 +1312,190 @@ void TSnap7Partner::CloseWorker()
      }
 }
 //------------------------------------------------------------------------------
-bool TSnap7Partner::BlockSend()
+void TSnap7Partner::SendBegin()
+{
+    ClrError();
+    memset(&FSendStatus,0,sizeof(TSendStatus));
+    FSendStatus.TotalSize=TxBuffer.Size;
+    FSendStatus.SentSize =TxBuffer.Size;
+    FSendStatus.First    =true;
+    FSendStatus.Elapsed  =SysGetTick();
+  // With BSend we can transfer up to 32k (S7300) or 64k (S7400), but splitted
+  // into slice that cannot exced the PDU size negotiated (including various headers).
+    FSendStatus.MaxSlice=PDULength-sizeof(TS7ReqHeader)-sizeof(TBSendParams)-sizeof(TBsendRequestData)-2;
+}
+//------------------------------------------------------------------------------
+void TSnap7Partner::SendSlice()
 {
     PBSendReqParams ReqParams;
-    PBSendReqParams ResParams;
     PBsendRequestData DataSendReq;
-    int TotalSize;
-    int SentSize;
     int Slice;
-    int MaxSlice;
-    uintptr_t Offset;
     pbyte Source;
     bool First, Last;
-    byte Seq_IN;
     int TxIsoSize;
     pbyte Data;
     pword TotalPackSize;
     int DataPtrOffset;
     word Extra;
 
-    ClrError();
-    TotalSize=TxBuffer.Size;
-    SentSize =TotalSize;
-    Offset=0;
-    First =true;
-    Seq_IN=0x00;
+    ReqParams=PBSendReqParams(pbyte(PDUH_out)+sizeof(TS7ReqHeader));
 
-  // With BSend we can transfer up to 32k (S7300) or 64k (S7400), but splitted
-  // into slice that cannot exced the PDU size negotiated (including various headers).
-    MaxSlice=PDULength-sizeof(TS7ReqHeader)-sizeof(TBSendParams)-sizeof(TBsendRequestData)-2;
+	Source=pbyte(&TxBuffer.Data)+FSendStatus.Offset;
+	Slice=FSendStatus.TotalSize;
 
-    ReqParams=PBSendReqParams(pbyte(PDUH_out)+sizeof(TS7ReqHeader));
-    ResParams=ReqParams; // pdu 7 is symmetrical
+	if (Slice>FSendStatus.MaxSlice)
+		Slice=FSendStatus.MaxSlice;
 
-    while ((TotalSize>0) && (LastError==0))
-    {
-		Source=pbyte(&TxBuffer.Data)+Offset;
-		Slice=TotalSize;
-
-		if (Slice>MaxSlice)
-			Slice=MaxSlice;
-
-		TotalSize-=Slice;
-		Offset+=Slice;
-		Last=TotalSize==0;
-
-		// Prepare send
-		DataPtrOffset=sizeof(TS7ReqHeader)+sizeof(TBSendParams);
-		// Header
-		PDUH_out->P=0x32;                     // Always 0x32
-		PDUH_out->PDUType=PduType_userdata;  // 7
-		PDUH_out->AB_EX=0x0000;               // Always 0x0000
-		PDUH_out->Sequence=GetNextWord();      // Autoinc
-		PDUH_out->ParLen=SwapWord(sizeof(TBSendParams)); // 16 bytes
-
-		ReqParams->Head[0]=0x00;
-		ReqParams->Head[1]=0x01;
-		ReqParams->Head[2]=0x12;
-		ReqParams->Plen   =0x08; // length from here up the end of the record
-		ReqParams->Uk     =0x12;
-		ReqParams->Tg     =grBSend; // 0x46
-		ReqParams->SubFun =0x01;
-		ReqParams->Seq    =Seq_IN;
-		ReqParams->Err    =0x0000;
-		if (Last)
-			ReqParams->EoS  =0x00;
-		else
-			ReqParams->EoS  =0x01;
-		// Next byte is auto inc and not zero for partial sequences
-		// Is zero for lonely sequences.
-		if (First && Last)
-			ReqParams->IDSeq=0x00;
-		else
-			ReqParams->IDSeq=GetNextByte();
+	FSendStatus.TotalSize-=Slice;
+	FSendStatus.Offset+=Slice;
+	First=FSendStatus.First;
+	Last=FSendStatus.TotalSize==0;
 
-		DataSendReq=PBsendRequestData(pbyte(PDUH_out)+DataPtrOffset);
-		if (First)
-		{
-			// in the first pdu, after data header there is the whole packet length
-			TotalPackSize=pword(pbyte(DataSendReq)+sizeof(TBsendRequestData));
-			Data=pbyte(TotalPackSize)+sizeof(word);
-			*TotalPackSize=SwapWord(word(TxBuffer.Size));
-			Extra=2; // extra bytes (total pack size indicator)
-		}
-		else
-		{
-			Data=pbyte(DataSendReq)+sizeof(TBsendRequestData);
-			Extra=0;
-		};
-
-		PDUH_out->DataLen=SwapWord(word(sizeof(TBsendRequestData))+Slice+Extra);
-		DataSendReq->Len =SwapWord(Slice+8+Extra);
-		TxIsoSize=Slice+sizeof(TS7ReqHeader)+sizeof(TBSendParams)+sizeof(TBsendRequestData)+Extra;
-
-		DataSendReq->FF      =0xFF;
-		DataSendReq->TRSize  =TS_ResOctet;
-		DataSendReq->DHead[0]=0x12;
-		DataSendReq->DHead[1]=0x06;
-		DataSendReq->DHead[2]=0x13;
-		DataSendReq->DHead[3]=0x00;
-		DataSendReq->R_ID    =SwapDWord(TxBuffer.R_ID);
-		memcpy(Data, Source ,Slice);
-
-		if (isoExchangeBuffer(NULL, TxIsoSize)!=0)
-			SetError(errParSendingBlock);
-
-		if (LastError==0)
-		{
-		   Seq_IN=ResParams->Seq;
-		   if (SwapWord(ResParams->Err)!=0)
-			   LastError=errParSendRefused;
-		}
+	// Prepare send
+	DataPtrOffset=sizeof(TS7ReqHeader)+sizeof(TBSendParams);
+	// Header
+	PDUH_out->P=0x32;                     // Always 0x32
+	PDUH_out->PDUType=PduType_userdata;  // 7
+	PDUH_out->AB_EX=0x0000;               // Always 0x0000
+	PDUH_out->Sequence=GetNextWord();      // Autoinc
+	PDUH_out->ParLen=SwapWord(sizeof(TBSendParams)); // 16 bytes
 
-		if (First)
-		{
-			First =false;
-			MaxSlice+=2; // only in the first frame we have the extra info
-		};
+	ReqParams->Head[0]=0x00;
+	ReqParams->Head[1]=0x01;
+	ReqParams->Head[2]=0x12;
+	ReqParams->Plen   =0x08; // length from here up the end of the record
+	ReqParams->Uk     =0x12;
+	ReqParams->Tg     =grBSend; // 0x46
+	ReqParams->SubFun =0x01;
+	ReqParams->Seq    =FSendStatus.Seq_IN;
+	ReqParams->Err    =0x0000;
+	if (Last)
+		ReqParams->EoS  =0x00;
+	else
+		ReqParams->EoS  =0x01;
+	// Next byte is auto inc and not zero for partial sequences
+	// Is zero for lonely sequences.
+	if (First && Last)
+		ReqParams->IDSeq=0x00;
+	else
+		ReqParams->IDSeq=GetNextByte();
+
+	DataSendReq=PBsendRequestData(pbyte(PDUH_out)+DataPtrOffset);
+	if (First)
+	{
+		// in the first pdu, after data header there is the whole packet length
+		TotalPackSize=pword(pbyte(DataSendReq)+sizeof(TBsendRequestData));
+		Data=pbyte(TotalPackSize)+sizeof(word);
+		*TotalPackSize=SwapWord(word(TxBuffer.Size));
+		Extra=2; // extra bytes (total pack size indicator)
+	}
+	else
+	{
+		Data=pbyte(DataSendReq)+sizeof(TBsendRequestData);
+		Extra=0;
 	};
 
-	SendTime=SysGetTick()-FSendElapsed;
-	if (LastError==0)
-		BytesSent+=SentSize;
+	PDUH_out->DataLen=SwapWord(word(sizeof(TBsendRequestData))+Slice+Extra);
+	DataSendReq->Len =SwapWord(Slice+8+Extra);
+	TxIsoSize=Slice+sizeof(TS7ReqHeader)+sizeof(TBSendParams)+sizeof(TBsendRequestData)+Extra;
+
+	DataSendReq->FF      =0xFF;
+	DataSendReq->TRSize  =TS_ResOctet;
+	DataSendReq->DHead[0]=0x12;
+	DataSendReq->DHead[1]=0x06;
+	DataSendReq->DHead[2]=0x13;
+	DataSendReq->DHead[3]=0x00;
+	DataSendReq->R_ID    =SwapDWord(TxBuffer.R_ID);
+	memcpy(Data, Source ,Slice);
+
+	if (isoSendBuffer(NULL, TxIsoSize)!=0)
+	{
+		SetError(errParSendingBlock);
+		FSendStatus.Broken=true;
+	}
+	else
+		FSendStatus.InFlight++;
+	FSendStatus.Elapsed=SysGetTick();
+}
+//------------------------------------------------------------------------------
+void TSnap7Partner::SendAck()
+{
+    PBSendReqParams ResParams;
+    int AckSize;
 
+    ResParams=PBSendReqParams(pbyte(PDUH_out)+sizeof(TS7ReqHeader)); // pdu 7 is symmetrical
+	if (isoRecvBuffer(NULL, AckSize)!=0)
+	{
+		SetError(errParSendingBlock);
+		FSendStatus.Broken=true;
+	}
+	else
+	{
+		FSendStatus.InFlight--;
+		FSendStatus.Seq_IN=ResParams->Seq;
+		if ((SwapWord(ResParams->Err)!=0) && (LastError==0))
+			LastError=errParSendRefused;
+		if (FSendStatus.First)
+		{
+			FSendStatus.First=false;
+			FSendStatus.MaxSlice+=2; // only in the first frame we have the extra info
+		}
+	}
+	FSendStatus.Elapsed=SysGetTick();
+}
+//------------------------------------------------------------------------------
+bool TSnap7Partner::SendAckDue()
+{
+    // The first slice is always acknowledged before going on, since its answer carries
+    // the sequence the peer expects. Then up to BSendWindow slices are kept in flight
+    // (BSendWindow=1 is the plain stop-and-wait of the S7 protocol).
+    // After a refusal the acks of the slices already sent are still read (and discarded),
+    // otherwise the next exchange would take one of them as its answer.
+    return !FSendStatus.Broken && (FSendStatus.InFlight>0) && (FSendStatus.First ||
+        (FSendStatus.TotalSize==0) || (FSendStatus.InFlight>=BSendWindow) || (LastError!=0));
+}
+//------------------------------------------------------------------------------
+bool TSnap7Partner::SendDone()
+{
+    return FSendStatus.Broken || ((FSendStatus.InFlight==0) &&
+        ((FSendStatus.TotalSize==0) || (LastError!=0)));
+}
+//------------------------------------------------------------------------------
+bool TSnap7Partner::SendEnd()
+{
+    uint64_t Elapsed;
+
+	Elapsed=SysGetTickNs()-FSendStart;
+	SendTime=longword(Elapsed/1000000);
+	SendTimeUs=longword(Elapsed/1000);
+	if (LastError==0)
+		BytesSent+=FSendStatus.SentSize;
+	FSendStatus.Busy=false;
 	return LastError==0;
 }
 //------------------------------------------------------------------------------
+void TSnap7Partner::SendComplete()
+{
+    // Cleared before signaling, so the next BSend can start as soon as the waiter wakes up
+    FSendPending=false;
+    SendEvt->Set();
+    if ((OnBSend!=NULL) && (!Destroying))
+        OnBSend(FSendUsrPtr, LastError);
+}
+//------------------------------------------------------------------------------
+bool TSnap7Partner::BlockSend()
+{
+    SendBegin();
+    while (!SendDone())
+    {
+        if (SendAckDue())
+            SendAck();
+        else
+            SendSlice();
+    }
+    return SendEnd();
+}
+//------------------------------------------------------------------------------
 bool TSnap7Partner::PickData()
 {
 	PBSendReqParams   ReqParams;
@@ -855,6 +1528,26 @@ bool TSnap7Partner::PickData()
 		FRecvStatus.In_R_ID=SwapDWord(DataSendReq->R_ID);
 		FRecvStatus.Offset=0;
 		Slice=SwapWord(DataSendReq->Len)-10;
+		if (FRing!=NULL)
+		{
+			RingCS->Enter();
+			for (FRecvSlot = 0; FRecvSlot < FRingCount; FRecvSlot++)
+				if (FRingSlots[FRecvSlot].State==rsFree)
+					break;
+			if (FRecvSlot<FRingCount)
+			{
+				FRingSlots[FRecvSlot].State=rsFilling;
+				FRingFree--;
+			}
+			else
+				FRecvSlot=-1;
+			RingCS->Leave();
+			if (FRecvSlot<0)
+			{
+				LastError=errParBusy;
+				return false;
+			}
+		}
 	}
 	else {
 		Slice=SwapWord(DataSendReq->Len)-8;
@@ -863,7 +1556,17 @@ bool TSnap7Partner::PickData()
 
 	FRecvStatus.Done=ReqParams->EoS==0x00;
 
-	Target=pbyte(&RxBuffer)+FRecvStatus.Offset;
+	if (FRecvSlot>=0)
+	{
+		if (FRecvStatus.Offset+Slice>uintptr_t(FRingBufSize))
+		{
+			LastError=errParBufferTooSmall;
+			return false;
+		}
+		Target=FRing+FRecvSlot*FRingBufSize+FRecvStatus.Offset;
+	}
+	else
+		Target=pbyte(&RxBuffer)+FRecvStatus.Offset;
 	memcpy(Target, Source, Slice);
 	FRecvStatus.Offset+=Slice;
 
@@ -899,6 +1602,7 @@ bool TSnap7Partner::PickData()
 bool TSnap7Partner::BlockRecv()
 {
 	bool Result;
+    uint64_t Elapsed;
     if (!FRecvPending) // Start sequence
     {
         FRecvPending=true;
@@ -906,11 +1610,13 @@ bool TSnap7Partner::BlockRecv()
         FRecvStatus.Done =false;
         FRecvStatus.Seq_Out =GetNextByte();
         FRecvStatus.Elapsed =SysGetTick();
+        FRecvStatus.Start   =SysGetTickNs();
         FRecvLast.Done=false;
         FRecvLast.Result=0;
         FRecvLast.R_ID=0;
         FRecvLast.Size=0;
         RecvTime =0;
+        RecvTimeUs =0;
         FRecvLast.Count++;
         if (FRecvLast.Count==0xFFFFFFFF)
           FRecvLast.Count=0;
@@ -925,14 +1631,21 @@ bool TSnap7Partner::BlockRecv()
         if (Result)
         {
             BytesRecv+=FRecvStatus.TotalLength;
-            RecvTime=SysGetTick()-FRecvStatus.Elapsed;
+            Elapsed=SysGetTickNs()-FRecvStatus.Start;
+            RecvTime=longword(Elapsed/1000000);
+            RecvTimeUs=longword(Elapsed/1000);
             FRecvLast.R_ID=FRecvStatus.In_R_ID;
             FRecvLast.Size=FRecvStatus.TotalLength;
         };
-        RecvEvt->Set();
-        if ((OnBRecv!=NULL) && !Destroying)
-            OnBRecv(FRecvUsrPtr, FRecvLast.Result, FRecvLast.R_ID, &RxBuffer, FRecvLast.Size);
-        FRecvLast.Done=true;
+        if (FRecvSlot>=0)
+            RingDeliver(Result);
+        else
+        {
+            RecvEvt->Set();
+            if ((OnBRecv!=NULL) && !Destroying)
+                OnBRecv(FRecvUsrPtr, FRecvLast.Result, FRecvLast.R_ID, &RxBuffer, FRecvLast.Size);
+            FRecvLast.Done=true;
+        }
         ClearRecv();
     };
     return Result;
@@ -975,6 +1688,11 @@ int TSnap7Partner::Status()
 }
 //------------------------------------------------------------------------------
 bool TSnap7Partner::Execute()
+{
+    return Work(WorkInterval);
+}
+//------------------------------------------------------------------------------
+bool TSnap7Partner::Work(int ReadTimeout)
 {
     TPDUKind PduKind;
     bool RTimeout;
@@ -983,25 +1701,31 @@ bool TSnap7Partner::Execute()
     // Checks if there is something to send (and we are not receiving...)
     if (FSendPending && !FRecvPending)
     {
-        Result=BlockSend();
-        SendEvt->Set();
-        if ((OnBSend!=NULL) && (!Destroying))
-            OnBSend(FSendUsrPtr, LastError);
-        FSendPending=false;
+        // A refused block leaves the connection in sync (all the acks were read),
+        // only a transport error drops it
+        Result=BlockSend() || (LastError==errParSendRefused);
+        SendComplete();
     }
 
 	if (Destroying)
 		return false;
 
+    // With a receive ring, a new block is not read until a buffer is free :
+    // the sender waits for our answer (back pressure)
+    if (Result && !FRecvPending && RingFull())
+    {
+        if (ReadTimeout>0)
+            RingFreeEvt->WaitFor(ReadTimeout);
+    }
     // Checks if there is something to recv
-    if (Result && CanRead(WorkInterval))
+    else if (Result && CanRead(ReadTimeout))
     {
         // Peeks info and returns PDU Kind
-        isoRecvPDU(&PDU);
+        isoRecvPDU(PDU);
         if (LastTcpError==0)
         {
             // First check valid data incoming (most likely situation)
-            IsoPeek(&PDU,PduKind);
+            IsoPeek(PDU,PduKind);
             if (PduKind==pkValidData)
             {
                 if (PDUH_in->PDUType==PduType_request)
@@ -1033,7 +1757,7 @@ bool TSnap7Partner::Execute()
             Disconnect();
 
     // Check BRecv sequence timeout
-    RTimeout= FRecvPending && (SysGetTick()-FRecvStatus.Elapsed>longword(BRecvTimeout));
+    RTimeout= FRecvPending && (SysGetTickNs()-FRecvStatus.Start>uint64_t(longword(BRecvTimeout))*1000000);
 
     if (RTimeout)
     {
@@ -1063,6 +1787,7 @@ int TSnap7Partner::BSend(longword R_ID, void *pUsrData, int Size)
 int TSnap7Partner::AsBSend(longword R_ID, void *pUsrData, int Size)
 {
     SendTime=0;
+    SendTimeUs=0;
     if (Linked)
     {
       if (!FSendPending)
@@ -1072,7 +1797,9 @@ int TSnap7Partner::AsBSend(longword R_ID, void *pUsrData, int Size)
           TxBuffer.Size=Size;
           SendEvt->Reset();
           FSendPending=true;
-          FSendElapsed=SysGetTick();
+          FSendStart=SysGetTickNs();
+          if (FLoop!=NULL)
+              FLoop->Wake();
           return 0;
       }
       else
@@ -1124,6 +1851,21 @@ int TSnap7Partner::SetSendCallback(pfn_ParBSendCompletion pCompletion, void *usr
 int TSnap7Partner::BRecv(longword &R_ID, void *pData, int &Size, longword Timeout)
 {
      int Result=0;
+     void *pRing;
+     // With a receive ring BRecv is a RecvFromRing plus a copy
+     if (FRing!=NULL)
+     {
+         Result=RecvFromRing(R_ID, pRing, Size, Timeout);
+         if (Result==0)
+         {
+             if (pData!=NULL)
+                 memcpy(pData, pRing, Size);
+             else
+                 Result=errParInvalidParams;
+             ReleaseRingBuffer(pRing);
+         }
+         return Result;
+     }
      if (RecvEvt->WaitFor(Timeout)==WAIT_OBJECT_0)
      {
          R_ID =FRecvLast.R_ID;
@@ -1155,6 +1897,20 @@ bool TSnap7Partner::CheckAsBRecvCompletion(int &opResult, longword &R_ID,
 		return true;
 	}
 	
+	void *pRing;
+	if (FRing!=NULL)
+	{
+		bool Result=RecvFromRing(R_ID, pRing, Size, 0)==0;
+		if (Result)
+		{
+			opResult=0;
+			if ((pData!=NULL) && (Size>0))
+				memcpy(pData, pRing, Size);
+			ReleaseRingBuffer(pRing);
+		}
+		return Result;
+	}
+
 	bool Result=FRecvLast.Done;
     if (Result)
     {
@@ -1175,4 +1931,153 @@ int TSnap7Partner::SetRecvCallback(pfn_ParBRecvCallBack pCompletion, void *usrPt
     return 0;
 }
 //------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+bool TSnap7Partner::RingFull()
+{
+    bool Result;
+    if (FRing==NULL)
+        return false;
+    RingCS->Enter();
+    Result=FRingFree==0;
+    if (Result)
+        RingFreeEvt->Reset(); // Set again by the next release
+    RingCS->Leave();
+    return Result;
+}
+//------------------------------------------------------------------------------
+bool TSnap7Partner::RingRelease(int Slot, int Expected)
+{
+    PPartnerLoop Loop;
+    bool Result;
+    // Checked and changed together : a stale release must not free a slot
+    // that the worker is filling again
+    RingCS->Enter();
+    Result=FRingSlots[Slot].State==Expected;
+    if (Result)
+    {
+        FRingSlots[Slot].State=rsFree;
+        FRingFree++;
+        RingFreeEvt->Set();
+    }
+    RingCS->Leave();
+    // An event loop doesn't watch the socket while the ring is full
+    Loop=FLoop;
+    if (Result && (Loop!=NULL))
+        Loop->Wake();
+    return Result;
+}
+//------------------------------------------------------------------------------
+void TSnap7Partner::RingDeliver(bool Success)
+{
+    int Slot=FRecvSlot;
+    pbyte Data=FRing+Slot*FRingBufSize;
+    bool Held;
+
+    if (!Success)
+    {
+        if ((OnBRecv!=NULL) && !Destroying)
+            OnBRecv(FRecvUsrPtr, FRecvLast.Result, 0, NULL, 0);
+        return; // ClearRecv() releases the buffer
+    }
+    // From here the buffer belongs to the application : to the callback if any,
+    // otherwise it's queued for RecvFromRing()
+    Held=(OnBRecv!=NULL) && !Destroying;
+    RingCS->Enter();
+    FRingSlots[Slot].R_ID=FRecvLast.R_ID;
+    FRingSlots[Slot].Size=FRecvLast.Size;
+    FRingSlots[Slot].Seq=FRingSeq++;
+    if (Held)
+        FRingSlots[Slot].State=rsHeld;
+    else
+    {
+        FRingSlots[Slot].State=rsReady;
+        RingReadyEvt->Set();
+    }
+    RingCS->Leave();
+    FRecvSlot=-1;
+    if (Held)
+        OnBRecv(FRecvUsrPtr, 0, FRecvLast.R_ID, Data, FRecvLast.Size);
+}
+//------------------------------------------------------------------------------
+int TSnap7Partner::SetRecvRing(void *pBuffers, int BufferSize, int Count)
+{
+    int Result=0;
+    if ((pBuffers!=NULL) && ((BufferSize<=0) || (Count<=0) || (Count>MaxRingBuffers)))
+        return errParInvalidParams;
+
+    RingCS->Enter();
+    // Can be changed only when the application holds no buffer
+    if ((FRing!=NULL) && (FRingFree<FRingCount))
+        Result=errParBusy;
+    else
+    {
+        memset(FRingSlots,0,sizeof(FRingSlots));
+        FRing=pbyte(pBuffers);
+        FRingBufSize=BufferSize;
+        FRingCount=pBuffers!=NULL ? Count : 0;
+        FRingFree=FRingCount;
+        RingReadyEvt->Reset();
+        RingFreeEvt->Set();
+    }
+    RingCS->Leave();
+    return Result;
+}
+//------------------------------------------------------------------------------
+int TSnap7Partner::RecvFromRing(longword &R_ID, void *&pData, int &Size, longword Timeout)
+{
+    int c, Slot;
+
+    // LastError is left alone, it belongs to the worker
+    pData=NULL;
+    Size=0;
+    if (FRing==NULL)
+        return errParInvalidParams;
+    if (RingReadyEvt->WaitFor(Timeout)!=WAIT_OBJECT_0)
+        return errParRecvTimeout;
+    if (Destroying)
+        return errParDestroying;
+
+    // Oldest ready buffer
+    RingCS->Enter();
+    Slot=-1;
+    for (c = 0; c < FRingCount; c++)
+    {
+        if ((FRingSlots[c].State==rsReady) && ((Slot<0) || (int32_t(FRingSlots[c].Seq-FRingSlots[Slot].Seq)<0)))
+            Slot=c;
+    }
+    if (Slot>=0)
+    {
+        FRingSlots[Slot].State=rsHeld;
+        R_ID=FRingSlots[Slot].R_ID;
+        Size=FRingSlots[Slot].Size;
+        pData=FRing+Slot*FRingBufSize;
+    }
+    // Reset when the last one was taken
+    for (c = 0; c < FRingCount; c++)
+        if (FRingSlots[c].State==rsReady)
+            break;
+    if (c==FRingCount)
+        RingReadyEvt->Reset();
+    RingCS->Leave();
+
+    if (Slot<0) // taken by another thread
+        return errParRecvTimeout;
+    return 0;
+}
+//------------------------------------------------------------------------------
+int TSnap7Partner::ReleaseRingBuffer(void *pData)
+{
+    intptr_t Offset;
+    int Slot;
 
+    if (FRing==NULL)
+        return errParInvalidParams;
+    Offset=pbyte(pData)-FRing;
+    if ((Offset<0) || (Offset % FRingBufSize!=0) || (Offset/FRingBufSize>=FRingCount))
+        return errParInvalidParams;
+    Slot=int(Offset/FRingBufSize);
+    if (!RingRelease(Slot, rsHeld))
+        return errParInvalidParams;
+    return 0;
+}
+//------------------------------------------------------------------------------
@@ -27,13 +27,14 @@
 #define s7_partner_h
 //---------------------------------------------------------------------------
 #include "snap_threads.h"
+#include "snap_poller.h"
 #include "s7_peer.h"
 //---------------------------------------------------------------------------
-using namespace std;
-//---------------------------------------------------------------------------
 
 #define MaxPartners 256
 #define MaxAdapters 256
+#define MaxPartnerLoops 64
+#define LoopMaxWait 1000 // Longest event loop wait when no timer is due (ms)
 #define csTimeout   1500 // Connection server destruction timeout
 
 const int par_stopped         = 0;   // stopped
@@ -73,6 +74,9 @@ typedef TSnap7Partner *PSnap7Partner;
 class TConnectionServer;
 typedef TConnectionServer *PConnectionServer;
 
+class TPartnerLoop;
+typedef TPartnerLoop *PPartnerLoop;
+
 //------------------------------------------------------------------------------
 // CONNECTION SERVERS MANAGER
 //------------------------------------------------------------------------------
@@ -111,6 +115,7 @@ public:
         FServer=Server;
         FListener=Listener;
         FreeOnTerminate=false;
+        Role=thrPartner;
     };
 	void Execute();
 };
@@ -172,10 +177,77 @@ public:
         FPartner = Partner;
         FRecoveryTime =RecoveryTime;
         FreeOnTerminate =false;
+        Role =thrPartner;
     };
     ~TPartnerThread(){};
 };
 typedef TPartnerThread *PPartnerThread;
+
+//------------------------------------------------------------------------------
+// PARTNER EVENT LOOP
+//------------------------------------------------------------------------------
+// Serves many partners with a single thread instead of one TPartnerThread each.
+// Their sockets are multiplexed with a TSnapPoller, a pending BSend wakes the
+// loop, reconnection and keep alive are timers instead of sleeps.
+// Nothing waits for the network inside the loop : the connection goes on phase
+// by phase as the socket gets ready, a BSend sends the slices allowed by the
+// window and the next ones when the acks arrive, and the keep alive is a TCP
+// connect probe to the peer (reachable if it accepts or refuses).
+// Every partner has two poller tags : its slot for the connection and
+// slot+MaxPartners for the probe.
+class TPartnerLoop : public TSnapThread
+{
+private:
+    PSnapPoller Poller;
+    PSnapCriticalSection cs;
+    PSnap7Partner Partners[MaxPartners];
+    socket_t Polled[MaxPartners*2];
+    bool PolledOut[MaxPartners*2]; // watched for writable
+    void Lock();
+    void Unlock();
+    void Reconcile(longword Now);
+    int NextTimeout(longword Now);
+    void Service(PSnap7Partner Partner, bool Ready, bool ProbeReady, longword Now);
+    void ConnectStep(PSnap7Partner Partner, bool Ready, longword Now);
+    bool SendStep(PSnap7Partner Partner, bool Ready, longword Now);
+    void ProbeStart(PSnap7Partner Partner, longword Now);
+    void ProbeStep(PSnap7Partner Partner, bool Ready, longword Now);
+    void ProbeStop(PSnap7Partner Partner);
+    void Unwatch(int Tag);
+protected:
+    void Execute();
+public:
+    int PartnersCount;
+    TPartnerLoop();
+    ~TPartnerLoop();
+    bool Valid();
+    int Attach(PSnap7Partner Partner);
+    void Detach(PSnap7Partner Partner);
+    void Wake();
+    friend class TSnap7Partner;
+};
+
+//------------------------------------------------------------------------------
+// EVENT LOOPS MANAGER
+//------------------------------------------------------------------------------
+class TPartnerLoops
+{
+private:
+    PPartnerLoop Loops[MaxPartnerLoops];
+    PSnapCriticalSection cs;
+    void Clear();
+public:
+    int LoopsCount;
+    TPartnerLoops();
+    ~TPartnerLoops();
+    // Count=0 means one thread per partner (the default)
+    int SetCount(int Count);
+    // Attaches the partner to the least loaded loop
+    int Attach(PSnap7Partner Partner);
+};
+typedef TPartnerLoops *PPartnerLoops;
+
+int PartnerLoops_SetCount(int Count);
 //------------------------------------------------------------------------------
 // S7 PARTNER
 //------------------------------------------------------------------------------
@@ -186,10 +258,25 @@ typedef struct{
     uintptr_t Offset;
     longword  TotalLength;
     longword  In_R_ID;
-    longword  Elapsed;
+    longword  Elapsed;   // ms tick, for the loop timers
+    uint64_t  Start;     // SysGetTickNs() at the start of the receive
     byte      Seq_Out;
 }TRecvStatus;
 
+// Block send in progress, BlockSend() runs it in steps (so does the event loop)
+typedef struct{
+    bool      First;     // the next slice is the first one, or its ack is awaited
+    bool      Broken;    // transport error, the block is over
+    bool      Busy;      // sent by the event loop
+    int       TotalSize; // still to send
+    int       SentSize;  // whole block
+    int       MaxSlice;
+    int       InFlight;  // slices not acknowledged yet
+    uintptr_t Offset;
+    longword  Elapsed;   // ms tick of the last slice or ack, for the loop timers
+    byte      Seq_IN;
+}TSendStatus;
+
 typedef struct{
     bool     Done;
     int      Size;
@@ -198,6 +285,23 @@ typedef struct{
     longword Count;
 }TRecvLast;
 
+// Receive ring : buffers provided by the application, the partner reassembles
+// the incoming blocks directly into them and the application gives each one
+// back with ReleaseRingBuffer() once consumed.
+const int MaxRingBuffers = 256;
+
+const int rsFree    = 0; // available for the next block
+const int rsFilling = 1; // a block is being reassembled into it
+const int rsReady   = 2; // complete, waiting for RecvFromRing()
+const int rsHeld    = 3; // owned by the application until released
+
+typedef struct{
+    int      State;
+    int      Size;
+    longword R_ID;
+    longword Seq;  // delivery order
+}TRingSlot;
+
 extern "C" {
 typedef void (S7API *pfn_ParBRecvCallBack)(void * usrPtr, int opResult, longword R_ID, void *pdata, int Size);
 typedef void (S7API *pfn_ParBSendCompletion)(void * usrPtr, int opResult);
@@ -216,27 +320,59 @@ private:
     bool FSendPending;
     bool FRecvPending;
     TRecvStatus FRecvStatus;
+    TSendStatus FSendStatus;
     TRecvLast FRecvLast;
     TPendingBuffer TxBuffer;
     TPendingBuffer RxBuffer;
-    longword FSendElapsed;
+    uint64_t FSendStart; // SysGetTickNs() at the start of the send
     bool BindError;
     byte NextByte;
+    pbyte FRing;
+    int FRingBufSize;
+    int FRingCount;
+    int FRingFree;
+    longword FRingSeq;
+    int FRecvSlot; // ring buffer of the block being received (-1 : RxBuffer)
+    TRingSlot FRingSlots[MaxRingBuffers];
+    PSnapCriticalSection RingCS;
+    PSnapEvent RingFreeEvt;
+    PSnapEvent RingReadyEvt;
+    PPartnerLoop FLoop;
+    int FLoopSlot;
+    longword FLoopHold;   // not served by the loop before this tick (recovery)
+    longword FKaElapsed;  // keep alive timer when served by the loop
+    int FLoopPhase;       // connection phase when connected by the loop
+    longword FPhaseStart; // tick of the start of the phase
+    PMsgSocket FProbe;    // keep alive probe of the loop (created on first use)
+    bool FProbing;
+    longword FProbeStart;
     pfn_ParBRecvCallBack OnBRecv;
     pfn_ParBSendCompletion OnBSend;
     void ClearRecv();
     byte GetNextByte();
     void CloseWorker();
     bool BlockSend();
+    void SendBegin();
+    void SendSlice();
+    void SendAck();
+    bool SendAckDue();
+    bool SendDone();
+    bool SendEnd();
+    void SendComplete();
     bool PickData();
     bool BlockRecv();
     bool ConnectionConfirm();
+    bool Work(int ReadTimeout);
+    bool RingFull();
+    bool RingRelease(int Slot, int Expected);
+    void RingDeliver(bool Success);
 protected:
     bool Stopping;
     bool Execute();
     void Disconnect();
     bool ConnectToPeer();
     bool PerformFunctionNegotiate();
+    int SetIsoPayloadSize(int Size);
 public:
     bool Active;
     bool Running;
@@ -244,8 +380,11 @@ public:
     longword SrcAddress;
     int BRecvTimeout;
     int BSendTimeout;
+    int BSendWindow;
     longword SendTime;
     longword RecvTime;
+    longword SendTimeUs;
+    longword RecvTimeUs;
     longword RecoveryTime;
     longword KeepAliveTime;
     longword BytesSent;
@@ -275,9 +414,15 @@ public:
     bool CheckAsBRecvCompletion(int &opResult, longword &R_ID,
         void *pData, int &Size);
     int SetRecvCallback(pfn_ParBRecvCallBack pCompletion, void *usrPtr);
+    // Receive ring (Count buffers of BufferSize bytes, contiguous), NULL to remove it
+    int SetRecvRing(void *pBuffers, int BufferSize, int Count);
+    int RecvFromRing(longword &R_ID, void *&pData, int &Size, longword Timeout);
+    int ReleaseRingBuffer(void *pData);
 
     friend class TConnectionServer;
     friend class TPartnerThread;
+    friend class TPartnerLoop;
+    friend class TPartnerLoops;
 };
 
 
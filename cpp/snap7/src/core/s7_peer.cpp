@@ -28,10 +28,12 @@
 
 TSnap7Peer::TSnap7Peer()
 {
-    PDUH_out=PS7ReqHeader(&PDU.Payload);
+    PDUH_out=PS7ReqHeader(&PDU->Payload);
     PDURequest=480; // Our request, FPDULength will contain the CPU answer
     LastError=0;
 	cntword = 0;
+    IsoConnectTime = 0;
+    NegotiateTime = 0;
     Destroying = false;
 }
 //---------------------------------------------------------------------------
@@ -40,6 +42,13 @@ TSnap7Peer::~TSnap7Peer()
     Destroying = true;
 }
 //---------------------------------------------------------------------------
+int TSnap7Peer::SetIsoPayloadSize(int Size)
+{
+    int Result = TIsoTcpSocket::SetIsoPayloadSize(Size);
+    PDUH_out=PS7ReqHeader(&PDU->Payload);
+    return Result;
+}
+//---------------------------------------------------------------------------
 int TSnap7Peer::SetError(int Error)
 {
     if (Error==0)
@@ -63,12 +72,10 @@ word TSnap7Peer::GetNextWord()
      return cntword++;
 }
 //---------------------------------------------------------------------------
-int TSnap7Peer::NegotiatePDULength( )
+int TSnap7Peer::NegotiateRequest()
 {
-    int Result, IsoSize = 0;
+    int IsoSize = 0;
     PReqFunNegotiateParams ReqNegotiate;
-    PResFunNegotiateParams ResNegotiate;
-    PS7ResHeader23 Answer;
     ClrError();
     // Setup Pointers
     ReqNegotiate = PReqFunNegotiateParams(pbyte(PDUH_out) + sizeof(TS7ReqHeader));
@@ -86,20 +93,47 @@ int TSnap7Peer::NegotiatePDULength( )
     ReqNegotiate->ParallelJobs_2 = 0x0100;
     ReqNegotiate->PDULength = SwapWord(PDURequest);
     IsoSize = sizeof( TS7ReqHeader ) + sizeof( TReqFunNegotiateParams );
-    Result = isoExchangeBuffer(NULL, IsoSize);
+    return isoSendBuffer(NULL, IsoSize);
+}
+//---------------------------------------------------------------------------
+int TSnap7Peer::NegotiateConfirm()
+{
+    int Result, IsoSize = 0;
+    PResFunNegotiateParams ResNegotiate;
+    PS7ResHeader23 Answer;
+    Result = isoRecvBuffer(NULL, IsoSize);
     if ((Result == 0) && (IsoSize == int(sizeof(TS7ResHeader23) + sizeof(TResFunNegotiateParams))))
     {
         // Setup pointers
-        Answer = PS7ResHeader23(&PDU.Payload);
+        Answer = PS7ResHeader23(&PDU->Payload);
         ResNegotiate = PResFunNegotiateParams(pbyte(Answer) + sizeof(TS7ResHeader23));
         if ( Answer->Error != 0 )
 	    Result = SetError(errNegotiatingPDU);
         if ( Result == 0 )
+        {
 	    PDULength = SwapWord(ResNegotiate->PDULength);
+            // The CPU shouldn't grant more than requested, the buffer can't hold more anyway
+            if (PDULength > IsoPayloadSize)
+                PDULength = IsoPayloadSize;
+            // From now on the buffer only needs to hold the PDU granted
+            if (PDULength > IsoPayload_Min)
+                SetIsoPayloadSize(PDULength);
+            else
+                SetIsoPayloadSize(IsoPayload_Min);
+        }
     }
     return Result;
 }
 //---------------------------------------------------------------------------
+int TSnap7Peer::NegotiatePDULength( )
+{
+    int Result;
+    Result = NegotiateRequest();
+    if (Result == 0)
+        Result = NegotiateConfirm();
+    return Result;
+}
+//---------------------------------------------------------------------------
 void TSnap7Peer::PeerDisconnect( )
 {
     ClrError();
@@ -110,13 +144,82 @@ int TSnap7Peer::PeerConnect( )
 {
     int Result;
 
+    uint64_t Start;
+
     ClrError();
+    IsoConnectTime = 0;
+    NegotiateTime = 0;
+    SetIsoPayloadSize(PDURequest); // room for the largest PDU we may be granted
+    Start = SysGetTickUs();
 	Result = isoConnect();
+    IsoConnectTime = longword(SysGetTickUs() - Start) - TcpConnectTime;
 	if (Result == 0)
 	{
+		Start = SysGetTickUs();
 		Result = NegotiatePDULength();
+		NegotiateTime = longword(SysGetTickUs() - Start);
 		if (Result != 0)
 			PeerDisconnect();
 	}
     return Result;
 }
+//---------------------------------------------------------------------------
+#ifdef NON_BLOCKING_CONNECT
+int TSnap7Peer::PeerConnectStart()
+{
+    ClrError();
+    TcpConnectTime = 0;
+    IsoConnectTime = 0;
+    NegotiateTime = 0;
+    SetIsoPayloadSize(PDURequest); // room for the largest PDU we may be granted
+    return isoConnectStart();
+}
+//---------------------------------------------------------------------------
+int TSnap7Peer::PeerConnectRequest()
+{
+    return isoConnectRequest();
+}
+//---------------------------------------------------------------------------
+int TSnap7Peer::PeerConnectConfirm()
+{
+    int Result;
+
+    Result = isoConnectConfirm();
+    if (Result == 0)
+    {
+        Result = NegotiateRequest();
+        if (Result != 0)
+            PeerDisconnect();
+    }
+    return Result;
+}
+//---------------------------------------------------------------------------
+int TSnap7Peer::PeerNegotiateConfirm()
+{
+    int Result;
+
+    Result = NegotiateConfirm();
+    if (Result != 0)
+        PeerDisconnect();
+    return Result;
+}
+//---------------------------------------------------------------------------
+int TSnap7Peer::PeerConnectTimeout()
+{
+    bool TcpConnected = Connected;
+
+    PeerDisconnect();
+    if (TcpConnected)
+    {
+        // No answer to the CR or to the negotiation
+        LastTcpError = WSAETIMEDOUT;
+        return SetIsoError(errIsoRecvPacket);
+    }
+    else
+    {
+        // Same as SckConnect() when PingTimeout expires
+        LastTcpError = WSAEHOSTUNREACH;
+        return LastTcpError;
+    }
+}
+#endif
@@ -44,15 +44,31 @@ protected:
     word GetNextWord();
     int SetError(int Error);
     int NegotiatePDULength();
+    // Steps of NegotiatePDULength()
+    int NegotiateRequest();
+    int NegotiateConfirm();
     void ClrError();
+    int SetIsoPayloadSize(int Size);
 public:
     int LastError;
     int PDULength;
-    int PDURequest;
+    int PDURequest;  // The PDU buffer fits it while negotiating, then the PDU negotiated
+    // Phases of the last PeerConnect() (us), the TCP connect is in TcpConnectTime
+    longword IsoConnectTime;  // Connection request/confirm
+    longword NegotiateTime;   // PDU length negotiation
     TSnap7Peer();
     ~TSnap7Peer();
     void PeerDisconnect();
     int PeerConnect();
+#ifdef NON_BLOCKING_CONNECT
+    // PeerConnect() in steps, each one called when the socket is ready (see s7_connector).
+    // The phase times are left to the caller. A failed step disconnects.
+    int PeerConnectStart();     // Starts the TCP connect, wait for writable
+    int PeerConnectRequest();   // Completes the TCP connect and sends the CR, wait for readable
+    int PeerConnectConfirm();   // Receives the CC and requests the PDU length, wait for readable
+    int PeerNegotiateConfirm(); // Receives the negotiated PDU length
+    int PeerConnectTimeout();   // Gives up the current step
+#endif
 };
 //---------------------------------------------------------------------------
 #endif
@@ -0,0 +1,291 @@
+/*=============================================================================|
+|  PROJECT SNAP7                                                         1.3.0 |
+|==============================================================================|
+|  Copyright (C) 2013, 2015 Davide Nardella                                    |
+|  All rights reserved.                                                        |
+|==============================================================================|
+|  SNAP7 is free software: you can redistribute it and/or modify               |
+|  it under the terms of the Lesser GNU General Public License as published by |
+|  the Free Software Foundation, either version 3 of the License, or           |
+|  (at your option) any later version.                                         |
+|                                                                              |
+|  It means that you can distribute your commercial software linked with       |
+|  SNAP7 without the requirement to distribute the source code of your         |
+|  application and without the requirement that your application be itself     |
+|  distributed under LGPL.                                                     |
+|                                                                              |
+|  SNAP7 is distributed in the hope that it will be useful,                    |
+|  but WITHOUT ANY WARRANTY; without even the implied warranty of              |
+|  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the               |
+|  Lesser GNU General Public License for more details.                         |
+|                                                                              |
+|  You should have received a copy of the GNU General Public License and a     |
+|  copy of Lesser GNU General Public License along with Snap7.                 |
+|  If not, see  http://www.gnu.org/licenses/                                   |
+|=============================================================================*/
+#include "s7_proxy.h"
+#include <math.h>
+
+//---------------------------------------------------------------------------
+// QUEUE
+//---------------------------------------------------------------------------
+TProxyQueue::TProxyQueue()
+{
+    FChunks=new TProxyChunk[ProxyQueueSize];
+    FFirst=0;
+    FCount=0;
+    LastDue=0;
+    LinkFree=0;
+}
+//---------------------------------------------------------------------------
+TProxyQueue::~TProxyQueue()
+{
+    delete[] FChunks;
+}
+//---------------------------------------------------------------------------
+PProxyChunk TProxyQueue::Push()
+{
+    PProxyChunk Chunk = &FChunks[(FFirst + FCount) % ProxyQueueSize];
+    FCount++;
+    return Chunk;
+}
+//---------------------------------------------------------------------------
+void TProxyQueue::Pop()
+{
+    FFirst=(FFirst + 1) % ProxyQueueSize;
+    FCount--;
+}
+//---------------------------------------------------------------------------
+// PROXY WORKER
+//---------------------------------------------------------------------------
+TProxyWorker::TProxyWorker(TSnap7Proxy *Server, longword Seed)
+{
+    FServer=Server;
+    FTarget=new TProxyTarget();
+    strncpy(FTarget->RemoteAddress, Server->TargetAddress, 16);
+    FTarget->RemotePort=Server->TargetPort;
+    FRandom=Seed!=0 ? Seed : 1;
+}
+//---------------------------------------------------------------------------
+TProxyWorker::~TProxyWorker()
+{
+    FTarget->SckDisconnect();
+    delete FTarget;
+}
+//---------------------------------------------------------------------------
+double TProxyWorker::Random()
+{
+    // xorshift32 : fast and good enough to draw delays, in (0, 1]
+    FRandom^=FRandom << 13;
+    FRandom^=FRandom >> 17;
+    FRandom^=FRandom << 5;
+    return (double(FRandom) + 1.0) / 4294967296.0;
+}
+//---------------------------------------------------------------------------
+int64_t TProxyWorker::Jitter(PProxyImpairment Imp)
+{
+    double Value;
+    if (Imp->Jitter==0)
+        return 0;
+    switch (Imp->JitterKind)
+    {
+        case prxJitterNormal:
+            // Box-Muller
+            Value=sqrt(-2.0 * log(Random())) * cos(2.0 * 3.14159265358979 * Random()) * Imp->Jitter;
+            break;
+        case prxJitterPareto:
+            Value=Imp->Jitter * (1.0 / sqrt(Random()) - 1.0);
+            break;
+        default:
+            Value=(Random() * 2.0 - 1.0) * Imp->Jitter;
+    }
+    return int64_t(Value);
+}
+//---------------------------------------------------------------------------
+bool TProxyWorker::Forward(int Direction, TMsgSocket *From)
+{
+    PProxyImpairment Imp = &FServer->Impairment[Direction];
+    TProxyQueue *Queue = &FQueue[Direction];
+    PProxyChunk Chunk;
+    int Size, MaxSize, Offset, Segment;
+    bool Stalled = false;
+    int64_t Due;
+
+    // Receive no more than the free chunks can hold once split
+    MaxSize=ProxyChunkSize;
+    if (Imp->SegmentSize>0 && Queue->Free() * Imp->SegmentSize<MaxSize)
+        MaxSize=Queue->Free() * Imp->SegmentSize;
+    From->Receive(FBuffer, MaxSize, Size);
+    if (From->LastTcpError!=0)
+        return false;
+
+    Due=int64_t(SysGetTickUs()) + int64_t(Imp->Delay) + Jitter(Imp);
+    if (Due<int64_t(SysGetTickUs()))
+        Due=int64_t(SysGetTickUs());
+    if (Imp->StallPermille>0 && Random() * 1000.0 < Imp->StallPermille)
+    {
+        Due+=Imp->StallTime;
+        Stalled=true;
+    }
+
+    Offset=0;
+    while (Offset<Size)
+    {
+        Segment=Size - Offset;
+        if (Imp->SegmentSize>0 && Segment>Imp->SegmentSize)
+            Segment=Imp->SegmentSize;
+        // TCP keeps the order
+        if (Due<Queue->LastDue)
+            Due=Queue->LastDue;
+        if (Imp->Bandwidth>0)
+        {
+            if (Due<Queue->LinkFree)
+                Due=Queue->LinkFree;
+            Due+=int64_t(Segment) * 1000000 / Imp->Bandwidth;
+            Queue->LinkFree=Due;
+        }
+        Chunk=Queue->Push();
+        Chunk->Due=Due;
+        Chunk->Size=Segment;
+        memcpy(Chunk->Data, FBuffer + Offset, Segment);
+        Queue->LastDue=Due;
+        Offset+=Segment;
+        Due+=Imp->SegmentGap;
+    }
+
+    FServer->CSStats->Enter();
+    FServer->Chunks++;
+    if (Stalled)
+        FServer->Stalls++;
+    FServer->CSStats->Leave();
+    return true;
+}
+//---------------------------------------------------------------------------
+bool TProxyWorker::Flush(int Direction, TMsgSocket *To, int64_t Now)
+{
+    TProxyQueue *Queue = &FQueue[Direction];
+    PProxyChunk Chunk;
+    while (!Queue->Empty() && Queue->Head()->Due<=Now)
+    {
+        Chunk=Queue->Head();
+        if (To->SendPacket(Chunk->Data, Chunk->Size)!=0)
+            return false;
+        Queue->Pop();
+    }
+    return true;
+}
+//---------------------------------------------------------------------------
+bool TProxyWorker::Execute()
+{
+    fd_set Readable;
+    struct timeval Timeout;
+    int64_t Now, Wait;
+    socket_t Max;
+    int c;
+
+    // The target is connected with the first call, a failure closes the client
+    if (!FTarget->Connected && FTarget->SckConnect()!=0)
+        return false;
+
+    // Wait for data, but not longer than until the next chunk is due
+    Now=int64_t(SysGetTickUs());
+    Wait=int64_t(WorkInterval) * 1000;
+    for (c = prxToServer; c <= prxToClient; c++)
+        if (!FQueue[c].Empty() && FQueue[c].Head()->Due - Now<Wait)
+            Wait=FQueue[c].Head()->Due - Now;
+    if (Wait<0)
+        Wait=0;
+
+    FD_ZERO(&Readable);
+    Max=0;
+    if (!FQueue[prxToServer].Full())
+    {
+        FD_SET(FSocket, &Readable);
+        Max=FSocket;
+    }
+    if (!FQueue[prxToClient].Full())
+    {
+        FD_SET(FTarget->Handle(), &Readable);
+        if (FTarget->Handle()>Max)
+            Max=FTarget->Handle();
+    }
+    Timeout.tv_sec=long(Wait / 1000000);
+    Timeout.tv_usec=long(Wait % 1000000);
+    if (select(int(Max) + 1, &Readable, NULL, NULL, &Timeout)>0)
+    {
+        if (FD_ISSET(FSocket, &Readable) && !Forward(prxToServer, this))
+            return false;
+        if (FD_ISSET(FTarget->Handle(), &Readable) && !Forward(prxToClient, FTarget))
+            return false;
+    }
+
+    Now=int64_t(SysGetTickUs());
+    return Flush(prxToServer, FTarget, Now) && Flush(prxToClient, this, Now);
+}
+//---------------------------------------------------------------------------
+// PROXY SERVER
+//---------------------------------------------------------------------------
+TSnap7Proxy::TSnap7Proxy()
+{
+    CSStats=new TSnapCriticalSection();
+    memset(Impairment, 0, sizeof(Impairment));
+    memset(TargetAddress, 0, sizeof(TargetAddress));
+    TargetPort=isoTcpPort;
+    Seed=1;
+    FConnections=0;
+    Chunks=0;
+    Stalls=0;
+}
+//---------------------------------------------------------------------------
+TSnap7Proxy::~TSnap7Proxy()
+{
+    Stop();
+    delete CSStats;
+}
+//---------------------------------------------------------------------------
+int TSnap7Proxy::SetImpairment(int Direction, PProxyImpairment Imp)
+{
+    if (Direction<prxToServer || Direction>prxToClient || Imp==NULL)
+        return errSrvInvalidParams;
+    if (Imp->JitterKind<prxJitterUniform || Imp->JitterKind>prxJitterPareto || Imp->SegmentSize<0 ||
+        Imp->StallPermille<0 || Imp->StallPermille>1000)
+        return errSrvInvalidParams;
+    if (Status==SrvRunning)
+        return errSrvCannotChangeParam;
+    Impairment[Direction]=*Imp;
+    return 0;
+}
+//---------------------------------------------------------------------------
+int TSnap7Proxy::StartTo(const char *Address, word Port, const char *Target, word TargetPort)
+{
+    if (Target==NULL)
+        return errSrvInvalidParams;
+    strncpy(TargetAddress, Target, 15);
+    this->TargetPort=TargetPort;
+    CSStats->Enter();
+    FConnections=0;
+    Chunks=0;
+    Stalls=0;
+    CSStats->Leave();
+    return TCustomMsgServer::StartTo(Address, Port);
+}
+//---------------------------------------------------------------------------
+void TSnap7Proxy::GetStats(longword &ChunksCount, longword &StallsCount)
+{
+    CSStats->Enter();
+    ChunksCount=Chunks;
+    StallsCount=Stalls;
+    CSStats->Leave();
+}
+//---------------------------------------------------------------------------
+PWorkerSocket TSnap7Proxy::CreateWorkerSocket(socket_t Sock)
+{
+    PWorkerSocket Result;
+    longword Connection;
+    CSStats->Enter();
+    Connection=FConnections++;
+    CSStats->Leave();
+    Result = new TProxyWorker(this, Seed + Connection);
+    Result->SetSocket(Sock);
+    return Result;
+}
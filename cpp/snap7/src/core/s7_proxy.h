@@ -0,0 +1,156 @@
+/*=============================================================================|
+|  PROJECT SNAP7                                                         1.3.0 |
+|==============================================================================|
+|  Copyright (C) 2013, 2015 Davide Nardella                                    |
+|  All rights reserved.                                                        |
+|==============================================================================|
+|  SNAP7 is free software: you can redistribute it and/or modify               |
+|  it under the terms of the Lesser GNU General Public License as published by |
+|  the Free Software Foundation, either version 3 of the License, or           |
+|  (at your option) any later version.                                         |
+|                                                                              |
+|  It means that you can distribute your commercial software linked with       |
+|  SNAP7 without the requirement to distribute the source code of your         |
+|  application and without the requirement that your application be itself     |
+|  distributed under LGPL.                                                     |
+|                                                                              |
+|  SNAP7 is distributed in the hope that it will be useful,                    |
+|  but WITHOUT ANY WARRANTY; without even the implied warranty of              |
+|  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the               |
+|  Lesser GNU General Public License for more details.                         |
+|                                                                              |
+|  You should have received a copy of the GNU General Public License and a     |
+|  copy of Lesser GNU General Public License along with Snap7.                 |
+|  If not, see  http://www.gnu.org/licenses/                                   |
+|=============================================================================*/
+#ifndef s7_proxy_h
+#define s7_proxy_h
+//---------------------------------------------------------------------------
+#include "s7_server.h"
+//---------------------------------------------------------------------------
+// IMPAIRMENT PROXY
+//
+// Forwards every accepted connection to a target (PLC, server or replay) and
+// impairs the traffic the way a WAN or a congested switch would, so clients
+// can be measured under reproducible network conditions on one machine.
+//
+// The bytes are forwarded in chunks (what one recv() returned, split into
+// segments of at most SegmentSize bytes). Every chunk is held back by :
+//   Delay + jitter  : one-way delay, the jitter is drawn per chunk from the
+//                     JitterKind distribution (never below 0)
+//   Bandwidth       : serialization time Size/Bandwidth on a link shared by
+//                     the chunks of the same direction
+//   SegmentGap      : pause between the segments of one chunk
+//   Stall           : with a chance of StallPermille/1000 a chunk is stalled
+//                     for StallTime. TCP never loses data, a lost segment shows
+//                     up as a stall of the retransmission timeout instead.
+// TCP doesn't reorder either, so a chunk never overtakes the previous one.
+//
+// The random numbers come from a generator seeded per connection with Seed
+// (plus the connection number), so a run can be repeated exactly.
+// Times are in microseconds. Errors are the Server ones (Srv_ErrorText).
+//---------------------------------------------------------------------------
+const int prxToServer      = 0; // Client -> target direction
+const int prxToClient      = 1; // Target -> client direction
+
+const int prxJitterUniform = 0; // Uniform in [-Jitter, +Jitter]
+const int prxJitterNormal  = 1; // Normal, standard deviation Jitter
+const int prxJitterPareto  = 2; // Heavy tailed (Lomax, alpha 2), mean Jitter
+
+#pragma pack(1)
+
+typedef struct {
+    longword Delay;
+    longword Jitter;
+    int      JitterKind;
+    longword Bandwidth;    // Bytes per second, 0 = unlimited
+    int      SegmentSize;  // 0 = forward as received
+    longword SegmentGap;
+    int      StallPermille;
+    longword StallTime;
+} TProxyImpairment, *PProxyImpairment;
+
+#pragma pack()
+
+const int ProxyChunkSize   = 2048; // Max size of a forwarded chunk
+const int ProxyQueueSize   = 256;  // Chunks held back per direction
+
+typedef struct {
+    int64_t Due;  // Time the chunk is forwarded
+    int Size;
+    byte Data[ProxyChunkSize];
+} TProxyChunk, *PProxyChunk;
+
+class TSnap7Proxy;
+
+// Held back chunks of one direction
+class TProxyQueue
+{
+private:
+    PProxyChunk FChunks;
+    int FFirst;
+    int FCount;
+public:
+    int64_t LastDue;   // Due time of the last chunk queued
+    int64_t LinkFree;  // Time the (bandwidth limited) link is free again
+    TProxyQueue();
+    ~TProxyQueue();
+    bool Full() { return FCount==ProxyQueueSize; };
+    bool Empty() { return FCount==0; };
+    int Free() { return ProxyQueueSize - FCount; };
+    PProxyChunk Head() { return &FChunks[FFirst]; };
+    PProxyChunk Push();
+    void Pop();
+};
+
+// Socket connected to the target, only its handle is needed for select()
+class TProxyTarget : public TMsgSocket
+{
+public:
+    socket_t Handle() { return FSocket; };
+};
+
+class TProxyWorker : public TMsgSocket
+{
+private:
+    TSnap7Proxy *FServer;
+    TProxyTarget *FTarget;
+    TProxyQueue FQueue[2];  // Indexed by prxToServer/prxToClient
+    longword FRandom;
+    byte FBuffer[ProxyChunkSize];
+    double Random();
+    int64_t Jitter(PProxyImpairment Imp);
+    bool Forward(int Direction, TMsgSocket *From);
+    bool Flush(int Direction, TMsgSocket *To, int64_t Now);
+public:
+    TProxyWorker(TSnap7Proxy *Server, longword Seed);
+    ~TProxyWorker();
+    bool Execute();
+};
+typedef TProxyWorker *PProxyWorker;
+
+class TSnap7Proxy : public TCustomMsgServer
+{
+private:
+    PSnapCriticalSection CSStats;
+    longword FConnections;
+protected:
+    PWorkerSocket CreateWorkerSocket(socket_t Sock);
+public:
+    TProxyImpairment Impairment[2]; // Indexed by prxToServer/prxToClient
+    char TargetAddress[16];
+    word TargetPort;
+    longword Seed;
+    // Chunks received and chunks stalled
+    longword Chunks;
+    longword Stalls;
+    TSnap7Proxy();
+    ~TSnap7Proxy();
+    int SetImpairment(int Direction, PProxyImpairment Imp);
+    int StartTo(const char *Address, word Port, const char *Target, word TargetPort);
+    void GetStats(longword &ChunksCount, longword &StallsCount);
+    friend class TProxyWorker;
+};
+typedef TSnap7Proxy *PSnap7Proxy;
+
+#endif // s7_proxy_h
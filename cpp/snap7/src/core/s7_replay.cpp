@@ -0,0 +1,220 @@
+/*=============================================================================|
+|  PROJECT SNAP7                                                         1.3.0 |
+|==============================================================================|
+|  Copyright (C) 2013, 2015 Davide Nardella                                    |
+|  All rights reserved.                                                        |
+|==============================================================================|
+|  SNAP7 is free software: you can redistribute it and/or modify               |
+|  it under the terms of the Lesser GNU General Public License as published by |
+|  the Free Software Foundation, either version 3 of the License, or           |
+|  (at your option) any later version.                                         |
+|                                                                              |
+|  It means that you can distribute your commercial software linked with       |
+|  SNAP7 without the requirement to distribute the source code of your         |
+|  application and without the requirement that your application be itself     |
+|  distributed under LGPL.                                                     |
+|                                                                              |
+|  SNAP7 is distributed in the hope that it will be useful,                    |
+|  but WITHOUT ANY WARRANTY; without even the implied warranty of              |
+|  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the               |
+|  Lesser GNU General Public License for more details.                         |
+|                                                                              |
+|  You should have received a copy of the GNU General Public License and a     |
+|  copy of Lesser GNU General Public License along with Snap7.                 |
+|  If not, see  http://www.gnu.org/licenses/                                   |
+|=============================================================================*/
+#include "s7_replay.h"
+
+//---------------------------------------------------------------------------
+static void ReplayWaitUntil(int64_t Time)
+{
+    int64_t Delay = Time - int64_t(SysGetTickUs());
+    if (Delay<=0)
+        return;
+#ifdef OS_WINDOWS
+    Sleep(DWORD((Delay + 999) / 1000));
+#else
+    struct timespec ts;
+    ts.tv_sec = time_t(Delay / 1000000);
+    ts.tv_nsec = long(Delay % 1000000) * 1000;
+    nanosleep(&ts, (struct timespec *)0);
+#endif
+}
+//---------------------------------------------------------------------------
+// REPLAY WORKER
+//---------------------------------------------------------------------------
+TReplayWorker::TReplayWorker(TSnap7Replay *Server, int Session)
+{
+    FServer=Server;
+    FSession=Session;
+    FCursor=0;
+    FFrame=new byte[MaxPacketSize];
+}
+//---------------------------------------------------------------------------
+TReplayWorker::~TReplayWorker()
+{
+    delete[] FFrame;
+}
+//---------------------------------------------------------------------------
+int TReplayWorker::RecvFrame(int &Size)
+{
+    Size=0;
+    RecvPacket(FFrame, sizeof(TTPKT));
+    if (LastTcpError==0)
+    {
+        Size=(FFrame[2] << 8) | FFrame[3];
+        if (FFrame[0]!=0x03 || Size<int(sizeof(TTPKT)))
+        {
+            Size=0;
+            LastTcpError=errIsoInvalidPDU;
+        }
+        else
+            if (Size>int(sizeof(TTPKT)))
+                RecvPacket(FFrame + sizeof(TTPKT), Size - sizeof(TTPKT));
+    }
+    return LastTcpError;
+}
+//---------------------------------------------------------------------------
+int TReplayWorker::NextTelegram(int Index)
+{
+    PCaptureReader Capture = FServer->FCapture;
+    while (Index<Capture->Count && Capture->Telegram(Index)->Session!=FSession)
+        Index++;
+    return Index;
+}
+//---------------------------------------------------------------------------
+bool TReplayWorker::SameRequest(pbyte Frame, int Size, pbyte Recorded, int RecordedSize)
+{
+    if (Size!=RecordedSize)
+        return false;
+    // S7 telegram (COTP DT + S7 header) : skip the PDU reference
+    if (Size>=13 && Frame[5]==0xF0 && Frame[7]==0x32)
+        return memcmp(Frame, Recorded, 11)==0 &&
+               memcmp(Frame + 13, Recorded + 13, Size - 13)==0;
+    return memcmp(Frame, Recorded, Size)==0;
+}
+//---------------------------------------------------------------------------
+bool TReplayWorker::Execute()
+{
+    PCaptureReader Capture = FServer->FCapture;
+    PCaptureTelegram Request, Answer;
+    int Size, AnswerSize;
+    int64_t Received;
+    bool Same;
+    pbyte Data;
+
+    if (!CanRead(WorkInterval))
+        return true;
+    if (RecvFrame(Size)!=0)
+        return LastTcpError!=WSAECONNRESET && LastTcpError!=errIsoInvalidPDU;
+    Received=int64_t(SysGetTickUs());
+
+    // Next telegram recorded from the client
+    FCursor=NextTelegram(FCursor);
+    while (FCursor<Capture->Count && !Capture->Telegram(FCursor)->FromClient)
+        FCursor=NextTelegram(FCursor + 1);
+    if (FCursor>=Capture->Count)
+    {
+        // The client goes on beyond the recorded session
+        FServer->CSStats->Enter();
+        FServer->Mismatches++;
+        FServer->CSStats->Leave();
+        return false;
+    }
+    Request=Capture->Telegram(FCursor);
+    Same=SameRequest(FFrame, Size, Capture->Data(FCursor), Request->Size);
+
+    // Answers : everything the PLC sent before the next client telegram
+    FCursor=NextTelegram(FCursor + 1);
+    while (FCursor<Capture->Count && !Capture->Telegram(FCursor)->FromClient)
+    {
+        Answer=Capture->Telegram(FCursor);
+        AnswerSize=Answer->Size;
+        Data=Capture->Data(FCursor);
+        if (FServer->TimeScale>0)
+            ReplayWaitUntil(Received + (Answer->Time - Request->Time) * FServer->TimeScale / 100);
+        // The answer must carry the PDU reference of the live request
+        if (AnswerSize>=13 && Size>=13 && Data[5]==0xF0 && Data[7]==0x32 && FFrame[7]==0x32)
+        {
+            memcpy(FFrame, Data, 11);
+            memcpy(FFrame + 13, Data + 13, AnswerSize - 13);
+            // FFrame[11..12] still holds the reference of the request
+            SendPacket(FFrame, AnswerSize);
+        }
+        else
+            SendPacket(Data, AnswerSize);
+        if (LastTcpError!=0)
+            return false;
+        FCursor=NextTelegram(FCursor + 1);
+    }
+
+    FServer->CSStats->Enter();
+    FServer->Exchanges++;
+    if (!Same)
+        FServer->Mismatches++;
+    FServer->CSStats->Leave();
+    return true;
+}
+//---------------------------------------------------------------------------
+// REPLAY SERVER
+//---------------------------------------------------------------------------
+TSnap7Replay::TSnap7Replay()
+{
+    FCapture=new TCaptureReader();
+    CSStats=new TSnapCriticalSection();
+    FNextSession=0;
+    TimeScale=100;
+    Exchanges=0;
+    Mismatches=0;
+}
+//---------------------------------------------------------------------------
+TSnap7Replay::~TSnap7Replay()
+{
+    Stop();
+    delete FCapture;
+    delete CSStats;
+}
+//---------------------------------------------------------------------------
+int TSnap7Replay::LoadCapture(const char *FileName)
+{
+    if (Status==SrvRunning)
+        return errSrvCannotChangeParam;
+    if (FileName==NULL || !FCapture->LoadFromFile(FileName) || FCapture->Count==0)
+        return errSrvCannotLoadCapture;
+    FNextSession=0;
+    return 0;
+}
+//---------------------------------------------------------------------------
+int TSnap7Replay::StartTo(const char *Address, word Port)
+{
+    if (FCapture->Sessions==0)
+        return errSrvCannotLoadCapture;
+    CSStats->Enter();
+    Exchanges=0;
+    Mismatches=0;
+    CSStats->Leave();
+    return TCustomMsgServer::StartTo(Address, Port);
+}
+//---------------------------------------------------------------------------
+void TSnap7Replay::GetStats(longword &ExchangesCount, longword &MismatchesCount)
+{
+    CSStats->Enter();
+    ExchangesCount=Exchanges;
+    MismatchesCount=Mismatches;
+    CSStats->Leave();
+}
+//---------------------------------------------------------------------------
+PWorkerSocket TSnap7Replay::CreateWorkerSocket(socket_t Sock)
+{
+    PWorkerSocket Result;
+    int Session;
+    // Sessions are assigned round robin : the same capture can serve any number
+    // of consecutive (or concurrent) connections
+    CSStats->Enter();
+    Session=FNextSession;
+    FNextSession=(FNextSession + 1) % FCapture->Sessions;
+    CSStats->Leave();
+    Result = new TReplayWorker(this, Session);
+    Result->SetSocket(Sock);
+    return Result;
+}
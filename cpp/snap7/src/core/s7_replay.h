@@ -0,0 +1,91 @@
+/*=============================================================================|
+|  PROJECT SNAP7                                                         1.3.0 |
+|==============================================================================|
+|  Copyright (C) 2013, 2015 Davide Nardella                                    |
+|  All rights reserved.                                                        |
+|==============================================================================|
+|  SNAP7 is free software: you can redistribute it and/or modify               |
+|  it under the terms of the Lesser GNU General Public License as published by |
+|  the Free Software Foundation, either version 3 of the License, or           |
+|  (at your option) any later version.                                         |
+|                                                                              |
+|  It means that you can distribute your commercial software linked with       |
+|  SNAP7 without the requirement to distribute the source code of your         |
+|  application and without the requirement that your application be itself     |
+|  distributed under LGPL.                                                     |
+|                                                                              |
+|  SNAP7 is distributed in the hope that it will be useful,                    |
+|  but WITHOUT ANY WARRANTY; without even the implied warranty of              |
+|  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the               |
+|  Lesser GNU General Public License for more details.                         |
+|                                                                              |
+|  You should have received a copy of the GNU General Public License and a     |
+|  copy of Lesser GNU General Public License along with Snap7.                 |
+|  If not, see  http://www.gnu.org/licenses/                                   |
+|=============================================================================*/
+#ifndef s7_replay_h
+#define s7_replay_h
+//---------------------------------------------------------------------------
+#include "s7_server.h"
+#include "snap_capture.h"
+//---------------------------------------------------------------------------
+// REPLAY SERVER
+//
+// Answers S7 clients from a pcap capture (see snap_capture.h) instead of a PLC.
+// Every accepted connection replays the next TCP session of the capture : each
+// incoming telegram consumes the next telegram recorded from the client and is
+// answered with the telegrams the PLC sent after it.
+//
+// The S7 PDU reference of the request is copied into the answers, since the
+// client checks it; it's also ignored when incoming telegrams are compared with
+// the recorded ones. A different telegram is counted as mismatch but answered
+// anyway, so a client doing the same job can be profiled against the real
+// traffic shape.
+//
+// The answers are delayed as recorded (measured from the request) scaled by
+// TimeScale : 100 = as recorded, 50 = twice as fast, 0 = immediately.
+// Errors are the Server ones (Srv_ErrorText).
+//---------------------------------------------------------------------------
+class TSnap7Replay;
+
+class TReplayWorker : public TMsgSocket
+{
+private:
+    TSnap7Replay *FServer;
+    int FSession;
+    int FCursor;
+    pbyte FFrame;
+    int RecvFrame(int &Size);
+    int NextTelegram(int Index);
+    bool SameRequest(pbyte Frame, int Size, pbyte Recorded, int RecordedSize);
+public:
+    TReplayWorker(TSnap7Replay *Server, int Session);
+    ~TReplayWorker();
+    bool Execute();
+};
+typedef TReplayWorker *PReplayWorker;
+
+class TSnap7Replay : public TCustomMsgServer
+{
+private:
+    PCaptureReader FCapture;
+    PSnapCriticalSection CSStats;
+    int FNextSession;
+protected:
+    PWorkerSocket CreateWorkerSocket(socket_t Sock);
+public:
+    // Percent of the recorded answer times
+    int TimeScale;
+    // Requests answered and requests different from the recorded ones
+    longword Exchanges;
+    longword Mismatches;
+    TSnap7Replay();
+    ~TSnap7Replay();
+    int LoadCapture(const char *FileName);
+    int StartTo(const char *Address, word Port);
+    void GetStats(longword &ExchangesCount, longword &MismatchesCount);
+    friend class TReplayWorker;
+};
+typedef TSnap7Replay *PSnap7Replay;
+
+#endif // s7_replay_h
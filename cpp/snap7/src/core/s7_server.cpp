@@ -41,57 +41,91 @@ bool TIsoTcpWorker::ExecuteSend()
     return true;
 }
 //---------------------------------------------------------------------------
+void TIsoTcpWorker::UsePool(PSnapBufferPool Pool)
+{
+    delete[] pbyte(PDU);
+    PDU=NULL;
+    FPool=Pool;
+}
+//---------------------------------------------------------------------------
+void TIsoTcpWorker::LendPDU(pbyte Buffer)
+{
+    PDU=PIsoDataPDU(Buffer);
+}
+//---------------------------------------------------------------------------
 bool TIsoTcpWorker::ExecuteRecv()
 {
-    TPDUKind PduKind;
-    int PayloadSize;
+    bool Result;
 
     if (CanRead(WorkInterval)) // should be Small to avoid time wait during the close
     {
-        isoRecvPDU(&PDU);
-        if (LastTcpError==0)
+        if (FPool==NULL)
+            return IsoRecvCommand();
+        // Borrows the PDU only for the time of this telegram
+        LendPDU(FPool->Acquire());
+        try
+        {
+            Result=IsoRecvCommand();
+        } catch (...)
         {
-            IsoPeek(&PDU,PduKind);
-            // First check valid data incoming (most likely situation)
-            if (PduKind==pkValidData)
-            {
-                PayloadSize=PDUSize(&PDU)-DataHeaderSize;
-                return IsoPerformCommand(PayloadSize);
-            };
-            // Connection request incoming
-            if (PduKind==pkConnectionRequest)
-            {
-                IsoConfirmConnection(pdu_type_CC); // <- Connection confirm
-                return LastTcpError!=WSAECONNRESET;
-            };
-            // Disconnect request incoming (only for isotcp full complient equipment, not S7)
-            if (PduKind==pkDisconnectRequest)
-            {
-                IsoConfirmConnection(pdu_type_DC); // <- Disconnect confirm
-                return false;
-            };
-            // Empty fragment, maybe an ACK
-            if (PduKind==pkEmptyFragment)
-            {
-                PayloadSize=0;
-                return IsoPerformCommand(PayloadSize);
-            };
-            // Valid PDU format but we have to discard it
-            if (PduKind==pkUnrecognizedType)
-            {
-                return LastTcpError!=WSAECONNRESET;
-            };
-            // Here we have an Invalid PDU
-            Purge();
-            return true;
+            FPool->Release(pbyte(PDU));
+            LendPDU(NULL);
+            throw;
         }
-        else
-            return LastTcpError!=WSAECONNRESET;
+        FPool->Release(pbyte(PDU));
+        LendPDU(NULL);
+        return Result;
     }
     else
         return true;
 }
 //---------------------------------------------------------------------------
+bool TIsoTcpWorker::IsoRecvCommand()
+{
+    TPDUKind PduKind;
+    int PayloadSize;
+
+    isoRecvPDU(PDU);
+    if (LastTcpError==0)
+    {
+        IsoPeek(PDU,PduKind);
+        // First check valid data incoming (most likely situation)
+        if (PduKind==pkValidData)
+        {
+            PayloadSize=PDUSize(PDU)-DataHeaderSize;
+            return IsoPerformCommand(PayloadSize);
+        };
+        // Connection request incoming
+        if (PduKind==pkConnectionRequest)
+        {
+            IsoConfirmConnection(pdu_type_CC); // <- Connection confirm
+            return LastTcpError!=WSAECONNRESET;
+        };
+        // Disconnect request incoming (only for isotcp full complient equipment, not S7)
+        if (PduKind==pkDisconnectRequest)
+        {
+            IsoConfirmConnection(pdu_type_DC); // <- Disconnect confirm
+            return false;
+        };
+        // Empty fragment, maybe an ACK
+        if (PduKind==pkEmptyFragment)
+        {
+            PayloadSize=0;
+            return IsoPerformCommand(PayloadSize);
+        };
+        // Valid PDU format but we have to discard it
+        if (PduKind==pkUnrecognizedType)
+        {
+            return LastTcpError!=WSAECONNRESET;
+        };
+        // Here we have an Invalid PDU
+        Purge();
+        return true;
+    }
+    else
+        return LastTcpError!=WSAECONNRESET;
+}
+//---------------------------------------------------------------------------
 bool TIsoTcpWorker::Execute()
 {
     return ExecuteSend() && ExecuteRecv();
@@ -102,12 +136,19 @@ bool TIsoTcpWorker::Execute()
 TS7Worker::TS7Worker()
 {
     // We skip RFC/ISO header, our PDU is the payload
-    PDUH_in   =PS7ReqHeader(&PDU.Payload);
+    PDUH_in   =PS7ReqHeader(&PDU->Payload);
     FPDULength=2048;
     DBCnt     =0;
     LastBlk   =Block_DB;
+    SZL       =NULL;
 }
 
+void TS7Worker::LendPDU(pbyte Buffer)
+{
+    TIsoTcpWorker::LendPDU(Buffer);
+    PDUH_in=PS7ReqHeader(&PDU->Payload);
+}
+//------------------------------------------------------------------------------
 bool TS7Worker::ExecuteRecv()
 {
     WorkInterval=FServer->WorkInterval;
@@ -332,7 +373,7 @@ word TS7Worker::ReadArea(PResFunReadItem ResItemData, PReqFunReadItem ReqItemPar
     byte BitIndex, ByteVal;
 	int Multiplier;
     void *Source = NULL;
-    PSnapCriticalSection pcs;
+    PSnapLightMutex pcs;
 
     P=NULL;
     EV.EvStart   =0;
@@ -374,7 +415,7 @@ word TS7Worker::ReadArea(PResFunReadItem ResItemData, PReqFunReadItem ReqItemPar
 	EV.EvSize=Size;
 
     // The sum of the items must not exceed the PDU size negotiated
-    if (PDURemainder-Size<=0)
+    if (int(Size)>PDURemainder) // Size is unsigned, PDURemainder-Size would never be negative
         return RA_SizeOverPDU(ResItemData, EV);
     else
         PDURemainder-=Size;
@@ -507,7 +548,6 @@ bool TS7Worker::PerformFunctionRead()
     PDURemainder;
     TEv EV;
 
-	PDURemainder=FPDULength;
     // Stage 1 : Setup pointers and initial check
 	ReqParams=PReqFunReadParams(pbyte(PDUH_in)+sizeof(TS7ReqHeader));
     ResParams=PResFunReadParams(pbyte(&Answer)+ResHeaderSize23);        // Params after the header
@@ -517,6 +557,8 @@ bool TS7Worker::PerformFunctionRead()
         ReqParams->ItemsCount=MaxVars;
 
     ItemsCount=ReqParams->ItemsCount;
+    // The answer header, the item headers and their fill bytes are part of the PDU too
+    PDURemainder=FPDULength-ResHeaderSize23-int(sizeof(TResFunReadParams))-4*ItemsCount-(ItemsCount-1);
 
     // Stage 2 : gather data
     Offset=sizeof(TResFunReadParams);      // = 2
@@ -592,7 +634,7 @@ byte TS7Worker::WriteArea(PReqFunWriteDataItem ReqItemData, PReqFunWriteItem Req
 	word DBNum = 0;
 	word Elements;
     longword *PAdd;
-	PSnapCriticalSection pcs;
+	PSnapLightMutex pcs;
 	longword Start, Size, ASize, DataLen, AStart;
 	pbyte Target = NULL;
 	byte BitIndex;
@@ -737,7 +779,8 @@ bool TS7Worker::PerformFunctionWrite()
 	{
 		ReqData[c]=PReqFunWriteDataItem(pbyte(PDUH_in)+StartData);
 		
-		if ((ReqParams->Items[c].TransportSize == S7WLTimer) || (ReqParams->Items[c].TransportSize == S7WLCounter) || (ReqParams->Items[c].TransportSize == S7WLBit))
+		// Same rule as WriteArea() : octet, real and bit lengths are in bytes, the others in bits
+		if ((ReqData[c]->TransportSize == TS_ResOctet) || (ReqData[c]->TransportSize == TS_ResReal) || (ReqData[c]->TransportSize == TS_ResBit))
 			L = SwapWord(ReqData[c]->DataLength);
 		else
 			L = (SwapWord(ReqData[c]->DataLength) / 8);
@@ -1234,19 +1277,19 @@ bool TS7Worker::PerformGroupBlockInfo()
 //==============================================================================
 void TS7Worker::SZLNotAvailable()
 {
-    SZL.Answer.Header.DataLen=SwapWord(sizeof(SZLNotAvail));
-	SZL.ResParams->Err = 0x02D4;
-    memcpy(SZL.ResData, &SZLNotAvail, sizeof(SZLNotAvail));
-    isoSendBuffer(&SZL.Answer,26);
-    SZL.SZLDone=false;
+    SZL->Answer.Header.DataLen=SwapWord(sizeof(SZLNotAvail));
+	SZL->ResParams->Err = 0x02D4;
+    memcpy(SZL->ResData, &SZLNotAvail, sizeof(SZLNotAvail));
+    isoSendBuffer(&SZL->Answer,26);
+    SZL->SZLDone=false;
 }
 void TS7Worker::SZLSystemState()
 {
-    SZL.Answer.Header.DataLen=SwapWord(sizeof(SZLSysState));
-    SZL.ResParams->Err =0x0000;
-    memcpy(SZL.ResData,&SZLNotAvail,sizeof(SZLSysState));
-    isoSendBuffer(&SZL.Answer,28);
-	SZL.SZLDone=true;
+    SZL->Answer.Header.DataLen=SwapWord(sizeof(SZLSysState));
+    SZL->ResParams->Err =0x0000;
+    memcpy(SZL->ResData,&SZLNotAvail,sizeof(SZLSysState));
+    isoSendBuffer(&SZL->Answer,28);
+	SZL->SZLDone=true;
 
 }
 void TS7Worker::SZLData(void *P, int len)
@@ -1257,16 +1300,16 @@ void TS7Worker::SZLData(void *P, int len)
 		len=MaxSzl;
 	}
 
-	SZL.Answer.Header.DataLen=SwapWord(word(len));
-	SZL.ResParams->Err  =0x0000;
-	SZL.ResParams->resvd=0x0000; // this is the end, no more packets
-	memcpy(SZL.ResData, P, len);
+	SZL->Answer.Header.DataLen=SwapWord(word(len));
+	SZL->ResParams->Err  =0x0000;
+	SZL->ResParams->resvd=0x0000; // this is the end, no more packets
+	memcpy(SZL->ResData, P, len);
 
-	SZL.ResData[2]=((len-4)>>8) & 0xFF;
-	SZL.ResData[3]=(len-4) & 0xFF;
+	SZL->ResData[2]=((len-4)>>8) & 0xFF;
+	SZL->ResData[3]=(len-4) & 0xFF;
 
-	isoSendBuffer(&SZL.Answer,22+len);
-	SZL.SZLDone=true;
+	isoSendBuffer(&SZL->Answer,22+len);
+	SZL->SZLDone=true;
 }
 // this block is dynamic (contains date/time and cpu status)
 void TS7Worker::SZL_ID424()
@@ -1274,75 +1317,93 @@ void TS7Worker::SZL_ID424()
 	PS7Time PTime;
 	pbyte PStatus;
 
-	SZL.Answer.Header.DataLen=SwapWord(sizeof(SZL_ID_0424_IDX_XXXX));
-	SZL.ResParams->Err  =0x0000;
-	PTime=PS7Time(pbyte(SZL.ResData)+24);
-	PStatus =pbyte(SZL.ResData)+15;
-	memcpy(SZL.ResData,&SZL_ID_0424_IDX_XXXX,sizeof(SZL_ID_0424_IDX_XXXX));
+	SZL->Answer.Header.DataLen=SwapWord(sizeof(SZL_ID_0424_IDX_XXXX));
+	SZL->ResParams->Err  =0x0000;
+	PTime=PS7Time(pbyte(SZL->ResData)+24);
+	PStatus =pbyte(SZL->ResData)+15;
+	memcpy(SZL->ResData,&SZL_ID_0424_IDX_XXXX,sizeof(SZL_ID_0424_IDX_XXXX));
 	FillTime(PTime);
 	*PStatus=FServer->CpuStatus;
-	SZL.SZLDone=true;
-	isoSendBuffer(&SZL.Answer,22+sizeof(SZL_ID_0424_IDX_XXXX));
+	SZL->SZLDone=true;
+	isoSendBuffer(&SZL->Answer,22+sizeof(SZL_ID_0424_IDX_XXXX));
 }
 
 void TS7Worker::SZL_ID131_IDX003()
 {
 	word len = sizeof(SZL_ID_0131_IDX_0003);
-	SZL.Answer.Header.DataLen=SwapWord(len);
-	SZL.ResParams->Err  =0x0000;
-	SZL.ResParams->resvd=0x0000; // this is the end, no more packets
-	memcpy(SZL.ResData, &SZL_ID_0131_IDX_0003, len);
+	SZL->Answer.Header.DataLen=SwapWord(len);
+	SZL->ResParams->Err  =0x0000;
+	SZL->ResParams->resvd=0x0000; // this is the end, no more packets
+	memcpy(SZL->ResData, &SZL_ID_0131_IDX_0003, len);
     // Set the max consistent data window to PDU size
-	SZL.ResData[18]=((FPDULength)>>8) & 0xFF;
-	SZL.ResData[19]=(FPDULength) & 0xFF;
+	SZL->ResData[18]=((FPDULength)>>8) & 0xFF;
+	SZL->ResData[19]=(FPDULength) & 0xFF;
 
-	isoSendBuffer(&SZL.Answer,22+len);
-	SZL.SZLDone=true;
+	isoSendBuffer(&SZL->Answer,22+len);
+	SZL->SZLDone=true;
 }
 
 bool TS7Worker::PerformGroupSZL()
 {
-  SZL.SZLDone=false;
+  bool Result;
+  // The answer frame is lent by the pool as the PDU, not needed between requests
+  SZL=(TSZL*)(FServer->PDUPool->Acquire());
+  try
+  {
+      Result=PerformReadSZL();
+  } catch (...)
+  {
+      FServer->PDUPool->Release(pbyte(SZL));
+      throw;
+  }
+  FServer->PDUPool->Release(pbyte(SZL));
+  SZL=NULL;
+  return Result;
+}
+//------------------------------------------------------------------------------
+bool TS7Worker::PerformReadSZL()
+{
+  SZL->SZLDone=false;
   // Setup pointers
-  SZL.ReqParams=PReqFunReadSZLFirst(pbyte(PDUH_in)+ReqHeaderSize);
-  SZL.ResParams=PS7ResParams7(pbyte(&SZL.Answer)+ResHeaderSize17);
-  SZL.ResData  =pbyte(&SZL.Answer)+ResHeaderSize17+sizeof(TS7Params7);
+  SZL->ReqParams=PReqFunReadSZLFirst(pbyte(PDUH_in)+ReqHeaderSize);
+  SZL->ResParams=PS7ResParams7(pbyte(&SZL->Answer)+ResHeaderSize17);
+  SZL->ResData  =pbyte(&SZL->Answer)+ResHeaderSize17+sizeof(TS7Params7);
   // Prepare Answer header
-  SZL.Answer.Header.P=0x32;
-  SZL.Answer.Header.PDUType=PduType_userdata;
-  SZL.Answer.Header.AB_EX=0x0000;
-  SZL.Answer.Header.Sequence=PDUH_in->Sequence;
-  SZL.Answer.Header.ParLen =SwapWord(sizeof(TS7Params7));
-
-  SZL.ResParams->Head[0]=SZL.ReqParams->Head[0];
-  SZL.ResParams->Head[1]=SZL.ReqParams->Head[1];
-  SZL.ResParams->Head[2]=SZL.ReqParams->Head[2];
-  SZL.ResParams->Plen  =0x08;
-  SZL.ResParams->Uk    =0x12;
-  SZL.ResParams->Tg    =0x84; // Type response + group szl
-  SZL.ResParams->SubFun=SZL.ReqParams->SubFun;
-  SZL.ResParams->Seq   =SZL.ReqParams->Seq;
-  SZL.ResParams->resvd=0x0000; // this is the end, no more packets
+  SZL->Answer.Header.P=0x32;
+  SZL->Answer.Header.PDUType=PduType_userdata;
+  SZL->Answer.Header.AB_EX=0x0000;
+  SZL->Answer.Header.Sequence=PDUH_in->Sequence;
+  SZL->Answer.Header.ParLen =SwapWord(sizeof(TS7Params7));
+
+  SZL->ResParams->Head[0]=SZL->ReqParams->Head[0];
+  SZL->ResParams->Head[1]=SZL->ReqParams->Head[1];
+  SZL->ResParams->Head[2]=SZL->ReqParams->Head[2];
+  SZL->ResParams->Plen  =0x08;
+  SZL->ResParams->Uk    =0x12;
+  SZL->ResParams->Tg    =0x84; // Type response + group szl
+  SZL->ResParams->SubFun=SZL->ReqParams->SubFun;
+  SZL->ResParams->Seq   =SZL->ReqParams->Seq;
+  SZL->ResParams->resvd=0x0000; // this is the end, no more packets
 
   // only two subfunction are defined : 0x01 read, 0x02 system state
-  if (SZL.ResParams->SubFun==0x02)   // 0x02 = subfunction system state
+  if (SZL->ResParams->SubFun==0x02)   // 0x02 = subfunction system state
   {
       SZLSystemState();
       return true;
   };
-  if (SZL.ResParams->SubFun!=0x01)
+  if (SZL->ResParams->SubFun!=0x01)
   {
       SZLNotAvailable();
       return true;
   };
   // From here we assume subfunction = 0x01
-  SZL.ReqData=PS7ReqSZLData(pbyte(PDUH_in)+ReqHeaderSize+sizeof(TReqFunReadSZLFirst));// Data after params
+  SZL->ReqData=PS7ReqSZLData(pbyte(PDUH_in)+ReqHeaderSize+sizeof(TReqFunReadSZLFirst));// Data after params
 
-  SZL.ID=SwapWord(SZL.ReqData->ID);
-  SZL.Index=SwapWord(SZL.ReqData->Index);
+  SZL->ID=SwapWord(SZL->ReqData->ID);
+  SZL->Index=SwapWord(SZL->ReqData->Index);
 
   // Switch prebuilt Data Bank (they come from a physical CPU)
-  switch (SZL.ID)
+  switch (SZL->ID)
   {
     case 0x0000 : SZLData(&SZL_ID_0000_IDX_XXXX,sizeof(SZL_ID_0000_IDX_XXXX));break;
     case 0x0F00 : SZLData(&SZL_ID_0F00_IDX_XXXX,sizeof(SZL_ID_0F00_IDX_XXXX));break;
@@ -1396,66 +1457,66 @@ bool TS7Worker::PerformGroupSZL()
     case 0x003A : SZLData(&SZL_ID_003A_IDX_XXXX,sizeof(SZL_ID_003A_IDX_XXXX));break;
     case 0x0F3A : SZLData(&SZL_ID_0F3A_IDX_XXXX,sizeof(SZL_ID_0F3A_IDX_XXXX));break;
     case 0x0F9A : SZLData(&SZL_ID_0F9A_IDX_XXXX,sizeof(SZL_ID_0F9A_IDX_XXXX));break;
-    case 0x0D91 : switch(SZL.Index){
+    case 0x0D91 : switch(SZL->Index){
                     case 0x0000 : SZLData(&SZL_ID_0D91_IDX_0000,sizeof(SZL_ID_0D91_IDX_0000));break;
                     default: SZLNotAvailable();break;
                   };
                   break;
-    case 0x0092 : switch(SZL.Index){
+    case 0x0092 : switch(SZL->Index){
                     case 0x0000 : SZLData(&SZL_ID_0092_IDX_0000,sizeof(SZL_ID_0092_IDX_0000));break;
                     default     : SZLNotAvailable();break;
                   };break;
-    case 0x0292 : switch(SZL.Index){
+    case 0x0292 : switch(SZL->Index){
                     case 0x0000 : SZLData(&SZL_ID_0292_IDX_0000,sizeof(SZL_ID_0292_IDX_0000));break;
                     default     : SZLNotAvailable();break;
                   };break;
-    case 0x0692 : switch(SZL.Index){
+    case 0x0692 : switch(SZL->Index){
                     case 0x0000 : SZLData(&SZL_ID_0692_IDX_0000,sizeof(SZL_ID_0692_IDX_0000));break;
                     default     : SZLNotAvailable();break;
                   };break;
-	case 0x0094 : switch(SZL.Index){
+	case 0x0094 : switch(SZL->Index){
                     case 0x0000 : SZLData(&SZL_ID_0094_IDX_0000,sizeof(SZL_ID_0094_IDX_0000));break;
                     default     : SZLNotAvailable();break;
                   };break;
-    case 0x0D97 : switch(SZL.Index){
+    case 0x0D97 : switch(SZL->Index){
                     case 0x0000 : SZLData(&SZL_ID_0D97_IDX_0000,sizeof(SZL_ID_0D97_IDX_0000));break;
                     default     : SZLNotAvailable();break;
                   };break;
-    case 0x0111 : switch(SZL.Index){
+    case 0x0111 : switch(SZL->Index){
                     case 0x0001 : SZLData(&SZL_ID_0111_IDX_0001,sizeof(SZL_ID_0111_IDX_0001));break;
                     case 0x0006 : SZLData(&SZL_ID_0111_IDX_0006,sizeof(SZL_ID_0111_IDX_0006));break;
                     case 0x0007 : SZLData(&SZL_ID_0111_IDX_0007,sizeof(SZL_ID_0111_IDX_0007));break;
                     default     : SZLNotAvailable();break;
                   };break;
-    case 0x0F11 : switch(SZL.Index){
+    case 0x0F11 : switch(SZL->Index){
                     case 0x0001 : SZLData(&SZL_ID_0F11_IDX_0001,sizeof(SZL_ID_0F11_IDX_0001));break;
                     case 0x0006 : SZLData(&SZL_ID_0F11_IDX_0006,sizeof(SZL_ID_0F11_IDX_0006));break;
                     case 0x0007 : SZLData(&SZL_ID_0F11_IDX_0007,sizeof(SZL_ID_0F11_IDX_0007));break;
                     default     : SZLNotAvailable();break;
                   };break;
-    case 0x0112 : switch(SZL.Index){
+    case 0x0112 : switch(SZL->Index){
                     case 0x0000 : SZLData(&SZL_ID_0112_IDX_0000,sizeof(SZL_ID_0112_IDX_0000));break;
                     case 0x0100 : SZLData(&SZL_ID_0112_IDX_0100,sizeof(SZL_ID_0112_IDX_0100));break;
                     case 0x0200 : SZLData(&SZL_ID_0112_IDX_0200,sizeof(SZL_ID_0112_IDX_0200));break;
                     case 0x0400 : SZLData(&SZL_ID_0112_IDX_0400,sizeof(SZL_ID_0112_IDX_0400));break;
                     default     : SZLNotAvailable();break;
                   };break;
-    case 0x0F12 : switch(SZL.Index){
+    case 0x0F12 : switch(SZL->Index){
                    case 0x0000 : SZLData(&SZL_ID_0F12_IDX_0000,sizeof(SZL_ID_0F12_IDX_0000));break;
                    case 0x0100 : SZLData(&SZL_ID_0F12_IDX_0100,sizeof(SZL_ID_0F12_IDX_0100));break;
                    case 0x0200 : SZLData(&SZL_ID_0F12_IDX_0200,sizeof(SZL_ID_0F12_IDX_0200));break;
                    case 0x0400 : SZLData(&SZL_ID_0F12_IDX_0400,sizeof(SZL_ID_0F12_IDX_0400));break;
                    default     : SZLNotAvailable();break;
                   };break;
-    case 0x0113 : switch(SZL.Index){
+    case 0x0113 : switch(SZL->Index){
                     case 0x0001 : SZLData(&SZL_ID_0113_IDX_0001,sizeof(SZL_ID_0113_IDX_0001));break;
                     default     : SZLNotAvailable();break;
                   };break;
-	case 0x0115 : switch(SZL.Index){
+	case 0x0115 : switch(SZL->Index){
                     case 0x0800 : SZLData(&SZL_ID_0115_IDX_0800,sizeof(SZL_ID_0115_IDX_0800));break;
                     default     : SZLNotAvailable();break;
                   };break;
-    case 0x011C : switch(SZL.Index){
+    case 0x011C : switch(SZL->Index){
                     case 0x0001 : SZLData(&SZL_ID_011C_IDX_0001,sizeof(SZL_ID_011C_IDX_0001));break;
                     case 0x0002 : SZLData(&SZL_ID_011C_IDX_0002,sizeof(SZL_ID_011C_IDX_0002));break;
                     case 0x0003 : SZLData(&SZL_ID_011C_IDX_0003,sizeof(SZL_ID_011C_IDX_0003));break;
@@ -1468,7 +1529,7 @@ bool TS7Worker::PerformGroupSZL()
                     case 0x000B : SZLData(&SZL_ID_011C_IDX_000B,sizeof(SZL_ID_011C_IDX_000B));break;
                     default     : SZLNotAvailable();break;
                   };break;
-    case 0x0222 : switch(SZL.Index){
+    case 0x0222 : switch(SZL->Index){
                     case 0x0001 : SZLData(&SZL_ID_0222_IDX_0001,sizeof(SZL_ID_0222_IDX_0001));break;
                     case 0x000A : SZLData(&SZL_ID_0222_IDX_000A,sizeof(SZL_ID_0222_IDX_000A));break;
                     case 0x0014 : SZLData(&SZL_ID_0222_IDX_0014,sizeof(SZL_ID_0222_IDX_0014));break;
@@ -1477,16 +1538,16 @@ bool TS7Worker::PerformGroupSZL()
                     case 0x0064 : SZLData(&SZL_ID_0222_IDX_0064,sizeof(SZL_ID_0222_IDX_0064));break;
                     default     : SZLNotAvailable();break;
                   };break;
-    case 0x0125 : switch(SZL.Index){
+    case 0x0125 : switch(SZL->Index){
                     case 0x0000 : SZLData(&SZL_ID_0125_IDX_0000,sizeof(SZL_ID_0125_IDX_0000));break;
                     case 0x0001 : SZLData(&SZL_ID_0125_IDX_0001,sizeof(SZL_ID_0125_IDX_0001));break;
                     default     : SZLNotAvailable();break;
                   };break;
-    case 0x0225 : switch(SZL.Index){
+    case 0x0225 : switch(SZL->Index){
                     case 0x0001 : SZLData(&SZL_ID_0225_IDX_0001,sizeof(SZL_ID_0225_IDX_0001));break;
                     default     : SZLNotAvailable();break;
                   };break;
-    case 0x0131 : switch(SZL.Index){
+    case 0x0131 : switch(SZL->Index){
 					case 0x0001 : SZLData(&SZL_ID_0131_IDX_0001,sizeof(SZL_ID_0131_IDX_0001));break;
 					case 0x0002 : SZLData(&SZL_ID_0131_IDX_0002,sizeof(SZL_ID_0131_IDX_0002));break;
 					case 0x0003 : SZL_ID131_IDX003();break;
@@ -1498,7 +1559,7 @@ bool TS7Worker::PerformGroupSZL()
                     case 0x0009 : SZLData(&SZL_ID_0131_IDX_0009,sizeof(SZL_ID_0131_IDX_0009));break;
                     default     : SZLNotAvailable();break;
                   };break;
-    case 0x0117 : switch(SZL.Index){
+    case 0x0117 : switch(SZL->Index){
                      case 0x0000 : SZLData(&SZL_ID_0117_IDX_0000,sizeof(SZL_ID_0117_IDX_0000));break;
                      case 0x0001 : SZLData(&SZL_ID_0117_IDX_0001,sizeof(SZL_ID_0117_IDX_0001));break;
                      case 0x0002 : SZLData(&SZL_ID_0117_IDX_0002,sizeof(SZL_ID_0117_IDX_0002));break;
@@ -1506,14 +1567,14 @@ bool TS7Worker::PerformGroupSZL()
                      case 0x0004 : SZLData(&SZL_ID_0117_IDX_0004,sizeof(SZL_ID_0117_IDX_0004));break;
                      default     : SZLNotAvailable();break;
                    };break;
-    case 0x0118 : switch(SZL.Index){
+    case 0x0118 : switch(SZL->Index){
                      case 0x0000 : SZLData(&SZL_ID_0118_IDX_0000,sizeof(SZL_ID_0118_IDX_0000));break;
                      case 0x0001 : SZLData(&SZL_ID_0118_IDX_0001,sizeof(SZL_ID_0118_IDX_0001));break;
                      case 0x0002 : SZLData(&SZL_ID_0118_IDX_0002,sizeof(SZL_ID_0118_IDX_0002));break;
                      case 0x0003 : SZLData(&SZL_ID_0118_IDX_0003,sizeof(SZL_ID_0118_IDX_0003));break;
                      default     : SZLNotAvailable();break;
                    };break;
-    case 0x0132 : switch(SZL.Index){
+    case 0x0132 : switch(SZL->Index){
                      case 0x0001 : SZLData(&SZL_ID_0132_IDX_0001,sizeof(SZL_ID_0132_IDX_0001));break;
                      case 0x0002 : SZLData(&SZL_ID_0132_IDX_0002,sizeof(SZL_ID_0132_IDX_0002));break;
                      case 0x0003 : SZLData(&SZL_ID_0132_IDX_0003,sizeof(SZL_ID_0132_IDX_0003));break;
@@ -1528,11 +1589,11 @@ bool TS7Worker::PerformGroupSZL()
                      case 0x000C : SZLData(&SZL_ID_0132_IDX_000C,sizeof(SZL_ID_0132_IDX_000C));break;
                      default     : SZLNotAvailable();break;
                    };break;
-    case 0x0137 : switch(SZL.Index){
+    case 0x0137 : switch(SZL->Index){
                     case 0x07FE : SZLData(&SZL_ID_0137_IDX_07FE,sizeof(SZL_ID_0137_IDX_07FE));break;
                     default     : SZLNotAvailable();break;
                   };break;
-    case 0x01A0 : switch(SZL.Index){
+    case 0x01A0 : switch(SZL->Index){
                      case 0x0000 : SZLData(&SZL_ID_01A0_IDX_0000,sizeof(SZL_ID_01A0_IDX_0000));break;
                      case 0x0001 : SZLData(&SZL_ID_01A0_IDX_0001,sizeof(SZL_ID_01A0_IDX_0001));break;
                      case 0x0002 : SZLData(&SZL_ID_01A0_IDX_0002,sizeof(SZL_ID_01A0_IDX_0002));break;
@@ -1557,7 +1618,7 @@ bool TS7Worker::PerformGroupSZL()
                      case 0x0015 : SZLData(&SZL_ID_01A0_IDX_0015,sizeof(SZL_ID_01A0_IDX_0015));break;
                      default     : SZLNotAvailable();break;
                    };break;
-    case 0x0174 : switch(SZL.Index){
+    case 0x0174 : switch(SZL->Index){
                     case 0x0001 : SZLData(&SZL_ID_0174_IDX_0001,sizeof(SZL_ID_0174_IDX_0001));break;
                     case 0x0004 : SZLData(&SZL_ID_0174_IDX_0004,sizeof(SZL_ID_0174_IDX_0004));break;
                     case 0x0005 : SZLData(&SZL_ID_0174_IDX_0005,sizeof(SZL_ID_0174_IDX_0005));break;
@@ -1566,30 +1627,30 @@ bool TS7Worker::PerformGroupSZL()
                     case 0x000C : SZLData(&SZL_ID_0174_IDX_000C,sizeof(SZL_ID_0174_IDX_000C));break;
                     default     : SZLNotAvailable();break;
                   };break;
-    case 0x0194 : switch(SZL.Index){
+    case 0x0194 : switch(SZL->Index){
                     case 0x0064 : SZLData(&SZL_ID_0194_IDX_0064,sizeof(SZL_ID_0194_IDX_0064));break;
                     default     : SZLNotAvailable();break;
                   };break;
-    case 0x0694 : switch(SZL.Index){
+    case 0x0694 : switch(SZL->Index){
                     case 0x0064 : SZLData(&SZL_ID_0694_IDX_0064,sizeof(SZL_ID_0694_IDX_0064));break;
                     default     : SZLNotAvailable();break;
                   };break;
-    case 0x0232 : switch(SZL.Index){
+    case 0x0232 : switch(SZL->Index){
                      case 0x0001 : SZLData(&SZL_ID_0232_IDX_0001,sizeof(SZL_ID_0232_IDX_0001));break;
                      case 0x0004 : SZLData(&SZL_ID_0232_IDX_0004,sizeof(SZL_ID_0232_IDX_0004));break;
                      default     : SZLNotAvailable();break;
                    };break;
-    case 0x0C91 : switch(SZL.Index){
+    case 0x0C91 : switch(SZL->Index){
                     case 0x07FE : SZLData(&SZL_ID_0C91_IDX_07FE,sizeof(SZL_ID_0C91_IDX_07FE));break;
                     default     : SZLNotAvailable();break;
                   };break;
     default : SZLNotAvailable();break;
   }
   // Event
-  if (SZL.SZLDone)
-      DoEvent(evcReadSZL,evrNoError,SZL.ID,SZL.Index,0,0);
+  if (SZL->SZLDone)
+      DoEvent(evcReadSZL,evrNoError,SZL->ID,SZL->Index,0,0);
   else
-      DoEvent(evcReadSZL,evrInvalidSZL,SZL.ID,SZL.Index,0,0);
+      DoEvent(evcReadSZL,evrInvalidSZL,SZL->ID,SZL->Index,0,0);
   return true;
 }
 //------------------------------------------------------------------------------
@@ -1733,6 +1794,11 @@ bool TS7Worker::PerformSetClock()
 TSnap7Server::TSnap7Server()
 {
 	CSRWHook = new TSnapCriticalSection();
+	// A block holds a PDU or a SZL answer frame
+	if (sizeof(TSZL)>IsoFrameSize)
+		PDUPool = new TSnapBufferPool(sizeof(TSZL), 16);
+	else
+		PDUPool = new TSnapBufferPool(IsoFrameSize, 16);
 	OnReadEvent=NULL;
 	memset(&DB,0,sizeof(DB));
     memset(&HA,0,sizeof(HA));
@@ -1747,8 +1813,12 @@ TSnap7Server::TSnap7Server()
 //------------------------------------------------------------------------------
 TSnap7Server::~TSnap7Server()
 {
+    // The workers must be gone before their buffers
+    Destroying = true;
+    Stop();
     DisposeAll();
 	delete CSRWHook;
+	delete PDUPool;
 }
 //------------------------------------------------------------------------------
 PWorkerSocket TSnap7Server::CreateWorkerSocket(socket_t Sock)
@@ -1757,6 +1827,7 @@ PWorkerSocket TSnap7Server::CreateWorkerSocket(socket_t Sock)
     Result = new TS7Worker();
     Result->SetSocket(Sock);
     PS7Worker(Result)->FServer=this;
+    PS7Worker(Result)->UsePool(PDUPool);
     return Result;
 }
 //------------------------------------------------------------------------------
@@ -1824,7 +1895,7 @@ int TSnap7Server::RegisterDB(word Number, void *pUsrData, word Size)
 
     TheArea =new TS7Area;
     TheArea->Number=Number;
-    TheArea->cs=new TSnapCriticalSection();
+    TheArea->cs=new TSnapLightMutex();
     TheArea->PData=pbyte(pUsrData);
     TheArea->Size=Size;
     DB[index]=TheArea;
@@ -1871,7 +1942,7 @@ int TSnap7Server::RegisterSys(int AreaCode, void *pUsrData, word Size)
     if (HA[AreaCode]==0)
     {
 	TheArea=new TS7Area;
-	TheArea->cs=new TSnapCriticalSection();
+	TheArea->cs=new TSnapLightMutex();
 	TheArea->PData=pbyte(pUsrData);
 	TheArea->Size=Size;
 	HA[AreaCode]=TheArea;
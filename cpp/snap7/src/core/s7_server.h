@@ -27,6 +27,7 @@
 #define s7_server_h
 //---------------------------------------------------------------------------
 #include "snap_tcpsrvr.h"
+#include "snap_bufpool.h"
 #include "s7_types.h"
 #include "s7_isotcp.h"
 //---------------------------------------------------------------------------
@@ -46,6 +47,7 @@ const longword errSrvInvalidParams      = 0x00500000; // Invalid param(s) suppli
 const longword errSrvTooManyDB          = 0x00600000; // Cannot register DB
 const longword errSrvInvalidParamNumber = 0x00700000; // Invalid param (srv_get/set_param)
 const longword errSrvCannotChangeParam  = 0x00800000; // Cannot change because running
+const longword errSrvCannotLoadCapture  = 0x00900000; // Replay : capture file not found or invalid
 
 // Server Area ID  (use with Register/unregister - Lock/unlock Area)
 const int srvAreaPE = 0;
@@ -59,7 +61,7 @@ typedef struct{
 	word   Number; // Number (only for DB)
 	word   Size;   // Area size (in bytes)
 	pbyte  PData;  // Pointer to area
-	PSnapCriticalSection cs;
+	PSnapLightMutex cs;
 }TS7Area, *PS7Area;
 
 //------------------------------------------------------------------------------
@@ -67,13 +69,23 @@ typedef struct{
 //------------------------------------------------------------------------------
 class TIsoTcpWorker : public TIsoTcpSocket
 {
+private:
+	PSnapBufferPool FPool;
+	// Receives and performs the telegram waiting
+	bool IsoRecvCommand();
 protected:
 	virtual bool IsoPerformCommand(int &Size);
 	virtual bool ExecuteSend();
 	virtual bool ExecuteRecv();
+	// Points PDU to a buffer lent by the pool (NULL when given back),
+	// override to update the pointers into the payload
+	virtual void LendPDU(pbyte Buffer);
 public:
-	TIsoTcpWorker(){};
+	TIsoTcpWorker(){ FPool=NULL; };
 	~TIsoTcpWorker(){};
+	// PDU is only allocated (by Pool) while a telegram is processed,
+	// an idle connection doesn't hold any buffer.
+	void UsePool(PSnapBufferPool Pool);
 	// Worker execution
 	bool Execute();
 };
@@ -119,7 +131,7 @@ private:
     PS7ReqHeader PDUH_in;
 	int DBCnt;
     byte LastBlk;
-    TSZL SZL;
+    TSZL *SZL; // Lent by the pool within PerformGroupSZL()
     byte BCD(word Value);
     // Checks the consistence of the incoming PDU
     bool CheckPDU_in(int PayloadSize);
@@ -132,6 +144,7 @@ protected:
     void DoReadEvent(longword Code, word RetCode, word Param1, word Param2,
       word Param3, word Param4);
     void FragmentSkipped(int Size);
+    void LendPDU(pbyte Buffer);
     // Entry parse
     bool IsoPerformCommand(int &Size);
     // First stage parse
@@ -183,6 +196,7 @@ protected:
     bool PerformSetClock();
     // SZL Group
     bool PerformGroupSZL();
+    bool PerformReadSZL();
     // Subfunctions (called by PerformGroupSZL)
     void SZLNotAvailable();
 	void SZLSystemState();
@@ -215,6 +229,8 @@ private:
 	pfn_RWAreaCallBack OnRWArea;
 	// Critical section to lock Read/Write Hook Area
 	PSnapCriticalSection CSRWHook;
+	// PDU buffers lent to the workers while they process a telegram
+	PSnapBufferPool PDUPool;
 	void *FReadUsrPtr;
 	void *FRWAreaUsrPtr;
 	void DisposeAll();
@@ -245,6 +245,7 @@ char* CliTextOf(int Error, char* Result)
 	  case errCliDestroying             : strcpy(Result,"CLI : Cannot perform (destroying)\0");break;
 	  case errCliInvalidParamNumber     : strcpy(Result,"CLI : Invalid Param Number\0");break;
 	  case errCliCannotChangeParam      : strcpy(Result,"CLI : Cannot change this param now\0");break;
+	  case errCliCannotOpenCapture      : strcpy(Result,"CLI : Cannot create the capture file\0");break;
 	  default                           :
 	  {
 		  char CNumber[16];
@@ -270,6 +271,7 @@ char* SrvTextOf(int Error, char* Result)
 	case errSrvTooManyDB:          strcpy(Result, "SRV : DB Limit reached\0"); break;
 	case errSrvInvalidParamNumber: strcpy(Result, "SRV : Invalid Param Number\0"); break;
 	case errSrvCannotChangeParam:  strcpy(Result, "SRV : Cannot change this param now\0");break;
+	case errSrvCannotLoadCapture:  strcpy(Result, "SRV : Cannot load the capture file\0");break;
 	default: 
 		{
 			char CNumber[16];
@@ -329,6 +331,7 @@ char* ErrCliText(int Error, char * Result, int TextLen)
 		{
 			case errLibInvalidParam  : strncpy(Result,"LIB : Invalid param supplied\0",TextLen);break;
 			case errLibInvalidObject: strncpy(Result, "LIB : Invalid object supplied\0", TextLen); break;
+			case errLibNotAvailable : strncpy(Result, "LIB : Function not available in this build\0", TextLen); break;
 			default :
 			{
 				CliTextOf(Error & ErrS7Mask, CliError);
@@ -354,6 +357,7 @@ char* ErrSrvText(int Error, char* Result, int TextLen)
 		{
 		case errLibInvalidParam: strncpy(Result, "LIB : Invalid param supplied\0", TextLen); break;
 		case errLibInvalidObject: strncpy(Result, "LIB : Invalid object supplied\0", TextLen); break;
+		case errLibNotAvailable: strncpy(Result, "LIB : Function not available in this build\0", TextLen); break;
 		default:
 		{
 			SrvTextOf(Error & ErrS7Mask, SrvError);
@@ -379,6 +383,7 @@ char* ErrParText(int Error, char* Result, int TextLen)
 		{
 		case errLibInvalidParam: strncpy(Result, "LIB : Invalid param supplied\0", TextLen); break;
 		case errLibInvalidObject: strncpy(Result, "LIB : Invalid object supplied\0", TextLen); break;
+		case errLibNotAvailable: strncpy(Result, "LIB : Function not available in this build\0", TextLen); break;
 		default:
 		{
 			ParTextOf(Error & ErrS7Mask, ParError);
@@ -33,6 +33,7 @@
 
 const int errLibInvalidParam  = -1;
 const int errLibInvalidObject = -2;
+const int errLibNotAvailable  = -3; // Function not compiled in this build
 // Errors areas definition
 const longword ErrTcpMask = 0x0000FFFF;
 const longword ErrIsoMask = 0x000F0000;
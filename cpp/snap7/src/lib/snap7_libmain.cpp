@@ -112,6 +112,28 @@ int S7API Cli_ConnectTo(S7Object Client, const char *Address, int Rack, int Slot
         return errLibInvalidObject;
 }
 //---------------------------------------------------------------------------
+int S7API Cli_ConnectMany(S7Object *Clients, int Count, int *Results)
+{
+    PSnap7MicroClient *List;
+    int c, Result;
+
+    if ((Clients==NULL) || (Count<=0))
+        return errCliInvalidParams;
+    for (c = 0; c < Count; c++)
+    {
+        if (!Clients[c])
+            return errLibInvalidObject;
+        if (PSnap7Client(Clients[c])->Busy())
+            return errCliJobPending;
+    }
+    List=new PSnap7MicroClient[Count];
+    for (c = 0; c < Count; c++)
+        List[c]=PSnap7Client(Clients[c]);
+    Result=ConnectClients(List, Count, Results);
+    delete[] List;
+    return Result;
+}
+//---------------------------------------------------------------------------
 int S7API Cli_Connect(S7Object Client)
 {
     if (Client)
@@ -515,6 +537,17 @@ int S7API Cli_GetExecTime(S7Object Client, int &Time)
         return errLibInvalidObject;
 }
 //---------------------------------------------------------------------------
+int S7API Cli_GetExecTimeUs(S7Object Client, int &Time)
+{
+    if (Client)
+    {
+        Time=PSnap7Client(Client)->TimeUs();
+        return 0;
+    }
+    else
+        return errLibInvalidObject;
+}
+//---------------------------------------------------------------------------
 int S7API Cli_GetLastError(S7Object Client, int &LastError)
 {
     if (Client)
@@ -538,6 +571,19 @@ int S7API Cli_GetPduLength(S7Object Client, int &Requested, int &Negotiated)
         return errLibInvalidObject;
 }
 //---------------------------------------------------------------------------
+int S7API Cli_GetConnectTimes(S7Object Client, int &TcpTime, int &IsoTime, int &NegotiateTime)
+{
+    if (Client)
+    {
+        TcpTime      =int(PSnap7Client(Client)->TcpConnectTime);
+        IsoTime      =int(PSnap7Client(Client)->IsoConnectTime);
+        NegotiateTime=int(PSnap7Client(Client)->NegotiateTime);
+        return 0;
+    }
+    else
+        return errLibInvalidObject;
+}
+//---------------------------------------------------------------------------
 int S7API Cli_ErrorText(int Error, char *Text, int TextLen)
 {
 	try{
@@ -562,6 +608,67 @@ int S7API Cli_GetConnected(S7Object Client, int &Connected)
         return errLibInvalidObject;
 }
 //---------------------------------------------------------------------------
+int S7API Cli_GetStats(S7Object Client, TS7ClientStats *pUsrData)
+{
+    if (Client)
+    {
+        if (pUsrData==NULL)
+            return errCliInvalidParams;
+        // The job thread updates them, they are only consistent between the jobs
+        if (PSnap7Client(Client)->Busy())
+            return errCliJobPending;
+        PSnap7Client(Client)->GetStats(pUsrData);
+        return 0;
+    }
+    else
+        return errLibInvalidObject;
+}
+//---------------------------------------------------------------------------
+int S7API Cli_ClearStats(S7Object Client)
+{
+    if (Client)
+    {
+        if (PSnap7Client(Client)->Busy())
+            return errCliJobPending;
+        PSnap7Client(Client)->ClearStats();
+        return 0;
+    }
+    else
+        return errLibInvalidObject;
+}
+//---------------------------------------------------------------------------
+int S7API Cli_StartCapture(S7Object Client, const char *FileName)
+{
+    if (Client)
+    {
+        if (FileName==NULL)
+            return errCliInvalidParams;
+        // The writer is used by the job thread, it can't be replaced under a pending job
+        if (PSnap7Client(Client)->Busy())
+            return errCliJobPending;
+        if (PSnap7Client(Client)->StartCapture(FileName))
+            return 0;
+        else
+            return errCliCannotOpenCapture;
+    }
+    else
+        return errLibInvalidObject;
+}
+//---------------------------------------------------------------------------
+int S7API Cli_StopCapture(S7Object Client)
+{
+    if (Client)
+    {
+        // The writer is used by the job thread, it can't be deleted under a pending job
+        if (PSnap7Client(Client)->Busy())
+            return errCliJobPending;
+        PSnap7Client(Client)->StopCapture();
+        return 0;
+    }
+    else
+        return errLibInvalidObject;
+}
+//---------------------------------------------------------------------------
 int S7API Cli_AsReadArea(S7Object Client, int Area, int DBNumber, int Start, int Amount, int WordLen, void *pUsrData)
 {
     if (Client)
@@ -1132,6 +1239,30 @@ int S7API Par_SetRecvCallback(S7Object Partner, pfn_ParBRecvCallBack pCompletion
         return errLibInvalidObject;
 }
 //---------------------------------------------------------------------------
+int S7API Par_SetRecvRing(S7Object Partner, void *pBuffers, int BufferSize, int Count)
+{
+    if (Partner)
+        return PSnap7Partner(Partner)->SetRecvRing(pBuffers, BufferSize, Count);
+    else
+        return errLibInvalidObject;
+}
+//---------------------------------------------------------------------------
+int S7API Par_RecvFromRing(S7Object Partner, longword &R_ID, void *&pData, int &Size, longword Timeout)
+{
+    if (Partner)
+        return PSnap7Partner(Partner)->RecvFromRing(R_ID, pData, Size, Timeout);
+    else
+        return errLibInvalidObject;
+}
+//---------------------------------------------------------------------------
+int S7API Par_ReleaseRingBuffer(S7Object Partner, void *pData)
+{
+    if (Partner)
+        return PSnap7Partner(Partner)->ReleaseRingBuffer(pData);
+    else
+        return errLibInvalidObject;
+}
+//---------------------------------------------------------------------------
 int S7API Par_GetTimes(S7Object Partner, longword &SendTime, longword &RecvTime)
 {
     if (Partner)
@@ -1145,6 +1276,18 @@ int S7API Par_GetTimes(S7Object Partner, longword &SendTime, longword &RecvTime)
 
 }
 //---------------------------------------------------------------------------
+int S7API Par_GetTimesUs(S7Object Partner, longword &SendTime, longword &RecvTime)
+{
+    if (Partner)
+    {
+        SendTime=PSnap7Partner(Partner)->SendTimeUs;
+        RecvTime=PSnap7Partner(Partner)->RecvTimeUs;
+        return 0;
+    }
+    else
+        return errLibInvalidObject;
+}
+//---------------------------------------------------------------------------
 int S7API Par_GetStats(S7Object Partner, longword &BytesSent, longword &BytesRecv,
     longword &SendErrors, longword &RecvErrors)
 {
@@ -1193,4 +1336,182 @@ int S7API Par_ErrorText(int Error, char *Text, int TextLen)
 	}
 	return 0;
 }
-
+//---------------------------------------------------------------------------
+int S7API Par_SetEventLoops(int Loops)
+{
+    return PartnerLoops_SetCount(Loops);
+}
+//***************************************************************************
+// REPLAY
+//***************************************************************************
+S7Object S7API Rpl_Create()
+{
+    return S7Object(new TSnap7Replay());
+}
+//---------------------------------------------------------------------------
+void S7API Rpl_Destroy(S7Object &Replay)
+{
+    if (Replay)
+    {
+        delete PSnap7Replay(Replay);
+        Replay=0;
+    }
+}
+//---------------------------------------------------------------------------
+int S7API Rpl_LoadCapture(S7Object Replay, const char *FileName)
+{
+    if (Replay)
+        return PSnap7Replay(Replay)->LoadCapture(FileName);
+    else
+        return errLibInvalidObject;
+}
+//---------------------------------------------------------------------------
+int S7API Rpl_SetTimeScale(S7Object Replay, int Percent)
+{
+    if (Replay)
+    {
+        if (Percent<0)
+            return errSrvInvalidParams;
+        PSnap7Replay(Replay)->TimeScale=Percent;
+        return 0;
+    }
+    else
+        return errLibInvalidObject;
+}
+//---------------------------------------------------------------------------
+int S7API Rpl_StartTo(S7Object Replay, const char *Address, word Port)
+{
+    if (Replay)
+        return PSnap7Replay(Replay)->StartTo(Address, Port);
+    else
+        return errLibInvalidObject;
+}
+//---------------------------------------------------------------------------
+int S7API Rpl_Stop(S7Object Replay)
+{
+    if (Replay)
+    {
+        PSnap7Replay(Replay)->Stop();
+        return 0;
+    }
+    else
+        return errLibInvalidObject;
+}
+//---------------------------------------------------------------------------
+int S7API Rpl_GetStats(S7Object Replay, longword &Exchanges, longword &Mismatches)
+{
+    if (Replay)
+    {
+        PSnap7Replay(Replay)->GetStats(Exchanges, Mismatches);
+        return 0;
+    }
+    else
+        return errLibInvalidObject;
+}
+//***************************************************************************
+// IMPAIRMENT PROXY
+//***************************************************************************
+S7Object S7API Prx_Create()
+{
+    return S7Object(new TSnap7Proxy());
+}
+//---------------------------------------------------------------------------
+void S7API Prx_Destroy(S7Object &Proxy)
+{
+    if (Proxy)
+    {
+        delete PSnap7Proxy(Proxy);
+        Proxy=0;
+    }
+}
+//---------------------------------------------------------------------------
+int S7API Prx_SetImpairment(S7Object Proxy, int Direction, TProxyImpairment *pImpairment)
+{
+    if (Proxy)
+        return PSnap7Proxy(Proxy)->SetImpairment(Direction, pImpairment);
+    else
+        return errLibInvalidObject;
+}
+//---------------------------------------------------------------------------
+int S7API Prx_SetSeed(S7Object Proxy, longword Seed)
+{
+    if (Proxy)
+    {
+        PSnap7Proxy(Proxy)->Seed=Seed;
+        return 0;
+    }
+    else
+        return errLibInvalidObject;
+}
+//---------------------------------------------------------------------------
+int S7API Prx_StartTo(S7Object Proxy, const char *Address, word Port, const char *TargetAddress, word TargetPort)
+{
+    if (Proxy)
+        return PSnap7Proxy(Proxy)->StartTo(Address, Port, TargetAddress, TargetPort);
+    else
+        return errLibInvalidObject;
+}
+//---------------------------------------------------------------------------
+int S7API Prx_Stop(S7Object Proxy)
+{
+    if (Proxy)
+    {
+        PSnap7Proxy(Proxy)->Stop();
+        return 0;
+    }
+    else
+        return errLibInvalidObject;
+}
+//---------------------------------------------------------------------------
+int S7API Prx_GetStats(S7Object Proxy, longword &Chunks, longword &Stalls)
+{
+    if (Proxy)
+    {
+        PSnap7Proxy(Proxy)->GetStats(Chunks, Stalls);
+        return 0;
+    }
+    else
+        return errLibInvalidObject;
+}
+//***************************************************************************
+// TRACE
+//***************************************************************************
+int S7API Trc_Dump(const char *FileName)
+{
+    if (!TraceAvailable())
+        return errLibNotAvailable;
+    if (FileName==NULL || !TraceDump(FileName))
+        return errLibInvalidParam;
+    return 0;
+}
+//---------------------------------------------------------------------------
+int S7API Trc_Clear()
+{
+    if (!TraceAvailable())
+        return errLibNotAvailable;
+    TraceClear();
+    return 0;
+}
+//***************************************************************************
+// THREADS
+//***************************************************************************
+int S7API Thr_SetConfig(int Role, TSnapThreadConfig *pConfig)
+{
+    if (ThreadConfigSet(Role, pConfig)!=0)
+        return errLibInvalidParam;
+    return 0;
+}
+//---------------------------------------------------------------------------
+int S7API Thr_GetConfig(int Role, TSnapThreadConfig *pConfig)
+{
+    if (ThreadConfigGet(Role, pConfig)!=0)
+        return errLibInvalidParam;
+    return 0;
+}
+//---------------------------------------------------------------------------
+int S7API Thr_GetStats(int Role, int &Started, int &Errors)
+{
+    if (ThreadConfigStats(Role, Started, Errors)!=0)
+        return errLibInvalidParam;
+    return 0;
+}
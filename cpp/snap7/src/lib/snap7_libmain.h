@@ -27,8 +27,11 @@
 #define snap7_libmain_h
 //---------------------------------------------------------------------------
 #include "s7_client.h"
+#include "s7_connector.h"
 #include "s7_server.h"
 #include "s7_partner.h"
+#include "s7_replay.h"
+#include "s7_proxy.h"
 #include "s7_text.h"
 //---------------------------------------------------------------------------
 
@@ -46,6 +49,8 @@ EXPORTSPEC int S7API Cli_Connect(S7Object Client);
 EXPORTSPEC int S7API Cli_SetConnectionParams(S7Object Client, const char *Address, word LocalTSAP, word RemoteTSAP);
 EXPORTSPEC int S7API Cli_SetConnectionType(S7Object Client, word ConnectionType);
 EXPORTSPEC int S7API Cli_ConnectTo(S7Object Client, const char *Address, int Rack, int Slot);
+// Connects many clients (connection params already set) at once, see s7_connector.h
+EXPORTSPEC int S7API Cli_ConnectMany(S7Object *Clients, int Count, int *Results);
 EXPORTSPEC int S7API Cli_Disconnect(S7Object Client);
 EXPORTSPEC int S7API Cli_GetParam(S7Object Client, int ParamNumber, void *pValue);
 EXPORTSPEC int S7API Cli_SetParam(S7Object Client, int ParamNumber, void *pValue);
@@ -105,10 +110,19 @@ EXPORTSPEC int S7API Cli_ClearSessionPassword(S7Object Client);
 EXPORTSPEC int S7API Cli_IsoExchangeBuffer(S7Object Client, void *pUsrData, int &Size);
 // Misc
 EXPORTSPEC int S7API Cli_GetExecTime(S7Object Client, int &Time);
+// Execution time of the last job in microseconds
+EXPORTSPEC int S7API Cli_GetExecTimeUs(S7Object Client, int &Time);
 EXPORTSPEC int S7API Cli_GetLastError(S7Object Client, int &LastError);
 EXPORTSPEC int S7API Cli_GetPduLength(S7Object Client, int &Requested, int &Negotiated);
+EXPORTSPEC int S7API Cli_GetConnectTimes(S7Object Client, int &TcpTime, int &IsoTime, int &NegotiateTime);
 EXPORTSPEC int S7API Cli_ErrorText(int Error, char *Text, int TextLen);
 EXPORTSPEC int S7API Cli_GetConnected(S7Object Client, int &Connected);
+// Statistics (refused with errCliJobPending while an async job is pending)
+EXPORTSPEC int S7API Cli_GetStats(S7Object Client, TS7ClientStats *pUsrData);
+EXPORTSPEC int S7API Cli_ClearStats(S7Object Client);
+// Capture (refused with errCliJobPending while an async job is pending)
+EXPORTSPEC int S7API Cli_StartCapture(S7Object Client, const char *FileName);
+EXPORTSPEC int S7API Cli_StopCapture(S7Object Client);
 //==============================================================================
 //  CLIENT EXPORT LIST - Async functions
 //==============================================================================
@@ -188,14 +202,55 @@ EXPORTSPEC int S7API Par_BRecv(S7Object Partner, longword &R_ID, void *pData, in
 EXPORTSPEC int S7API Par_CheckAsBRecvCompletion(S7Object Partner, int &opResult, longword &R_ID,
     void *pData, int &Size);
 EXPORTSPEC int S7API Par_SetRecvCallback(S7Object Partner, pfn_ParBRecvCallBack pCompletion, void *usrPtr);
+// BRecv into buffers provided by the application (zero copy)
+EXPORTSPEC int S7API Par_SetRecvRing(S7Object Partner, void *pBuffers, int BufferSize, int Count);
+EXPORTSPEC int S7API Par_RecvFromRing(S7Object Partner, longword &R_ID, void *&pData, int &Size, longword Timeout);
+EXPORTSPEC int S7API Par_ReleaseRingBuffer(S7Object Partner, void *pData);
 // Stat
 EXPORTSPEC int S7API Par_GetTimes(S7Object Partner, longword &SendTime, longword &RecvTime);
+// Last send and receive times in microseconds
+EXPORTSPEC int S7API Par_GetTimesUs(S7Object Partner, longword &SendTime, longword &RecvTime);
 EXPORTSPEC int S7API Par_GetStats(S7Object Partner, longword &BytesSent, longword &BytesRecv,
     longword &SendErrors, longword &RecvErrors);
 EXPORTSPEC int S7API Par_GetLastError(S7Object Partner, int &LastError);
 EXPORTSPEC int S7API Par_GetStatus(S7Object Partner, int &Status);
 EXPORTSPEC int S7API Par_ErrorText(int Error, char *Text, int TextLen);
+// Event loops : partners started afterwards share Loops threads (0 = one thread per partner)
+EXPORTSPEC int S7API Par_SetEventLoops(int Loops);
 
+//==============================================================================
+//  REPLAY EXPORT LIST (errors are Server errors, use Srv_ErrorText)
+//==============================================================================
+EXPORTSPEC S7Object S7API Rpl_Create();
+EXPORTSPEC void S7API Rpl_Destroy(S7Object &Replay);
+EXPORTSPEC int S7API Rpl_LoadCapture(S7Object Replay, const char *FileName);
+EXPORTSPEC int S7API Rpl_SetTimeScale(S7Object Replay, int Percent);
+EXPORTSPEC int S7API Rpl_StartTo(S7Object Replay, const char *Address, word Port);
+EXPORTSPEC int S7API Rpl_Stop(S7Object Replay);
+EXPORTSPEC int S7API Rpl_GetStats(S7Object Replay, longword &Exchanges, longword &Mismatches);
+
+//==============================================================================
+//  IMPAIRMENT PROXY EXPORT LIST (errors are Server errors, use Srv_ErrorText)
+//==============================================================================
+EXPORTSPEC S7Object S7API Prx_Create();
+EXPORTSPEC void S7API Prx_Destroy(S7Object &Proxy);
+EXPORTSPEC int S7API Prx_SetImpairment(S7Object Proxy, int Direction, TProxyImpairment *pImpairment);
+EXPORTSPEC int S7API Prx_SetSeed(S7Object Proxy, longword Seed);
+EXPORTSPEC int S7API Prx_StartTo(S7Object Proxy, const char *Address, word Port, const char *TargetAddress, word TargetPort);
+EXPORTSPEC int S7API Prx_Stop(S7Object Proxy);
+EXPORTSPEC int S7API Prx_GetStats(S7Object Proxy, longword &Chunks, longword &Stalls);
 
+//==============================================================================
+//  TRACE EXPORT LIST (tracepoints are compiled only with SNAP7_TRACE)
+//==============================================================================
+EXPORTSPEC int S7API Trc_Dump(const char *FileName);
+EXPORTSPEC int S7API Trc_Clear();
+
+//==============================================================================
+//  THREAD EXPORT LIST (see snap_threads.h, applies to threads started afterwards)
+//==============================================================================
+EXPORTSPEC int S7API Thr_SetConfig(int Role, TSnapThreadConfig *pConfig);
+EXPORTSPEC int S7API Thr_GetConfig(int Role, TSnapThreadConfig *pConfig);
+EXPORTSPEC int S7API Thr_GetStats(int Role, int &Started, int &Errors);
 
 #endif // snap7_libmain_h
@@ -0,0 +1,99 @@
+/*=============================================================================|
+|  PROJECT SNAP7                                                         1.3.0 |
+|==============================================================================|
+|  Copyright (C) 2013, 2015 Davide Nardella                                    |
+|  All rights reserved.                                                        |
+|==============================================================================|
+|  SNAP7 is free software: you can redistribute it and/or modify               |
+|  it under the terms of the Lesser GNU General Public License as published by |
+|  the Free Software Foundation, either version 3 of the License, or           |
+|  (at your option) any later version.                                         |
+|                                                                              |
+|  It means that you can distribute your commercial software linked with       |
+|  SNAP7 without the requirement to distribute the source code of your         |
+|  application and without the requirement that your application be itself     |
+|  distributed under LGPL.                                                     |
+|                                                                              |
+|  SNAP7 is distributed in the hope that it will be useful,                    |
+|  but WITHOUT ANY WARRANTY; without even the implied warranty of              |
+|  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the               |
+|  Lesser GNU General Public License for more details.                         |
+|                                                                              |
+|  You should have received a copy of the GNU General Public License and a     |
+|  copy of Lesser GNU General Public License along with Snap7.                 |
+|  If not, see  http://www.gnu.org/licenses/                                   |
+|=============================================================================*/
+#include "snap_bufpool.h"
+
+// Blocks are aligned as the chunk header, enough for any PDU layout
+const int ChunkHeaderSize = 16;
+//---------------------------------------------------------------------------
+TSnapBufferPool::TSnapBufferPool(int BlockSize, int BlocksPerChunk)
+{
+    CS=new TSnapCriticalSection();
+    FChunks=NULL;
+    FFree=NULL;
+    FBlockSize=(BlockSize+ChunkHeaderSize-1) & ~(ChunkHeaderSize-1);
+    FBlocksPerChunk=BlocksPerChunk>0 ? BlocksPerChunk : 1;
+    Capacity=0;
+    Lent=0;
+    PeakLent=0;
+}
+//---------------------------------------------------------------------------
+TSnapBufferPool::~TSnapBufferPool()
+{
+    pbyte Next;
+    while (FChunks!=NULL)
+    {
+        Next=*(pbyte*)(FChunks);
+        delete[] FChunks;
+        FChunks=Next;
+    }
+    delete CS;
+}
+//---------------------------------------------------------------------------
+void TSnapBufferPool::Grow()
+{
+    pbyte Chunk, Block;
+    int c;
+
+    Chunk=new byte[ChunkHeaderSize+FBlockSize*FBlocksPerChunk];
+    *(pbyte*)(Chunk)=FChunks;
+    FChunks=Chunk;
+    // Blocks are linked backwards so the first one is lent first
+    Block=Chunk+ChunkHeaderSize;
+    for (c = 0; c < FBlocksPerChunk; c++)
+    {
+        *(pbyte*)(Block)=FFree;
+        FFree=Block;
+        Block+=FBlockSize;
+    }
+    Capacity+=FBlocksPerChunk;
+}
+//---------------------------------------------------------------------------
+pbyte TSnapBufferPool::Acquire()
+{
+    pbyte Result;
+
+    CS->Enter();
+    if (FFree==NULL)
+        Grow();
+    Result=FFree;
+    FFree=*(pbyte*)(Result);
+    Lent++;
+    if (Lent>PeakLent)
+        PeakLent=Lent;
+    CS->Leave();
+    return Result;
+}
+//---------------------------------------------------------------------------
+void TSnapBufferPool::Release(pbyte Block)
+{
+    if (Block==NULL)
+        return;
+    CS->Enter();
+    *(pbyte*)(Block)=FFree;
+    FFree=Block;
+    Lent--;
+    CS->Leave();
+}
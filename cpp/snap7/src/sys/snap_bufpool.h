@@ -0,0 +1,62 @@
+/*=============================================================================|
+|  PROJECT SNAP7                                                         1.3.0 |
+|==============================================================================|
+|  Copyright (C) 2013, 2015 Davide Nardella                                    |
+|  All rights reserved.                                                        |
+|==============================================================================|
+|  SNAP7 is free software: you can redistribute it and/or modify               |
+|  it under the terms of the Lesser GNU General Public License as published by |
+|  the Free Software Foundation, either version 3 of the License, or           |
+|  (at your option) any later version.                                         |
+|                                                                              |
+|  It means that you can distribute your commercial software linked with       |
+|  SNAP7 without the requirement to distribute the source code of your         |
+|  application and without the requirement that your application be itself     |
+|  distributed under LGPL.                                                     |
+|                                                                              |
+|  SNAP7 is distributed in the hope that it will be useful,                    |
+|  but WITHOUT ANY WARRANTY; without even the implied warranty of              |
+|  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the               |
+|  Lesser GNU General Public License for more details.                         |
+|                                                                              |
+|  You should have received a copy of the GNU General Public License and a     |
+|  copy of Lesser GNU General Public License along with Snap7.                 |
+|  If not, see  http://www.gnu.org/licenses/                                   |
+|=============================================================================*/
+#ifndef snap_bufpool_h
+#define snap_bufpool_h
+//---------------------------------------------------------------------------
+#include "snap_platform.h"
+#include "snap_threads.h"
+//---------------------------------------------------------------------------
+// Pool of fixed size buffers shared by many threads.
+//
+// The buffers are carved from chunks of BlocksPerChunk blocks (the arena) that
+// are only given back to the system when the pool is destroyed, and are lent
+// by Acquire() until Release(). A free block holds the link to the next one,
+// so the bookkeeping costs no memory. All the buffers must be released before
+// destroying the pool.
+//---------------------------------------------------------------------------
+class TSnapBufferPool
+{
+private:
+    PSnapCriticalSection CS;
+    pbyte FChunks;     // Chunk list, linked through the first bytes of every chunk
+    pbyte FFree;       // Free list, linked through the first bytes of every block
+    int FBlockSize;
+    int FBlocksPerChunk;
+    void Grow();
+public:
+    int Capacity;   // Blocks carved so far
+    int Lent;       // Blocks acquired and not yet released
+    int PeakLent;   // Highest Lent seen
+    TSnapBufferPool(int BlockSize, int BlocksPerChunk);
+    ~TSnapBufferPool();
+    int BlockSize(){ return FBlockSize; };
+    // Lends a block, the pool grows by one chunk when all the blocks are lent
+    pbyte Acquire();
+    void Release(pbyte Block);
+};
+typedef TSnapBufferPool *PSnapBufferPool;
+
+#endif // snap_bufpool_h
@@ -0,0 +1,536 @@
+/*=============================================================================|
+|  PROJECT SNAP7                                                         1.3.0 |
+|==============================================================================|
+|  Copyright (C) 2013, 2015 Davide Nardella                                    |
+|  All rights reserved.                                                        |
+|==============================================================================|
+|  SNAP7 is free software: you can redistribute it and/or modify               |
+|  it under the terms of the Lesser GNU General Public License as published by |
+|  the Free Software Foundation, either version 3 of the License, or           |
+|  (at your option) any later version.                                         |
+|                                                                              |
+|  It means that you can distribute your commercial software linked with       |
+|  SNAP7 without the requirement to distribute the source code of your         |
+|  application and without the requirement that your application be itself     |
+|  distributed under LGPL.                                                     |
+|                                                                              |
+|  SNAP7 is distributed in the hope that it will be useful,                    |
+|  but WITHOUT ANY WARRANTY; without even the implied warranty of              |
+|  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the               |
+|  Lesser GNU General Public License for more details.                         |
+|                                                                              |
+|  You should have received a copy of the GNU General Public License and a     |
+|  copy of Lesser GNU General Public License along with Snap7.                 |
+|  If not, see  http://www.gnu.org/licenses/                                   |
+|=============================================================================*/
+#include "snap_capture.h"
+
+//---------------------------------------------------------------------------
+// Wall clock time in microseconds (pcap timestamps are UTC)
+//---------------------------------------------------------------------------
+static int64_t CaptureTime()
+{
+#ifdef OS_WINDOWS
+    FILETIME ft;
+    int64_t Time;
+    GetSystemTimeAsFileTime(&ft);
+    Time = (int64_t(ft.dwHighDateTime) << 32) | ft.dwLowDateTime;
+    // 100 ns intervals since 1601-01-01 -> microseconds since 1970-01-01
+    return (Time - 116444736000000000LL) / 10;
+#else
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return int64_t(tv.tv_sec) * 1000000 + tv.tv_usec;
+#endif
+}
+//---------------------------------------------------------------------------
+static longword SwapLongword(longword Value)
+{
+    return (Value >> 24) | ((Value << 8) & 0x00FF0000) | ((Value >> 8) & 0x0000FF00) | (Value << 24);
+}
+//---------------------------------------------------------------------------
+// WRITER
+//---------------------------------------------------------------------------
+TSnapCapture::TSnapCapture()
+{
+    FFile=NULL;
+    FBuffer=NULL;
+    FId=0;
+    Frames=0;
+    CS=new TSnapCriticalSection();
+}
+//---------------------------------------------------------------------------
+TSnapCapture::~TSnapCapture()
+{
+    Close();
+    delete CS;
+}
+//---------------------------------------------------------------------------
+word TSnapCapture::IPChecksum(TCaptureIPHeader &Header)
+{
+    pword Data = pword(&Header);
+    longword Sum = 0;
+    for (int c = 0; c < int(sizeof(TCaptureIPHeader) / 2); c++)
+        Sum+=Data[c];
+    while (Sum >> 16)
+        Sum=(Sum & 0xFFFF) + (Sum >> 16);
+    return word(~Sum);
+}
+//---------------------------------------------------------------------------
+bool TSnapCapture::Open(const char *FileName)
+{
+    TPcapFileHeader Header;
+
+    Close();
+    CS->Enter();
+    FFile=fopen(FileName, "wb");
+    if (FFile!=NULL)
+    {
+        // Frames are small : let stdio collect them and write in large blocks
+        FBuffer=new char[CaptureBufferSize];
+        setvbuf(FFile, FBuffer, _IOFBF, CaptureBufferSize);
+
+        Header.magic_number=PcapMagic;
+        Header.version_major=2;
+        Header.version_minor=4;
+        Header.thiszone=0;
+        Header.sigfigs=0;
+        Header.snaplen=PcapSnapLen;
+        Header.network=LinkTypeRaw;
+        fwrite(&Header, sizeof(Header), 1, FFile);
+        Frames=0;
+    }
+    CS->Leave();
+    return FFile!=NULL;
+}
+//---------------------------------------------------------------------------
+void TSnapCapture::Close()
+{
+    CS->Enter();
+    if (FFile!=NULL)
+    {
+        fclose(FFile);
+        FFile=NULL;
+    }
+    if (FBuffer!=NULL)
+    {
+        delete[] FBuffer;
+        FBuffer=NULL;
+    }
+    CS->Leave();
+}
+//---------------------------------------------------------------------------
+bool TSnapCapture::Active()
+{
+    return FFile!=NULL;
+}
+//---------------------------------------------------------------------------
+void TSnapCapture::WriteFrame(longword SrcAddr, word SrcPort, longword DstAddr, word DstPort,
+      longword Seq, longword Ack, byte Flags, void *Data, int Size)
+{
+    TPcapRecordHeader Record;
+    TCaptureIPHeader IP;
+    TCaptureTCPHeader TCP;
+    int64_t Now;
+    int MaxData = PcapSnapLen - sizeof(IP) - sizeof(TCP);
+
+    if (Data==NULL || Size<0)
+        Size=0;
+    if (Size>MaxData)
+        Size=MaxData;
+
+    Now=CaptureTime();
+    Record.ts_sec=longword(Now / 1000000);
+    Record.ts_usec=longword(Now % 1000000);
+    Record.incl_len=sizeof(IP) + sizeof(TCP) + Size;
+    Record.orig_len=Record.incl_len;
+
+    IP.ip_hl_v=0x45;
+    IP.ip_tos=0;
+    IP.ip_len=htons(word(Record.incl_len));
+    IP.ip_off=htons(0x4000); // Don't fragment
+    IP.ip_ttl=64;
+    IP.ip_p=6; // TCP
+    IP.ip_sum=0;
+    IP.ip_src=SrcAddr;
+    IP.ip_dst=DstAddr;
+
+    TCP.th_sport=SrcPort;
+    TCP.th_dport=DstPort;
+    TCP.th_seq=htonl(Seq);
+    TCP.th_ack=htonl(Ack);
+    TCP.th_off=0x50; // 5 longwords, no options
+    TCP.th_flags=Flags;
+    TCP.th_win=htons(0xFFFF);
+    TCP.th_sum=0; // Not computed, Wireshark doesn't validate it by default
+    TCP.th_urp=0;
+
+    CS->Enter();
+    if (FFile!=NULL)
+    {
+        IP.ip_id=htons(FId++);
+        IP.ip_sum=IPChecksum(IP);
+        fwrite(&Record, sizeof(Record), 1, FFile);
+        fwrite(&IP, sizeof(IP), 1, FFile);
+        fwrite(&TCP, sizeof(TCP), 1, FFile);
+        if (Size>0)
+            fwrite(Data, Size, 1, FFile);
+        Frames++;
+    }
+    CS->Leave();
+}
+//---------------------------------------------------------------------------
+// READER
+//---------------------------------------------------------------------------
+TCaptureReader::TCaptureReader()
+{
+    FPool=NULL;
+    FPoolSize=0;
+    FPoolCapacity=0;
+    FTelegrams=NULL;
+    FCapacity=0;
+    Count=0;
+    Sessions=0;
+    memset(FSessions, 0, sizeof(FSessions));
+}
+//---------------------------------------------------------------------------
+TCaptureReader::~TCaptureReader()
+{
+    Clear();
+}
+//---------------------------------------------------------------------------
+void TCaptureReader::Clear()
+{
+    for (int c = 0; c < Sessions; c++)
+    {
+        CloseSession(c);
+        delete FSessions[c];
+        FSessions[c]=NULL;
+    }
+    if (FPool!=NULL)
+        delete[] FPool;
+    if (FTelegrams!=NULL)
+        delete[] FTelegrams;
+    FPool=NULL;
+    FPoolSize=0;
+    FPoolCapacity=0;
+    FTelegrams=NULL;
+    FCapacity=0;
+    Count=0;
+    Sessions=0;
+}
+//---------------------------------------------------------------------------
+PCaptureTelegram TCaptureReader::Telegram(int Index)
+{
+    return &FTelegrams[Index];
+}
+//---------------------------------------------------------------------------
+pbyte TCaptureReader::Data(int Index)
+{
+    return FPool + FTelegrams[Index].Offset;
+}
+//---------------------------------------------------------------------------
+void TCaptureReader::AddTelegram(int Session, bool FromClient, int64_t Time, pbyte Data, int Size)
+{
+    if (Count==FCapacity)
+    {
+        int NewCapacity = FCapacity ? FCapacity * 2 : 1024;
+        PCaptureTelegram NewTelegrams = new TCaptureTelegram[NewCapacity];
+        if (Count>0)
+            memcpy(NewTelegrams, FTelegrams, Count * sizeof(TCaptureTelegram));
+        delete[] FTelegrams;
+        FTelegrams=NewTelegrams;
+        FCapacity=NewCapacity;
+    }
+    if (FPoolSize + Size > FPoolCapacity)
+    {
+        longword NewCapacity = FPoolCapacity ? FPoolCapacity * 2 : 65536;
+        while (FPoolSize + Size > NewCapacity)
+            NewCapacity*=2;
+        pbyte NewPool = new byte[NewCapacity];
+        if (FPoolSize>0)
+            memcpy(NewPool, FPool, FPoolSize);
+        delete[] FPool;
+        FPool=NewPool;
+        FPoolCapacity=NewCapacity;
+    }
+    memcpy(FPool + FPoolSize, Data, Size);
+    FTelegrams[Count].Session=Session;
+    FTelegrams[Count].FromClient=FromClient;
+    FTelegrams[Count].Time=Time;
+    FTelegrams[Count].Offset=FPoolSize;
+    FTelegrams[Count].Size=Size;
+    FPoolSize+=Size;
+    Count++;
+}
+//---------------------------------------------------------------------------
+void TCaptureReader::AddSegment(int Session, int Direction, int64_t Time, longword Seq, pbyte Data, int Size)
+{
+    TCaptureFlow *Flow = &FSessions[Session]->Flow[Direction];
+    int32_t Diff = int32_t(Seq - Flow->NextSeq);
+    int Needed, Chunk;
+
+    if (Diff<0)
+    {
+        // Retransmission : skip what we already have
+        if (-Diff>=Size)
+            return;
+        Data+=-Diff;
+        Size-=-Diff;
+        Seq=Flow->NextSeq;
+    }
+    else
+        if (Diff>0)
+            // Bytes lost by the capture : drop the partial telegram and
+            // resync on the next TPKT header
+            Flow->Size=0;
+    Flow->NextSeq=Seq + Size;
+
+    if (Flow->Buffer==NULL)
+        Flow->Buffer=new byte[CaptureBufferSize];
+
+    while (Size>0)
+    {
+        if (Flow->Size<4)
+            Needed=4;
+        else
+            Needed=(Flow->Buffer[2] << 8) | Flow->Buffer[3];
+        Chunk=Needed - Flow->Size;
+        if (Chunk>Size)
+            Chunk=Size;
+        memcpy(Flow->Buffer + Flow->Size, Data, Chunk);
+        Flow->Size+=Chunk;
+        Data+=Chunk;
+        Size-=Chunk;
+
+        if (Flow->Size==4)
+        {
+            // TPKT header complete : version 3 and at least a COTP length byte
+            Needed=(Flow->Buffer[2] << 8) | Flow->Buffer[3];
+            if (Flow->Buffer[0]!=0x03 || Needed<5)
+            {
+                Flow->Size=0;
+                return;
+            }
+        }
+        if (Flow->Size>=4 && Flow->Size==((Flow->Buffer[2] << 8) | Flow->Buffer[3]))
+        {
+            AddTelegram(Session, Direction==0, Time, Flow->Buffer, Flow->Size);
+            Flow->Size=0;
+        }
+    }
+}
+//---------------------------------------------------------------------------
+void TCaptureReader::CloseSession(int Session)
+{
+    PCaptureSession S = FSessions[Session];
+    S->Closed=true;
+    for (int c = 0; c < 2; c++)
+    {
+        if (S->Flow[c].Buffer!=NULL)
+        {
+            delete[] S->Flow[c].Buffer;
+            S->Flow[c].Buffer=NULL;
+        }
+        S->Flow[c].Size=0;
+    }
+}
+//---------------------------------------------------------------------------
+void TCaptureReader::ProcessPacket(int64_t Time, pbyte Packet, int Size)
+{
+    int IPHeaderSize, TCPHeaderSize, TotalSize, PayloadSize;
+    longword SrcAddr, DstAddr, Seq;
+    word SrcPort, DstPort, Fragment;
+    byte Flags;
+    pbyte TCP;
+    int Session = -1;
+    int Direction = 0;
+    bool SrcIsClient;
+    PCaptureSession S;
+
+    if (Size<int(sizeof(TCaptureIPHeader)) || (Packet[0] >> 4)!=4 || Packet[9]!=6)
+        return;
+    IPHeaderSize=(Packet[0] & 0x0F) * 4;
+    TotalSize=(Packet[2] << 8) | Packet[3];
+    Fragment=word((Packet[6] << 8) | Packet[7]);
+    if ((Fragment & 0x3FFF)!=0) // IP fragments are not reassembled
+        return;
+    if (TotalSize>Size || TotalSize==0) // truncated or TSO (length not set)
+        TotalSize=Size;
+    if (TotalSize<IPHeaderSize + 20)
+        return;
+
+    TCP=Packet + IPHeaderSize;
+    TCPHeaderSize=(TCP[12] >> 4) * 4;
+    PayloadSize=TotalSize - IPHeaderSize - TCPHeaderSize;
+    if (PayloadSize<0)
+        return;
+    memcpy(&SrcAddr, Packet + 12, 4);
+    memcpy(&DstAddr, Packet + 16, 4);
+    memcpy(&SrcPort, TCP, 2);
+    memcpy(&DstPort, TCP + 2, 2);
+    Seq=(longword(TCP[4]) << 24) | (longword(TCP[5]) << 16) | (longword(TCP[6]) << 8) | TCP[7];
+    Flags=TCP[13];
+
+    for (int c = 0; c < Sessions; c++)
+    {
+        S=FSessions[c];
+        if (S->Closed)
+            continue;
+        if (S->ClientAddr==SrcAddr && S->ClientPort==SrcPort && S->ServerAddr==DstAddr && S->ServerPort==DstPort)
+        {
+            Session=c;
+            Direction=0;
+            break;
+        }
+        if (S->ClientAddr==DstAddr && S->ClientPort==DstPort && S->ServerAddr==SrcAddr && S->ServerPort==SrcPort)
+        {
+            Session=c;
+            Direction=1;
+            break;
+        }
+    }
+
+    if (Session<0)
+    {
+        if ((Flags & (tcpRST | tcpFIN))!=0 || Sessions==MaxCaptureSessions)
+            return;
+        // The active side is the one which sent the SYN, if we didn't see it
+        // (capture started with the connection already established) the one
+        // not using the ISO-TCP port
+        if ((Flags & tcpSYN)!=0)
+            SrcIsClient=(Flags & tcpACK)==0;
+        else
+            if (DstPort==htons(CaptureServerPort))
+                SrcIsClient=true;
+            else
+                SrcIsClient=SrcPort!=htons(CaptureServerPort);
+
+        S=new TCaptureSession;
+        memset(S, 0, sizeof(TCaptureSession));
+        if (SrcIsClient)
+        {
+            S->ClientAddr=SrcAddr;
+            S->ClientPort=SrcPort;
+            S->ServerAddr=DstAddr;
+            S->ServerPort=DstPort;
+        }
+        else
+        {
+            S->ClientAddr=DstAddr;
+            S->ClientPort=DstPort;
+            S->ServerAddr=SrcAddr;
+            S->ServerPort=SrcPort;
+        }
+        Session=Sessions++;
+        FSessions[Session]=S;
+        Direction=SrcIsClient ? 0 : 1;
+    }
+
+    S=FSessions[Session];
+    if ((Flags & tcpSYN)!=0)
+    {
+        S->Flow[Direction].NextSeq=Seq + 1;
+        S->Flow[Direction].Synced=true;
+        return;
+    }
+    if (!S->Flow[Direction].Synced)
+    {
+        S->Flow[Direction].NextSeq=Seq;
+        S->Flow[Direction].Synced=true;
+    }
+    if (PayloadSize>0)
+        AddSegment(Session, Direction, Time, Seq, TCP + TCPHeaderSize, PayloadSize);
+
+    if ((Flags & tcpFIN)!=0)
+        S->Flow[Direction].Fin=true;
+    if ((Flags & tcpRST)!=0 || (S->Flow[0].Fin && S->Flow[1].Fin))
+        CloseSession(Session);
+}
+//---------------------------------------------------------------------------
+bool TCaptureReader::LoadFromFile(const char *FileName)
+{
+    TPcapFileHeader Header;
+    TPcapRecordHeader Record;
+    FILE *F;
+    pbyte Frame;
+    pbyte Packet;
+    int Size;
+    bool Swapped, Nano;
+    int64_t Time;
+
+    Clear();
+    F=fopen(FileName, "rb");
+    if (F==NULL)
+        return false;
+
+    if (fread(&Header, sizeof(Header), 1, F)!=1)
+    {
+        fclose(F);
+        return false;
+    }
+    Swapped=Header.magic_number==SwapLongword(PcapMagic) || Header.magic_number==SwapLongword(PcapMagicNano);
+    Nano=Header.magic_number==PcapMagicNano || Header.magic_number==SwapLongword(PcapMagicNano);
+    if (!Swapped && !Nano && Header.magic_number!=PcapMagic)
+    {
+        fclose(F);
+        return false;
+    }
+    if (Swapped)
+        Header.network=SwapLongword(Header.network);
+
+    Frame=new byte[CaptureBufferSize * 4];
+    while (fread(&Record, sizeof(Record), 1, F)==1)
+    {
+        if (Swapped)
+        {
+            Record.ts_sec=SwapLongword(Record.ts_sec);
+            Record.ts_usec=SwapLongword(Record.ts_usec);
+            Record.incl_len=SwapLongword(Record.incl_len);
+        }
+        if (Record.incl_len>longword(CaptureBufferSize * 4) || fread(Frame, 1, Record.incl_len, F)!=Record.incl_len)
+            break; // Corrupted or truncated file : keep what we have
+        Time=int64_t(Record.ts_sec) * 1000000 + (Nano ? Record.ts_usec / 1000 : Record.ts_usec);
+        Packet=Frame;
+        Size=Record.incl_len;
+
+        switch (Header.network)
+        {
+            case LinkTypeNull:
+                Packet+=4;
+                Size-=4;
+                break;
+            case LinkTypeEthernet:
+                if (Size>=18 && Frame[12]==0x81 && Frame[13]==0x00) // VLAN tag
+                {
+                    Packet+=4;
+                    Size-=4;
+                }
+                if (Size<14 || Packet[12]!=0x08 || Packet[13]!=0x00)
+                    Size=0;
+                Packet+=14;
+                Size-=14;
+                break;
+            case LinkTypeLinuxSLL:
+                if (Size<16 || Frame[14]!=0x08 || Frame[15]!=0x00)
+                    Size=0;
+                Packet+=16;
+                Size-=16;
+                break;
+            case LinkTypeRaw:
+            case LinkTypeRawBSD:
+                break;
+            default:
+                Size=0;
+        }
+        if (Size>0)
+            ProcessPacket(Time, Packet, Size);
+    }
+    delete[] Frame;
+    fclose(F);
+    // Release the reassembly buffers, only the telegrams are needed from now on
+    for (int c = 0; c < Sessions; c++)
+        if (!FSessions[c]->Closed)
+            CloseSession(c);
+    return true;
+}
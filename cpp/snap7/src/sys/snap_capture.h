@@ -0,0 +1,192 @@
+/*=============================================================================|
+|  PROJECT SNAP7                                                         1.3.0 |
+|==============================================================================|
+|  Copyright (C) 2013, 2015 Davide Nardella                                    |
+|  All rights reserved.                                                        |
+|==============================================================================|
+|  SNAP7 is free software: you can redistribute it and/or modify               |
+|  it under the terms of the Lesser GNU General Public License as published by |
+|  the Free Software Foundation, either version 3 of the License, or           |
+|  (at your option) any later version.                                         |
+|                                                                              |
+|  It means that you can distribute your commercial software linked with       |
+|  SNAP7 without the requirement to distribute the source code of your         |
+|  application and without the requirement that your application be itself     |
+|  distributed under LGPL.                                                     |
+|                                                                              |
+|  SNAP7 is distributed in the hope that it will be useful,                    |
+|  but WITHOUT ANY WARRANTY; without even the implied warranty of              |
+|  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the               |
+|  Lesser GNU General Public License for more details.                         |
+|                                                                              |
+|  You should have received a copy of the GNU General Public License and a     |
+|  copy of Lesser GNU General Public License along with Snap7.                 |
+|  If not, see  http://www.gnu.org/licenses/                                   |
+|=============================================================================*/
+#ifndef snap_capture_h
+#define snap_capture_h
+//---------------------------------------------------------------------------
+#include "snap_platform.h"
+#include "snap_threads.h"
+#include <stdio.h>
+//---------------------------------------------------------------------------
+// Wire level capture of TCP sessions into pcap files (libpcap classic format).
+//
+// Frames are written with LINKTYPE_RAW : every record is an IPv4 packet whose
+// IP and TCP headers are synthesized from the socket coordinates, followed by
+// the bytes that were really sent or received. Sequence numbers are relative
+// to the connection, so Wireshark reassembles the TPKT/COTP/S7 telegrams.
+//
+// The reader accepts these files and also the ones made by tcpdump/Wireshark
+// (Ethernet, Linux cooked and raw IP), it reassembles the TPKT telegrams of
+// each TCP session and stores them, in time order, for the replay.
+//---------------------------------------------------------------------------
+const longword PcapMagic       = 0xA1B2C3D4; // microseconds timestamps
+const longword PcapMagicNano   = 0xA1B23C4D; // nanoseconds timestamps
+const longword PcapSnapLen     = 65535;
+
+const longword LinkTypeNull     = 0;
+const longword LinkTypeEthernet = 1;
+const longword LinkTypeRawBSD   = 12;
+const longword LinkTypeRaw      = 101;
+const longword LinkTypeLinuxSLL = 113;
+
+// TCP flags
+const byte tcpFIN = 0x01;
+const byte tcpSYN = 0x02;
+const byte tcpRST = 0x04;
+const byte tcpPSH = 0x08;
+const byte tcpACK = 0x10;
+
+// Passive side of a session whose SYN was not captured
+const word CaptureServerPort = 102; // RFC 1006
+
+const int MaxCaptureSessions = 1024;
+const int CaptureBufferSize  = 65536;
+
+#pragma pack(1)
+
+typedef struct{
+    longword magic_number;
+    word     version_major;
+    word     version_minor;
+    int32_t  thiszone;
+    longword sigfigs;
+    longword snaplen;
+    longword network;
+}TPcapFileHeader;
+
+typedef struct{
+    longword ts_sec;
+    longword ts_usec;
+    longword incl_len;
+    longword orig_len;
+}TPcapRecordHeader;
+
+typedef struct{
+    byte     ip_hl_v;
+    byte     ip_tos;
+    word     ip_len;
+    word     ip_id;
+    word     ip_off;
+    byte     ip_ttl;
+    byte     ip_p;
+    word     ip_sum;
+    longword ip_src;
+    longword ip_dst;
+}TCaptureIPHeader;
+
+typedef struct{
+    word     th_sport;
+    word     th_dport;
+    longword th_seq;
+    longword th_ack;
+    byte     th_off;
+    byte     th_flags;
+    word     th_win;
+    word     th_sum;
+    word     th_urp;
+}TCaptureTCPHeader;
+
+#pragma pack()
+
+//---------------------------------------------------------------------------
+// WRITER
+//---------------------------------------------------------------------------
+class TSnapCapture
+{
+private:
+    FILE *FFile;
+    char *FBuffer;
+    word FId;
+    PSnapCriticalSection CS;
+    word IPChecksum(TCaptureIPHeader &Header);
+public:
+    longword Frames;
+    TSnapCapture();
+    ~TSnapCapture();
+    // Creates the file (an existing one is overwritten) and writes the pcap header
+    bool Open(const char *FileName);
+    void Close();
+    bool Active();
+    // Writes a frame, Addresses and Ports are in network byte order as in sockaddr_in
+    void WriteFrame(longword SrcAddr, word SrcPort, longword DstAddr, word DstPort,
+      longword Seq, longword Ack, byte Flags, void *Data, int Size);
+};
+typedef TSnapCapture *PSnapCapture;
+
+//---------------------------------------------------------------------------
+// READER
+//---------------------------------------------------------------------------
+typedef struct{
+    int      Session;    // TCP session index, in order of appearance
+    bool     FromClient; // true if the telegram was sent by the active side
+    int64_t  Time;       // Timestamp in microseconds (as recorded)
+    longword Offset;     // Offset of the telegram bytes into the data pool
+    int      Size;       // Size of the telegram (TPKT header included)
+}TCaptureTelegram, *PCaptureTelegram;
+
+typedef struct{
+    longword NextSeq;
+    bool     Synced;
+    bool     Fin;
+    pbyte    Buffer;
+    int      Size;
+}TCaptureFlow;
+
+typedef struct{
+    longword ClientAddr;
+    longword ServerAddr;
+    word     ClientPort;
+    word     ServerPort;
+    bool     Closed;
+    TCaptureFlow Flow[2]; // 0 : Client->Server, 1 : Server->Client
+}TCaptureSession, *PCaptureSession;
+
+class TCaptureReader
+{
+private:
+    pbyte FPool;
+    longword FPoolSize;
+    longword FPoolCapacity;
+    PCaptureTelegram FTelegrams;
+    int FCapacity;
+    PCaptureSession FSessions[MaxCaptureSessions];
+    void AddTelegram(int Session, bool FromClient, int64_t Time, pbyte Data, int Size);
+    void AddSegment(int Session, int Direction, int64_t Time, longword Seq, pbyte Data, int Size);
+    void CloseSession(int Session);
+    void ProcessPacket(int64_t Time, pbyte Packet, int Size);
+public:
+    int Count;    // Telegrams
+    int Sessions; // TCP sessions
+    TCaptureReader();
+    ~TCaptureReader();
+    // Returns false if the file cannot be opened or it's not a pcap file
+    bool LoadFromFile(const char *FileName);
+    void Clear();
+    PCaptureTelegram Telegram(int Index);
+    pbyte Data(int Index);
+};
+typedef TCaptureReader *PCaptureReader;
+
+#endif // snap_capture_h
@@ -95,11 +95,18 @@ TMsgSocket::TMsgSocket()
     FSocket=INVALID_SOCKET;
     LastTcpError=0;
     LocalBind=0;
+    FCapture=NULL;
+    FCapSeqOut=0;
+    FCapSeqIn=0;
+#ifdef NON_BLOCKING_CONNECT
+    FConnectFlags=0;
+#endif
 }
 //---------------------------------------------------------------------------
 TMsgSocket::~TMsgSocket()
 {
     DestroySocket();
+    StopCapture();
     delete Pinger;
 }
 //---------------------------------------------------------------------------
@@ -168,6 +175,8 @@ void TMsgSocket::Purge()
            do
            {
                Read=recv(FSocket, Trash, 512, MSG_NOSIGNAL );
+               if (FCapture!=NULL && Read>0)
+                   CaptureIn(Trash, Read);
            } while(Read==512);
         }
     }
@@ -237,7 +246,8 @@ int TMsgSocket::WaitingData()
 //---------------------------------------------------------------------------
 int TMsgSocket::WaitForData(int Size, int Timeout)
 {
-    longword Elapsed;
+    uint64_t Deadline, Now;
+    int Waiting;
 
     // Check for connection active
     if (CanRead(0) && (WaitingData()==0))
@@ -248,14 +258,23 @@ int TMsgSocket::WaitForData(int Size, int Timeout)
     // Enter main loop
     if (LastTcpError==0)
     {
-        Elapsed =SysGetTick();
-        while((WaitingData()<Size) && (LastTcpError==0))
+        Deadline=SysGetTickNs()+uint64_t(longword(Timeout))*1000000;
+        while(((Waiting=WaitingData())<Size) && (LastTcpError==0))
         {
             // Checks timeout
-            if (DeltaTime(Elapsed)>=(longword)(Timeout))
+            Now=SysGetTickNs();
+            if (Now>=Deadline)
                 LastTcpError =WSAETIMEDOUT;
             else
-                SysSleep(1);
+                if (Waiting==0)
+                {
+                    // Sleeps in select() until the first byte (instead of polling),
+                    // readable with nothing to read means that the peer closed
+                    if (CanReadUs((Deadline-Now)/1000) && (WaitingData()==0))
+                        LastTcpError=WSAECONNRESET;
+                }
+                else
+                    SysSleepUs(PartialDataWait); // the rest of the packet is on its way
         }
     }
     if(LastTcpError==WSAECONNRESET)
@@ -308,6 +327,11 @@ bool TMsgSocket::CanWrite(int Timeout)
 }
 //---------------------------------------------------------------------------
 bool TMsgSocket::CanRead(int Timeout)
+{
+    return CanReadUs(uint64_t(longword(Timeout))*1000);
+}
+//---------------------------------------------------------------------------
+bool TMsgSocket::CanReadUs(uint64_t Timeout_us)
 {
     timeval TimeV;
     int64_t x;
@@ -316,8 +340,8 @@ bool TMsgSocket::CanRead(int Timeout)
 	if(FSocket == INVALID_SOCKET)
 		return false;
 
-	TimeV.tv_usec = (Timeout % 1000) * 1000;
-    TimeV.tv_sec = Timeout / 1000;
+	TimeV.tv_usec = long(Timeout_us % 1000000);
+    TimeV.tv_sec = long(Timeout_us / 1000000);
 
     FD_ZERO(&FDset);
     FD_SET(FSocket, &FDset);
@@ -335,74 +359,23 @@ bool TMsgSocket::CanRead(int Timeout)
 //
 // Non blocking connection (UNIX) Thanks to Rolf Stalder
 //
-int TMsgSocket::SckConnect()
+int TMsgSocket::SckConnectStart()
 {
-	int n, flags, err;
-	socklen_t len;
-	fd_set rset, wset;
-	struct timeval tval;
+	int n;
 
  	SetSin(RemoteSin, RemoteAddress, RemotePort);
+	Connected=false;
 
 	if (LastTcpError == 0) {
 		CreateSocket();
 		if (LastTcpError == 0) {
-			flags = fcntl(FSocket, F_GETFL, 0);
-			if (flags >= 0) {
-				if (fcntl(FSocket, F_SETFL, flags | O_NONBLOCK)  != -1) {
+			FConnectFlags = fcntl(FSocket, F_GETFL, 0);
+			if (FConnectFlags >= 0) {
+				if (fcntl(FSocket, F_SETFL, FConnectFlags | O_NONBLOCK)  != -1) {
 					n = connect(FSocket, (struct sockaddr*)&RemoteSin, sizeof(RemoteSin));
-					if (n < 0) {
-						if (errno != EINPROGRESS) {
-							LastTcpError = GetLastSocketError();
-						}
-						else {
-							// still connecting ... 
-							FD_ZERO(&rset);
-							FD_SET(FSocket, &rset);
-							wset = rset;
-							tval.tv_sec = PingTimeout / 1000;
-							tval.tv_usec = (PingTimeout % 1000) * 1000;
-
-							n = select(FSocket+1, &rset, &wset, NULL, 
-							           (PingTimeout ? &tval : NULL));
-							if (n == 0) {
-								// timeout
-								LastTcpError = WSAEHOSTUNREACH;
-							}
-							else {
-								if (FD_ISSET(FSocket, &rset) || FD_ISSET(FSocket, &wset)) {
-									err = 0;
-									len = sizeof(err);						
-									if (getsockopt(
-									      FSocket, SOL_SOCKET, SO_ERROR, &err, &len) == 0) {
-										if (err) {
-											 LastTcpError = err;
-										}
-										else {
-											if (fcntl(FSocket, F_SETFL, flags) != -1) {
-												GetLocal();
-												ClientHandle = LocalSin.sin_addr.s_addr;
-											}
-											else {
-												LastTcpError = GetLastSocketError();
-											}
-										}
-									}
-									else {
-										LastTcpError = GetLastSocketError();
-									}
-								}
-								else {
-									LastTcpError = -1;
-								}
-							}
-						} // still connecting
-					} 
-					else if (n == 0) { 
-						// connected immediatly
-						GetLocal();
-						ClientHandle = LocalSin.sin_addr.s_addr;
-					}
+					// EINPROGRESS : still connecting, the socket becomes writable when done
+					if ((n < 0) && (errno != EINPROGRESS))
+						LastTcpError = GetLastSocketError();
 				}
 				else {
 					LastTcpError = GetLastSocketError();
@@ -413,7 +386,67 @@ int TMsgSocket::SckConnect()
 			} // fcntl(F_GETFL)
 		} //valid socket 
 	} // LastTcpError==0
+	return LastTcpError;
+}
+//---------------------------------------------------------------------------
+int TMsgSocket::SckConnectDone()
+{
+	int err;
+	socklen_t len;
+
+	err = 0;
+	len = sizeof(err);
+	if (getsockopt(FSocket, SOL_SOCKET, SO_ERROR, &err, &len) == 0) {
+		if (err) {
+			 LastTcpError = err;
+		}
+		else {
+			if (fcntl(FSocket, F_SETFL, FConnectFlags) != -1) {
+				GetLocal();
+				ClientHandle = LocalSin.sin_addr.s_addr;
+			}
+			else {
+				LastTcpError = GetLastSocketError();
+			}
+		}
+	}
+	else {
+		LastTcpError = GetLastSocketError();
+	}
 	Connected=LastTcpError==0;
+	if (Connected && FCapture!=NULL)
+		CaptureConnect();
+ 	return LastTcpError;
+}
+//---------------------------------------------------------------------------
+int TMsgSocket::SckConnect()
+{
+	int n;
+	fd_set rset, wset;
+	struct timeval tval;
+
+	if (SckConnectStart() == 0) {
+		// still connecting ... 
+		FD_ZERO(&rset);
+		FD_SET(FSocket, &rset);
+		wset = rset;
+		tval.tv_sec = PingTimeout / 1000;
+		tval.tv_usec = (PingTimeout % 1000) * 1000;
+
+		n = select(FSocket+1, &rset, &wset, NULL, 
+		           (PingTimeout ? &tval : NULL));
+		if (n == 0) {
+			// timeout
+			LastTcpError = WSAEHOSTUNREACH;
+		}
+		else {
+			if (FD_ISSET(FSocket, &rset) || FD_ISSET(FSocket, &wset))
+				return SckConnectDone();
+			else
+				LastTcpError = -1;
+		}
+	}
+	Connected=false;
  	return LastTcpError;
 }
 #else
@@ -444,12 +477,16 @@ int TMsgSocket::SckConnect()
             LastTcpError=WSAEHOSTUNREACH;
     }
     Connected=LastTcpError==0;
+    if (Connected && FCapture!=NULL)
+        CaptureConnect();
     return LastTcpError;
 }
 #endif
 //---------------------------------------------------------------------------
 void TMsgSocket::SckDisconnect()
 {
+    if (Connected && FCapture!=NULL)
+        CaptureOut(NULL, 0, tcpFIN | tcpACK);
     DestroySocket();
     Connected=false;
 }
@@ -540,7 +577,11 @@ int TMsgSocket::SendPacket(void *Data, int Size)
         }
     }
     if (send(FSocket, (char*)Data, Size, MSG_NOSIGNAL)==Size)
+    {
+        if (FCapture!=NULL)
+            CaptureOut(Data, Size, tcpPSH | tcpACK);
         return 0;
+    }
     else
         Result =SOCKET_ERROR;
 
@@ -561,7 +602,11 @@ int TMsgSocket::Receive(void *Data, int BufSize, int &SizeRecvd)
         SizeRecvd=recv(FSocket ,(char*)Data ,BufSize ,MSG_NOSIGNAL );
 
         if (SizeRecvd>0) // something read (default case)
+        {
            LastTcpError=0;
+           if (FCapture!=NULL)
+               CaptureIn(Data, SizeRecvd);
+        }
         else
             if (SizeRecvd==0)
                 LastTcpError = WSAECONNRESET;  // Connection reset by Peer
@@ -589,6 +634,9 @@ int TMsgSocket::RecvPacket(void *Data, int Size)
         else
             if (BytesRead<0)
                 LastTcpError = GetLastSocketError();
+            else
+                if (FCapture!=NULL)
+                    CaptureIn(Data, BytesRead);
     }
     else // After the timeout the bytes waiting were less then we expected
         if (LastTcpError==WSAETIMEDOUT)
@@ -623,6 +671,57 @@ int TMsgSocket::PeekPacket(void *Data, int Size)
     return LastTcpError;
 }
 //---------------------------------------------------------------------------
+bool TMsgSocket::StartCapture(const char *FileName)
+{
+    StopCapture();
+    FCapture=new TSnapCapture();
+    if (!FCapture->Open(FileName))
+    {
+        StopCapture();
+        return false;
+    }
+    // Sequence numbers are relative to the connection (SYN = 0)
+    FCapSeqOut=1;
+    FCapSeqIn=1;
+    return true;
+}
+//---------------------------------------------------------------------------
+void TMsgSocket::StopCapture()
+{
+    if (FCapture!=NULL)
+    {
+        delete FCapture;
+        FCapture=NULL;
+    }
+}
+//---------------------------------------------------------------------------
+void TMsgSocket::CaptureConnect()
+{
+    // The handshake is synthesized so the reader knows who is the active side
+    FCapSeqOut=0;
+    FCapSeqIn=0;
+    FCapture->WriteFrame(LocalSin.sin_addr.s_addr, LocalSin.sin_port,
+      RemoteSin.sin_addr.s_addr, RemoteSin.sin_port, 0, 0, tcpSYN, NULL, 0);
+    FCapture->WriteFrame(RemoteSin.sin_addr.s_addr, RemoteSin.sin_port,
+      LocalSin.sin_addr.s_addr, LocalSin.sin_port, 0, 1, tcpSYN | tcpACK, NULL, 0);
+    FCapSeqOut=1;
+    FCapSeqIn=1;
+}
+//---------------------------------------------------------------------------
+void TMsgSocket::CaptureOut(void *Data, int Size, byte Flags)
+{
+    FCapture->WriteFrame(LocalSin.sin_addr.s_addr, LocalSin.sin_port,
+      RemoteSin.sin_addr.s_addr, RemoteSin.sin_port, FCapSeqOut, FCapSeqIn, Flags, Data, Size);
+    FCapSeqOut+=Size;
+}
+//---------------------------------------------------------------------------
+void TMsgSocket::CaptureIn(void *Data, int Size)
+{
+    FCapture->WriteFrame(RemoteSin.sin_addr.s_addr, RemoteSin.sin_port,
+      LocalSin.sin_addr.s_addr, LocalSin.sin_port, FCapSeqIn, FCapSeqOut, tcpPSH | tcpACK, Data, Size);
+    FCapSeqIn+=Size;
+}
+//---------------------------------------------------------------------------
 bool TMsgSocket::Execute()
 {
     return true;
@@ -28,6 +28,7 @@
 //---------------------------------------------------------------------------
 #include "snap_platform.h"
 #include "snap_sysutils.h"
+#include "snap_capture.h"
 //----------------------------------------------------------------------------
 #if defined(OS_WINDOWS) || defined (OS_SOLARIS) || defined(OS_OSX)
 # define MSG_NOSIGNAL    0
@@ -69,6 +70,7 @@ typedef int socket_t;
 #define  SD_SEND         0x01
 #define  SD_BOTH         0x02
 #define  MaxPacketSize   65536
+#define  PartialDataWait 50     // us, WaitForData() pause while a packet is arriving
 
 //----------------------------------------------------------------------------
 // For other platform we need to re-define next constants
@@ -236,6 +238,17 @@ class TMsgSocket : public TSnapBase
 {
 private:
         PPinger Pinger;
+        // Wire level capture (NULL if disabled)
+        PSnapCapture FCapture;
+        longword FCapSeqOut;
+        longword FCapSeqIn;
+#ifdef NON_BLOCKING_CONNECT
+        // Socket flags to restore once a non blocking connect is done
+        int FConnectFlags;
+#endif
+        void CaptureConnect();
+        void CaptureOut(void *Data, int Size, byte Flags);
+        void CaptureIn(void *Data, int Size);
         int GetLastSocketError();
         int SockCheck(int SockResult);
         void DestroySocket();
@@ -290,8 +303,17 @@ public:
         virtual ~TMsgSocket();
         // Returns true if "something" can be read during the Timeout interval..
         bool CanRead(int Timeout);
+        // The same with the Timeout in microseconds
+        bool CanReadUs(uint64_t Timeout_us);
         // Connects to a peer (using RemoteAddress and RemotePort)
         int SckConnect(); // (client-side)
+#ifdef NON_BLOCKING_CONNECT
+        // SckConnect() in two steps, to wait for many connections at once :
+        // SckConnectStart() starts a non blocking connect, when the socket becomes
+        // writable SckConnectDone() completes it (PingTimeout is not applied)
+        int SckConnectStart();
+        int SckConnectDone();
+#endif
         // Disconnects from a peer (gracefully)
         void SckDisconnect();
         // Disconnects RAW
@@ -302,6 +324,7 @@ public:
         int SckListen();
         // Set an external socket reference (tipically from a listener)
         void SetSocket(socket_t s);
+        socket_t GetSocket(){ return FSocket; }
         // Accepts an incoming connection returning a socket descriptor (server-side)
         socket_t SckAccept();
         // Pings the peer before connecting
@@ -317,6 +340,9 @@ public:
         int RecvPacket(void *Data, int Size);
         // Peeks a packet of size specified without extract it from the socket queue
         int PeekPacket(void *Data, int Size);
+        // Starts writing everything sent and received into a pcap file
+        bool StartCapture(const char *FileName);
+        void StopCapture();
         virtual bool Execute();
 };
 
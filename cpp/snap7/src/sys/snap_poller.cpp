@@ -0,0 +1,280 @@
+/*=============================================================================|
+|  PROJECT SNAP7                                                         1.3.0 |
+|==============================================================================|
+|  Copyright (C) 2013, 2015 Davide Nardella                                    |
+|  All rights reserved.                                                        |
+|==============================================================================|
+|  SNAP7 is free software: you can redistribute it and/or modify               |
+|  it under the terms of the Lesser GNU General Public License as published by |
+|  the Free Software Foundation, either version 3 of the License, or           |
+|  (at your option) any later version.                                         |
+|                                                                              |
+|  It means that you can distribute your commercial software linked with       |
+|  SNAP7 without the requirement to distribute the source code of your         |
+|  application and without the requirement that your application be itself     |
+|  distributed under LGPL.                                                     |
+|                                                                              |
+|  SNAP7 is distributed in the hope that it will be useful,                    |
+|  but WITHOUT ANY WARRANTY; without even the implied warranty of              |
+|  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the               |
+|  Lesser GNU General Public License for more details.                         |
+|                                                                              |
+|  You should have received a copy of the GNU General Public License and a     |
+|  copy of Lesser GNU General Public License along with Snap7.                 |
+|  If not, see  http://www.gnu.org/licenses/                                   |
+|=============================================================================*/
+#include "snap_poller.h"
+#include "snap_sysutils.h"
+
+#ifdef SNAP_POLLER_EPOLL
+# include <sys/epoll.h>
+# include <sys/eventfd.h>
+#endif
+#ifdef SNAP_POLLER_SELECT
+# include <fcntl.h>
+#endif
+
+#ifdef SNAP_POLLER_EPOLL
+//---------------------------------------------------------------------------
+// EPOLL
+//---------------------------------------------------------------------------
+TSnapPoller::TSnapPoller()
+{
+    epoll_event Event;
+
+    Count=0;
+    FEpoll=epoll_create1(EPOLL_CLOEXEC);
+    FWake=eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if ((FEpoll!=-1) && (FWake!=-1))
+    {
+        memset(&Event,0,sizeof(Event));
+        Event.events=EPOLLIN;
+        Event.data.u64=0; // Tag -1 is the wake event
+        epoll_ctl(FEpoll, EPOLL_CTL_ADD, FWake, &Event);
+    }
+}
+//---------------------------------------------------------------------------
+TSnapPoller::~TSnapPoller()
+{
+    if (FWake!=-1)
+        close(FWake);
+    if (FEpoll!=-1)
+        close(FEpoll);
+}
+//---------------------------------------------------------------------------
+bool TSnapPoller::Valid()
+{
+    return (FEpoll!=-1) && (FWake!=-1);
+}
+//---------------------------------------------------------------------------
+bool TSnapPoller::Insert(socket_t Sock, int Tag, bool Writable)
+{
+    epoll_event Event;
+
+    memset(&Event,0,sizeof(Event));
+    Event.events=Writable ? EPOLLOUT : EPOLLIN;
+    Event.data.u64=uint64_t(Tag)+1;
+    if (epoll_ctl(FEpoll, EPOLL_CTL_ADD, Sock, &Event)!=0)
+        return false;
+    Count++;
+    return true;
+}
+//---------------------------------------------------------------------------
+void TSnapPoller::Remove(socket_t Sock)
+{
+    epoll_event Event; // Kernels before 2.6.9 want it even if unused
+
+    // A closed socket was already removed by the kernel
+    if (epoll_ctl(FEpoll, EPOLL_CTL_DEL, Sock, &Event)==0 || errno==EBADF || errno==ENOENT)
+        if (Count>0)
+            Count--;
+}
+//---------------------------------------------------------------------------
+void TSnapPoller::Drain()
+{
+    uint64_t Value;
+    while (read(FWake, &Value, sizeof(Value))==sizeof(Value)) {};
+}
+//---------------------------------------------------------------------------
+int TSnapPoller::Wait(int Timeout, int *Ready, int MaxReady)
+{
+    epoll_event Events[64];
+    int c, n, Result;
+
+    if (MaxReady>64)
+        MaxReady=64;
+    n=epoll_wait(FEpoll, Events, MaxReady, Timeout);
+    Result=0;
+    for (c = 0; c < n; c++)
+    {
+        if (Events[c].data.u64==0)
+            Drain();
+        else
+            Ready[Result++]=int(Events[c].data.u64-1);
+    }
+    return Result;
+}
+//---------------------------------------------------------------------------
+void TSnapPoller::Wake()
+{
+    uint64_t Value = 1;
+    if (write(FWake, &Value, sizeof(Value))!=sizeof(Value)) {}; // already signaled
+}
+#endif // SNAP_POLLER_EPOLL
+
+#ifdef SNAP_POLLER_SELECT
+//---------------------------------------------------------------------------
+// SELECT
+//---------------------------------------------------------------------------
+TSnapPoller::TSnapPoller()
+{
+    Count=0;
+    if (pipe(FWake)==0)
+    {
+        fcntl(FWake[0], F_SETFL, fcntl(FWake[0], F_GETFL, 0) | O_NONBLOCK);
+        fcntl(FWake[1], F_SETFL, fcntl(FWake[1], F_GETFL, 0) | O_NONBLOCK);
+    }
+    else
+        FWake[0]=FWake[1]=-1;
+}
+//---------------------------------------------------------------------------
+TSnapPoller::~TSnapPoller()
+{
+    if (FWake[0]!=-1)
+    {
+        close(FWake[0]);
+        close(FWake[1]);
+    }
+}
+//---------------------------------------------------------------------------
+bool TSnapPoller::Valid()
+{
+    return FWake[0]!=-1;
+}
+//---------------------------------------------------------------------------
+bool TSnapPoller::Insert(socket_t Sock, int Tag, bool Writable)
+{
+    if ((Count>=MaxPollerSockets) || (Sock>=FD_SETSIZE))
+        return false;
+    FSockets[Count]=Sock;
+    FTags[Count]=Tag;
+    FWritable[Count]=Writable;
+    Count++;
+    return true;
+}
+//---------------------------------------------------------------------------
+void TSnapPoller::Remove(socket_t Sock)
+{
+    int c;
+    for (c = 0; c < Count; c++)
+    {
+        if (FSockets[c]==Sock)
+        {
+            Count--;
+            FSockets[c]=FSockets[Count];
+            FTags[c]=FTags[Count];
+            FWritable[c]=FWritable[Count];
+            break;
+        }
+    }
+}
+//---------------------------------------------------------------------------
+void TSnapPoller::Drain()
+{
+    byte Buffer[64];
+    while (read(FWake[0], Buffer, sizeof(Buffer))>0) {};
+}
+//---------------------------------------------------------------------------
+int TSnapPoller::Wait(int Timeout, int *Ready, int MaxReady)
+{
+    fd_set FDset, WDset;
+    timeval TimeV;
+    socket_t MaxSock;
+    int c, Result;
+
+    FD_ZERO(&FDset);
+    FD_ZERO(&WDset);
+    FD_SET(FWake[0], &FDset);
+    MaxSock=FWake[0];
+    for (c = 0; c < Count; c++)
+    {
+        if (FWritable[c])
+            FD_SET(FSockets[c], &WDset);
+        else
+            FD_SET(FSockets[c], &FDset);
+        if (FSockets[c]>MaxSock)
+            MaxSock=FSockets[c];
+    }
+    TimeV.tv_sec = Timeout / 1000;
+    TimeV.tv_usec = (Timeout % 1000) * 1000;
+
+    Result=0;
+    if (select(MaxSock + 1, &FDset, &WDset, NULL, &TimeV)>0)
+    {
+        if (FD_ISSET(FWake[0], &FDset))
+            Drain();
+        for (c = 0; (c < Count) && (Result < MaxReady); c++)
+            if (FD_ISSET(FSockets[c], FWritable[c] ? &WDset : &FDset))
+                Ready[Result++]=FTags[c];
+    }
+    return Result;
+}
+//---------------------------------------------------------------------------
+void TSnapPoller::Wake()
+{
+    byte Value = 1;
+    if (write(FWake[1], &Value, 1)!=1) {}; // pipe full : already signaled
+}
+#endif // SNAP_POLLER_SELECT
+
+#ifdef OS_WINDOWS
+//---------------------------------------------------------------------------
+// Not available
+//---------------------------------------------------------------------------
+TSnapPoller::TSnapPoller()
+{
+    Count=0;
+}
+//---------------------------------------------------------------------------
+TSnapPoller::~TSnapPoller()
+{
+}
+//---------------------------------------------------------------------------
+bool TSnapPoller::Valid()
+{
+    return false;
+}
+//---------------------------------------------------------------------------
+bool TSnapPoller::Insert(socket_t Sock, int Tag, bool Writable)
+{
+    return false;
+}
+//---------------------------------------------------------------------------
+void TSnapPoller::Remove(socket_t Sock)
+{
+}
+//---------------------------------------------------------------------------
+void TSnapPoller::Drain()
+{
+}
+//---------------------------------------------------------------------------
+int TSnapPoller::Wait(int Timeout, int *Ready, int MaxReady)
+{
+    SysSleep(Timeout);
+    return 0;
+}
+//---------------------------------------------------------------------------
+void TSnapPoller::Wake()
+{
+}
+#endif // OS_WINDOWS
+//---------------------------------------------------------------------------
+bool TSnapPoller::Add(socket_t Sock, int Tag)
+{
+    return Insert(Sock, Tag, false);
+}
+//---------------------------------------------------------------------------
+bool TSnapPoller::AddWritable(socket_t Sock, int Tag)
+{
+    return Insert(Sock, Tag, true);
+}
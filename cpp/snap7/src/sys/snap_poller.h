@@ -0,0 +1,79 @@
+/*=============================================================================|
+|  PROJECT SNAP7                                                         1.3.0 |
+|==============================================================================|
+|  Copyright (C) 2013, 2015 Davide Nardella                                    |
+|  All rights reserved.                                                        |
+|==============================================================================|
+|  SNAP7 is free software: you can redistribute it and/or modify               |
+|  it under the terms of the Lesser GNU General Public License as published by |
+|  the Free Software Foundation, either version 3 of the License, or           |
+|  (at your option) any later version.                                         |
+|                                                                              |
+|  It means that you can distribute your commercial software linked with       |
+|  SNAP7 without the requirement to distribute the source code of your         |
+|  application and without the requirement that your application be itself     |
+|  distributed under LGPL.                                                     |
+|                                                                              |
+|  SNAP7 is distributed in the hope that it will be useful,                    |
+|  but WITHOUT ANY WARRANTY; without even the implied warranty of              |
+|  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the               |
+|  Lesser GNU General Public License for more details.                         |
+|                                                                              |
+|  You should have received a copy of the GNU General Public License and a     |
+|  copy of Lesser GNU General Public License along with Snap7.                 |
+|  If not, see  http://www.gnu.org/licenses/                                   |
+|=============================================================================*/
+#ifndef snap_poller_h
+#define snap_poller_h
+//---------------------------------------------------------------------------
+#include "snap_platform.h"
+#include "snap_msgsock.h"
+//---------------------------------------------------------------------------
+// Readiness multiplexer for many sockets served by one thread.
+//
+// Every socket is added with a Tag (chosen by the caller, e.g. a slot index)
+// that Wait() returns when the socket can be read, or written if it was added
+// with AddWritable() (e.g. a connect in progress). Wake() can be called by any
+// thread to make a pending Wait() return early.
+//
+// Linux uses epoll (level triggered) and an eventfd, the other unix flavours
+// select and a pipe. Not available under Windows (Valid() returns false).
+//---------------------------------------------------------------------------
+#if defined(__linux__)
+# define SNAP_POLLER_EPOLL
+#elif !defined(OS_WINDOWS)
+# define SNAP_POLLER_SELECT
+#endif
+
+const int MaxPollerSockets = 1024;
+
+class TSnapPoller
+{
+private:
+#ifdef SNAP_POLLER_EPOLL
+    int FEpoll;
+    int FWake;
+#endif
+#ifdef SNAP_POLLER_SELECT
+    int FWake[2];
+    socket_t FSockets[MaxPollerSockets];
+    int FTags[MaxPollerSockets];
+    bool FWritable[MaxPollerSockets];
+#endif
+    void Drain();
+    bool Insert(socket_t Sock, int Tag, bool Writable);
+public:
+    int Count;
+    TSnapPoller();
+    ~TSnapPoller();
+    bool Valid();
+    bool Add(socket_t Sock, int Tag);
+    bool AddWritable(socket_t Sock, int Tag);
+    void Remove(socket_t Sock);
+    // Waits up to Timeout ms, returns the number of Tags stored into Ready
+    int Wait(int Timeout, int *Ready, int MaxReady);
+    void Wake();
+};
+typedef TSnapPoller *PSnapPoller;
+
+#endif // snap_poller_h
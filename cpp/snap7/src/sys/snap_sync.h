@@ -0,0 +1,211 @@
+/*=============================================================================|
+|  PROJECT SNAP7                                                         1.3.0 |
+|==============================================================================|
+|  Copyright (C) 2013, 2015 Davide Nardella                                    |
+|  All rights reserved.                                                        |
+|==============================================================================|
+|  SNAP7 is free software: you can redistribute it and/or modify               |
+|  it under the terms of the Lesser GNU General Public License as published by |
+|  the Free Software Foundation, either version 3 of the License, or           |
+|  (at your option) any later version.                                         |
+|                                                                              |
+|  It means that you can distribute your commercial software linked with       |
+|  SNAP7 without the requirement to distribute the source code of your         |
+|  application and without the requirement that your application be itself     |
+|  distributed under LGPL.                                                     |
+|                                                                              |
+|  SNAP7 is distributed in the hope that it will be useful,                    |
+|  but WITHOUT ANY WARRANTY; without even the implied warranty of              |
+|  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the               |
+|  Lesser GNU General Public License for more details.                         |
+|                                                                              |
+|  You should have received a copy of the GNU General Public License and a     |
+|  copy of Lesser GNU General Public License along with Snap7.                 |
+|  If not, see  http://www.gnu.org/licenses/                                   |
+|=============================================================================*/
+#ifndef snap_sync_h
+#define snap_sync_h
+//---------------------------------------------------------------------------
+#include "snap_platform.h"
+#include "snap_threads.h"
+//---------------------------------------------------------------------------
+// LIGHTWEIGHT SYNCHRONIZATION
+//
+// TSnapLightMutex : non recursive lock that spins a little before parking the
+//                   thread, for the short critical sections of the hot paths
+//                   (area copies, event queue).
+// TSnapLightEvent : same interface of TSnapEvent, for the job hand-off between
+//                   two threads.
+//
+// Under Linux both are an atomic word plus a futex: an uncontended Enter/Leave
+// or a Set with nobody waiting never enters the kernel, and a waiter is woken
+// by a single syscall instead of a mutex + condvar round. Elsewhere they are
+// the platform TSnapCriticalSection and TSnapEvent (recursive under Windows).
+//---------------------------------------------------------------------------
+#if defined(__linux__)
+
+#include <atomic>
+#include <climits>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+
+// Tries before parking (a few us), none on a single CPU where spinning only
+// delays the thread we are waiting for
+static inline int SyncSpinCount()
+{
+    static const int Count = sysconf(_SC_NPROCESSORS_ONLN) > 1 ? 100 : 0;
+    return Count;
+}
+
+static inline void SyncSpinPause()
+{
+#if defined(__i386__) || defined(__x86_64__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    __asm__ __volatile__("yield");
+#endif
+}
+
+// Parks the thread while *Addr == Value (Timeout NULL = forever)
+static inline void FutexWait(std::atomic<int> *Addr, int Value, const timespec *Timeout)
+{
+    syscall(SYS_futex, reinterpret_cast<int *>(Addr), FUTEX_WAIT_PRIVATE, Value, Timeout, NULL, 0);
+}
+
+static inline void FutexWake(std::atomic<int> *Addr, int Count)
+{
+    syscall(SYS_futex, reinterpret_cast<int *>(Addr), FUTEX_WAKE_PRIVATE, Count, NULL, NULL, 0);
+}
+
+class TSnapLightMutex
+{
+private:
+    std::atomic<int> State; // 0 free, 1 locked, 2 locked with (possible) waiters
+public:
+    TSnapLightMutex() : State(0) {};
+
+    void Enter()
+    {
+        int c = 0;
+        if (State.compare_exchange_strong(c, 1, std::memory_order_acquire, std::memory_order_relaxed))
+            return;
+        // Spin while nobody is parked, the owner may leave soon
+        for (int i = 0; i < SyncSpinCount() && c != 2; i++)
+        {
+            SyncSpinPause();
+            c = 0;
+            if (State.compare_exchange_weak(c, 1, std::memory_order_acquire, std::memory_order_relaxed))
+                return;
+        }
+        // Mark the waiters and park until the owner leaves
+        if (c != 2)
+            c = State.exchange(2, std::memory_order_acquire);
+        while (c != 0)
+        {
+            FutexWait(&State, 2, NULL);
+            c = State.exchange(2, std::memory_order_acquire);
+        }
+    };
+
+    void Leave()
+    {
+        if (State.exchange(0, std::memory_order_release) == 2)
+            FutexWake(&State, 1);
+    };
+
+    bool TryEnter()
+    {
+        int c = 0;
+        return State.compare_exchange_strong(c, 1, std::memory_order_acquire, std::memory_order_relaxed);
+    };
+};
+
+class TSnapLightEvent
+{
+private:
+    std::atomic<int> State;   // 0 not signaled, 1 signaled
+    std::atomic<int> Waiters; // Threads parked (or about to) on State
+    bool AutoReset;
+
+    bool TryTake()
+    {
+        // seq_cst, pairs with Set() once Waiters is raised
+        if (!AutoReset)
+            return State.load() == 1;
+        int c = 1;
+        return State.compare_exchange_strong(c, 0);
+    };
+public:
+    TSnapLightEvent(bool ManualReset) : State(0), Waiters(0)
+    {
+        AutoReset = !ManualReset;
+    };
+
+    void Set()
+    {
+        // seq_cst store and load : either we see the waiter or the waiter sees the state
+        State.store(1);
+        if (Waiters.load() > 0)
+            FutexWake(&State, AutoReset ? 1 : INT_MAX);
+    };
+
+    void Reset()
+    {
+        State.store(0, std::memory_order_release);
+    };
+
+    longword WaitForever()
+    {
+        return WaitFor(-1);
+    };
+
+    // Timeout in ms, <0 waits forever, 0 is treated as 1 (as TSnapEvent does)
+    longword WaitFor(int64_t Timeout)
+    {
+        if (TryTake())
+            return WAIT_OBJECT_0;
+        for (int i = 0; i < SyncSpinCount(); i++)
+        {
+            SyncSpinPause();
+            if (TryTake())
+                return WAIT_OBJECT_0;
+        }
+        if (Timeout == 0)
+            Timeout = 1;
+        uint64_t Deadline = Timeout > 0 ? SysGetTickUs() + uint64_t(Timeout) * 1000 : 0;
+        longword Result = WAIT_OBJECT_0;
+        Waiters.fetch_add(1);
+        while (!TryTake())
+        {
+            if (Timeout > 0)
+            {
+                uint64_t Now = SysGetTickUs();
+                if (Now >= Deadline)
+                {
+                    Result = WAIT_TIMEOUT;
+                    break;
+                }
+                timespec ts;
+                ts.tv_sec = time_t((Deadline - Now) / 1000000);
+                ts.tv_nsec = long((Deadline - Now) % 1000000) * 1000;
+                FutexWait(&State, 0, &ts);
+            }
+            else
+                FutexWait(&State, 0, NULL);
+        }
+        Waiters.fetch_sub(1);
+        return Result;
+    };
+};
+
+#else
+
+typedef TSnapCriticalSection TSnapLightMutex;
+typedef TSnapEvent TSnapLightEvent;
+
+#endif
+
+typedef TSnapLightMutex *PSnapLightMutex;
+typedef TSnapLightEvent *PSnapLightEvent;
+
+#endif // snap_sync_h
@@ -39,17 +39,33 @@ int clock_gettime(int clk_id, struct timespec* t)
 #endif
 
 //---------------------------------------------------------------------------
-longword SysGetTick()
+uint64_t SysGetTickNs()
 {
 #ifdef OS_WINDOWS
-    return timeGetTime();
+    static LARGE_INTEGER Frequency = {{0, 0}};
+    LARGE_INTEGER Counter;
+    if (Frequency.QuadPart==0)
+        QueryPerformanceFrequency(&Frequency);
+    QueryPerformanceCounter(&Counter);
+    return uint64_t(Counter.QuadPart / Frequency.QuadPart) * 1000000000 +
+      uint64_t(Counter.QuadPart % Frequency.QuadPart) * 1000000000 / Frequency.QuadPart;
 #else
     struct timespec ts;
     clock_gettime(CLOCK_MONOTONIC, &ts);
-    return (longword) (ts.tv_sec * 1000) + (ts.tv_nsec / 1000000);
+    return uint64_t(ts.tv_sec) * 1000000000 + ts.tv_nsec;
 #endif
 }
 //---------------------------------------------------------------------------
+uint64_t SysGetTickUs()
+{
+    return SysGetTickNs() / 1000;
+}
+//---------------------------------------------------------------------------
+longword SysGetTick()
+{
+    return longword(SysGetTickNs() / 1000000);
+}
+//---------------------------------------------------------------------------
 void SysSleep(longword Delay_ms)
 {
 #ifdef OS_WINDOWS
@@ -57,7 +73,19 @@ void SysSleep(longword Delay_ms)
 #else
     struct timespec ts;
     ts.tv_sec = (time_t)(Delay_ms / 1000);
-    ts.tv_nsec =(long)((Delay_ms - ts.tv_sec) * 1000000);
+    ts.tv_nsec =(long)((Delay_ms % 1000) * 1000000);
+    nanosleep(&ts, (struct timespec *)0);
+#endif
+}
+//---------------------------------------------------------------------------
+void SysSleepUs(longword Delay_us)
+{
+#ifdef OS_WINDOWS
+	Sleep((Delay_us + 999) / 1000); // Windows sleeps in ms
+#else
+    struct timespec ts;
+    ts.tv_sec = (time_t)(Delay_us / 1000000);
+    ts.tv_nsec =(long)((Delay_us % 1000000) * 1000);
     nanosleep(&ts, (struct timespec *)0);
 #endif
 }
@@ -32,8 +32,13 @@
 # define CLOCK_MONOTONIC 0
 #endif
 
+// Monotonic nanoseconds, the time base of the library (deadlines, execution times)
+uint64_t SysGetTickNs();
+// Same clock in microseconds and in milliseconds (the latter wraps at 32 bit)
+uint64_t SysGetTickUs();
 longword SysGetTick();
 void SysSleep(longword Delay_ms);
+void SysSleepUs(longword Delay_us);
 longword DeltaTime(longword &Elapsed);
 
 #endif // snap_sysutils_h
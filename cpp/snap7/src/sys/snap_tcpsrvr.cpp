@@ -102,6 +102,7 @@ TMsgWorkerThread::TMsgWorkerThread(TMsgSocket *Socket, TCustomMsgServer *Server)
     FreeOnTerminate = true;
     WorkerSocket = Socket;
     FServer = Server;
+    Role = thrServerWorker;
 }
 //---------------------------------------------------------------------------
 void TMsgWorkerThread::Execute() 
@@ -149,6 +150,7 @@ TMsgListenerThread::TMsgListenerThread(TMsgSocket *Listener, TCustomMsgServer *S
     FServer = Server;
     FListener = Listener;
     FreeOnTerminate = false;
+    Role = thrServerListener;
 }
 //---------------------------------------------------------------------------
 
@@ -182,7 +184,7 @@ TCustomMsgServer::TCustomMsgServer()
 {
     strcpy(FLocalAddress, "0.0.0.0");
     CSList = new TSnapCriticalSection();
-    CSEvent = new TSnapCriticalSection();
+    CSEvent = new TSnapLightMutex();
     FEventQueue = new TMsgEventQueue(MaxEvents, sizeof (TSrvEvent));
     memset(Workers, 0, sizeof (Workers));
     for (int i = 0; i < MaxWorkers; i++)
@@ -27,7 +27,7 @@
 #define snap_tcpsrvr_h
 //---------------------------------------------------------------------------
 #include "snap_msgsock.h"
-#include "snap_threads.h"
+#include "snap_sync.h"
 //---------------------------------------------------------------------------
 
 #define MaxWorkers 1024
@@ -168,7 +168,7 @@ private:
 protected:
         bool Destroying;
         // Critical section to lock Event activities
-        PSnapCriticalSection CSEvent;
+        PSnapLightMutex CSEvent;
 	    // Workers list
         void *Workers[MaxWorkers];
         // Terminates all worker threads
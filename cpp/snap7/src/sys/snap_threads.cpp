@@ -41,6 +41,8 @@ void* ThreadProc(void* param)
     pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, &last_state);
 #endif
     Thread = PSnapThread(param);
+    if (Thread->Role!=thrNone)
+        ThreadConfigApply(Thread->Role);
 
     if (!Thread->Terminated)
         try
@@ -75,6 +77,7 @@ TSnapThread::TSnapThread()
 	Closed=false;
     Terminated = false;
     FreeOnTerminate = false;
+    Role = thrNone;
 }
 //---------------------------------------------------------------------------
 TSnapThread::~TSnapThread() 
@@ -159,4 +162,116 @@ longword TSnapThread::WaitFor(uint64_t Timeout)
         return WAIT_OBJECT_0;
 }
 //---------------------------------------------------------------------------
+// THREAD CONFIGURATION
+//---------------------------------------------------------------------------
+static const char *ThreadDefaultNames[thrRoles] = {
+    "s7cli",         // thrClientWorker
+    "s7srv-listen",  // thrServerListener
+    "s7srv",         // thrServerWorker
+    "s7partner"      // thrPartner
+};
+
+static TSnapThreadConfig ThreadConfigs[thrRoles];
+static int ThreadStarted[thrRoles];
+static int ThreadErrors[thrRoles];
+static TSnapCriticalSection ThreadConfigCS;
+//---------------------------------------------------------------------------
+int ThreadConfigSet(int Role, PSnapThreadConfig Config)
+{
+    if ((Role<0) || (Role>=thrRoles) || (Config==NULL))
+        return -1;
+    if ((Config->Policy<thrPolicyDefault) || (Config->Policy>thrPolicyRR))
+        return -1;
+#if defined(OS_WINDOWS)
+    // The native mask is as wide as a pointer
+    if ((sizeof(DWORD_PTR)<sizeof(uint64_t)) && ((Config->AffinityMask>>(sizeof(DWORD_PTR)*8))!=0))
+        return -1;
+#endif
+#if (defined(POSIX) || defined(OS_OSX)) && (!defined(OS_SOLARIS_NATIVE_THREADS))
+    if (Config->Policy!=thrPolicyDefault)
+    {
+        int Policy = Config->Policy==thrPolicyFifo ? SCHED_FIFO : SCHED_RR;
+        if ((Config->Priority<sched_get_priority_min(Policy)) || (Config->Priority>sched_get_priority_max(Policy)))
+            return -1;
+    }
+#endif
+    ThreadConfigCS.Enter();
+    ThreadConfigs[Role]=*Config;
+    ThreadConfigs[Role].Name[sizeof(ThreadConfigs[Role].Name)-1]='\0';
+    ThreadStarted[Role]=0;
+    ThreadErrors[Role]=0;
+    ThreadConfigCS.Leave();
+    return 0;
+}
+//---------------------------------------------------------------------------
+int ThreadConfigGet(int Role, PSnapThreadConfig Config)
+{
+    if ((Role<0) || (Role>=thrRoles) || (Config==NULL))
+        return -1;
+    ThreadConfigCS.Enter();
+    *Config=ThreadConfigs[Role];
+    ThreadConfigCS.Leave();
+    return 0;
+}
+//---------------------------------------------------------------------------
+int ThreadConfigStats(int Role, int &Started, int &Errors)
+{
+    if ((Role<0) || (Role>=thrRoles))
+        return -1;
+    ThreadConfigCS.Enter();
+    Started=ThreadStarted[Role];
+    Errors=ThreadErrors[Role];
+    ThreadConfigCS.Leave();
+    return 0;
+}
+//---------------------------------------------------------------------------
+bool ThreadConfigApply(int Role)
+{
+    TSnapThreadConfig Config;
+    const char *Name;
+    bool Result = true;
 
+    if ((Role<0) || (Role>=thrRoles))
+        return false;
+    ThreadConfigCS.Enter();
+    Config=ThreadConfigs[Role];
+    ThreadConfigCS.Leave();
+    Name = Config.Name[0]!='\0' ? Config.Name : ThreadDefaultNames[Role];
+
+#if defined(__linux__)
+    if (Config.AffinityMask!=0)
+    {
+        cpu_set_t Set;
+        CPU_ZERO(&Set);
+        for (int c = 0; c < 64; c++)
+            if (Config.AffinityMask & (uint64_t(1) << c))
+                CPU_SET(c, &Set);
+        Result=pthread_setaffinity_np(pthread_self(), sizeof(Set), &Set)==0;
+    }
+    pthread_setname_np(pthread_self(), Name);
+#elif defined(OS_OSX)
+    pthread_setname_np(Name);
+#elif defined(OS_WINDOWS)
+    if (Config.AffinityMask!=0)
+        Result=SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR(Config.AffinityMask))!=0;
+    if (Config.Policy!=thrPolicyDefault)
+        Result=(SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL)!=0) && Result;
+#endif
+#if (defined(POSIX) || defined(OS_OSX)) && (!defined(OS_SOLARIS_NATIVE_THREADS))
+    if (Config.Policy!=thrPolicyDefault)
+    {
+        sched_param Param;
+        memset(&Param, 0, sizeof(Param));
+        Param.sched_priority=Config.Priority;
+        Result=(pthread_setschedparam(pthread_self(),
+            Config.Policy==thrPolicyFifo ? SCHED_FIFO : SCHED_RR, &Param)==0) && Result;
+    }
+#endif
+    ThreadConfigCS.Enter();
+    ThreadStarted[Role]++;
+    if (!Result)
+        ThreadErrors[Role]++;
+    ThreadConfigCS.Leave();
+    return Result;
+}
+//---------------------------------------------------------------------------
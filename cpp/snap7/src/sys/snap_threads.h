@@ -41,5 +41,45 @@
 # include "unix_threads.h"
 #endif
 
+//---------------------------------------------------------------------------
+// THREAD CONFIGURATION
+//
+// Affinity, scheduling and name applied by every thread of a role when it
+// starts, threads already running keep their settings. The defaults leave the
+// system settings as they are (only the name is set).
+//
+// Linux applies everything, OSX the scheduling and the name, the other
+// unix flavours the scheduling, Windows the affinity and the priority (time
+// critical for Fifo and RR). Solaris native threads apply nothing.
+// Real time policies need privileges (CAP_SYS_NICE under Linux), a thread
+// that can't apply its configuration runs anyway and counts an error.
+// The affinity reaches the CPUs 0..63 (0..31 for 32 bit Windows).
+// A mask with CPUs beyond the width of the platform is refused.
+//---------------------------------------------------------------------------
+const int thrNone           = -1;
+const int thrClientWorker   = 0; // Async jobs of a client
+const int thrServerListener = 1; // Accepts the connections of a server
+const int thrServerWorker   = 2; // Serves one connection of a server
+const int thrPartner        = 3; // Partner workers, listeners and event loops
+const int thrRoles          = 4;
+
+const int thrPolicyDefault  = 0; // Time sharing, Priority ignored
+const int thrPolicyFifo     = 1; // SCHED_FIFO
+const int thrPolicyRR       = 2; // SCHED_RR
+
+typedef struct{
+    uint64_t AffinityMask; // CPUs allowed (bit n = CPU n), 0 = all
+    int Policy;            // thrPolicyXXX
+    int Priority;          // Real time priority (1..99 under Linux), only for Fifo and RR
+    char Name[16];         // Thread name, empty for the role default (s7cli, s7srv, ...)
+}TSnapThreadConfig, *PSnapThreadConfig;
+
+int ThreadConfigSet(int Role, PSnapThreadConfig Config);
+int ThreadConfigGet(int Role, PSnapThreadConfig Config);
+// Threads of the role started so far, and those that failed to apply the configuration
+int ThreadConfigStats(int Role, int &Started, int &Errors);
+// Applies the configuration of Role to the calling thread, false on failure
+bool ThreadConfigApply(int Role);
+
 //---------------------------------------------------------------------------
 #endif // snap_threads_h
@@ -0,0 +1,219 @@
+/*=============================================================================|
+|  PROJECT SNAP7                                                         1.3.0 |
+|==============================================================================|
+|  Copyright (C) 2013, 2015 Davide Nardella                                    |
+|  All rights reserved.                                                        |
+|==============================================================================|
+|  SNAP7 is free software: you can redistribute it and/or modify               |
+|  it under the terms of the Lesser GNU General Public License as published by |
+|  the Free Software Foundation, either version 3 of the License, or           |
+|  (at your option) any later version.                                         |
+|                                                                              |
+|  It means that you can distribute your commercial software linked with       |
+|  SNAP7 without the requirement to distribute the source code of your         |
+|  application and without the requirement that your application be itself     |
+|  distributed under LGPL.                                                     |
+|                                                                              |
+|  SNAP7 is distributed in the hope that it will be useful,                    |
+|  but WITHOUT ANY WARRANTY; without even the implied warranty of              |
+|  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the               |
+|  Lesser GNU General Public License for more details.                         |
+|                                                                              |
+|  You should have received a copy of the GNU General Public License and a     |
+|  copy of Lesser GNU General Public License along with Snap7.                 |
+|  If not, see  http://www.gnu.org/licenses/                                   |
+|=============================================================================*/
+#include "snap_trace.h"
+#include "snap_sysutils.h"
+#include "snap_threads.h"
+#include <stdio.h>
+#ifndef OS_WINDOWS
+# include <pthread.h>
+#endif
+
+#ifdef SNAP7_TRACE
+
+#ifdef OS_WINDOWS
+# define SNAP_THREADVAR __declspec(thread)
+#else
+# define SNAP_THREADVAR __thread
+#endif
+
+typedef struct{
+    uint64_t    Time; // us
+    const char *Name;
+    longword    Arg;
+    char        Phase;
+}TTraceRecord;
+
+typedef struct{
+    volatile longword Head; // Records written (the ring keeps the last TraceRingSize)
+    bool Free;              // Its thread has exited, a new one can take it
+    TTraceRecord Records[TraceRingSize];
+}TTraceRing, *PTraceRing;
+
+static PTraceRing Rings[MaxTraceThreads];
+static volatile int RingsCount = 0;
+static longword UntracedThreads = 0;
+static TSnapCriticalSection RingsCS;
+static SNAP_THREADVAR PTraceRing LocalRing = NULL;
+static SNAP_THREADVAR bool LocalRingFull = false;
+
+#ifndef OS_WINDOWS
+// The value of the key is the ring of the thread, its destructor runs when the thread exits
+static pthread_key_t RingKey;
+static pthread_once_t RingKeyOnce = PTHREAD_ONCE_INIT;
+//---------------------------------------------------------------------------
+static void TraceRelease(void *Ring)
+{
+    RingsCS.Enter();
+    PTraceRing(Ring)->Free=true;
+    RingsCS.Leave();
+}
+//---------------------------------------------------------------------------
+static void TraceKeyCreate()
+{
+    pthread_key_create(&RingKey, TraceRelease);
+}
+#endif
+//---------------------------------------------------------------------------
+static PTraceRing TraceRegister()
+{
+    PTraceRing Ring = NULL;
+    int c;
+#ifndef OS_WINDOWS
+    pthread_once(&RingKeyOnce, TraceKeyCreate);
+#endif
+    RingsCS.Enter();
+    // The ring of a thread that has exited is reused before creating a new one
+    for (c = 0; c < RingsCount; c++)
+    {
+        if (Rings[c]->Free)
+        {
+            Ring=Rings[c];
+            break;
+        }
+    }
+    if ((Ring==NULL) && (RingsCount<MaxTraceThreads))
+    {
+        Ring=new TTraceRing;
+        Rings[RingsCount]=Ring;
+        RingsCount++;
+    }
+    if (Ring!=NULL)
+    {
+        Ring->Head=0;
+        Ring->Free=false;
+    }
+    else
+        UntracedThreads++;
+    RingsCS.Leave();
+#ifndef OS_WINDOWS
+    if (Ring!=NULL)
+        pthread_setspecific(RingKey, Ring);
+#endif
+    return Ring;
+}
+//---------------------------------------------------------------------------
+void TraceWrite(char Phase, const char *Name, longword Arg)
+{
+    TTraceRecord *Record;
+    if (LocalRing==NULL)
+    {
+        if (LocalRingFull)
+            return;
+        LocalRing=TraceRegister();
+        if (LocalRing==NULL)
+        {
+            // Too many threads at once : this one is not traced
+            LocalRingFull=true;
+            return;
+        }
+    }
+    Record=&LocalRing->Records[LocalRing->Head & (TraceRingSize-1)];
+    Record->Time=SysGetTickUs();
+    Record->Name=Name;
+    Record->Arg=Arg;
+    Record->Phase=Phase;
+    // The record must be complete before the head moves on
+#ifdef OS_WINDOWS
+    MemoryBarrier();
+#else
+    __sync_synchronize();
+#endif
+    LocalRing->Head=LocalRing->Head+1;
+}
+//---------------------------------------------------------------------------
+bool TraceAvailable()
+{
+    return true;
+}
+//---------------------------------------------------------------------------
+bool TraceDump(const char *FileName)
+{
+    FILE *F;
+    PTraceRing Ring;
+    TTraceRecord *Record;
+    longword Head, First;
+    bool Comma = false;
+    int Count;
+    longword Untraced;
+
+    F=fopen(FileName, "wb");
+    if (F==NULL)
+        return false;
+
+    RingsCS.Enter();
+    Count=RingsCount;
+    Untraced=UntracedThreads;
+    RingsCS.Leave();
+
+    fprintf(F, "{\"displayTimeUnit\":\"ns\",\"otherData\":{\"untracedThreads\":%u},\"traceEvents\":[", Untraced);
+    for (int c = 0; c < Count; c++)
+    {
+        Ring=Rings[c];
+        Head=Ring->Head;
+        First=Head>TraceRingSize ? Head-TraceRingSize : 0;
+        for (longword i = First; i < Head; i++)
+        {
+            Record=&Ring->Records[i & (TraceRingSize-1)];
+            fprintf(F, "%s\n{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%llu,\"pid\":1,\"tid\":%d",
+              Comma ? "," : "", Record->Name, Record->Phase, (unsigned long long)Record->Time, c+1);
+            if (Record->Phase==trcInstant)
+                fprintf(F, ",\"s\":\"t\"");
+            if (Record->Phase!=trcEnd)
+                fprintf(F, ",\"args\":{\"arg\":%u}", Record->Arg);
+            fprintf(F, "}");
+            Comma=true;
+        }
+    }
+    fprintf(F, "\n]}\n");
+    return fclose(F)==0;
+}
+//---------------------------------------------------------------------------
+void TraceClear()
+{
+    RingsCS.Enter();
+    for (int c = 0; c < RingsCount; c++)
+        Rings[c]->Head=0;
+    UntracedThreads=0;
+    RingsCS.Leave();
+}
+
+#else
+
+bool TraceAvailable()
+{
+    return false;
+}
+
+bool TraceDump(const char * /*FileName*/)
+{
+    return false;
+}
+
+void TraceClear()
+{
+}
+
+#endif // SNAP7_TRACE
@@ -0,0 +1,98 @@
+/*=============================================================================|
+|  PROJECT SNAP7                                                         1.3.0 |
+|==============================================================================|
+|  Copyright (C) 2013, 2015 Davide Nardella                                    |
+|  All rights reserved.                                                        |
+|==============================================================================|
+|  SNAP7 is free software: you can redistribute it and/or modify               |
+|  it under the terms of the Lesser GNU General Public License as published by |
+|  the Free Software Foundation, either version 3 of the License, or           |
+|  (at your option) any later version.                                         |
+|                                                                              |
+|  It means that you can distribute your commercial software linked with       |
+|  SNAP7 without the requirement to distribute the source code of your         |
+|  application and without the requirement that your application be itself     |
+|  distributed under LGPL.                                                     |
+|                                                                              |
+|  SNAP7 is distributed in the hope that it will be useful,                    |
+|  but WITHOUT ANY WARRANTY; without even the implied warranty of              |
+|  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the               |
+|  Lesser GNU General Public License for more details.                         |
+|                                                                              |
+|  You should have received a copy of the GNU General Public License and a     |
+|  copy of Lesser GNU General Public License along with Snap7.                 |
+|  If not, see  http://www.gnu.org/licenses/                                   |
+|=============================================================================*/
+#ifndef snap_trace_h
+#define snap_trace_h
+//---------------------------------------------------------------------------
+#include "snap_platform.h"
+//---------------------------------------------------------------------------
+// TRACEPOINTS
+//
+// Static tracepoints along the path of a request (job, request build, send,
+// first header, fragments, completion) recorded into per-thread ring buffers and dumped as
+// Chrome trace JSON (chrome://tracing, Perfetto).
+//
+// They are compiled only if SNAP7_TRACE is defined (cmake -DSNAP7_TRACE=ON),
+// otherwise the macros expand to nothing.
+//
+// Every thread writes only into its own ring (the last TraceRingSize records
+// are kept), so recording needs neither locks nor atomic read-modify-write.
+// A thread takes a ring when it records for the first time and gives it back
+// when it exits (not under Windows, where the rings are never released): the
+// ring keeps its records for the dump until a new thread reuses it.
+// Beyond MaxTraceThreads rings in use the new threads are not traced, the dump
+// counts them (otherData.untracedThreads).
+// Dump and Clear are meant to be called while the traced threads are idle,
+// records written during the dump may be torn.
+// Names must be string literals (only the pointer is stored).
+//---------------------------------------------------------------------------
+#define TraceRingSize   8192 // Records per thread, power of two
+#define MaxTraceThreads 256
+
+const char trcBegin   = 'B';
+const char trcEnd     = 'E';
+const char trcInstant = 'i';
+
+#ifdef SNAP7_TRACE
+
+void TraceWrite(char Phase, const char *Name, longword Arg);
+
+class TSnapTraceScope
+{
+private:
+    const char *FName;
+public:
+    TSnapTraceScope(const char *Name, longword Arg)
+    {
+        FName=Name;
+        TraceWrite(trcBegin, Name, Arg);
+    };
+    ~TSnapTraceScope()
+    {
+        TraceWrite(trcEnd, FName, 0);
+    };
+};
+
+#define SNAP_TRACE_BEGIN(Name, Arg)   TraceWrite(trcBegin, Name, longword(Arg))
+#define SNAP_TRACE_END(Name)          TraceWrite(trcEnd, Name, 0)
+#define SNAP_TRACE_INSTANT(Name, Arg) TraceWrite(trcInstant, Name, longword(Arg))
+#define SNAP_TRACE_SCOPE(Name, Arg)   TSnapTraceScope SnapTraceScope(Name, longword(Arg))
+
+#else
+
+#define SNAP_TRACE_BEGIN(Name, Arg)   ((void)0)
+#define SNAP_TRACE_END(Name)          ((void)0)
+#define SNAP_TRACE_INSTANT(Name, Arg) ((void)0)
+#define SNAP_TRACE_SCOPE(Name, Arg)   ((void)0)
+
+#endif // SNAP7_TRACE
+
+// Always available : they fail/do nothing if the tracepoints are compiled out
+bool TraceAvailable();
+// Writes all the rings into a Chrome trace JSON file, returns false on I/O error
+bool TraceDump(const char *FileName);
+void TraceClear();
+
+#endif // snap_trace_h
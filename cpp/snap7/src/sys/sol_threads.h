@@ -191,6 +191,7 @@ public:
     bool Terminated;
     bool Closed;
     bool FreeOnTerminate;
+    int Role; // thrXXX, its configuration is applied when the thread starts
     TSnapThread();
     virtual ~TSnapThread();
 